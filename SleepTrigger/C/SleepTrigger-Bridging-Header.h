@@ -4,3 +4,4 @@
 
 // SleepTrigger-Bridging-Header.h
 #include "simple_sleep.h"
+#include "export_stream.h"
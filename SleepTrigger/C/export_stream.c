@@ -0,0 +1,318 @@
+//
+//  export_stream.c
+//  SleepTrigger
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#include "export_stream.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "es_bin_* write host order; the binary format is little-endian"
+#endif
+
+static const char kDigits2[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const double kPow10[10] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+static const uint64_t kPow10u[10] = {1u, 10u, 100u, 1000u, 10000u, 100000u,
+                                     1000000u, 10000000u, 100000000u, 1000000000u};
+
+static void fail(es_writer_t* w, int e) {
+    if (!w->err) w->err = e ? e : EIO;
+}
+
+static int init(es_writer_t* w, size_t bufSize) {
+    w->cap = bufSize ? bufSize : ES_BUF_DEFAULT;
+    if (w->cap < 2 * ES_F64_MAX) w->cap = 2 * ES_F64_MAX;
+    w->buf = (char*)malloc(w->cap);
+    if (!w->buf) { errno = ENOMEM; return -1; }
+    return 0;
+}
+
+int es_open(es_writer_t* w, const char* path, size_t bufSize) {
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    size_t n = strlen(path);
+    w->path = (char*)malloc(n + 1);
+    w->tmpPath = (char*)malloc(n + 5);
+    if (!w->path || !w->tmpPath) { es_abort(w); errno = ENOMEM; return -1; }
+    memcpy(w->path, path, n + 1);
+    memcpy(w->tmpPath, path, n);
+    memcpy(w->tmpPath + n, ".tmp", 5);
+
+    if (init(w, bufSize) != 0) { es_abort(w); errno = ENOMEM; return -1; }
+    w->fd = open(w->tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) { int e = errno; es_abort(w); errno = e; return -1; }
+    w->ownsFd = 1;
+    return 0;
+}
+
+int es_open_fd(es_writer_t* w, int fd, size_t bufSize) {
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+    if (fd < 0) { errno = EBADF; return -1; }
+    return init(w, bufSize);
+}
+
+static void write_all(es_writer_t* w, const char* p, size_t n) {
+    while (n && !w->err) {
+        ssize_t k = write(w->fd, p, n);
+        if (k < 0) {
+            if (errno == EINTR) continue;
+            fail(w, errno);
+            return;
+        }
+        p += k;
+        n -= (size_t)k;
+        w->bytes += (uint64_t)k;
+    }
+}
+
+int es_flush(es_writer_t* w) {
+    if (w->len) write_all(w, w->buf, w->len);
+    w->len = 0;
+    return w->err ? -1 : 0;
+}
+
+// Room for `n` more bytes in the buffer (n <= cap).
+static inline char* reserve(es_writer_t* w, size_t n) {
+    if (w->cap - w->len < n) es_flush(w);
+    return w->buf + w->len;
+}
+
+int es_close(es_writer_t* w) {
+    if (w->fd >= 0 && w->buf) es_flush(w);
+    if (w->ownsFd) {
+        if (!w->err && fsync(w->fd) != 0) fail(w, errno);
+        if (close(w->fd) != 0) fail(w, errno);
+        w->fd = -1;
+        if (!w->err && rename(w->tmpPath, w->path) != 0) fail(w, errno);
+        if (w->err) unlink(w->tmpPath);
+    }
+    int err = w->err;
+    free(w->buf);
+    free(w->path);
+    free(w->tmpPath);
+    w->buf = w->path = w->tmpPath = NULL;
+    w->fd = -1;
+    w->ownsFd = 0;
+    if (err) { errno = err; return -1; }
+    return 0;
+}
+
+void es_abort(es_writer_t* w) {
+    if (w->ownsFd && w->fd >= 0) close(w->fd);
+    if (w->ownsFd && w->tmpPath) unlink(w->tmpPath);
+    free(w->buf);
+    free(w->path);
+    free(w->tmpPath);
+    int err = w->err;
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    w->err = err;
+}
+
+void es_put(es_writer_t* w, const void* data, size_t n) {
+    const char* p = (const char*)data;
+    if (n >= w->cap) {                 // big blocks bypass the buffer
+        es_flush(w);
+        write_all(w, p, n);
+        return;
+    }
+    memcpy(reserve(w, n), p, n);
+    w->len += n;
+}
+
+void es_puts(es_writer_t* w, const char* s) { es_put(w, s, strlen(s)); }
+
+void es_putc(es_writer_t* w, int c) {
+    *reserve(w, 1) = (char)c;
+    w->len += 1;
+}
+
+// Digits of v, right-aligned ending at `end`; returns the first digit.
+static inline char* utoa_rev(char* end, uint64_t v) {
+    while (v >= 100) {
+        unsigned d = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--end = kDigits2[d + 1];
+        *--end = kDigits2[d];
+    }
+    if (v >= 10) {
+        unsigned d = (unsigned)v * 2;
+        *--end = kDigits2[d + 1];
+        *--end = kDigits2[d];
+    } else {
+        *--end = (char)('0' + v);
+    }
+    return end;
+}
+
+static size_t format_i64(char* out, int64_t v) {
+    char tmp[24];
+    char* end = tmp + sizeof(tmp);
+    uint64_t u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+    char* p = utoa_rev(end, u);
+    if (v < 0) *--p = '-';
+    size_t n = (size_t)(end - p);
+    memcpy(out, p, n);
+    return n;
+}
+
+void es_put_i64(es_writer_t* w, int64_t v) {
+    w->len += format_i64(reserve(w, 24), v);
+}
+
+// snprintf honours LC_NUMERIC, so undo a ',' decimal point on the way out.
+static size_t copy_c_locale(char* out, const char* tmp, int n) {
+    if (n < 0) n = 0;
+    if ((size_t)n > ES_F64_MAX) n = (int)ES_F64_MAX;
+    for (int i = 0; i < n; ++i) out[i] = tmp[i] == ',' ? '.' : tmp[i];
+    return (size_t)n;
+}
+
+// Fewest significant digits (15..17) that strtod reads back as v. strtod
+// uses the same locale as snprintf, so the check runs before the ','
+// is undone.
+static size_t format_roundtrip(char* out, double v) {
+    char tmp[40];
+    int n = 0;
+    for (int prec = 15; prec <= 17; ++prec) {
+        n = snprintf(tmp, sizeof(tmp), "%.*g", prec, v);
+        if (strtod(tmp, NULL) == v) break;
+    }
+    return copy_c_locale(out, tmp, n);
+}
+
+size_t es_format_f64(char* out, double v, int decimals) {
+    if (isnan(v)) { memcpy(out, "nan", 3); return 3; }
+    if (isinf(v)) {
+        if (v < 0) { memcpy(out, "-inf", 4); return 4; }
+        memcpy(out, "inf", 3); return 3;
+    }
+    if (decimals == ES_DEC_ROUNDTRIP) return format_roundtrip(out, v == 0 ? 0.0 : v);
+    if (decimals < 0) decimals = 0;
+    if (decimals > 9) decimals = 9;
+
+    const double a = fabs(v) * kPow10[decimals] + 0.5;
+    if (a >= 9.0e15) {
+        // Beyond exact integer range: rare enough to take the slow path.
+        char tmp[40];
+        return copy_c_locale(out, tmp, snprintf(tmp, sizeof(tmp), "%.17g", v));
+    }
+
+    uint64_t scaled = (uint64_t)a;
+    const uint64_t p10 = kPow10u[decimals];
+    uint64_t ip = scaled / p10;
+    uint64_t fp = scaled % p10;
+
+    char* o = out;
+    if (v < 0 && scaled != 0) *o++ = '-';
+    char tmp[24];
+    char* end = tmp + sizeof(tmp);
+    char* s = utoa_rev(end, ip);
+    memcpy(o, s, (size_t)(end - s));
+    o += end - s;
+
+    if (fp) {
+        int d = decimals;
+        while (fp % 10 == 0) { fp /= 10; --d; }
+        *o++ = '.';
+        char* f = o + d;
+        for (char* q = f; q > o; fp /= 10) *--q = (char)('0' + fp % 10);
+        o = f;
+    }
+    return (size_t)(o - out);
+}
+
+void es_put_f64(es_writer_t* w, double v, int decimals) {
+    w->len += es_format_f64(reserve(w, ES_F64_MAX), v, decimals);
+}
+
+// Days since 1970-01-01 to proleptic Gregorian y/m/d (Hinnant's algorithm).
+static void civil_from_days(int64_t z, int64_t* y, unsigned* m, unsigned* d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = (int64_t)yoe + era * 400 + (*m <= 2);
+}
+
+static inline char* put2(char* p, unsigned v) {
+    p[0] = kDigits2[v * 2];
+    p[1] = kDigits2[v * 2 + 1];
+    return p + 2;
+}
+
+void es_put_iso8601(es_writer_t* w, double epochSeconds) {
+    if (!isfinite(epochSeconds)) { es_puts(w, "nan"); return; }
+    const int64_t ms = (int64_t)floor(epochSeconds * 1000.0 + 0.5);
+    int64_t days = ms / 86400000;
+    int64_t rem = ms % 86400000;
+    if (rem < 0) { rem += 86400000; days -= 1; }
+    int64_t y; unsigned mo, d;
+    civil_from_days(days, &y, &mo, &d);
+
+    char* p = reserve(w, 40);
+    char* start = p;
+    if (y >= 0 && y <= 9999) {
+        p = put2(p, (unsigned)(y / 100));
+        p = put2(p, (unsigned)(y % 100));
+    } else {
+        p += format_i64(p, y);
+    }
+    *p++ = '-'; p = put2(p, mo);
+    *p++ = '-'; p = put2(p, d);
+    *p++ = 'T'; p = put2(p, (unsigned)(rem / 3600000));
+    *p++ = ':'; p = put2(p, (unsigned)(rem / 60000 % 60));
+    *p++ = ':'; p = put2(p, (unsigned)(rem / 1000 % 60));
+    const unsigned milli = (unsigned)(rem % 1000);
+    *p++ = '.';
+    *p++ = (char)('0' + milli / 100);
+    p = put2(p, milli % 100);
+    *p++ = 'Z';
+    w->len += (size_t)(p - start);
+}
+
+void es_csv_row_f64(es_writer_t* w, const double* v, const uint8_t* decimals, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        char* p = reserve(w, ES_F64_MAX + 1);
+        size_t k = es_format_f64(p, v[i], decimals ? decimals[i] : 6);
+        p[k] = i + 1 < n ? ',' : '\n';
+        w->len += k + 1;
+    }
+    if (n == 0) es_putc(w, '\n');
+}
+
+void es_bin_header(es_writer_t* w, const char* const* names, const uint8_t* types, uint16_t ncols) {
+    const uint16_t version = ES_BIN_VERSION;
+    es_put(w, ES_BIN_MAGIC, 4);
+    es_put(w, &version, 2);
+    es_put(w, &ncols, 2);
+    for (uint16_t i = 0; i < ncols; ++i) {
+        size_t n = strlen(names[i]);
+        if (n > 255) n = 255;
+        es_putc(w, types[i]);
+        es_putc(w, (int)n);
+        es_put(w, names[i], n);
+    }
+}
+
+void es_bin_f64(es_writer_t* w, double v) { es_put(w, &v, sizeof v); }
+void es_bin_f32(es_writer_t* w, float v) { es_put(w, &v, sizeof v); }
+void es_bin_u8(es_writer_t* w, uint8_t v) { es_putc(w, v); }
+void es_bin_i64(es_writer_t* w, int64_t v) { es_put(w, &v, sizeof v); }
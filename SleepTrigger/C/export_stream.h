@@ -0,0 +1,100 @@
+//
+//  export_stream.h
+//  SleepTrigger
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Streaming CSV / binary writer with a fixed-size output buffer. Rows are
+//  formatted straight into the buffer and flushed with write(2) when it
+//  fills, so peak memory is the buffer no matter how long the export is.
+//  Number formatting is locale-free ('.' decimal point, no grouping).
+//
+//  es_open writes to "<path>.tmp" and es_close renames it over `path`, so a
+//  reader never sees a half-written export. Errors are sticky: the put
+//  functions return nothing and es_close reports the first failure.
+//
+//  Binary layout (little-endian):
+//
+//    "STXB" | u16 version | u16 ncols | ncols x (u8 type, u8 len, name)
+//    then packed rows, each column at its es_col_t width, no padding.
+//
+
+#ifndef EXPORT_STREAM_H
+#define EXPORT_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ES_BUF_DEFAULT  (64u * 1024u)
+#define ES_F64_MAX      32u            // longest es_format_f64 output
+#define ES_DEC_ROUNDTRIP 255           // decimals: shortest text strtod reads back exactly
+#define ES_BIN_MAGIC    "STXB"
+#define ES_BIN_VERSION  1u
+
+typedef struct es_writer {
+    int      fd;
+    int      ownsFd;      // opened by es_open (closed and renamed by es_close)
+    char*    buf;
+    size_t   cap;
+    size_t   len;
+    uint64_t bytes;       // total bytes handed to the file so far
+    int      err;         // first errno seen, 0 if none
+    char*    path;        // final name (es_open only)
+    char*    tmpPath;
+} es_writer_t;
+
+typedef enum {
+    ES_COL_F64 = 1,
+    ES_COL_F32 = 2,
+    ES_COL_U8  = 3,
+    ES_COL_I64 = 4
+} es_col_t;
+
+/// Create `path` via a temp file. bufSize 0 selects ES_BUF_DEFAULT.
+/// Returns 0, or -1 with errno set.
+int  es_open(es_writer_t* w, const char* path, size_t bufSize);
+/// Write to an fd the caller keeps owning (not closed, no rename).
+int  es_open_fd(es_writer_t* w, int fd, size_t bufSize);
+int  es_flush(es_writer_t* w);
+/// Flush, close and publish. Returns 0, or -1 if any write failed
+/// (the temp file is removed and `err` holds the errno).
+int  es_close(es_writer_t* w);
+/// Drop everything written so far and remove the temp file.
+void es_abort(es_writer_t* w);
+
+void es_put(es_writer_t* w, const void* data, size_t n);
+void es_puts(es_writer_t* w, const char* s);
+void es_putc(es_writer_t* w, int c);
+void es_put_i64(es_writer_t* w, int64_t v);
+/// Fixed-point with at most `decimals` (0..9) digits, trailing zeros trimmed:
+/// 72 -> "72", 0.25 -> "0.25"; anything that rounds to zero is "0", never
+/// "-0". Non-finite values print as nan / inf / -inf. Rounds half away from
+/// zero on the scaled value. ES_DEC_ROUNDTRIP instead prints the fewest
+/// significant digits (%.15g..%.17g) that parse back to exactly v; this
+/// goes through snprintf and is several times slower than fixed point.
+void es_put_f64(es_writer_t* w, double v, int decimals);
+/// Same formatting into `out` (at least ES_F64_MAX bytes, not terminated).
+size_t es_format_f64(char* out, double v, int decimals);
+/// UTC timestamp "YYYY-MM-DDTHH:MM:SS.mmmZ" (what ISO8601DateFormatter
+/// prints with .withInternetDateTime + .withFractionalSeconds).
+void es_put_iso8601(es_writer_t* w, double epochSeconds);
+
+/// One CSV line: n values separated by ',' and a trailing '\n'.
+/// `decimals` may be NULL (6 for every column).
+void es_csv_row_f64(es_writer_t* w, const double* v, const uint8_t* decimals, size_t n);
+
+/// Binary header; rows follow as raw es_put calls (or the typed helpers).
+void es_bin_header(es_writer_t* w, const char* const* names, const uint8_t* types, uint16_t ncols);
+void es_bin_f64(es_writer_t* w, double v);
+void es_bin_f32(es_writer_t* w, float v);
+void es_bin_u8(es_writer_t* w, uint8_t v);
+void es_bin_i64(es_writer_t* w, int64_t v);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* EXPORT_STREAM_H */
@@ -6,7 +6,9 @@
 //
 
 #include "simple_sleep.h"
+#include "window_features.h"
 #include <math.h>
+#include <stddef.h>
 
 static double clamp(double v, double lo, double hi) {
     return v < lo ? lo : (v > hi ? hi : v);
@@ -14,34 +16,11 @@ static double clamp(double v, double lo, double hi) {
 
 ss_stats_t ss_stats(const double *x, int n) {
     ss_stats_t out = {NAN, NAN, NAN};
-    if (!x || n <= 0) return out;
-
-    double sum = 0.0;
-    for (int i = 0; i < n; ++i) sum += x[i];
-    double mean = sum / (double)n;
-
-    double vsum = 0.0;
-    for (int i = 0; i < n; ++i) {
-        double d = x[i] - mean;
-        vsum += d * d;
-    }
-    double sd = (n > 0) ? sqrt(vsum / (double)n) : NAN;
-
-    if (n < 2) {
-        out.mean = mean; out.sd = sd; out.rmssd = NAN;
-        return out;
-    }
-
-    double diff2 = 0.0;
-    for (int i = 1; i < n; ++i) {
-        double d = x[i] - x[i-1];
-        diff2 += d * d;
-    }
-    double rmssd = sqrt(diff2 / (double)(n - 1));
-
-    out.mean = mean;
-    out.sd = sd;
-    out.rmssd = rmssd;
+    wf_features_t f;
+    if (wf_compute(NULL, x, n, 0, &f) != 0) return out;
+    out.mean = f.mean;
+    out.sd = sqrt(f.var);
+    out.rmssd = f.rmssd;
     return out;
 }
 
@@ -19,8 +19,8 @@ typedef struct {
 } ss_stats_t;
 
 /**
- Computes mean, sd, and RMSSD for an array of BPM samples.
- Returns {nan,nan,nan} if n < 2.
+ Computes mean, sd, and RMSSD for an array of BPM samples in one pass
+ (wf_compute). Returns {nan,nan,nan} if n < 1; rmssd is nan if n < 2.
  */
 ss_stats_t ss_stats(const double *samples, int n);
 
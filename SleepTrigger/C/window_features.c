@@ -0,0 +1,430 @@
+//
+//  window_features.c
+//  SleepTrigger
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#include "window_features.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// ---- lane abstraction (selected at compile time) ----
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define WF_LANES 4
+typedef __m256d wfv;
+static inline wfv wfv_load(const double* p)     { return _mm256_loadu_pd(p); }
+static inline void wfv_store(double* p, wfv v)  { _mm256_storeu_pd(p, v); }
+static inline wfv wfv_set1(double x)            { return _mm256_set1_pd(x); }
+static inline wfv wfv_add(wfv a, wfv b)         { return _mm256_add_pd(a, b); }
+static inline wfv wfv_sub(wfv a, wfv b)         { return _mm256_sub_pd(a, b); }
+static inline wfv wfv_mul(wfv a, wfv b)         { return _mm256_mul_pd(a, b); }
+static inline wfv wfv_min(wfv a, wfv b)         { return _mm256_min_pd(a, b); }
+static inline wfv wfv_max(wfv a, wfv b)         { return _mm256_max_pd(a, b); }
+static inline wfv wfv_abs(wfv a)                { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+// 1.0 in lanes where a and b sit on opposite sides of l, else 0.
+static inline wfv wfv_cross(wfv a, wfv b, wfv l) {
+    const wfv m = _mm256_xor_pd(_mm256_cmp_pd(a, l, _CMP_GE_OQ), _mm256_cmp_pd(b, l, _CMP_GE_OQ));
+    return _mm256_and_pd(m, _mm256_set1_pd(1.0));
+}
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define WF_LANES 2
+typedef __m128d wfv;
+static inline wfv wfv_load(const double* p)     { return _mm_loadu_pd(p); }
+static inline void wfv_store(double* p, wfv v)  { _mm_storeu_pd(p, v); }
+static inline wfv wfv_set1(double x)            { return _mm_set1_pd(x); }
+static inline wfv wfv_add(wfv a, wfv b)         { return _mm_add_pd(a, b); }
+static inline wfv wfv_sub(wfv a, wfv b)         { return _mm_sub_pd(a, b); }
+static inline wfv wfv_mul(wfv a, wfv b)         { return _mm_mul_pd(a, b); }
+static inline wfv wfv_min(wfv a, wfv b)         { return _mm_min_pd(a, b); }
+static inline wfv wfv_max(wfv a, wfv b)         { return _mm_max_pd(a, b); }
+static inline wfv wfv_abs(wfv a)                { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+static inline wfv wfv_cross(wfv a, wfv b, wfv l) {
+    const wfv m = _mm_xor_pd(_mm_cmpge_pd(a, l), _mm_cmpge_pd(b, l));
+    return _mm_and_pd(m, _mm_set1_pd(1.0));
+}
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define WF_LANES 2
+typedef float64x2_t wfv;
+static inline wfv wfv_load(const double* p)     { return vld1q_f64(p); }
+static inline void wfv_store(double* p, wfv v)  { vst1q_f64(p, v); }
+static inline wfv wfv_set1(double x)            { return vdupq_n_f64(x); }
+static inline wfv wfv_add(wfv a, wfv b)         { return vaddq_f64(a, b); }
+static inline wfv wfv_sub(wfv a, wfv b)         { return vsubq_f64(a, b); }
+static inline wfv wfv_mul(wfv a, wfv b)         { return vmulq_f64(a, b); }
+static inline wfv wfv_min(wfv a, wfv b)         { return vminq_f64(a, b); }
+static inline wfv wfv_max(wfv a, wfv b)         { return vmaxq_f64(a, b); }
+static inline wfv wfv_abs(wfv a)                { return vabsq_f64(a); }
+static inline wfv wfv_cross(wfv a, wfv b, wfv l) {
+    const uint64x2_t m = veorq_u64(vcgeq_f64(a, l), vcgeq_f64(b, l));
+    return vreinterpretq_f64_u64(vandq_u64(m, vreinterpretq_u64_f64(vdupq_n_f64(1.0))));
+}
+#else
+#define WF_LANES 1
+typedef double wfv;
+static inline wfv wfv_load(const double* p)     { return *p; }
+static inline void wfv_store(double* p, wfv v)  { *p = v; }
+static inline wfv wfv_set1(double x)            { return x; }
+static inline wfv wfv_add(wfv a, wfv b)         { return a + b; }
+static inline wfv wfv_sub(wfv a, wfv b)         { return a - b; }
+static inline wfv wfv_mul(wfv a, wfv b)         { return a * b; }
+static inline wfv wfv_min(wfv a, wfv b)         { return a < b ? a : b; }
+static inline wfv wfv_max(wfv a, wfv b)         { return a > b ? a : b; }
+static inline wfv wfv_abs(wfv a)                { return fabs(a); }
+static inline wfv wfv_cross(wfv a, wfv b, wfv l) { return (a >= l) != (b >= l) ? 1.0 : 0.0; }
+#endif
+
+// Bin groups (one vector each), rounded up to a pair.
+#define WF_GROUPS (((WF_MAX_BINS + WF_LANES - 1) / WF_LANES + 1) & ~1)
+// Samples per block of the fused pass; the Goertzel state stays in
+// registers across a block.
+#define WF_BLOCK  64
+
+int wf_simd_lanes(void) { return WF_LANES; }
+
+static double hsum(wfv v) {
+    double t[WF_LANES];
+    wfv_store(t, v);
+    double s = 0;
+    for (int i = 0; i < WF_LANES; ++i) s += t[i];
+    return s;
+}
+
+static void set_nan(wf_features_t* f) {
+    f->n = 0;
+    f->mean = f->var = f->rmssd = f->min = f->max = f->mad = f->energy = NAN;
+    f->crossings = 0;
+    for (int b = 0; b < WF_MAX_BANDS; ++b) f->band[b] = NAN;
+}
+
+// ---- plan ----
+
+int wf_plan_init(wf_plan_t* p, int n, double fs,
+                 const double* lo, const double* hi, int bands, double level) {
+    if (!p) return -1;
+    memset(p, 0, sizeof(*p));
+    if (n < 2 || !(fs > 0) || bands < 0 || bands > WF_MAX_BANDS) return -1;
+    if (bands && (!lo || !hi)) return -1;
+    p->n = n;
+    p->level = level;
+    p->bands = bands;
+    for (int b = 0; b < bands; ++b) {
+        for (int k = 1; k <= n / 2; ++k) {
+            const double f = k * fs / n;
+            if (f < lo[b] || f > hi[b]) continue;
+            if (p->bins == WF_MAX_BINS) { memset(p, 0, sizeof(*p)); return -1; }
+            p->k[p->bins] = k;
+            p->bandOf[p->bins] = b;
+            p->coeff[p->bins] = 2.0 * cos(2.0 * M_PI * k / n);
+            p->bins += 1;
+        }
+    }
+    return 0;
+}
+
+// ---- fused pass ----
+
+// Goertzel recurrences for every bin, one bin per lane:
+// s0 = x + c s1 - s2, with x - s2 summed first, off the dependency chain
+// through s1. Groups run in pairs so two chains overlap.
+typedef struct {
+    wfv c[WF_GROUPS], s1[WF_GROUPS], s2[WF_GROUPS];
+    int groups;            // even, 0 without bins
+} bank_t;
+
+static void bank_init(bank_t* g, const wf_plan_t* p) {
+    double c[WF_GROUPS * WF_LANES] = {0};
+    for (int b = 0; b < p->bins; ++b) c[b] = p->coeff[b];
+    g->groups = (((p->bins + WF_LANES - 1) / WF_LANES) + 1) & ~1;
+    for (int i = 0; i < WF_GROUPS; ++i) {
+        g->c[i] = wfv_load(c + i * WF_LANES);
+        g->s1[i] = g->s2[i] = wfv_set1(0.0);
+    }
+}
+
+static void bank_run(bank_t* g, const double* x, int n) {
+    for (int i = 0; i < g->groups; i += 2) {
+        const wfv ca = g->c[i], cb = g->c[i + 1];
+        wfv a1 = g->s1[i], a2 = g->s2[i], b1 = g->s1[i + 1], b2 = g->s2[i + 1];
+        for (int j = 0; j < n; ++j) {
+            const wfv v = wfv_set1(x[j]);
+            const wfv a0 = wfv_add(wfv_sub(v, a2), wfv_mul(ca, a1));
+            const wfv b0 = wfv_add(wfv_sub(v, b2), wfv_mul(cb, b1));
+            a2 = a1; a1 = a0;
+            b2 = b1; b1 = b0;
+        }
+        g->s1[i] = a1; g->s2[i] = a2;
+        g->s1[i + 1] = b1; g->s2[i + 1] = b2;
+    }
+}
+
+// |X_k|^2 / n from the state after n samples.
+static void bank_power(const bank_t* g, const wf_plan_t* p, int n, double* band) {
+    double s1[WF_GROUPS * WF_LANES], s2[WF_GROUPS * WF_LANES];
+    for (int i = 0; i < g->groups; ++i) {
+        wfv_store(s1 + i * WF_LANES, g->s1[i]);
+        wfv_store(s2 + i * WF_LANES, g->s2[i]);
+    }
+    for (int b = 0; b < p->bins; ++b) {
+        const double a = s1[b], c = s2[b];
+        band[p->bandOf[b]] += (a * a + c * c - p->coeff[b] * a * c) / n;
+    }
+}
+
+typedef struct {
+    double sd, sdd;      // sums of (x - x[0]) and its square
+    double sq, d2;       // sums of x^2 and of squared steps
+    double lo, hi;
+    double cross;
+} sums_t;
+
+// One sweep over x (n >= 1), block by block. Every moment has its own lane
+// accumulator; the bank (if any) then runs over the block while it is
+// still in L1.
+static void fused_pass(const double* x, int n, double level, bank_t* g, sums_t* r) {
+    const double K = x[0];
+    const wfv vK = wfv_set1(K), vL = wfv_set1(level);
+    wfv sd = wfv_set1(0.0), sdd = sd, sq = sd, d2 = sd, cr = sd;
+    wfv lo = wfv_set1(K), hi = lo;
+    double tsd = 0, tsdd = 0, tsq = K * K, td2 = 0, tcr = 0, tlo = K, thi = K;
+    if (g) bank_run(g, x, 1);
+
+    for (int start = 1; start < n; start += WF_BLOCK) {
+        const int end = n - start > WF_BLOCK ? start + WF_BLOCK : n;
+        int i = start;
+        for (; i + WF_LANES <= end; i += WF_LANES) {
+            const wfv v = wfv_load(x + i), prev = wfv_load(x + i - 1);
+            const wfv d = wfv_sub(v, vK), s = wfv_sub(v, prev);
+            sd  = wfv_add(sd, d);
+            sdd = wfv_add(sdd, wfv_mul(d, d));
+            sq  = wfv_add(sq, wfv_mul(v, v));
+            d2  = wfv_add(d2, wfv_mul(s, s));
+            cr  = wfv_add(cr, wfv_cross(v, prev, vL));
+            lo  = wfv_min(lo, v);
+            hi  = wfv_max(hi, v);
+        }
+        for (; i < end; ++i) {
+            const double v = x[i], d = v - K, s = v - x[i - 1];
+            tsd += d; tsdd += d * d; tsq += v * v; td2 += s * s;
+            tcr += (v >= level) != (x[i - 1] >= level);
+            if (v < tlo) tlo = v;
+            if (v > thi) thi = v;
+        }
+        if (g) bank_run(g, x + start, end - start);
+    }
+
+    double l[WF_LANES], h[WF_LANES];
+    wfv_store(l, lo);
+    wfv_store(h, hi);
+    for (int j = 0; j < WF_LANES; ++j) {
+        if (l[j] < tlo) tlo = l[j];
+        if (h[j] > thi) thi = h[j];
+    }
+    r->sd = hsum(sd) + tsd;
+    r->sdd = hsum(sdd) + tsdd;
+    r->sq = hsum(sq) + tsq;
+    r->d2 = hsum(d2) + td2;
+    r->cross = hsum(cr) + tcr;
+    r->lo = tlo;
+    r->hi = thi;
+}
+
+static double absdev_sum(const double* x, int n, double m) {
+    const wfv vm = wfv_set1(m);
+    wfv a0 = wfv_set1(0.0), a1 = a0;
+    int i = 0;
+    for (; i + 2 * WF_LANES <= n; i += 2 * WF_LANES) {
+        a0 = wfv_add(a0, wfv_abs(wfv_sub(wfv_load(x + i), vm)));
+        a1 = wfv_add(a1, wfv_abs(wfv_sub(wfv_load(x + i + WF_LANES), vm)));
+    }
+    double s = hsum(wfv_add(a0, a1));
+    for (; i < n; ++i) s += fabs(x[i] - m);
+    return s;
+}
+
+// Moments from shifted sums over n samples.
+static void finish(wf_features_t* f, int n, double shift, double sd, double sdd,
+                   double sq, double d2) {
+    const double v = (sdd - sd * sd / n) / n;
+    f->n = n;
+    f->mean = shift + sd / n;
+    f->var = v > 0 ? v : 0.0;
+    f->rmssd = n >= 2 ? sqrt(d2 > 0 ? d2 / (n - 1) : 0.0) : NAN;
+    f->energy = sq > 0 ? sq / n : 0.0;
+}
+
+int wf_compute(const wf_plan_t* p, const double* x, int n, unsigned flags, wf_features_t* out) {
+    if (!out) return -1;
+    set_nan(out);
+    if (!x || n < 1) return -1;
+
+    const int bands = p && p->n == n && p->bins > 0;
+    bank_t g;
+    if (bands) bank_init(&g, p);
+    sums_t r;
+    fused_pass(x, n, p ? p->level : 0.0, bands ? &g : NULL, &r);
+
+    finish(out, n, x[0], r.sd, r.sdd, r.sq, r.d2);
+    out->min = r.lo;
+    out->max = r.hi;
+    out->crossings = (int)r.cross;
+    if (p && p->n == n) {
+        for (int b = 0; b < p->bands; ++b) out->band[b] = 0.0;
+        if (bands) bank_power(&g, p, n, out->band);
+    }
+    if (flags & WF_MAD) out->mad = absdev_sum(x, n, out->mean) / n;
+    return 0;
+}
+
+// ---- sliding window ----
+
+int wf_stream_init(wf_stream_t* s, const wf_plan_t* p, int resyncEvery) {
+    if (!s || !p) return -1;
+    memset(s, 0, sizeof(*s));
+    if (p->n < 2 || p->n > WF_MAX_N) return -1;
+    s->plan = *p;
+    s->resyncEvery = resyncEvery > 0 ? resyncEvery : 4 * p->n;
+    for (int b = 0; b < p->bins; ++b) {
+        const double w = 2.0 * M_PI * p->k[b] / p->n;
+        s->wr[b] = cos(w);
+        s->wi[b] = sin(w);
+    }
+    wf_stream_reset(s);
+    return 0;
+}
+
+void wf_stream_reset(wf_stream_t* s) {
+    s->head = s->count = 0;
+    s->seq = 0;
+    s->shift = s->sd = s->sdd = s->sq = s->d2 = 0;
+    s->crossings = 0;
+    s->minHead = s->minLen = s->maxHead = s->maxLen = 0;
+    memset(s->re, 0, sizeof(s->re));
+    memset(s->im, 0, sizeof(s->im));
+    s->sinceResync = 0;
+}
+
+static inline int wrap(int i, int n) { return i >= n ? i - n : i; }
+
+// Window as at most two contiguous runs, oldest first.
+static int spans(const wf_stream_t* s, const double** a, int* na, const double** b) {
+    const int N = s->plan.n;
+    *a = s->ring + s->head;
+    *na = s->count < N - s->head ? s->count : N - s->head;
+    *b = s->ring;
+    return s->count - *na;
+}
+
+// Re-centre on the current mean and recompute every sum and bin from the
+// window. The bins see the window zero-padded to N at the old end.
+static void resync(wf_stream_t* s) {
+    s->sinceResync = 0;
+    if (s->count == 0) return;
+    const int N = s->plan.n, n = s->count;
+    const double shift = s->shift + s->sd / n;
+    double sd = 0, sdd = 0, sq = 0, d2 = 0;
+    double re[WF_MAX_BINS] = {0}, im[WF_MAX_BINS] = {0};
+    double pr[WF_MAX_BINS], pi[WF_MAX_BINS];   // e^{-j 2 pi k m / N}
+    for (int b = 0; b < s->plan.bins; ++b) {
+        const double w = 2.0 * M_PI * s->plan.k[b] * (N - n) / N;
+        pr[b] = cos(w);
+        pi[b] = -sin(w);
+    }
+    double prev = 0;
+    for (int i = 0; i < n; ++i) {
+        const double v = s->ring[wrap(s->head + i, N)];
+        const double d = v - shift;
+        sd += d; sdd += d * d; sq += v * v;
+        if (i) d2 += (v - prev) * (v - prev);
+        prev = v;
+        for (int b = 0; b < s->plan.bins; ++b) {
+            re[b] += v * pr[b];
+            im[b] += v * pi[b];
+            const double r = pr[b] * s->wr[b] + pi[b] * s->wi[b];   // times e^{-j w}
+            pi[b] = pi[b] * s->wr[b] - pr[b] * s->wi[b];
+            pr[b] = r;
+        }
+    }
+    s->shift = shift;
+    s->sd = sd; s->sdd = sdd; s->sq = sq; s->d2 = d2;
+    memcpy(s->re, re, sizeof(re));
+    memcpy(s->im, im, sizeof(im));
+}
+
+void wf_stream_push(wf_stream_t* s, double x) {
+    const int N = s->plan.n;
+    const double L = s->plan.level;
+    double old = 0.0;
+    int slot;
+    if (s->count == N) {
+        old = s->ring[s->head];
+        const double next = s->ring[wrap(s->head + 1, N)];
+        const double d = old - s->shift, st = next - old;
+        s->sd -= d; s->sdd -= d * d; s->sq -= old * old;
+        s->d2 -= st * st;
+        s->crossings -= (old >= L) != (next >= L);
+        slot = s->head;
+        s->head = wrap(s->head + 1, N);
+    } else {
+        if (s->count == 0) s->shift = x;
+        slot = s->count++;
+    }
+    if (s->count > 1) {
+        const double last = s->ring[slot == 0 ? N - 1 : slot - 1];
+        s->d2 += (x - last) * (x - last);
+        s->crossings += (last >= L) != (x >= L);
+    }
+    s->ring[slot] = x;
+    const double d = x - s->shift;
+    s->sd += d; s->sdd += d * d; s->sq += x * x;
+
+    // Monotonic deques; the window start moves by at most one per push.
+    const uint64_t t = s->seq++, first = s->seq - (uint64_t)s->count;
+    if (s->minLen && s->minq[s->minHead].seq < first) { s->minHead = wrap(s->minHead + 1, N); --s->minLen; }
+    if (s->maxLen && s->maxq[s->maxHead].seq < first) { s->maxHead = wrap(s->maxHead + 1, N); --s->maxLen; }
+    while (s->minLen && !(s->minq[wrap(s->minHead + s->minLen - 1, N)].v < x)) --s->minLen;
+    while (s->maxLen && !(s->maxq[wrap(s->maxHead + s->maxLen - 1, N)].v > x)) --s->maxLen;
+    const int mi = wrap(s->minHead + s->minLen++, N), ma = wrap(s->maxHead + s->maxLen++, N);
+    s->minq[mi].seq = t; s->minq[mi].v = x;
+    s->maxq[ma].seq = t; s->maxq[ma].v = x;
+
+    // Sliding DFT: S_k <- e^{j 2 pi k / N} (S_k + x - x_old).
+    for (int b = 0; b < s->plan.bins; ++b) {
+        const double a = s->re[b] + x - old, c = s->im[b];
+        s->re[b] = a * s->wr[b] - c * s->wi[b];
+        s->im[b] = a * s->wi[b] + c * s->wr[b];
+    }
+
+    if (++s->sinceResync >= s->resyncEvery) resync(s);
+}
+
+void wf_stream_push_block(wf_stream_t* s, const double* x, int n) {
+    for (int i = 0; i < n; ++i) wf_stream_push(s, x[i]);
+}
+
+int wf_stream_features(const wf_stream_t* s, unsigned flags, wf_features_t* out) {
+    if (!out) return -1;
+    set_nan(out);
+    if (!s || s->count == 0) return -1;
+    const int n = s->count, N = s->plan.n;
+    finish(out, n, s->shift, s->sd, s->sdd, s->sq, s->d2);
+    out->min = s->minq[s->minHead].v;
+    out->max = s->maxq[s->maxHead].v;
+    out->crossings = s->crossings;
+    for (int b = 0; b < s->plan.bands; ++b) out->band[b] = 0.0;
+    for (int b = 0; b < s->plan.bins; ++b)
+        out->band[s->plan.bandOf[b]] += (s->re[b] * s->re[b] + s->im[b] * s->im[b]) / N;
+    if (flags & WF_MAD) {
+        const double* a; const double* b; int na;
+        const int nb = spans(s, &a, &na, &b);
+        out->mad = (absdev_sum(a, na, out->mean) + absdev_sum(b, nb, out->mean)) / n;
+    }
+    return 0;
+}
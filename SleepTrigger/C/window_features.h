@@ -0,0 +1,112 @@
+//
+//  window_features.h
+//  SleepTrigger
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Summary features of a window of samples, computed in one fused pass:
+//  mean, variance, RMSSD, min / max, level crossings, energy and the power
+//  in up to WF_MAX_BANDS frequency bands. The pass runs in SIMD lanes
+//  (AVX2 / SSE2 / NEON, chosen at compile time) with one accumulator set per
+//  lane; the band bins run as Goertzel recurrences side by side in the same
+//  loop. Mean absolute deviation needs the mean first, so it costs a second
+//  (vectorised) sweep and is only computed when asked for with WF_MAD.
+//
+//  Moments are accumulated about the first sample (shifted data) in double,
+//  so a large common offset (resting HR, a gravity baseline) costs the
+//  variance no precision; a plain sum / sum-of-squares pass loses it to
+//  cancellation.
+//
+//  wf_stream_* keeps the same features over a sliding window of the last N
+//  samples in O(1 + bins) per push: running shifted sums, monotonic deques
+//  for min / max, and a sliding DFT for the band bins. Round-off is cleared
+//  by recomputing everything from the window every `resyncEvery` pushes.
+//
+
+#ifndef WINDOW_FEATURES_H
+#define WINDOW_FEATURES_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WF_MAX_BANDS 4
+#define WF_MAX_BINS  16      // DFT bins over all bands together
+#define WF_MAX_N     256     // streaming window capacity
+
+/// Flags for features that are not part of the fused pass.
+#define WF_MAD 1u
+
+typedef struct {
+    int    n;                    // samples the features describe
+    double mean;
+    double var;                  // population variance
+    double rmssd;                // RMS of successive differences, NaN if n < 2
+    double min, max;
+    double mad;                  // mean |x - mean|, NaN without WF_MAD
+    double energy;               // mean square, sum(x^2) / n
+    int    crossings;            // neighbours on opposite sides of `level`
+    double band[WF_MAX_BANDS];   // sum of |X_k|^2 / N over the band's bins
+} wf_features_t;
+
+/// Bands resolved to DFT bins for windows of exactly n samples.
+typedef struct {
+    int    n;
+    double level;                // crossing level (x >= level counts as above)
+    int    bands;
+    int    bins;
+    int    k[WF_MAX_BINS];       // bin index, 1..n/2
+    int    bandOf[WF_MAX_BINS];
+    double coeff[WF_MAX_BINS];   // 2 cos(2 pi k / n)
+} wf_plan_t;
+
+/// Band b covers the bins k (1 <= k <= n/2) with k * fs / n in [lo[b], hi[b]].
+/// A band too narrow to hold a bin reports 0. Returns 0, or -1 if n < 2,
+/// fs <= 0, bands is outside 0..WF_MAX_BANDS or the bands need more than
+/// WF_MAX_BINS bins between them.
+int  wf_plan_init(wf_plan_t* p, int n, double fs,
+                  const double* lo, const double* hi, int bands, double level);
+
+/// Features of x[0..n). p may be NULL (no bands, crossings about 0); bands
+/// are only filled when n == p->n and are NaN otherwise. Returns 0, or -1
+/// (out set to NaN) if x is NULL or n < 1.
+int  wf_compute(const wf_plan_t* p, const double* x, int n, unsigned flags, wf_features_t* out);
+
+/// Lanes per vector in the fused pass (1 = scalar build).
+int  wf_simd_lanes(void);
+
+// ---- sliding window ----
+
+typedef struct {
+    wf_plan_t plan;              // plan.n is the window length N
+    double    ring[WF_MAX_N];
+    int       head;              // slot of the oldest sample once full
+    int       count;
+    uint64_t  seq;               // samples pushed since reset
+    double    shift, sd, sdd;    // sums of (x - shift) and its square
+    double    sq, d2;            // sums of x^2 and of squared steps
+    int       crossings;
+    struct { uint64_t seq; double v; } minq[WF_MAX_N], maxq[WF_MAX_N];
+    int       minHead, minLen, maxHead, maxLen;
+    double    re[WF_MAX_BINS], im[WF_MAX_BINS];
+    double    wr[WF_MAX_BINS], wi[WF_MAX_BINS];   // e^{j 2 pi k / N}
+    int       resyncEvery, sinceResync;
+} wf_stream_t;
+
+/// Window length p->n (2..WF_MAX_N), with p's bands and level. resyncEvery
+/// 0 selects 4N. Returns 0 or -1.
+int  wf_stream_init(wf_stream_t* s, const wf_plan_t* p, int resyncEvery);
+void wf_stream_reset(wf_stream_t* s);
+void wf_stream_push(wf_stream_t* s, double x);
+void wf_stream_push_block(wf_stream_t* s, const double* x, int n);
+/// Features of the samples now in the window (fewer than N while filling;
+/// the band bins then see the window zero-padded at the old end). WF_MAD
+/// sweeps the window. Returns 0, or -1 (out set to NaN) when empty.
+int  wf_stream_features(const wf_stream_t* s, unsigned flags, wf_features_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* WINDOW_FEATURES_H */
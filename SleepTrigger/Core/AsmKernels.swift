@@ -10,14 +10,15 @@ import Foundation
 import Accelerate
 #endif
 
-// Declare the assembly routine only on real watchOS hardware.
-// (No symbol gets emitted on iOS/macOS or on the watch simulator.)
-#if os(watchOS) && !targetEnvironment(simulator)
+// The watch target links the C kernel library (dot_f32_accel → vk_dot_f32,
+// NEON on device, dispatched SIMD/scalar on the simulator); other targets
+// don't carry that code.
+#if os(watchOS)
 @_silgen_name("dot_f32_accel")
 private func dot_f32_accel(
     _ a: UnsafePointer<Float>?,
     _ b: UnsafePointer<Float>?,
-    _ n: Int32
+    _ n: Int                      // size_t
 ) -> Float
 #endif
 
@@ -25,16 +26,16 @@ private func dot_f32_accel(
 enum AsmKernels {
 
     /// Dot product of two `Float` vectors.
-    /// Uses NEON assembly on real Apple Watch hardware; otherwise falls back.
+    /// Uses the watch kernel library on watchOS; Accelerate elsewhere.
     static func dot(_ a: [Float], _ b: [Float]) -> Float {
         precondition(a.count == b.count, "Mismatched lengths")
 
-        // --- Fast path: assembly on real watchOS device ---
-        #if os(watchOS) && !targetEnvironment(simulator)
+        // --- Fast path: watch kernel library ---
+        #if os(watchOS)
         return a.withUnsafeBufferPointer { ap in
             b.withUnsafeBufferPointer { bp in
                 guard let pa = ap.baseAddress, let pb = bp.baseAddress else { return 0 }
-                return dot_f32_accel(pa, pb, Int32(a.count))
+                return dot_f32_accel(pa, pb, a.count)
             }
         }
         #else
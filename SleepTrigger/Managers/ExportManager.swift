@@ -28,38 +28,40 @@ enum ExportManager {
     static func exportHistoryCSVSync(days: Int = 90) -> URL? {
         let rows = HistoryDAO.recentDailyCounts(days)
 
-        var csv = "date,count\n"
-
         // Stable ascending order
         let sorted = rows.sorted { $0.0 < $1.0 }
 
-        let fmt = iso8601Formatter
-        for (d, c) in sorted {
-            csv += "\(fmt.string(from: d)),\(c)\n"
-        }
-
         // Unique file name to avoid collisions in the temp directory.
         let filename = "sleep_history_\(timestampFormatter.string(from: Date())).csv"
         let url = FileManager.default.temporaryDirectory.appendingPathComponent(filename)
 
-        do {
-            try csv.write(to: url, atomically: true, encoding: .utf8)
-            return url
-        } catch {
-            print("ExportManager: CSV write failed: \(error)")
+        // Streamed through export_stream.c (fixed buffer, temp file + rename,
+        // same ISO8601 text as ISO8601DateFormatter with fractional seconds).
+        var w = es_writer_t()
+        guard es_open(&w, url.path, 0) == 0 else {
+            print("ExportManager: CSV open failed: errno \(errno)")
+            return nil
+        }
+        es_puts(&w, "date,count\n")
+        for (d, c) in sorted {
+            es_put_iso8601(&w, d.timeIntervalSince1970)
+            es_putc(&w, comma)
+            es_put_i64(&w, Int64(c))
+            es_putc(&w, newline)
+        }
+        guard es_close(&w) == 0 else {
+            print("ExportManager: CSV write failed: errno \(errno)")
             return nil
         }
+        return url
     }
 
     // MARK: - Helpers
 
-    /// Reuse formatters (they’re expensive to create).
-    private static let iso8601Formatter: ISO8601DateFormatter = {
-        let f = ISO8601DateFormatter()
-        f.formatOptions = [.withInternetDateTime, .withFractionalSeconds]
-        return f
-    }()
+    private static let comma = Int32(UInt8(ascii: ","))
+    private static let newline = Int32(UInt8(ascii: "\n"))
 
+    /// Reuse formatters (they’re expensive to create).
     private static let timestampFormatter: DateFormatter = {
         let f = DateFormatter()
         f.dateFormat = "yyyyMMdd_HHmmss"
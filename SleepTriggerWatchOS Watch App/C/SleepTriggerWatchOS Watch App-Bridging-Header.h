@@ -9,9 +9,16 @@
 // New
 #import "HMMWrapper.h"
 #import "EKFWrapper.h"
+#import "RingWindowWrapper.h"
+#import "MotionFrontEndWrapper.h"
 #include "robust_stats.h"
+#include "time_window.h"
+#include "sample_queue.h"
+#include "frame_align.h"
 #include "respiration.h"
 #include "spectral.h"
 #include "duty_control.h"
 #include "ringlog.h"
+#include "nightlog.h"
+#include "export_stream.h"
 #include "tinyml_motion.h"
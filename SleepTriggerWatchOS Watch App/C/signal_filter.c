@@ -46,6 +46,24 @@ float iir1_update(iir1_t *f, float x) {
     return f->y;
 }
 
+void iir1_process_block(iir1_t *f, const float *in, float *out, size_t n) {
+    if (!f || !in || !out || n == 0) return;
+    size_t i = 0;
+    if (!f->initialized) {
+        f->y = in[0];
+        f->initialized = 1;
+        out[0] = in[0];
+        i = 1;
+    }
+    const float a = f->alpha;
+    float y = f->y;
+    for (; i < n; ++i) {
+        y = (1.0f - a) * y + a * in[i];
+        out[i] = y;
+    }
+    f->y = y;
+}
+
 float iir1_alpha_from_cutoff(float cutoff_hz, float dt_seconds) {
     if (cutoff_hz <= 0.0f)     return 1.0f; // "no smoothing" fallback
     if (dt_seconds <= 0.0f)    return 1.0f;
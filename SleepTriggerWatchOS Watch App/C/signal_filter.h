@@ -8,6 +8,8 @@
 #ifndef SIGNAL_FILTER_H
 #define SIGNAL_FILTER_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -33,6 +35,10 @@ void  iir1_set_alpha(iir1_t *f, float alpha);
 /// Single update step. If uninitialized, seeds y with x and returns x.
 float iir1_update(iir1_t *f, float x);
 
+/// Block update: out[i] = iir1_update(f, in[i]) for i < n, bit-identical to the
+/// per-sample path but with state held in registers. `out` may alias `in`.
+void  iir1_process_block(iir1_t *f, const float *in, float *out, size_t n);
+
 /// Utility: compute alpha from a desired low-pass cutoff (Hz) and sample
 /// period dt (seconds). Uses RC = 1 / (2π fc), alpha = dt / (RC + dt).
 float iir1_alpha_from_cutoff(float cutoff_hz, float dt_seconds);
@@ -16,6 +16,7 @@ NS_ASSUME_NONNULL_BEGIN
                negSlope:(double)negSlope
              respQuiet:(double)respQuiet
               vlfPower:(double)vlfPower; // returns propensity 0..1
+@property (nonatomic, readonly) double variance;  // KF1::P after the last update
 @end
 
 NS_ASSUME_NONNULL_END
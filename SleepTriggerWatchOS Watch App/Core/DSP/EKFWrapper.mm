@@ -24,4 +24,5 @@
   double z = st::fuseFeatures(drop, still, negSlope, respQuiet, vlfPower);
   return _kf.update(z);
 }
+- (double)variance { return _kf.P; }
 @end
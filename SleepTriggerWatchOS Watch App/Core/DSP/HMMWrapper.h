@@ -12,6 +12,10 @@ NS_ASSUME_NONNULL_BEGIN
 @interface HMMWrapper : NSObject
 - (instancetype)init;
 - (int)stepWithObservation:(NSInteger)obs; // 0=awake,1=drowsy,2=asleep
+// Fixed-lag smoothed state for the observation `smoothingLag` steps back,
+// or -1 until enough observations have arrived. Independent of the above.
+- (int)smoothedStepWithObservation:(NSInteger)obs;
+@property (class, nonatomic, readonly) NSInteger smoothingLag;
 @end
 
 NS_ASSUME_NONNULL_END
@@ -8,12 +8,20 @@
 #import "HMMWrapper.h"
 #import "hmm.hpp"
 
-@interface HMMWrapper () { st::HMM3 _hmm; }
+static constexpr int kSmoothingLag = 8;
+
+@interface HMMWrapper () {
+  st::HMM3 _hmm;
+  st::FixedLagViterbi<3, 3, kSmoothingLag> _smoother;
+}
 @end
 
 @implementation HMMWrapper
 - (instancetype)init {
-  if ((self = [super init])) { _hmm.setDefault(); }
+  if ((self = [super init])) {
+    _hmm.setDefault();
+    _smoother.setTables(st::kSleepHMM3Tables);
+  }
   return self;
 }
 - (int)stepWithObservation:(NSInteger)obs {
@@ -21,4 +29,8 @@
   if (o<0) o=0; if (o>2) o=2;
   return _hmm.step(o);
 }
+- (int)smoothedStepWithObservation:(NSInteger)obs {
+  return _smoother.step((int)obs);   // clamps to 0..2 itself
+}
++ (NSInteger)smoothingLag { return kSmoothingLag; }
 @end
@@ -21,4 +21,16 @@ public final class KalmanFilter1D {
     public func update(_ z: Double) -> Double {
         core.update(z)
     }
+
+    /// Filters a block of measurements in one bridged call.
+    public func update(_ zs: [Double]) -> [Double] {
+        var out = [Double](repeating: 0, count: zs.count)
+        zs.withUnsafeBufferPointer { src in
+            out.withUnsafeMutableBufferPointer { dst in
+                guard let s = src.baseAddress, let d = dst.baseAddress else { return }
+                core.updateBlock(s, output: d, count: zs.count)
+            }
+        }
+        return out
+    }
 }
@@ -17,4 +17,7 @@ NS_SWIFT_NAME(KalmanWrapper)
 
 - (double)update:(double)z;
 
+// Filters `count` measurements in one call; `output` may alias `input`.
+- (void)updateBlock:(const double *)input output:(double *)output count:(NSInteger)count;
+
 @end
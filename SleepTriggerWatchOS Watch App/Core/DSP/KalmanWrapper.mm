@@ -33,4 +33,9 @@ extern "C" {
     return kalman1d_update(&_kf, z);
 }
 
+- (void)updateBlock:(const double *)input output:(double *)output count:(NSInteger)count {
+    if (count <= 0) return;
+    kalman1d_process_block(&_kf, input, output, (size_t)count);
+}
+
 @end
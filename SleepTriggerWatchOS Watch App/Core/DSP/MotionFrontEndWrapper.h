@@ -0,0 +1,27 @@
+//
+//  MotionFrontEndWrapper.h
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// st::MotionFrontEnd<5, 3, 2, 31>: 20 Hz acceleration magnitude in, CIC x5
+// and polyphase FIR x2 down to 2 Hz for respiration and breathing-band
+// power; 5 s stillness variance from block moments.
+@interface MotionFrontEndWrapper : NSObject
+@property (class, nonatomic, readonly) double inputRate;    // Hz
+@property (class, nonatomic, readonly) NSInteger decimation;
+@property (nonatomic, readonly) BOOL windowReady;           // last push closed a window
+@property (nonatomic, readonly) double windowVariance;      // population variance
+@property (nonatomic, readonly) double respirationBPM;      // 0 until two crossings
+@property (nonatomic, readonly) double breathingPower;      // Goertzel, last 16 s block
+// Returns YES when the push produced a 2 Hz sample.
+- (BOOL)push:(double)x at:(double)t;
+- (void)reset;
+@end
+
+NS_ASSUME_NONNULL_END
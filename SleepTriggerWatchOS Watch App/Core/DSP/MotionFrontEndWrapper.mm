@@ -0,0 +1,25 @@
+//
+//  MotionFrontEndWrapper.mm
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#import "MotionFrontEndWrapper.h"
+#import "decimate.hpp"
+
+using FrontEnd = st::MotionFrontEnd<5, 3, 2, 31>;
+
+@interface MotionFrontEndWrapper () { FrontEnd _fe; }
+@end
+
+@implementation MotionFrontEndWrapper
++ (double)inputRate { return st::MotionFrontEndConfig{}.fsIn; }
++ (NSInteger)decimation { return FrontEnd::decimation(); }
+- (BOOL)windowReady { return _fe.windowReady(); }
+- (double)windowVariance { return _fe.windowVariance(); }
+- (double)respirationBPM { return _fe.respirationBPM(); }
+- (double)breathingPower { return _fe.goertzelPower(); }
+- (BOOL)push:(double)x at:(double)t { return _fe.push(x, t); }
+- (void)reset { _fe.reset(); }
+@end
@@ -16,6 +16,9 @@ final class RingBufferF32 {
     deinit { ringf_free(&core) }
 
     @inline(__always) func push(_ x: Float) { ringf_push(&core, x) }
+    func push(contentsOf xs: [Float]) {
+        xs.withUnsafeBufferPointer { ringf_push_block(&core, $0.baseAddress, xs.count) }
+    }
     @inline(__always) var mean: Float { ringf_mean(&core) }
     @inline(__always) var count: Int { Int(ringf_count(&core)) }
     func clear() { ringf_clear(&core) }
@@ -0,0 +1,28 @@
+//
+//  RingWindowWrapper.h
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Last 64 float samples (st::Ring<float, 64>) with O(1) mean, variance,
+// min and max. Replaces RingBufferF32 for SleepMonitor's windows.
+@interface RingWindowWrapper : NSObject
+@property (class, nonatomic, readonly) NSInteger capacity;
+@property (nonatomic, readonly) NSInteger count;
+@property (nonatomic, readonly) double mean;
+@property (nonatomic, readonly) double variance;  // sample variance, 0 if count < 2
+@property (nonatomic, readonly) float min;        // 0 when empty
+@property (nonatomic, readonly) float max;        // 0 when empty
+- (void)push:(float)x;
+- (void)pushBlock:(const float *)x count:(NSInteger)count;
+// Σ window[i] * weights[i], oldest first; weights holds `count` floats.
+- (float)dotWithWeights:(const float *)weights;
+- (void)clear;
+@end
+
+NS_ASSUME_NONNULL_END
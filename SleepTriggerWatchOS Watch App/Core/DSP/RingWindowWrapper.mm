@@ -0,0 +1,29 @@
+//
+//  RingWindowWrapper.mm
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#import "RingWindowWrapper.h"
+#import "ring.hpp"
+
+using Window = st::Ring<float, 64>;
+
+@interface RingWindowWrapper () { Window _ring; }
+@end
+
+@implementation RingWindowWrapper
++ (NSInteger)capacity { return (NSInteger)Window::capacity(); }
+- (NSInteger)count { return (NSInteger)_ring.size(); }
+- (double)mean { return _ring.mean(); }
+- (double)variance { return _ring.variance(); }
+- (float)min { return _ring.empty() ? 0.0f : _ring.min(); }
+- (float)max { return _ring.empty() ? 0.0f : _ring.max(); }
+- (void)push:(float)x { _ring.push(x); }
+- (void)pushBlock:(const float *)x count:(NSInteger)count {
+  if (count > 0) _ring.push(x, (size_t)count);
+}
+- (float)dotWithWeights:(const float *)weights { return st::dot(_ring, weights); }
+- (void)clear { _ring.clear(); }
+@end
@@ -6,22 +6,10 @@
 //
 
 #include "asm_compat.h"
+#include "vec_kernels.h"
 
-static inline float dot_f32_c(const float* a, const float* b, size_t n) {
-    float acc = 0.f;
-    for (size_t i=0; i<n; ++i) acc += a[i] * b[i];
-    return acc;
-}
-
-// Declaration for the asm symbol (only exists on arm64 devices)
-#if defined(__aarch64__)
-extern float neon_dot_f32(const float* a, const float* b, size_t n);
-#endif
-
+// Kept for existing callers; routes through the runtime-dispatched kernel
+// table (NEON assembly on arm64, AVX-512/AVX2/SSE4.2 on x86, scalar otherwise).
 float dot_f32_accel(const float* a, const float* b, size_t n) {
-#if defined(__aarch64__) && !TARGET_OS_SIMULATOR
-    return neon_dot_f32(a, b, n);
-#else
-    return dot_f32_c(a, b, n);
-#endif
+    return vk_dot_f32(a, b, n);
 }
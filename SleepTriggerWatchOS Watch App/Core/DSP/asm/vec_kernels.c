@@ -0,0 +1,539 @@
+//
+//  vec_kernels.c
+//  SleepTriggerWatchOS Watch App
+//
+
+#include "vec_kernels.h"
+#include <math.h>
+#include <pthread.h>
+
+typedef struct {
+  vk_isa_t isa;
+  float (*dot)(const float*, const float*, size_t);
+  float (*sum)(const float*, size_t);
+  float (*sumsq)(const float*, size_t);
+  void  (*axpy)(float, const float*, float*, size_t);
+  void  (*axpby)(float, const float*, float, float*, size_t);
+  void  (*minmax)(const float*, size_t, float*, float*);
+  void  (*gemv_s8)(const int8_t*, size_t, const int8_t*, size_t, size_t, int32_t*);
+} vk_ops_t;
+
+// ---------------- scalar (4 accumulators) ----------------
+
+static float dot_scalar(const float* a, const float* b, size_t n) {
+  float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    s0 += a[i] * b[i];     s1 += a[i+1] * b[i+1];
+    s2 += a[i+2] * b[i+2]; s3 += a[i+3] * b[i+3];
+  }
+  for (; i < n; ++i) s0 += a[i] * b[i];
+  return (s0 + s1) + (s2 + s3);
+}
+
+static float sum_scalar(const float* x, size_t n) {
+  float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) { s0 += x[i]; s1 += x[i+1]; s2 += x[i+2]; s3 += x[i+3]; }
+  for (; i < n; ++i) s0 += x[i];
+  return (s0 + s1) + (s2 + s3);
+}
+
+static float sumsq_scalar(const float* x, size_t n) { return dot_scalar(x, x, n); }
+
+static void axpy_scalar(float a, const float* x, float* y, size_t n) {
+  for (size_t i = 0; i < n; ++i) y[i] += a * x[i];
+}
+
+static void axpby_scalar(float a, const float* x, float b, float* y, size_t n) {
+  for (size_t i = 0; i < n; ++i) y[i] = a * x[i] + b * y[i];
+}
+
+static void minmax_scalar(const float* x, size_t n, float* mn, float* mx) {
+  float lo = INFINITY, hi = -INFINITY;
+  for (size_t i = 0; i < n; ++i) {
+    if (x[i] < lo) lo = x[i];
+    if (x[i] > hi) hi = x[i];
+  }
+  *mn = lo; *mx = hi;
+}
+
+static void gemv_s8_scalar(const int8_t* W, size_t stride, const int8_t* x, size_t n, size_t rows, int32_t* y) {
+  for (size_t r = 0; r < rows; ++r) {
+    const int8_t* w = W + r * stride;
+    int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+      s0 += w[k] * x[k];     s1 += w[k+1] * x[k+1];
+      s2 += w[k+2] * x[k+2]; s3 += w[k+3] * x[k+3];
+    }
+    for (; k < n; ++k) s0 += w[k] * x[k];
+    y[r] = (s0 + s1) + (s2 + s3);
+  }
+}
+
+static const vk_ops_t k_scalar = {
+  VK_ISA_SCALAR, dot_scalar, sum_scalar, sumsq_scalar, axpy_scalar, axpby_scalar, minmax_scalar,
+  gemv_s8_scalar
+};
+
+// ---------------- NEON ----------------
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+
+extern float neon_dot_f32(const float* a, const float* b, size_t n); // neon_dot.S
+
+static float sum_neon(const float* x, size_t n) {
+  float32x4_t s0 = vdupq_n_f32(0), s1 = s0, s2 = s0, s3 = s0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    s0 = vaddq_f32(s0, vld1q_f32(x + i));
+    s1 = vaddq_f32(s1, vld1q_f32(x + i + 4));
+    s2 = vaddq_f32(s2, vld1q_f32(x + i + 8));
+    s3 = vaddq_f32(s3, vld1q_f32(x + i + 12));
+  }
+  for (; i + 4 <= n; i += 4) s0 = vaddq_f32(s0, vld1q_f32(x + i));
+  float s = vaddvq_f32(vaddq_f32(vaddq_f32(s0, s1), vaddq_f32(s2, s3)));
+  for (; i < n; ++i) s += x[i];
+  return s;
+}
+
+static float sumsq_neon(const float* x, size_t n) { return neon_dot_f32(x, x, n); }
+
+static void axpy_neon(float a, const float* x, float* y, size_t n) {
+  float32x4_t va = vdupq_n_f32(a);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) vst1q_f32(y + i, vfmaq_f32(vld1q_f32(y + i), va, vld1q_f32(x + i)));
+  for (; i < n; ++i) y[i] += a * x[i];
+}
+
+static void axpby_neon(float a, const float* x, float b, float* y, size_t n) {
+  float32x4_t va = vdupq_n_f32(a), vb = vdupq_n_f32(b);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1q_f32(y + i, vfmaq_f32(vmulq_f32(vb, vld1q_f32(y + i)), va, vld1q_f32(x + i)));
+  for (; i < n; ++i) y[i] = a * x[i] + b * y[i];
+}
+
+static void minmax_neon(const float* x, size_t n, float* mn, float* mx) {
+  float32x4_t lo = vdupq_n_f32(INFINITY), hi = vdupq_n_f32(-INFINITY);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t v = vld1q_f32(x + i);
+    lo = vminq_f32(lo, v); hi = vmaxq_f32(hi, v);
+  }
+  float l = vminvq_f32(lo), h = vmaxvq_f32(hi);
+  for (; i < n; ++i) { if (x[i] < l) l = x[i]; if (x[i] > h) h = x[i]; }
+  *mn = l; *mx = h;
+}
+
+// SDOT (ARMv8.2 dot product) where the target has it, else widening
+// multiply + pairwise accumulate.
+static void gemv_s8_neon(const int8_t* W, size_t stride, const int8_t* x, size_t n, size_t rows, int32_t* y) {
+  for (size_t r = 0; r < rows; ++r) {
+    const int8_t* w = W + r * stride;
+    int32x4_t s0 = vdupq_n_s32(0), s1 = s0;
+    size_t k = 0;
+#if defined(__ARM_FEATURE_DOTPROD)
+    for (; k + 32 <= n; k += 32) {
+      s0 = vdotq_s32(s0, vld1q_s8(w + k),      vld1q_s8(x + k));
+      s1 = vdotq_s32(s1, vld1q_s8(w + k + 16), vld1q_s8(x + k + 16));
+    }
+    for (; k + 16 <= n; k += 16) s0 = vdotq_s32(s0, vld1q_s8(w + k), vld1q_s8(x + k));
+#else
+    for (; k + 16 <= n; k += 16) {
+      const int8x16_t a = vld1q_s8(w + k), b = vld1q_s8(x + k);
+      s0 = vpadalq_s16(s0, vmull_s8(vget_low_s8(a), vget_low_s8(b)));
+      s1 = vpadalq_s16(s1, vmull_high_s8(a, b));
+    }
+#endif
+    int32_t s = vaddvq_s32(vaddq_s32(s0, s1));
+    for (; k < n; ++k) s += w[k] * x[k];
+    y[r] = s;
+  }
+}
+
+static const vk_ops_t k_neon = {
+  VK_ISA_NEON, neon_dot_f32, sum_neon, sumsq_neon, axpy_neon, axpby_neon, minmax_neon,
+  gemv_s8_neon
+};
+#endif
+
+// ---------------- x86: SSE4.2 / AVX2 / AVX-512 ----------------
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define VK_X86 1
+
+#define VK_SSE42  __attribute__((target("sse4.2")))
+#define VK_AVX2   __attribute__((target("avx2,fma")))
+#define VK_AVX512 __attribute__((target("avx512f")))
+
+VK_SSE42 static float hsum128(__m128 v) {
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+  return _mm_cvtss_f32(v);
+}
+
+VK_SSE42 static float dot_sse42(const float* a, const float* b, size_t n) {
+  __m128 s0 = _mm_setzero_ps(), s1 = s0, s2 = s0, s3 = s0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i),      _mm_loadu_ps(b + i)));
+    s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4),  _mm_loadu_ps(b + i + 4)));
+    s2 = _mm_add_ps(s2, _mm_mul_ps(_mm_loadu_ps(a + i + 8),  _mm_loadu_ps(b + i + 8)));
+    s3 = _mm_add_ps(s3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_loadu_ps(b + i + 12)));
+  }
+  for (; i + 4 <= n; i += 4) s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  float s = hsum128(_mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+  for (; i < n; ++i) s += a[i] * b[i];
+  return s;
+}
+
+VK_SSE42 static float sum_sse42(const float* x, size_t n) {
+  __m128 s0 = _mm_setzero_ps(), s1 = s0, s2 = s0, s3 = s0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    s0 = _mm_add_ps(s0, _mm_loadu_ps(x + i));
+    s1 = _mm_add_ps(s1, _mm_loadu_ps(x + i + 4));
+    s2 = _mm_add_ps(s2, _mm_loadu_ps(x + i + 8));
+    s3 = _mm_add_ps(s3, _mm_loadu_ps(x + i + 12));
+  }
+  for (; i + 4 <= n; i += 4) s0 = _mm_add_ps(s0, _mm_loadu_ps(x + i));
+  float s = hsum128(_mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3)));
+  for (; i < n; ++i) s += x[i];
+  return s;
+}
+
+VK_SSE42 static float sumsq_sse42(const float* x, size_t n) { return dot_sse42(x, x, n); }
+
+VK_SSE42 static void axpy_sse42(float a, const float* x, float* y, size_t n) {
+  __m128 va = _mm_set1_ps(a);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+  for (; i < n; ++i) y[i] += a * x[i];
+}
+
+VK_SSE42 static void axpby_sse42(float a, const float* x, float b, float* y, size_t n) {
+  __m128 va = _mm_set1_ps(a), vb = _mm_set1_ps(b);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    _mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(va, _mm_loadu_ps(x + i)),
+                                    _mm_mul_ps(vb, _mm_loadu_ps(y + i))));
+  for (; i < n; ++i) y[i] = a * x[i] + b * y[i];
+}
+
+VK_SSE42 static void minmax_sse42(const float* x, size_t n, float* mn, float* mx) {
+  __m128 lo = _mm_set1_ps(INFINITY), hi = _mm_set1_ps(-INFINITY);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_loadu_ps(x + i);
+    lo = _mm_min_ps(lo, v); hi = _mm_max_ps(hi, v);
+  }
+  float l[4], h[4];
+  _mm_storeu_ps(l, lo); _mm_storeu_ps(h, hi);
+  float L = l[0], H = h[0];
+  for (int k = 1; k < 4; ++k) { if (l[k] < L) L = l[k]; if (h[k] > H) H = h[k]; }
+  for (; i < n; ++i) { if (x[i] < L) L = x[i]; if (x[i] > H) H = x[i]; }
+  *mn = L; *mx = H;
+}
+
+// w * x as |w| * sign(x, w): PMADDUBSW forms u8 * s8 pair sums in int16
+// (at most 2 * 127 * 127, so no saturation), PMADDWD widens them to int32.
+VK_SSE42 static inline __m128i dot16_s8(__m128i acc, __m128i w, __m128i x) {
+  const __m128i p = _mm_maddubs_epi16(_mm_abs_epi8(w), _mm_sign_epi8(x, w));
+  return _mm_add_epi32(acc, _mm_madd_epi16(p, _mm_set1_epi16(1)));
+}
+
+VK_SSE42 static int32_t hsum128_epi32(__m128i v) {
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0x4E));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, 0xB1));
+  return _mm_cvtsi128_si32(v);
+}
+
+VK_SSE42 static void gemv_s8_sse42(const int8_t* W, size_t stride, const int8_t* x, size_t n, size_t rows, int32_t* y) {
+  for (size_t r = 0; r < rows; ++r) {
+    const int8_t* w = W + r * stride;
+    __m128i s0 = _mm_setzero_si128(), s1 = s0;
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+      s0 = dot16_s8(s0, _mm_loadu_si128((const __m128i*)(w + k)),      _mm_loadu_si128((const __m128i*)(x + k)));
+      s1 = dot16_s8(s1, _mm_loadu_si128((const __m128i*)(w + k + 16)), _mm_loadu_si128((const __m128i*)(x + k + 16)));
+    }
+    for (; k + 16 <= n; k += 16)
+      s0 = dot16_s8(s0, _mm_loadu_si128((const __m128i*)(w + k)), _mm_loadu_si128((const __m128i*)(x + k)));
+    int32_t s = hsum128_epi32(_mm_add_epi32(s0, s1));
+    for (; k < n; ++k) s += w[k] * x[k];
+    y[r] = s;
+  }
+}
+
+static const vk_ops_t k_sse42 = {
+  VK_ISA_SSE42, dot_sse42, sum_sse42, sumsq_sse42, axpy_sse42, axpby_sse42, minmax_sse42,
+  gemv_s8_sse42
+};
+
+VK_AVX2 static float hsum256(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 0x55));
+  return _mm_cvtss_f32(s);
+}
+
+VK_AVX2 static float dot_avx2(const float* a, const float* b, size_t n) {
+  __m256 s0 = _mm256_setzero_ps(), s1 = s0, s2 = s0, s3 = s0;
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),      _mm256_loadu_ps(b + i),      s0);
+    s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),  _mm256_loadu_ps(b + i + 8),  s1);
+    s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), s2);
+    s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), s3);
+  }
+  for (; i + 8 <= n; i += 8) s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+  float s = hsum256(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+  for (; i < n; ++i) s += a[i] * b[i];
+  return s;
+}
+
+VK_AVX2 static float sum_avx2(const float* x, size_t n) {
+  __m256 s0 = _mm256_setzero_ps(), s1 = s0, s2 = s0, s3 = s0;
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    s0 = _mm256_add_ps(s0, _mm256_loadu_ps(x + i));
+    s1 = _mm256_add_ps(s1, _mm256_loadu_ps(x + i + 8));
+    s2 = _mm256_add_ps(s2, _mm256_loadu_ps(x + i + 16));
+    s3 = _mm256_add_ps(s3, _mm256_loadu_ps(x + i + 24));
+  }
+  for (; i + 8 <= n; i += 8) s0 = _mm256_add_ps(s0, _mm256_loadu_ps(x + i));
+  float s = hsum256(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+  for (; i < n; ++i) s += x[i];
+  return s;
+}
+
+VK_AVX2 static float sumsq_avx2(const float* x, size_t n) { return dot_avx2(x, x, n); }
+
+VK_AVX2 static void axpy_avx2(float a, const float* x, float* y, size_t n) {
+  __m256 va = _mm256_set1_ps(a);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+  for (; i < n; ++i) y[i] += a * x[i];
+}
+
+VK_AVX2 static void axpby_avx2(float a, const float* x, float b, float* y, size_t n) {
+  __m256 va = _mm256_set1_ps(a), vb = _mm256_set1_ps(b);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i),
+                                            _mm256_mul_ps(vb, _mm256_loadu_ps(y + i))));
+  for (; i < n; ++i) y[i] = a * x[i] + b * y[i];
+}
+
+VK_AVX2 static void minmax_avx2(const float* x, size_t n, float* mn, float* mx) {
+  __m256 lo = _mm256_set1_ps(INFINITY), hi = _mm256_set1_ps(-INFINITY);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 v = _mm256_loadu_ps(x + i);
+    lo = _mm256_min_ps(lo, v); hi = _mm256_max_ps(hi, v);
+  }
+  float l[8], h[8];
+  _mm256_storeu_ps(l, lo); _mm256_storeu_ps(h, hi);
+  float L = l[0], H = h[0];
+  for (int k = 1; k < 8; ++k) { if (l[k] < L) L = l[k]; if (h[k] > H) H = h[k]; }
+  for (; i < n; ++i) { if (x[i] < L) L = x[i]; if (x[i] > H) H = x[i]; }
+  *mn = L; *mx = H;
+}
+
+// Two rows per 256-bit step when rows are a single 16-byte chunk (the
+// motion MLP's shape), else 32 bytes of one row per step.
+VK_AVX2 static void gemv_s8_avx2(const int8_t* W, size_t stride, const int8_t* x, size_t n, size_t rows, int32_t* y) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  size_t r = 0;
+  if (n == 16) {
+    const __m256i xx = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)x));
+    for (; r + 2 <= rows; r += 2) {
+      const __m256i w = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(W + r * stride))),
+          _mm_loadu_si128((const __m128i*)(W + (r + 1) * stride)), 1);
+      const __m256i p = _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_abs_epi8(w), _mm256_sign_epi8(xx, w)), ones);
+      y[r]     = hsum128_epi32(_mm256_castsi256_si128(p));
+      y[r + 1] = hsum128_epi32(_mm256_extracti128_si256(p, 1));
+    }
+  }
+  for (; r < rows; ++r) {
+    const int8_t* w = W + r * stride;
+    __m256i s0 = _mm256_setzero_si256();
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+      const __m256i a = _mm256_loadu_si256((const __m256i*)(w + k));
+      const __m256i b = _mm256_loadu_si256((const __m256i*)(x + k));
+      s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_abs_epi8(a), _mm256_sign_epi8(b, a)), ones));
+    }
+    __m128i s1 = _mm_add_epi32(_mm256_castsi256_si128(s0), _mm256_extracti128_si256(s0, 1));
+    for (; k + 16 <= n; k += 16)
+      s1 = dot16_s8(s1, _mm_loadu_si128((const __m128i*)(w + k)), _mm_loadu_si128((const __m128i*)(x + k)));
+    int32_t s = hsum128_epi32(s1);
+    for (; k < n; ++k) s += w[k] * x[k];
+    y[r] = s;
+  }
+}
+
+static const vk_ops_t k_avx2 = {
+  VK_ISA_AVX2, dot_avx2, sum_avx2, sumsq_avx2, axpy_avx2, axpby_avx2, minmax_avx2,
+  gemv_s8_avx2
+};
+
+VK_AVX512 static float dot_avx512(const float* a, const float* b, size_t n) {
+  __m512 s0 = _mm512_setzero_ps(), s1 = s0, s2 = s0, s3 = s0;
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i),      _mm512_loadu_ps(b + i),      s0);
+    s1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), s1);
+    s2 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 32), _mm512_loadu_ps(b + i + 32), s2);
+    s3 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 48), _mm512_loadu_ps(b + i + 48), s3);
+  }
+  for (; i + 16 <= n; i += 16) s0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), s0);
+  if (i < n) {                                   // masked tail, no scalar loop
+    __mmask16 m = (__mmask16)((1u << (n - i)) - 1u);
+    s1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i), s1);
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3)));
+}
+
+VK_AVX512 static float sum_avx512(const float* x, size_t n) {
+  __m512 s0 = _mm512_setzero_ps(), s1 = s0, s2 = s0, s3 = s0;
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    s0 = _mm512_add_ps(s0, _mm512_loadu_ps(x + i));
+    s1 = _mm512_add_ps(s1, _mm512_loadu_ps(x + i + 16));
+    s2 = _mm512_add_ps(s2, _mm512_loadu_ps(x + i + 32));
+    s3 = _mm512_add_ps(s3, _mm512_loadu_ps(x + i + 48));
+  }
+  for (; i + 16 <= n; i += 16) s0 = _mm512_add_ps(s0, _mm512_loadu_ps(x + i));
+  if (i < n) {
+    __mmask16 m = (__mmask16)((1u << (n - i)) - 1u);
+    s1 = _mm512_add_ps(s1, _mm512_maskz_loadu_ps(m, x + i));
+  }
+  return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(s0, s1), _mm512_add_ps(s2, s3)));
+}
+
+VK_AVX512 static float sumsq_avx512(const float* x, size_t n) { return dot_avx512(x, x, n); }
+
+VK_AVX512 static void axpy_avx512(float a, const float* x, float* y, size_t n) {
+  __m512 va = _mm512_set1_ps(a);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+  if (i < n) {
+    __mmask16 m = (__mmask16)((1u << (n - i)) - 1u);
+    _mm512_mask_storeu_ps(y + i, m, _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(m, x + i),
+                                                    _mm512_maskz_loadu_ps(m, y + i)));
+  }
+}
+
+VK_AVX512 static void axpby_avx512(float a, const float* x, float b, float* y, size_t n) {
+  __m512 va = _mm512_set1_ps(a), vb = _mm512_set1_ps(b);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+    _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i),
+                                            _mm512_mul_ps(vb, _mm512_loadu_ps(y + i))));
+  if (i < n) {
+    __mmask16 m = (__mmask16)((1u << (n - i)) - 1u);
+    __m512 r = _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(m, x + i),
+                               _mm512_mul_ps(vb, _mm512_maskz_loadu_ps(m, y + i)));
+    _mm512_mask_storeu_ps(y + i, m, r);
+  }
+}
+
+VK_AVX512 static void minmax_avx512(const float* x, size_t n, float* mn, float* mx) {
+  __m512 lo = _mm512_set1_ps(INFINITY), hi = _mm512_set1_ps(-INFINITY);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 v = _mm512_loadu_ps(x + i);
+    lo = _mm512_min_ps(lo, v); hi = _mm512_max_ps(hi, v);
+  }
+  if (i < n) {
+    __mmask16 m = (__mmask16)((1u << (n - i)) - 1u);
+    lo = _mm512_mask_min_ps(lo, m, lo, _mm512_maskz_loadu_ps(m, x + i));
+    hi = _mm512_mask_max_ps(hi, m, hi, _mm512_maskz_loadu_ps(m, x + i));
+  }
+  *mn = _mm512_reduce_min_ps(lo);
+  *mx = _mm512_reduce_max_ps(hi);
+}
+
+// Byte-granular 512-bit ops need AVX-512BW; every AVX-512F part has AVX2.
+static const vk_ops_t k_avx512 = {
+  VK_ISA_AVX512, dot_avx512, sum_avx512, sumsq_avx512, axpy_avx512, axpby_avx512, minmax_avx512,
+  gemv_s8_avx2
+};
+#endif
+
+// ---------------- dispatch ----------------
+
+static const vk_ops_t* ops_for(vk_isa_t isa) {
+  switch (isa) {
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    case VK_ISA_NEON:   return &k_neon;
+#endif
+#if defined(VK_X86)
+    case VK_ISA_SSE42:  return __builtin_cpu_supports("sse4.2") ? &k_sse42 : NULL;
+    case VK_ISA_AVX2:   return (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                               ? &k_avx2 : NULL;
+    case VK_ISA_AVX512: return __builtin_cpu_supports("avx512f") ? &k_avx512 : NULL;
+#endif
+    case VK_ISA_SCALAR: return &k_scalar;
+    default:            return NULL;
+  }
+}
+
+static const vk_ops_t* g_ops = &k_scalar;
+static pthread_once_t g_once = PTHREAD_ONCE_INIT;
+
+static void vk_detect(void) {
+#if defined(VK_X86)
+  __builtin_cpu_init();
+#endif
+  static const vk_isa_t order[] = { VK_ISA_AVX512, VK_ISA_AVX2, VK_ISA_SSE42, VK_ISA_NEON };
+  for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i) {
+    const vk_ops_t* o = ops_for(order[i]);
+    if (o) { g_ops = o; return; }
+  }
+}
+
+static inline const vk_ops_t* ops(void) {
+  pthread_once(&g_once, vk_detect);
+  return g_ops;
+}
+
+float vk_dot_f32(const float* a, const float* b, size_t n) { return ops()->dot(a, b, n); }
+float vk_sum_f32(const float* x, size_t n)                 { return ops()->sum(x, n); }
+float vk_sumsq_f32(const float* x, size_t n)               { return ops()->sumsq(x, n); }
+void  vk_axpy_f32(float a, const float* x, float* y, size_t n)           { ops()->axpy(a, x, y, n); }
+void  vk_axpby_f32(float a, const float* x, float b, float* y, size_t n) { ops()->axpby(a, x, b, y, n); }
+void  vk_minmax_f32(const float* x, size_t n, float* mn, float* mx)      { ops()->minmax(x, n, mn, mx); }
+void  vk_gemv_s8(const int8_t* W, size_t stride, const int8_t* x, size_t n, size_t rows, int32_t* y) {
+  ops()->gemv_s8(W, stride, x, n, rows, y);
+}
+
+vk_isa_t vk_active_isa(void) { return ops()->isa; }
+
+const char* vk_isa_name(vk_isa_t isa) {
+  switch (isa) {
+    case VK_ISA_NEON:   return "neon";
+    case VK_ISA_SSE42:  return "sse4.2";
+    case VK_ISA_AVX2:   return "avx2";
+    case VK_ISA_AVX512: return "avx512";
+    default:            return "scalar";
+  }
+}
+
+int vk_select_isa(vk_isa_t isa) {
+  pthread_once(&g_once, vk_detect);
+#if defined(VK_X86)
+  __builtin_cpu_init();
+#endif
+  const vk_ops_t* o = ops_for(isa);
+  if (!o) return -1;
+  g_ops = o;
+  return 0;
+}
@@ -0,0 +1,53 @@
+//
+//  vec_kernels.h
+//  SleepTriggerWatchOS Watch App
+//
+
+#ifndef VEC_KERNELS_H
+#define VEC_KERNELS_H
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Small float32 kernel library. The implementation for each kernel is picked
+// once, on first use, from the best instruction set the CPU reports:
+//   x86:   AVX-512F > AVX2+FMA > SSE4.2 > scalar   (CPUID via __builtin_cpu_supports)
+//   arm64: NEON (baseline; dot uses neon_dot.S)
+// All paths use several independent accumulators so reductions are bound by
+// load throughput rather than FMA latency. Reductions therefore associate
+// differently from a left-to-right loop; results agree to float rounding.
+// The int8 kernels are exact on every path.
+
+typedef enum {
+  VK_ISA_SCALAR = 0,
+  VK_ISA_NEON   = 1,
+  VK_ISA_SSE42  = 2,
+  VK_ISA_AVX2   = 3,
+  VK_ISA_AVX512 = 4
+} vk_isa_t;
+
+float vk_dot_f32(const float* a, const float* b, size_t n);
+float vk_sum_f32(const float* x, size_t n);
+float vk_sumsq_f32(const float* x, size_t n);
+void  vk_axpy_f32(float a, const float* x, float* y, size_t n);            // y += a*x
+void  vk_axpby_f32(float a, const float* x, float b, float* y, size_t n);  // y = a*x + b*y
+void  vk_minmax_f32(const float* x, size_t n, float* outMin, float* outMax); // n == 0: +inf/-inf
+
+// int8 GEMV: y[r] = sum_k W[r*stride + k] * x[k] for r < rows, k < n, in
+// int32. W and x must stay within [-127, 127] (symmetric quantisation never
+// produces -128): the x86 paths use the pairwise u8*s8 multiply, which
+// would saturate on -128 * -128. NEON uses SDOT when the target has it.
+void  vk_gemv_s8(const int8_t* W, size_t stride, const int8_t* x, size_t n, size_t rows, int32_t* y);
+
+vk_isa_t    vk_active_isa(void);
+const char* vk_isa_name(vk_isa_t isa);
+// Force a specific path (tests/benchmarks). Returns 0 if the CPU supports it.
+int         vk_select_isa(vk_isa_t isa);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* VEC_KERNELS_H */
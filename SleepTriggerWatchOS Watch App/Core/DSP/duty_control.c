@@ -6,3 +6,83 @@
 //
 
 #include "duty_control.h"
+#include <string.h>
+
+static double clamp01(double v){ return v<0 ? 0 : (v>1 ? 1 : v); }
+
+void dc_policy_default(dc_policy_t* p){
+  p->minInterval = 2.0;
+  p->maxInterval = 30.0;
+  p->pLow = 0.25; p->pHigh = 0.85;  // the pipeline's assist thresholds
+  p->riseScale = 0.002;     // +0.12 per minute
+  p->riseTau = 60.0;
+  p->varScale = 0.10;
+  p->onLevel = 0.60; p->offLevel = 0.35;
+  p->growth = 1.5;
+  p->sensorLead = 10.0;     // two motion windows, a few HR samples
+}
+
+void dc_cost_default(dc_cost_t* c){
+  c->wakeJ = 2e-3;
+  c->evalJ = 0.5e-3;
+  c->sensorW = 4e-3;
+  c->cpuW = 0.25;
+}
+
+void dc_sched_init(dc_scheduler_t* s, const dc_policy_t* pol){
+  memset(s, 0, sizeof(*s));
+  if (pol) s->pol = *pol; else dc_policy_default(&s->pol);
+  dc_sched_reset(s);
+}
+
+void dc_sched_reset(dc_scheduler_t* s){
+  s->interval = s->pol.minInterval;
+  s->hasLast = 0;
+  s->rise = 0;
+  s->fast = 1;               // start fast until the filter settles
+  s->urgency = 1;
+}
+
+double dc_sched_next(dc_scheduler_t* s, double t, double p, double P, dc_state_t st){
+  const dc_policy_t* pol = &s->pol;
+  if (s->hasLast && t > s->lastT) {
+    const double dt = t - s->lastT, k = dt < pol->riseTau ? dt / pol->riseTau : 1.0;
+    s->rise += ((p - s->lastP) / dt - s->rise) * k;
+  }
+  s->lastT = t; s->lastP = p; s->hasLast = 1;
+
+  double u = clamp01((p - pol->pLow) / (pol->pHigh - pol->pLow));
+  const double ur = clamp01(s->rise / pol->riseScale);
+  const double uv = clamp01(P / pol->varScale);
+  if (ur > u) u = ur;
+  if (uv > u) u = uv;
+  if (st != DC_AWAKE) u = 1;
+  s->urgency = u;
+
+  if (s->fast) { if (u < pol->offLevel) s->fast = 0; }
+  else if (u >= pol->onLevel) s->fast = 1;
+
+  double dt;
+  if (s->fast) {
+    dt = pol->minInterval;
+  } else {
+    // Snap down to the target at once, back off towards it gradually.
+    const double target = pol->minInterval + (pol->maxInterval - pol->minInterval) * (1 - u) * (1 - u);
+    dt = s->interval * pol->growth;
+    if (dt > target) dt = target;
+    if (dt < pol->minInterval) dt = pol->minInterval;
+  }
+  s->interval = dt;
+  return dt;
+}
+
+void dc_account_eval(dc_account_t* a, double gap, double sensorLead, int fast){
+  a->wakeups += 1;
+  a->fastTicks += fast != 0;
+  a->elapsed += gap;
+  a->sensorOn += gap < sensorLead ? gap : sensorLead;
+}
+
+double dc_energy_j(const dc_account_t* a, const dc_cost_t* c){
+  return (double)a->wakeups * (c->wakeJ + c->evalJ) + a->sensorOn * c->sensorW + a->dspSeconds * c->cpuW;
+}
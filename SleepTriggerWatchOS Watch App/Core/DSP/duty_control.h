@@ -4,8 +4,19 @@
 //
 //  Created by Daniel Hu on 2025-08-14.
 //
+//  Evaluation pacing.
+//    dc_next_interval   the original two-value switch (fast while drowsy)
+//    dc_sched_*         adaptive scheduler: the next evaluation / sensor
+//                       interval from propensity level, its rate of change
+//                       and the propensity filter's variance, with bounds
+//                       and hysteresis
+//    dc_account_*       per-night wakeup / sensor-on / DSP-time accounting
+//                       and a coarse energy model, for any pacing
+//
 
 #pragma once
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -30,6 +41,67 @@ static inline double dc_next_interval(duty_ctrl_t* c, dc_state_t st){
   return dt;
 }
 
+// ---- adaptive scheduler ----
+
+typedef struct {
+  double minInterval;   // seconds, used while latched fast
+  double maxInterval;   // seconds, fully calm
+  double pLow, pHigh;   // propensity mapped to urgency 0 .. 1
+  double riseScale;     // dp/dt (1/s) that counts as fully urgent
+  double riseTau;       // seconds; dp/dt is smoothed over about this long
+  double varScale;      // filter variance P that counts as fully urgent
+  double onLevel;       // urgency that latches the fast cadence
+  double offLevel;      // ... and that releases it (< onLevel)
+  double growth;        // max interval growth per calm decision (> 1)
+  double sensorLead;    // seconds sensors run before each evaluation
+} dc_policy_t;
+
+typedef struct {
+  dc_policy_t pol;
+  double      interval;   // last interval handed out
+  double      lastT, lastP;
+  double      rise;       // smoothed dp/dt
+  int         hasLast;
+  int         fast;       // hysteresis latch
+  double      urgency;    // last computed, 0..1
+} dc_scheduler_t;
+
+// Per-night counters. Sensors are modelled as on for min(gap, sensorLead)
+// ahead of every evaluation, i.e. continuously once evaluations are no
+// further apart than the lead.
+typedef struct {
+  uint64_t wakeups;     // evaluations
+  uint64_t fastTicks;   // ... of which at the fast cadence
+  double   elapsed;     // seconds between the first and last evaluation
+  double   sensorOn;    // seconds with sensors powered
+  double   dspSeconds;  // caller-measured DSP time (optional)
+} dc_account_t;
+
+// Rough watch-class figures, for comparing policies rather than absolute
+// battery predictions.
+typedef struct {
+  double wakeJ;      // per DSP wakeup (scheduling, cache refill)
+  double evalJ;      // per evaluation
+  double sensorW;    // HR + motion while on
+  double cpuW;       // applied to dspSeconds when measured
+} dc_cost_t;
+
+void   dc_policy_default(dc_policy_t* p);
+void   dc_cost_default(dc_cost_t* c);
+
+// pol may be NULL for the defaults.
+void   dc_sched_init(dc_scheduler_t* s, const dc_policy_t* pol);
+void   dc_sched_reset(dc_scheduler_t* s);
+
+// After an evaluation at time t (seconds) with propensity p and its filter
+// variance P: seconds until the next one, within [minInterval,
+// maxInterval]. Drowsy, and asleep awaiting confirmation, latch fast.
+double dc_sched_next(dc_scheduler_t* s, double t, double p, double P, dc_state_t st);
+
+// Book one evaluation `gap` seconds after the previous one (0 for the first).
+void   dc_account_eval(dc_account_t* a, double gap, double sensorLead, int fast);
+double dc_energy_j(const dc_account_t* a, const dc_cost_t* c);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,8 @@
 
 #pragma once
 #include <algorithm>
+#include <array>
+#include <cmath>
 namespace st {
 
 struct KF1 {
@@ -45,4 +47,271 @@ inline double fuseFeatures(double drop, double still, double negSlope,
   return 0.35*drop + 0.30*still + 0.15*negSlope + 0.10*respQuiet + 0.10*vlfPower;
 }
 
+// ---- KF<N, M> ----
+//
+// Linear Kalman filter with N states and M measurements. Everything lives in
+// fixed std::arrays (row-major), so a filter is a plain value with no heap
+// use; every loop has a compile-time trip count and is fully unrolled at -O2
+// for the sizes used here (N, M <= 5).
+//
+//   predict():  x = F x,  P = F P F' + Q
+//   update(z):  S = H P H' + R,  K = P H' S^-1,  x += K (z - H x),  P -= K H P
+//
+// S^-1 is never formed: K' comes from a Cholesky solve of S K' = H P.
+// updateScalar() folds in one measurement row at a time, which for a
+// diagonal R gives the same posterior without any M x M algebra.
+
+namespace kf_detail {
+
+// C = A (r x k) * B (k x c)
+template <int R, int K, int C>
+inline void mul(const double* A, const double* B, double* out) {
+  for (int i = 0; i < R; ++i)
+    for (int j = 0; j < C; ++j) {
+      double acc = 0;
+      for (int k = 0; k < K; ++k) acc += A[i * K + k] * B[k * C + j];
+      out[i * C + j] = acc;
+    }
+}
+
+// C = A (r x k) * B' (B is c x k)
+template <int R, int K, int C>
+inline void mulT(const double* A, const double* B, double* out) {
+  for (int i = 0; i < R; ++i)
+    for (int j = 0; j < C; ++j) {
+      double acc = 0;
+      for (int k = 0; k < K; ++k) acc += A[i * K + k] * B[j * K + k];
+      out[i * C + j] = acc;
+    }
+}
+
+// Solve S X = B in place (S is M x M SPD, B is M x C). Returns false if S
+// is not positive definite; B is then left unspecified.
+template <int M, int C>
+inline bool cholSolve(std::array<double, M * M> S, double* B) {
+  for (int j = 0; j < M; ++j) {
+    double d = S[j * M + j];
+    for (int k = 0; k < j; ++k) d -= S[j * M + k] * S[j * M + k];
+    if (!(d > 0)) return false;
+    d = std::sqrt(d);
+    S[j * M + j] = d;
+    for (int i = j + 1; i < M; ++i) {
+      double v = S[i * M + j];
+      for (int k = 0; k < j; ++k) v -= S[i * M + k] * S[j * M + k];
+      S[i * M + j] = v / d;
+    }
+  }
+  for (int c = 0; c < C; ++c) {
+    for (int i = 0; i < M; ++i) {            // L y = b
+      double v = B[i * C + c];
+      for (int k = 0; k < i; ++k) v -= S[i * M + k] * B[k * C + c];
+      B[i * C + c] = v / S[i * M + i];
+    }
+    for (int i = M - 1; i >= 0; --i) {       // L' x = y
+      double v = B[i * C + c];
+      for (int k = i + 1; k < M; ++k) v -= S[k * M + i] * B[k * C + c];
+      B[i * C + c] = v / S[i * M + i];
+    }
+  }
+  return true;
+}
+
+template <int N>
+constexpr std::array<double, N * N> identity() {
+  std::array<double, N * N> I{};
+  for (int i = 0; i < N; ++i) I[i * N + i] = 1.0;
+  return I;
+}
+
+} // namespace kf_detail
+
+template <int N, int M>
+struct KF {
+  static_assert(N >= 1 && M >= 1, "KF needs at least one state and one measurement");
+  using Vec  = std::array<double, N>;
+  using Mat  = std::array<double, N * N>;
+  using ZVec = std::array<double, M>;
+
+  Vec x{};
+  Mat P{kf_detail::identity<N>()};
+  Mat F{kf_detail::identity<N>()};
+  Mat Q{};
+  std::array<double, M * N> H{};
+  std::array<double, M * M> R{kf_detail::identity<M>()};
+
+  void reset(const Vec& x0, const Mat& P0) { x = x0; P = P0; }
+
+  void predict() {
+    Vec nx;
+    kf_detail::mul<N, N, 1>(F.data(), x.data(), nx.data());
+    x = nx;
+    Mat FP;
+    kf_detail::mul<N, N, N>(F.data(), P.data(), FP.data());
+    kf_detail::mulT<N, N, N>(FP.data(), F.data(), P.data());
+    for (int i = 0; i < N * N; ++i) P[i] += Q[i];
+  }
+
+  // Returns false (state untouched) if the innovation covariance is not
+  // positive definite.
+  bool update(const ZVec& z) {
+    std::array<double, M * N> HP;
+    kf_detail::mul<M, N, N>(H.data(), P.data(), HP.data());
+    std::array<double, M * M> S;
+    kf_detail::mulT<M, N, M>(HP.data(), H.data(), S.data());
+    for (int i = 0; i < M * M; ++i) S[i] += R[i];
+
+    std::array<double, M * N> Kt = HP;       // K' = S^-1 H P
+    if (!kf_detail::cholSolve<M, N>(S, Kt.data())) return false;
+
+    ZVec y;
+    kf_detail::mul<M, N, 1>(H.data(), x.data(), y.data());
+    for (int m = 0; m < M; ++m) y[m] = z[m] - y[m];
+    for (int i = 0; i < N; ++i) {
+      double acc = 0;
+      for (int m = 0; m < M; ++m) acc += Kt[m * N + i] * y[m];
+      x[i] += acc;
+    }
+    for (int i = 0; i < N; ++i)
+      for (int j = 0; j < N; ++j) {
+        double acc = 0;
+        for (int m = 0; m < M; ++m) acc += Kt[m * N + i] * HP[m * N + j];
+        P[i * N + j] -= acc;
+      }
+    symmetrise();
+    return true;
+  }
+
+  // One measurement row h (length N) with variance r; ignores H and R.
+  bool updateScalar(const double* h, double z, double r) {
+    Vec Ph;
+    for (int i = 0; i < N; ++i) {
+      double acc = 0;
+      for (int k = 0; k < N; ++k) acc += P[i * N + k] * h[k];
+      Ph[i] = acc;
+    }
+    double s = r, hx = 0;
+    for (int i = 0; i < N; ++i) { s += h[i] * Ph[i]; hx += h[i] * x[i]; }
+    if (!(s > 0)) return false;
+    const double inv = 1.0 / s, y = z - hx;
+    for (int i = 0; i < N; ++i) x[i] += Ph[i] * inv * y;
+    for (int i = 0; i < N; ++i)
+      for (int j = 0; j < N; ++j) P[i * N + j] -= Ph[i] * Ph[j] * inv;
+    symmetrise();
+    return true;
+  }
+
+  void symmetrise() {
+    for (int i = 0; i < N; ++i)
+      for (int j = i + 1; j < N; ++j) {
+        const double v = 0.5 * (P[i * N + j] + P[j * N + i]);
+        P[i * N + j] = P[j * N + i] = v;
+      }
+  }
+};
+
+// Constant-velocity HR model with a slow baseline; an alternative to
+// HRTrend's time windows that needs no sample history:
+//
+//   state  [level (bpm), slope (bpm/s), baseline (bpm)]
+//   level' = level + slope*dt      (white-noise acceleration, accelNoise)
+//   base'  = base + a*(level - base),  a = 1 - exp(-dt / baselineTau)
+//   z      = level + v,  v ~ N(0, measNoise)
+//
+// Defaults were tuned on st_replay synthetic nights: baselineTau 200 s sits
+// a little above the 150 s mean age of HRTrend's 5-minute boxcar, because
+// the filtered level lags the raw latest sample the window compares with.
+// dropFraction() and slopeBPMPerSec() keep HRTrend's signatures, so
+// SleepFrontEnd can use either.
+struct HRTrendKF {
+  double accelNoise{1e-5};     // (bpm/s^2)^2 * s
+  double baselineNoise{1e-4};  // bpm^2 / s
+  double measNoise{1.0};       // bpm^2
+  double baselineTau{200};     // s
+  int    minSlopeSamples{5};   // HRTrend needs 5 points for a slope
+
+  void reset() { n_ = 0; }
+
+  void ingest(double bpm, double t) {
+    if (!std::isfinite(bpm)) return;
+    if (n_ == 0) {
+      kf_.x = {bpm, 0.0, bpm};
+      kf_.P = {measNoise, 0, 0,  0, 1e-2, 0,  0, 0, measNoise};
+    } else {
+      const double dt = std::max(0.0, t - t_);
+      const double a = 1.0 - std::exp(-dt / baselineTau);
+      kf_.F = {1, dt, 0,  0, 1, 0,  a, 0, 1 - a};
+      const double q = accelNoise, dt2 = dt * dt;
+      kf_.Q = {q * dt2 * dt / 3, q * dt2 / 2, 0,
+               q * dt2 / 2,      q * dt,      0,
+               0,                0,           baselineNoise * dt};
+      kf_.predict();
+      static constexpr double h[3] = {1, 0, 0};
+      kf_.updateScalar(h, bpm, measNoise);
+    }
+    t_ = t;
+    ++n_;
+  }
+
+  double level() const    { return kf_.x[0]; }
+  double baseline() const { return kf_.x[2]; }
+
+  bool dropFraction(double& out) const {
+    if (n_ == 0 || !(kf_.x[2] > 0)) return false;
+    out = (kf_.x[0] - kf_.x[2]) / kf_.x[2];
+    return true;
+  }
+
+  bool slopeBPMPerSec(double& out) const {
+    if (n_ < minSlopeSamples) return false;
+    out = kf_.x[1];
+    return true;
+  }
+
+  const KF<3, 1>& filter() const { return kf_; }
+
+private:
+  KF<3, 1> kf_{};
+  double t_{0};
+  int    n_{0};
+};
+
+// Joint propensity model: the five fuseFeatures inputs are measured
+// directly against a [propensity, rate per tick] state, each with variance
+// r / weight. With rateNoise = 0 and no initial rate uncertainty this is
+// KF1 over fuseFeatures() (the weights sum to 1); a non-zero rateNoise lets
+// the estimate follow a steady drift without the lag of a random walk.
+struct PropensityKF {
+  static constexpr int kFeatures = 5;
+  static constexpr double kWeights[kFeatures] = {0.35, 0.30, 0.15, 0.10, 0.10};
+
+  double q{0.01};           // propensity random walk (as KF1)
+  double r{0.10};           // variance of the fused measurement (as KF1)
+  double rateNoise{1e-4};
+  double rate0{1e-3};       // initial rate variance
+
+  void set(double q_, double r_, double x0 = 0.0, double p0 = 1.0) {
+    q = q_; r = r_;
+    kf_.x = {x0, 0.0};
+    kf_.P = {p0, 0, 0, rate0};
+    kf_.F = {1, 1, 0, 1};
+    kf_.Q = {q, 0, 0, rateNoise};
+  }
+
+  double update(double drop, double still, double negSlope, double respQuiet, double vlfPower) {
+    auto clip = [](double v){ return v<0?0:(v>1?1:v); };
+    const double z[kFeatures] = {clip(drop), clip(still), clip(negSlope), clip(respQuiet), clip(vlfPower)};
+    kf_.predict();
+    static constexpr double h[2] = {1, 0};
+    for (int k = 0; k < kFeatures; ++k) kf_.updateScalar(h, z[k], r / kWeights[k]);
+    kf_.x[0] = std::clamp(kf_.x[0], 0.0, 1.0);
+    return kf_.x[0];
+  }
+
+  double x() const    { return kf_.x[0]; }
+  double rate() const { return kf_.x[1]; }
+
+private:
+  KF<2, 1> kf_{};
+};
+
 } // namespace st
@@ -0,0 +1,210 @@
+//
+//  filter_bank.c
+//  SleepTriggerWatchOS Watch App
+//
+
+#include "filter_bank.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+// ---- lane abstraction (selected at compile time) ----
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FB_LANES 8
+typedef __m256 fbv;
+static inline fbv fbv_load(const float* p)      { return _mm256_loadu_ps(p); }
+static inline void fbv_store(float* p, fbv v)   { _mm256_storeu_ps(p, v); }
+static inline fbv fbv_set1(float x)             { return _mm256_set1_ps(x); }
+static inline fbv fbv_add(fbv a, fbv b)         { return _mm256_add_ps(a, b); }
+static inline fbv fbv_sub(fbv a, fbv b)         { return _mm256_sub_ps(a, b); }
+static inline fbv fbv_mul(fbv a, fbv b)         { return _mm256_mul_ps(a, b); }
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FB_LANES 4
+typedef __m128 fbv;
+static inline fbv fbv_load(const float* p)      { return _mm_loadu_ps(p); }
+static inline void fbv_store(float* p, fbv v)   { _mm_storeu_ps(p, v); }
+static inline fbv fbv_set1(float x)             { return _mm_set1_ps(x); }
+static inline fbv fbv_add(fbv a, fbv b)         { return _mm_add_ps(a, b); }
+static inline fbv fbv_sub(fbv a, fbv b)         { return _mm_sub_ps(a, b); }
+static inline fbv fbv_mul(fbv a, fbv b)         { return _mm_mul_ps(a, b); }
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FB_LANES 4
+typedef float32x4_t fbv;
+static inline fbv fbv_load(const float* p)      { return vld1q_f32(p); }
+static inline void fbv_store(float* p, fbv v)   { vst1q_f32(p, v); }
+static inline fbv fbv_set1(float x)             { return vdupq_n_f32(x); }
+static inline fbv fbv_add(fbv a, fbv b)         { return vaddq_f32(a, b); }
+static inline fbv fbv_sub(fbv a, fbv b)         { return vsubq_f32(a, b); }
+static inline fbv fbv_mul(fbv a, fbv b)         { return vmulq_f32(a, b); }
+#else
+#define FB_LANES 1
+#endif
+
+int fb_simd_lanes(void) { return FB_LANES; }
+
+// Same clamp as iir1_set_alpha.
+static inline float clamp_alpha(float a) {
+  if (a < FLT_EPSILON) return FLT_EPSILON;
+  if (a > 1.0f)        return 1.0f;
+  return a;
+}
+
+// ---- one-pole IIR bank ----
+
+int fb_iir1_init(fb_iir1_t* b, size_t channels, float alpha) {
+  if (!b || channels == 0) return -1;
+  memset(b, 0, sizeof(*b));
+  float* mem = (float*)calloc(channels * 3, sizeof(float));
+  unsigned char* pending = (unsigned char*)malloc(channels);
+  if (!mem || !pending) { free(mem); free(pending); return -2; }
+  memset(pending, 1, channels);
+  b->pending = pending;
+  b->channels = channels;
+  b->alpha = mem;
+  b->a0    = mem + channels;
+  b->y     = mem + channels * 2;
+  float a = clamp_alpha(alpha);
+  for (size_t c = 0; c < channels; ++c) { b->alpha[c] = a; b->a0[c] = 1.0f; }
+  return 0;
+}
+
+void fb_iir1_free(fb_iir1_t* b) {
+  if (!b) return;
+  free(b->alpha);
+  free(b->pending);
+  memset(b, 0, sizeof(*b));
+}
+
+void fb_iir1_set_alpha(fb_iir1_t* b, size_t ch, float alpha) {
+  if (!b || ch >= b->channels) return;
+  float a = clamp_alpha(alpha);
+  b->alpha[ch] = a;
+  if (!b->pending[ch]) b->a0[ch] = a;
+}
+
+void fb_iir1_reset(fb_iir1_t* b, size_t ch) {
+  if (!b || ch >= b->channels) return;
+  b->a0[ch] = 1.0f;   // (1-1)*0 + 1*x == x: the first sample seeds y exactly
+  b->y[ch] = 0.0f;
+  b->pending[ch] = 1;
+}
+
+void fb_iir1_reset_all(fb_iir1_t* b) {
+  if (!b) return;
+  for (size_t c = 0; c < b->channels; ++c) fb_iir1_reset(b, c);
+}
+
+void fb_iir1_process(fb_iir1_t* b, const float* x, float* y, size_t frames) {
+  if (!b || !x || !y || frames == 0) return;
+  const size_t C = b->channels;
+  memset(b->pending, 0, C);
+  size_t c = 0;
+#if FB_LANES > 1
+  const fbv one = fbv_set1(1.0f);
+  for (; c + FB_LANES <= C; c += FB_LANES) {
+    fbv a  = fbv_load(b->alpha + c);
+    fbv a0 = fbv_load(b->a0 + c);
+    fbv s  = fbv_load(b->y + c);
+    // first frame may seed; the rest use the steady-state factor
+    s = fbv_add(fbv_mul(fbv_sub(one, a0), s), fbv_mul(a0, fbv_load(x + c)));
+    fbv_store(y + c, s);
+    fbv k = fbv_sub(one, a);
+    for (size_t f = 1; f < frames; ++f) {
+      s = fbv_add(fbv_mul(k, s), fbv_mul(a, fbv_load(x + f * C + c)));
+      fbv_store(y + f * C + c, s);
+    }
+    fbv_store(b->y + c, s);
+    fbv_store(b->a0 + c, a);
+  }
+#endif
+  for (; c < C; ++c) {
+    const float a = b->alpha[c];
+    float a0 = b->a0[c];
+    float s = b->y[c];
+    s = (1.0f - a0) * s + a0 * x[c];
+    y[c] = s;
+    for (size_t f = 1; f < frames; ++f) {
+      s = (1.0f - a) * s + a * x[f * C + c];
+      y[f * C + c] = s;
+    }
+    b->y[c] = s;
+    b->a0[c] = a;
+  }
+}
+
+// ---- biquad bank ----
+
+int fb_biquad_init(fb_biquad_t* b, size_t channels) {
+  if (!b || channels == 0) return -1;
+  memset(b, 0, sizeof(*b));
+  float* mem = (float*)calloc(channels * 7, sizeof(float));
+  if (!mem) return -2;
+  b->channels = channels;
+  b->b0 = mem;               b->b1 = mem + channels;     b->b2 = mem + channels * 2;
+  b->a1 = mem + channels * 3; b->a2 = mem + channels * 4;
+  b->z1 = mem + channels * 5; b->z2 = mem + channels * 6;
+  for (size_t c = 0; c < channels; ++c) b->b0[c] = 1.0f;  // identity until set
+  return 0;
+}
+
+void fb_biquad_free(fb_biquad_t* b) {
+  if (!b) return;
+  free(b->b0);
+  memset(b, 0, sizeof(*b));
+}
+
+void fb_biquad_set(fb_biquad_t* b, size_t ch,
+                   float b0, float b1, float b2, float a1, float a2) {
+  if (!b || ch >= b->channels) return;
+  b->b0[ch] = b0; b->b1[ch] = b1; b->b2[ch] = b2;
+  b->a1[ch] = a1; b->a2[ch] = a2;
+}
+
+void fb_biquad_set_from_resp(fb_biquad_t* b, size_t ch, const resp_bpf_t* f) {
+  if (!f) return;
+  fb_biquad_set(b, ch, (float)f->b0, (float)f->b1, (float)f->b2, (float)f->a1, (float)f->a2);
+}
+
+void fb_biquad_reset_all(fb_biquad_t* b) {
+  if (!b) return;
+  memset(b->z1, 0, b->channels * sizeof(float));
+  memset(b->z2, 0, b->channels * sizeof(float));
+}
+
+void fb_biquad_process(fb_biquad_t* b, const float* x, float* y, size_t frames) {
+  if (!b || !x || !y || frames == 0) return;
+  const size_t C = b->channels;
+  size_t c = 0;
+#if FB_LANES > 1
+  for (; c + FB_LANES <= C; c += FB_LANES) {
+    const fbv b0 = fbv_load(b->b0 + c), b1 = fbv_load(b->b1 + c), b2 = fbv_load(b->b2 + c);
+    const fbv a1 = fbv_load(b->a1 + c), a2 = fbv_load(b->a2 + c);
+    fbv z1 = fbv_load(b->z1 + c), z2 = fbv_load(b->z2 + c);
+    for (size_t f = 0; f < frames; ++f) {
+      fbv xi = fbv_load(x + f * C + c);
+      fbv yi = fbv_add(fbv_mul(b0, xi), z1);
+      z1 = fbv_add(fbv_sub(fbv_mul(b1, xi), fbv_mul(a1, yi)), z2);
+      z2 = fbv_sub(fbv_mul(b2, xi), fbv_mul(a2, yi));
+      fbv_store(y + f * C + c, yi);
+    }
+    fbv_store(b->z1 + c, z1);
+    fbv_store(b->z2 + c, z2);
+  }
+#endif
+  for (; c < C; ++c) {
+    const float b0 = b->b0[c], b1 = b->b1[c], b2 = b->b2[c], a1 = b->a1[c], a2 = b->a2[c];
+    float z1 = b->z1[c], z2 = b->z2[c];
+    for (size_t f = 0; f < frames; ++f) {
+      float xi = x[f * C + c];
+      float yi = b0 * xi + z1;
+      z1 = b1 * xi - a1 * yi + z2;
+      z2 = b2 * xi - a2 * yi;
+      y[f * C + c] = yi;
+    }
+    b->z1[c] = z1;
+    b->z2[c] = z2;
+  }
+}
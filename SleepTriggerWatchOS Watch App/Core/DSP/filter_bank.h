@@ -0,0 +1,59 @@
+//
+//  filter_bank.h
+//  SleepTriggerWatchOS Watch App
+//
+
+#pragma once
+#include <stddef.h>
+#include "respiration.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Structure-of-arrays filter banks: N independent channels, each with its own
+// coefficients, advanced together so one SIMD register holds one coefficient
+// or state value for several channels (AVX2: 8, SSE2/NEON: 4, else scalar).
+//
+// Sample data is interleaved frame-major: x[f*channels + c] is frame f of
+// channel c. Block calls walk the bank in channel tiles and keep each tile's
+// state in registers across all frames of the block.
+
+// ---- one-pole IIR bank (per-channel iir1_t) ----
+typedef struct {
+  size_t channels;
+  float* alpha;   // per-channel smoothing factor (clamped like iir1_set_alpha)
+  float* a0;      // factor for the next sample: 1.0 until seeded, then alpha
+  float* y;
+  unsigned char* pending; // 1 while the channel waits for its seeding sample
+} fb_iir1_t;
+
+// Return 0 on success, nonzero on allocation failure/invalid size.
+int   fb_iir1_init(fb_iir1_t* b, size_t channels, float alpha);
+void  fb_iir1_free(fb_iir1_t* b);
+void  fb_iir1_set_alpha(fb_iir1_t* b, size_t ch, float alpha);
+void  fb_iir1_reset(fb_iir1_t* b, size_t ch);   // next sample seeds y = x
+void  fb_iir1_reset_all(fb_iir1_t* b);
+void  fb_iir1_process(fb_iir1_t* b, const float* x, float* y, size_t frames);
+
+// ---- biquad bank, transposed Direct Form II ----
+typedef struct {
+  size_t channels;
+  float *b0, *b1, *b2, *a1, *a2;  // per-channel, normalised (a0 = 1)
+  float *z1, *z2;
+} fb_biquad_t;
+
+int   fb_biquad_init(fb_biquad_t* b, size_t channels);
+void  fb_biquad_free(fb_biquad_t* b);
+void  fb_biquad_set(fb_biquad_t* b, size_t ch,
+                    float b0, float b1, float b2, float a1, float a2);
+void  fb_biquad_set_from_resp(fb_biquad_t* b, size_t ch, const resp_bpf_t* f);
+void  fb_biquad_reset_all(fb_biquad_t* b);
+void  fb_biquad_process(fb_biquad_t* b, const float* x, float* y, size_t frames);
+
+// Lanes used by the compiled SIMD path (1 = scalar).
+int   fb_simd_lanes(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,106 @@
+//
+//  frame_align.c
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#include "frame_align.h"
+#include <math.h>
+#include <string.h>
+
+#define FA_MASK (FA_QUEUE - 1)
+
+int fa_init(fa_aligner_t *a, double period, double lag, int nStreams) {
+    if (!a) return -1;
+    memset(a, 0, sizeof(*a));
+    if (!(period > 0) || !(lag >= 0) || nStreams < 1 || nStreams > FA_MAX_STREAMS) return -1;
+    a->period = period;
+    a->lag = lag;
+    a->ns = nStreams;
+    for (int i = 0; i < nStreams; ++i) {
+        a->s[i].mode = FA_HOLD;
+        a->s[i].staleAfter = INFINITY;
+    }
+    fa_reset(a);
+    return 0;
+}
+
+int fa_stream_config(fa_aligner_t *a, int i, fa_interp_t mode, double staleAfter) {
+    if (!a || i < 0 || i >= a->ns || !(staleAfter >= 0)) return -1;
+    if (mode != FA_HOLD && mode != FA_LINEAR) return -1;
+    a->s[i].mode = mode;
+    a->s[i].staleAfter = staleAfter;
+    return 0;
+}
+
+void fa_reset(fa_aligner_t *a) {
+    if (!a) return;
+    a->origin = NAN;
+    a->next = 0;
+    a->watermark = -INFINITY;
+    for (int i = 0; i < a->ns; ++i) {
+        fa_stream_t *s = &a->s[i];
+        s->hasPrev = 0;
+        s->qHead = s->qTail = 0;
+        s->latest = -INFINITY;
+    }
+}
+
+int fa_push(fa_aligner_t *a, int i, double t, double x) {
+    if (!a || i < 0 || i >= a->ns) return -1;
+    fa_stream_t *s = &a->s[i];
+    if (!(t >= s->latest) || s->qHead - s->qTail == FA_QUEUE) return -1;
+    s->q[s->qHead++ & FA_MASK] = (fa_point_t){t, x};
+    s->latest = t;
+    // The grid starts at the first frame time at or after the first sample.
+    if (isnan(a->origin)) a->origin = ceil(t / a->period) * a->period;
+    if (t > a->watermark) a->watermark = t;
+    return 0;
+}
+
+void fa_advance(fa_aligner_t *a, double now) {
+    if (a && now > a->watermark) a->watermark = now;
+}
+
+int fa_pop(fa_aligner_t *a, fa_frame_t *out) {
+    if (!a || isnan(a->origin)) return 0;
+    // origin + k·period rather than a running sum, so long nights stay on grid.
+    const double T = a->origin + (double)a->next * a->period;
+    if (T + a->lag > a->watermark) return 0;
+
+    out->t = T;
+    out->index = a->next++;
+    for (int i = 0; i < a->ns; ++i) {
+        fa_stream_t *s = &a->s[i];
+        uint16_t n = 0;
+        while (s->qTail != s->qHead && s->q[s->qTail & FA_MASK].t <= T) {
+            s->prev = s->q[s->qTail++ & FA_MASK];
+            s->hasPrev = 1;
+            ++n;
+        }
+        out->count[i] = n;
+        if (!s->hasPrev) {
+            out->value[i] = NAN;
+            out->age[i] = INFINITY;
+            out->flags[i] = 0;
+            continue;
+        }
+        const double age = T - s->prev.t;
+        uint8_t f = FA_VALID | (n ? FA_FRESH : 0) | (age > s->staleAfter ? FA_STALE : 0);
+        double v = s->prev.x;
+        if (s->mode == FA_LINEAR && s->qTail != s->qHead) {
+            const fa_point_t nx = s->q[s->qTail & FA_MASK];
+            const double span = nx.t - s->prev.t;
+            // Do not bridge a gap the stream would be stale across anyway.
+            if (span > 0 && span <= s->staleAfter) {
+                v += (nx.x - s->prev.x) * (age / span);
+                f |= FA_INTERPOLATED;
+            }
+        }
+        out->value[i] = v;
+        out->age[i] = age;
+        out->flags[i] = f;
+    }
+    return 1;
+}
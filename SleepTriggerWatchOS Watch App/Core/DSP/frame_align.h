@@ -0,0 +1,95 @@
+//
+//  frame_align.h
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Merges irregular, timestamped streams (HR every 1-5 s, stillness every
+//  5 s, ...) into frames on a fixed grid t = k·period. Each frame carries,
+//  per stream, the value at the frame time (held or linearly interpolated),
+//  the age of the newest sample at or before it, how many samples arrived
+//  since the previous frame and a stale flag.
+//
+//  A frame at T is released once some stream has a sample at or after
+//  T + lag, so linear streams normally have their next sample in hand. What
+//  a frame contains depends only on the samples, not on when fa_pop() is
+//  called, which keeps replay deterministic.
+//
+
+#ifndef FRAME_ALIGN_H
+#define FRAME_ALIGN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FA_MAX_STREAMS 4
+#define FA_QUEUE       64   // pending samples per stream (power of two)
+
+typedef enum {
+    FA_HOLD   = 0,   // last value at or before T
+    FA_LINEAR = 1,   // between the samples either side of T; hold past the end
+} fa_interp_t;
+
+enum {
+    FA_VALID        = 1,   // the stream has produced at least one sample
+    FA_FRESH        = 2,   // count > 0
+    FA_STALE        = 4,   // age > staleAfter
+    FA_INTERPOLATED = 8,   // value came from two samples
+};
+
+typedef struct {
+    double t, x;
+} fa_point_t;
+
+typedef struct {
+    int        mode;         // fa_interp_t
+    double     staleAfter;   // seconds
+    fa_point_t prev;         // newest sample already folded into a frame
+    int        hasPrev;
+    fa_point_t q[FA_QUEUE];  // samples not yet folded, oldest first
+    uint32_t   qHead, qTail;
+    double     latest;       // newest t pushed (order check)
+} fa_stream_t;
+
+typedef struct {
+    double      period, lag;
+    double      origin;      // time of frame 0, NaN until the first sample
+    uint64_t    next;        // index of the next frame
+    double      watermark;   // newest t pushed on any stream
+    int         ns;
+    fa_stream_t s[FA_MAX_STREAMS];
+} fa_aligner_t;
+
+typedef struct {
+    double   t;
+    uint64_t index;
+    double   value[FA_MAX_STREAMS];   // NaN while not FA_VALID
+    double   age[FA_MAX_STREAMS];     // T - newest sample time <= T
+    uint16_t count[FA_MAX_STREAMS];   // samples in (previous frame, T]
+    uint8_t  flags[FA_MAX_STREAMS];
+} fa_frame_t;
+
+// nStreams <= FA_MAX_STREAMS; streams start as FA_HOLD, never stale.
+// Return 0, or -1 on bad arguments.
+int  fa_init(fa_aligner_t *a, double period, double lag, int nStreams);
+int  fa_stream_config(fa_aligner_t *a, int i, fa_interp_t mode, double staleAfter);
+// Drop all samples and restart the grid at the next push.
+void fa_reset(fa_aligner_t *a);
+
+// Samples on one stream must arrive with non-decreasing t; samples older
+// than the last released frame fold into the next one. Returns 0, or -1
+// if out of order or the stream already holds FA_QUEUE pending samples.
+int  fa_push(fa_aligner_t *a, int i, double t, double x);
+// Moves the release clock without a sample (e.g. a wall-clock tick).
+void fa_advance(fa_aligner_t *a, double now);
+// Returns 1 and fills *out with the oldest unreleased frame, or 0.
+int  fa_pop(fa_aligner_t *a, fa_frame_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* FRAME_ALIGN_H */
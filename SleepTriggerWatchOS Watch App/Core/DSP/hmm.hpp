@@ -8,13 +8,17 @@
 #pragma once
 #include <array>
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
+#include <type_traits>
 
 namespace st {
 
 struct HMM3 {
   // 3-state HMM (0=awake,1=drowsy,2=asleep)
   // log-domain Viterbi; online with backpointer to last only.
+  // Filtered argmax only; HMM<N,M> / FixedLagViterbi below add sizes and
+  // smoothing. Kept as-is because the replay sweep mirrors it bit for bit.
   std::array<double,3> logPi{};
   std::array<double,9> logA{}; // row-major [i->j]
   std::array<double,9> logE{}; // emission confusion (obs->state)
@@ -61,4 +65,179 @@ struct HMM3 {
   }
 };
 
+// ---- generic HMM ----
+
+namespace hmm_detail {
+// log(x) usable in constant expressions (std::log is not constexpr before
+// C++26). Range-reduce to [sqrt(1/2), sqrt(2)) and sum the atanh series;
+// agrees with std::log to within a couple of ulps.
+constexpr double log(double x) {
+  constexpr double kLn2 = 0.69314718055994530942;
+  constexpr double kSqrt2 = 1.41421356237309504880;
+  int k = 0;
+  while (x >= kSqrt2) { x *= 0.5; ++k; }
+  while (x < kSqrt2 * 0.5) { x *= 2.0; --k; }
+  const double s = (x - 1.0) / (x + 1.0), s2 = s * s;
+  double term = s, sum = 0.0;
+  for (int n = 1; n < 40; n += 2) { sum += term / n; term *= s2; }
+  return 2.0 * sum + k * kLn2;
+}
+} // namespace hmm_detail
+
+// Probabilities of an N-state, M-symbol HMM. E is indexed [obs*N + state]
+// like HMM3::logE, so one observation selects a contiguous row.
+template <int N, int M>
+struct HMMModel {
+  std::array<double, N>     pi{};
+  std::array<double, N * N> A{};   // row-major [i*N + j], i -> j
+  std::array<double, M * N> E{};   // [obs*N + j]
+};
+
+template <int N, int M>
+struct HMMLogTables {
+  static constexpr double LOG0 = HMM3::LOG0;
+
+  std::array<double, N>     logPi{};
+  std::array<double, N * N> logA{};
+  std::array<double, M * N> logE{};
+
+  // constexpr-safe log; std::log when evaluated at run time, so runtime
+  // tables match HMM3::lg exactly.
+  static constexpr double lg(double x) {
+    if (x <= 0) return LOG0;
+    if (std::is_constant_evaluated()) return hmm_detail::log(x);
+    return std::log(x);
+  }
+
+  static constexpr HMMLogTables from(const HMMModel<N, M>& m) {
+    HMMLogTables t;
+    for (int i = 0; i < N; ++i) t.logPi[i] = lg(m.pi[i]);
+    for (int i = 0; i < N * N; ++i) t.logA[i] = lg(m.A[i]);
+    for (int i = 0; i < M * N; ++i) t.logE[i] = lg(m.E[i]);
+    return t;
+  }
+};
+
+// The pipeline's 3-state model (HMM3::setDefault) as constants.
+inline constexpr HMMModel<3, 3> kSleepHMM3Model{
+  {0.7, 0.2, 0.1},
+  {0.85, 0.12, 0.03,
+   0.10, 0.80, 0.10,
+   0.03, 0.12, 0.85},
+  {0.92, 0.06, 0.02,
+   0.08, 0.86, 0.06,
+   0.02, 0.08, 0.90}};
+inline constexpr HMMLogTables<3, 3> kSleepHMM3Tables = HMMLogTables<3, 3>::from(kSleepHMM3Model);
+
+// Online log-domain Viterbi over N states and M symbols. The max-plus step
+// runs i-outer / j-inner so each row of logA is a contiguous add + compare
+// + blend across j, which the compiler vectorises for N >= 4. delta is
+// renormalised to max 0 every step, so it never drifts on long nights.
+template <int N, int M>
+class HMM {
+  static_assert(N >= 1 && N <= 255 && M >= 1, "HMM sizes out of range");
+
+public:
+  using Model  = HMMModel<N, M>;
+  using Tables = HMMLogTables<N, M>;
+  static constexpr int kStates = N;
+  static constexpr int kSymbols = M;
+  static constexpr double LOG0 = Tables::LOG0;
+
+  constexpr HMM() = default;
+  constexpr explicit HMM(const Tables& t) : t_(t), delta_(t.logPi) {}
+
+  void setModel(const Model& m) { setTables(Tables::from(m)); }
+  void setTables(const Tables& t) { t_ = t; reset(); }
+  void reset() { delta_ = t_.logPi; }
+
+  // Advance one observation (clamped to [0, M)). Writes the backpointers
+  // (best predecessor of every state) to psi when given and returns the
+  // filtered MAP state; ties go to the lower index, as in HMM3.
+  int step(int obs, uint8_t* psi = nullptr) {
+    obs = obs < 0 ? 0 : (obs >= M ? M - 1 : obs);
+    // Backpointers ride along as doubles so the blend stays one lane width.
+    alignas(64) std::array<double, N> next;
+    alignas(64) std::array<double, N> bp{};
+    next.fill(LOG0);
+    for (int i = 0; i < N; ++i) {
+      const double di = delta_[i];
+      const double* row = &t_.logA[(size_t)i * N];
+      for (int j = 0; j < N; ++j) {
+        const double v = di + row[j];
+        const bool gt = v > next[j];
+        next[j] = gt ? v : next[j];
+        bp[j] = gt ? (double)i : bp[j];
+      }
+    }
+    const double* e = &t_.logE[(size_t)obs * N];
+    int arg = 0;
+    for (int j = 0; j < N; ++j) {
+      next[j] += e[j];
+      if (next[j] > next[arg]) arg = j;
+    }
+    const double top = next[arg];
+    for (int j = 0; j < N; ++j) delta_[j] = next[j] - top;
+    if (psi) for (int j = 0; j < N; ++j) psi[j] = (uint8_t)bp[j];
+    return arg;
+  }
+
+  // Filtered MAP state for the observations so far.
+  int best() const { return (int)(std::max_element(delta_.begin(), delta_.end()) - delta_.begin()); }
+  const std::array<double, N>& logDelta() const { return delta_; }
+  // Resume from a saved logDelta (offline checkpointed decoding).
+  void setLogDelta(const std::array<double, N>& d) { delta_ = d; }
+  const Tables& tables() const { return t_; }
+
+private:
+  Tables t_{};
+  std::array<double, N> delta_{};
+};
+
+// Fixed-lag Viterbi: after each observation, traces the current best path
+// back Lag steps and reports the state it passes through there. That is the
+// MAP estimate of the state Lag steps ago given everything up to now, which
+// does not flip on a single noisy observation the way the filtered argmax
+// does. O(N^2 + Lag) per step, Lag x N bytes of backpointers.
+template <int N, int M, int Lag>
+class FixedLagViterbi {
+  static_assert(Lag >= 1, "use HMM<N,M> directly for zero lag");
+
+public:
+  using Tables = HMMLogTables<N, M>;
+
+  constexpr FixedLagViterbi() = default;
+  constexpr explicit FixedLagViterbi(const Tables& t) : hmm_(t) {}
+
+  void setModel(const HMMModel<N, M>& m) { hmm_.setModel(m); t_ = 0; }
+  void setTables(const Tables& t) { hmm_.setTables(t); t_ = 0; }
+  void reset() { hmm_.reset(); t_ = 0; }
+
+  // Push one observation. Returns the smoothed state for the observation
+  // Lag steps back, or -1 until Lag + 1 observations have arrived.
+  int step(int obs) {
+    const size_t slot = t_ % Lag;
+    filtered_ = hmm_.step(obs, psi_[slot].data());
+    ++t_;
+    if (t_ <= (uint64_t)Lag) return -1;
+    int s = filtered_;
+    size_t k = slot;
+    for (int n = 0; n < Lag; ++n) {
+      s = psi_[k][s];
+      k = k ? k - 1 : Lag - 1;
+    }
+    return s;
+  }
+
+  int filtered() const { return filtered_; }          // argmax at the newest step
+  uint64_t steps() const { return t_; }
+  const HMM<N, M>& hmm() const { return hmm_; }
+
+private:
+  HMM<N, M> hmm_{};
+  std::array<std::array<uint8_t, N>, Lag> psi_{};
+  uint64_t t_{0};
+  int filtered_{0};
+};
+
 } // namespace st
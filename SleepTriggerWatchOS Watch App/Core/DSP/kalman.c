@@ -34,3 +34,24 @@ double kalman1d_update(Kalman1D *kf, double z) {
     kf->p = (1.0 - kf->k) * kf->p;       // new covariance
     return kf->x;
 }
+
+void kalman1d_process_block(Kalman1D *kf, const double *z, double *out, size_t n) {
+    if (!kf || !z || !out || n == 0) return;
+    size_t i = 0;
+    if (!kf->initialized) {
+        out[0] = kalman1d_update(kf, z[0]);
+        i = 1;
+    }
+    const double q = kf->q, r = kf->r;
+    double x = kf->x, p = kf->p, k = kf->k;
+    for (; i < n; ++i) {
+        p = p + q;
+        double denom = p + r;
+        if (denom <= 0.0) denom = r;
+        k = p / denom;
+        x = x + k * (z[i] - x);
+        p = (1.0 - k) * p;
+        out[i] = x;
+    }
+    kf->x = x; kf->p = p; kf->k = k;
+}
@@ -8,6 +8,8 @@
 #ifndef KALMAN_H
 #define KALMAN_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -28,6 +30,9 @@ void   kalman1d_init(Kalman1D *kf, double q, double r, double x0, double p0);
 // One update step with measurement z. Returns new estimate x.
 double kalman1d_update(Kalman1D *kf, double z);
 
+// Block update: out[i] = kalman1d_update(kf, z[i]); out may alias z.
+void   kalman1d_process_block(Kalman1D *kf, const double *z, double *out, size_t n);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,516 @@
+//
+//  nightlog.c
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#include "nightlog.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(nlog_file_hdr_t) == 32, "night log file header must stay 32 bytes");
+_Static_assert(sizeof(nlog_block_hdr_t) == 48, "night log block header must stay 48 bytes");
+
+#define QNAN   INT32_MIN     // quantised non-finite value
+#define PAD    8u            // slack after the last column for 8-byte bit reads
+#define MAX_MS 9007199254740992.0
+#define MINI   128u          // deltas per bit-packing miniblock
+
+// ---- primitives ----
+
+static inline uint64_t zz(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static inline int64_t unzz(uint64_t u) { return (int64_t)(u >> 1) ^ -(int64_t)(u & 1); }
+
+static inline uint8_t* put_varint(uint8_t* p, uint64_t v) {
+  while (v >= 0x80) { *p++ = (uint8_t)v | 0x80; v >>= 7; }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+static inline const uint8_t* get_varint(const uint8_t* p, const uint8_t* end, uint64_t* v) {
+  uint64_t x = 0;
+  for (unsigned s = 0; s < 64 && p < end; s += 7) {
+    uint8_t b = *p++;
+    x |= (uint64_t)(b & 0x7F) << s;
+    if (!(b & 0x80)) { *v = x; return p; }
+  }
+  return NULL;
+}
+
+static inline int64_t to_ticks(double t, uint32_t hz) {
+  double x = floor(t * (double)hz + 0.5);
+  if (!(x > -MAX_MS)) x = -MAX_MS;   // also catches NaN
+  if (x > MAX_MS) x = MAX_MS;
+  return (int64_t)x;
+}
+
+static inline int32_t quant(float v, float step) {
+  if (!isfinite(v)) return QNAN;
+  double q = floor((double)v / (double)step + 0.5);
+  if (q < -2147483647.0) q = -2147483647.0;
+  if (q > 2147483647.0) q = 2147483647.0;
+  return (int32_t)q;
+}
+
+static inline float dequant(int64_t q, float step) {
+  return q == QNAN ? NAN : (float)((double)q * (double)step);
+}
+
+// Worst case: 10-byte varints for every t token and state run, 33-bit
+// deltas (plus a width byte per miniblock) and a NaN run per two samples in
+// each float column, plus fixed overhead and padding.
+static size_t block_bound(uint32_t n) {
+  return sizeof(nlog_block_hdr_t) + (size_t)n * (10 + 3 * (5 + 10) + 11) +
+         3 * ((size_t)n / MINI + 24) + 10 + 2 * PAD;
+}
+
+// ---- block encode ----
+
+static uint64_t gcd_u64(uint64_t a, uint64_t b) {
+  while (b) { uint64_t t = a % b; a = b; b = t; }
+  return a;
+}
+
+// Deltas are bit-packed in miniblocks of MINI values, each with its own
+// width byte, so one jump only widens its own miniblock. Non-finite samples
+// leave the delta chain (holding the previous value) and are listed after
+// the deltas as (gap, length) runs. Flags byte: 0x80 = runs follow.
+static uint8_t* enc_column(uint8_t* p, const int32_t* q, size_t n) {
+  int32_t fill = 0;
+  for (size_t i = 0; i < n; ++i) if (q[i] != QNAN) { fill = q[i]; break; }
+  int nans = 0;
+  for (size_t i = 0; i < n; ++i) nans |= q[i] == QNAN;
+
+  int32_t last = q[0] == QNAN ? fill : q[0];
+  p = put_varint(p, zz(last));
+  *p++ = nans ? 0x80u : 0u;
+  for (size_t m = 1; m < n; m += MINI) {
+    const size_t e = m + MINI < n ? m + MINI : n;
+    uint64_t any = 0;
+    int32_t l = last;
+    for (size_t i = m; i < e; ++i) {
+      const int32_t v = q[i] == QNAN ? l : q[i];
+      any |= zz((int64_t)v - l);
+      l = v;
+    }
+    const unsigned w = any ? 64u - (unsigned)__builtin_clzll(any) : 0u;
+    *p++ = (uint8_t)w;
+    uint64_t acc = 0;
+    unsigned nb = 0;
+    for (size_t i = m; i < e; ++i) {
+      const int32_t v = q[i] == QNAN ? last : q[i];
+      acc |= zz((int64_t)v - last) << nb;   // nb < 8 and w <= 33
+      last = v;
+      nb += w;
+      while (nb >= 8) { *p++ = (uint8_t)acc; acc >>= 8; nb -= 8; }
+    }
+    if (nb) *p++ = (uint8_t)acc;
+  }
+  if (!nans) return p;
+
+  size_t runs = 0;
+  for (size_t i = 0; i < n; ++i) runs += q[i] == QNAN && (i == 0 || q[i - 1] != QNAN);
+  p = put_varint(p, runs);
+  size_t end = 0;
+  for (size_t i = 0; i < n;) {
+    if (q[i] != QNAN) { ++i; continue; }
+    size_t j = i;
+    while (j < n && q[j] == QNAN) ++j;
+    p = put_varint(p, i - end);
+    p = put_varint(p, j - i);
+    end = i = j;
+  }
+  return p;
+}
+
+static size_t encode_block(const nlog_file_hdr_t* fh, const rlog_rec_t* r, size_t n,
+                           int32_t* q, uint8_t* out) {
+  nlog_block_hdr_t bh;
+  memset(&bh, 0, sizeof(bh));
+  bh.magic = NLOG_BLOCK_MAGIC;
+  bh.count = (uint32_t)n;
+  uint8_t* p = out + sizeof(bh);
+
+  // t: delta-of-delta in units of the block's common tick step (the gcd of
+  // its deltas, usually whole seconds). Even tokens are runs of zero dod,
+  // odd ones a single zigzagged dod, so a steady cadence costs one varint.
+  const uint32_t hz = fh->tickHz;
+  int64_t prev = to_ticks(r[0].t, hz), pd = 0;
+  bh.tMin = (double)prev / hz;
+  uint64_t unit = 0;
+  for (size_t i = 1; i < n; ++i) {
+    const int64_t cur = to_ticks(r[i].t, hz);
+    unit = gcd_u64(unit, (uint64_t)(cur > prev ? cur - prev : prev - cur));
+    prev = cur;
+  }
+  if (unit == 0) unit = 1;
+  p = put_varint(p, unit);
+  prev = to_ticks(r[0].t, hz);
+  uint64_t run = 0;
+  for (size_t i = 1; i < n; ++i) {
+    const int64_t cur = to_ticks(r[i].t, hz);
+    const int64_t d = (cur - prev) / (int64_t)unit, dod = d - pd;
+    prev = cur;
+    pd = d;
+    if (dod == 0) { ++run; continue; }
+    if (run) { p = put_varint(p, run << 1); run = 0; }
+    p = put_varint(p, (zz(dod) << 1) | 1u);
+  }
+  if (run) p = put_varint(p, run << 1);
+  bh.tMax = (double)prev / hz;
+
+  int32_t* qh = q;
+  int32_t* qs = q + n;
+  int32_t* qp = q + 2 * n;
+  int32_t hlo = INT32_MAX, hhi = QNAN, plo = INT32_MAX, phi = QNAN;
+  for (size_t i = 0; i < n; ++i) {
+    qh[i] = quant(r[i].hr, fh->qHR);
+    qs[i] = quant(r[i].still, fh->qStill);
+    qp[i] = quant(r[i].prop, fh->qProp);
+    if (qh[i] != QNAN) { hlo = qh[i] < hlo ? qh[i] : hlo; hhi = qh[i] > hhi ? qh[i] : hhi; }
+    if (qp[i] != QNAN) { plo = qp[i] < plo ? qp[i] : plo; phi = qp[i] > phi ? qp[i] : phi; }
+  }
+  bh.hrMin = hhi == QNAN ? NAN : dequant(hlo, fh->qHR);
+  bh.hrMax = dequant(hhi, fh->qHR);
+  bh.propMin = phi == QNAN ? NAN : dequant(plo, fh->qProp);
+  bh.propMax = dequant(phi, fh->qProp);
+  p = enc_column(p, qh, n);
+  p = enc_column(p, qs, n);
+  p = enc_column(p, qp, n);
+
+  // state: (run, value) pairs.
+  size_t i = 0;
+  while (i < n) {
+    const uint8_t s = r[i].state;
+    size_t j = i + 1;
+    while (j < n && r[j].state == s) ++j;
+    p = put_varint(p, (uint64_t)(j - i));
+    *p++ = s;
+    if (s < 8) bh.stateMask |= (uint8_t)(1u << s);
+    i = j;
+  }
+
+  size_t payload = (size_t)(p - (out + sizeof(bh))) + PAD;
+  payload = (payload + 7) & ~(size_t)7;
+  memset(p, 0, (size_t)(out + sizeof(bh) + payload - p));
+  bh.bytes = (uint32_t)payload;
+  memcpy(out, &bh, sizeof(bh));
+  return sizeof(bh) + payload;
+}
+
+// ---- block decode ----
+
+// Decode one column into the float field at byte offset `off` of each record.
+static const uint8_t* dec_column(const uint8_t* p, const uint8_t* end, size_t n,
+                                 float step, rlog_rec_t* out, size_t off) {
+  uint64_t first;
+  if (!(p = get_varint(p, end, &first)) || p >= end) return NULL;
+  const unsigned flags = *p++;
+
+  int64_t v = unzz(first);
+  float f = dequant(v, step);
+  memcpy((uint8_t*)&out[0] + off, &f, sizeof f);
+  for (size_t m = 1; m < n; m += MINI) {
+    const size_t e = m + MINI < n ? m + MINI : n;
+    if (p >= end) return NULL;
+    const unsigned w = *p++;
+    if (w > 33) return NULL;
+    const size_t need = ((e - m) * w + 7) / 8;
+    if ((size_t)(end - p) < need + 7) return NULL;   // 8-byte reads stay in the block
+    const uint64_t mask = w ? (~0ull >> (64 - w)) : 0;
+    size_t bit = 0;
+    for (size_t i = m; i < e; ++i, bit += w) {
+      uint64_t word;
+      memcpy(&word, p + (bit >> 3), sizeof word);
+      v += unzz((word >> (bit & 7)) & mask);
+      f = dequant(v, step);
+      memcpy((uint8_t*)&out[i] + off, &f, sizeof f);
+    }
+    p += need;
+  }
+  if (!(flags & 0x80u)) return p;
+
+  uint64_t runs;
+  if (!(p = get_varint(p, end, &runs))) return NULL;
+  const float nan = NAN;
+  size_t pos = 0;
+  for (; runs; --runs) {
+    uint64_t gap, len;
+    if (!(p = get_varint(p, end, &gap)) || !(p = get_varint(p, end, &len))) return NULL;
+    if (gap > n - pos || len > n - pos - gap) return NULL;
+    for (pos += gap; len; --len, ++pos) memcpy((uint8_t*)&out[pos] + off, &nan, sizeof nan);
+  }
+  return p;
+}
+
+static int decode_block(const nlog_file_hdr_t* fh, const nlog_block_hdr_t* bh, rlog_rec_t* out) {
+  const size_t n = bh->count;
+  const uint8_t* p = (const uint8_t*)(bh + 1);
+  const uint8_t* end = p + bh->bytes;
+  const uint32_t hz = fh->tickHz;
+
+  int64_t cur = to_ticks(bh->tMin, hz), d = 0;
+  out[0].t = (double)cur / hz;
+  uint64_t unit;
+  if (!(p = get_varint(p, end, &unit)) || unit == 0 || unit > (1ull << 53)) return -1;
+  size_t i = 1;
+  while (i < n) {
+    uint64_t tok;
+    if (!(p = get_varint(p, end, &tok))) return -1;
+    if (tok & 1u) {
+      d += unzz(tok >> 1) * (int64_t)unit;
+      cur += d;
+      out[i++].t = (double)cur / hz;
+    } else {
+      uint64_t run = tok >> 1;
+      if (run == 0 || run > n - i) return -1;
+      for (; run; --run) { cur += d; out[i++].t = (double)cur / hz; }
+    }
+  }
+
+  if (!(p = dec_column(p, end, n, fh->qHR, out, offsetof(rlog_rec_t, hr)))) return -1;
+  if (!(p = dec_column(p, end, n, fh->qStill, out, offsetof(rlog_rec_t, still)))) return -1;
+  if (!(p = dec_column(p, end, n, fh->qProp, out, offsetof(rlog_rec_t, prop)))) return -1;
+
+  for (i = 0; i < n;) {
+    uint64_t run;
+    if (!(p = get_varint(p, end, &run)) || p >= end || run == 0 || run > n - i) return -1;
+    const uint8_t s = *p++;
+    for (; run; --run) out[i++].state = s;
+  }
+  return (int)n;
+}
+
+// ---- block walking (shared by reader and reopening writer) ----
+
+static int file_hdr_ok(const nlog_file_hdr_t* h) {
+  return h->magic == NLOG_MAGIC && h->version == NLOG_VERSION &&
+         h->blockRecords >= 1 && h->blockRecords <= NLOG_BLOCK_MAX &&
+         h->tickHz >= 1 && h->qHR > 0 && h->qStill > 0 && h->qProp > 0;
+}
+
+static int block_ok(const nlog_file_hdr_t* fh, const uint8_t* map, size_t len, size_t off) {
+  if (len - off < sizeof(nlog_block_hdr_t)) return 0;
+  const nlog_block_hdr_t* b = (const nlog_block_hdr_t*)(map + off);
+  return b->magic == NLOG_BLOCK_MAGIC && b->count >= 1 && b->count <= fh->blockRecords &&
+         (b->bytes & 7u) == 0 && b->bytes >= PAD &&
+         (size_t)b->bytes <= len - off - sizeof(nlog_block_hdr_t);
+}
+
+static size_t block_span(const uint8_t* map, size_t off) {
+  return sizeof(nlog_block_hdr_t) + ((const nlog_block_hdr_t*)(map + off))->bytes;
+}
+
+// ---- writer ----
+
+static int write_all(int fd, const uint8_t* p, size_t n) {
+  while (n) {
+    ssize_t k = write(fd, p, n);
+    if (k < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += k;
+    n -= (size_t)k;
+  }
+  return 0;
+}
+
+// Length of the valid prefix of an existing file, or 0 if it is not ours.
+static size_t valid_prefix(int fd, nlog_file_hdr_t* fh) {
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*fh)) return 0;
+  const size_t len = (size_t)st.st_size;
+  void* m = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+  if (m == MAP_FAILED) return 0;
+  const uint8_t* map = (const uint8_t*)m;
+  memcpy(fh, map, sizeof(*fh));
+  size_t off = 0;
+  if (file_hdr_ok(fh)) {
+    off = sizeof(*fh);
+    while (off < len && block_ok(fh, map, len, off)) off += block_span(map, off);
+  }
+  munmap(m, len);
+  return off;
+}
+
+int nlog_writer_open(nlog_writer_t* w, const char* path, uint32_t blockRecords) {
+  memset(w, 0, sizeof(*w));
+  w->fd = -1;
+  if (blockRecords == 0) blockRecords = NLOG_BLOCK_DEFAULT;
+  if (blockRecords > NLOG_BLOCK_MAX) return -1;
+
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) return -1;
+  size_t keep = valid_prefix(fd, &w->hdr);
+  if (keep == 0) {
+    memset(&w->hdr, 0, sizeof(w->hdr));
+    w->hdr.magic = NLOG_MAGIC;
+    w->hdr.version = NLOG_VERSION;
+    w->hdr.blockRecords = blockRecords;
+    w->hdr.qHR = 0.01f;
+    w->hdr.qStill = 1e-4f;
+    w->hdr.qProp = 1e-4f;
+    w->hdr.tickHz = 1000;
+    if (ftruncate(fd, 0) != 0 || write_all(fd, (const uint8_t*)&w->hdr, sizeof(w->hdr)) != 0) {
+      close(fd);
+      return -1;
+    }
+    keep = sizeof(w->hdr);
+  } else if (ftruncate(fd, (off_t)keep) != 0) {   // drop a torn tail
+    close(fd);
+    return -1;
+  }
+  if (lseek(fd, (off_t)keep, SEEK_SET) < 0) { close(fd); return -1; }
+
+  const uint32_t n = w->hdr.blockRecords;
+  w->fd = fd;
+  w->bytes = keep;
+  w->scratchCap = block_bound(n);
+  w->pending = (rlog_rec_t*)malloc((size_t)n * sizeof(rlog_rec_t));
+  w->quant = (int32_t*)malloc((size_t)n * 3 * sizeof(int32_t));
+  w->scratch = (uint8_t*)malloc(w->scratchCap);
+  if (!w->pending || !w->quant || !w->scratch) {
+    nlog_writer_close(w);
+    return -1;
+  }
+  return 0;
+}
+
+int nlog_writer_flush(nlog_writer_t* w) {
+  if (w->fd < 0) return -1;
+  if (!w->npending) return 0;
+  size_t len = encode_block(&w->hdr, w->pending, w->npending, w->quant, w->scratch);
+  if (write_all(w->fd, w->scratch, len) != 0) return -1;
+  w->records += w->npending;
+  w->blocks += 1;
+  w->bytes += len;
+  w->npending = 0;
+  return 0;
+}
+
+int nlog_append(nlog_writer_t* w, const rlog_rec_t* recs, size_t n) {
+  if (w->fd < 0) return -1;
+  const size_t cap = w->hdr.blockRecords;
+  while (n) {
+    size_t k = cap - w->npending;
+    if (k > n) k = n;
+    memcpy(w->pending + w->npending, recs, k * sizeof(rlog_rec_t));
+    w->npending += k;
+    recs += k;
+    n -= k;
+    if (w->npending == cap && nlog_writer_flush(w) != 0) return -1;
+  }
+  return 0;
+}
+
+int nlog_append_ring(nlog_writer_t* w, rlog_reader_t* rd) {
+  size_t skip = rd->pos;
+  int rc = 0;
+  if (skip < rd->na) rc |= nlog_append(w, rd->a + skip, rd->na - skip);
+  skip = skip > rd->na ? skip - rd->na : 0;
+  if (skip < rd->nb) rc |= nlog_append(w, rd->b + skip, rd->nb - skip);
+  rd->pos = rd->na + rd->nb;
+  return rc ? -1 : 0;
+}
+
+int nlog_writer_close(nlog_writer_t* w) {
+  int rc = 0;
+  if (w->fd >= 0) {
+    rc = nlog_writer_flush(w);
+    if (fsync(w->fd) != 0) rc = -1;
+    close(w->fd);
+  }
+  free(w->pending);
+  free(w->quant);
+  free(w->scratch);
+  w->pending = NULL;
+  w->quant = NULL;
+  w->scratch = NULL;
+  w->fd = -1;
+  return rc;
+}
+
+// ---- reader ----
+
+int nlog_reader_open(nlog_reader_t* rd, const char* path) {
+  memset(rd, 0, sizeof(*rd));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(nlog_file_hdr_t)) { close(fd); return -1; }
+  const size_t len = (size_t)st.st_size;
+  void* m = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) return -1;
+  rd->map = (const uint8_t*)m;
+  rd->mapLen = len;
+  memcpy(&rd->hdr, rd->map, sizeof(rd->hdr));
+  if (!file_hdr_ok(&rd->hdr)) { nlog_reader_close(rd); return -1; }
+
+  size_t cap = 0;
+  for (size_t off = sizeof(rd->hdr); off < len && block_ok(&rd->hdr, rd->map, len, off);
+       off += block_span(rd->map, off)) {
+    if (rd->nblocks == cap) {
+      cap = cap ? cap * 2 : 64;
+      size_t* grown = (size_t*)realloc(rd->offsets, cap * sizeof(size_t));
+      if (!grown) { nlog_reader_close(rd); return -1; }
+      rd->offsets = grown;
+    }
+    rd->offsets[rd->nblocks++] = off;
+    rd->records += ((const nlog_block_hdr_t*)(rd->map + off))->count;
+  }
+  return 0;
+}
+
+void nlog_reader_close(nlog_reader_t* rd) {
+  if (rd->map) munmap((void*)rd->map, rd->mapLen);
+  free(rd->offsets);
+  memset(rd, 0, sizeof(*rd));
+}
+
+const nlog_block_hdr_t* nlog_block(const nlog_reader_t* rd, size_t i) {
+  return i < rd->nblocks ? (const nlog_block_hdr_t*)(rd->map + rd->offsets[i]) : NULL;
+}
+
+size_t nlog_find_block(const nlog_reader_t* rd, double t) {
+  size_t lo = 0, hi = rd->nblocks;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (nlog_block(rd, mid)->tMax < t) lo = mid + 1; else hi = mid;
+  }
+  return lo;
+}
+
+int nlog_decode_block(const nlog_reader_t* rd, size_t i, rlog_rec_t* out) {
+  const nlog_block_hdr_t* b = nlog_block(rd, i);
+  return b ? decode_block(&rd->hdr, b, out) : -1;
+}
+
+size_t nlog_read_range(const nlog_reader_t* rd, double t0, double t1,
+                       rlog_rec_t* out, size_t cap) {
+  size_t k = 0;
+  rlog_rec_t* tmp = NULL;
+  for (size_t i = nlog_find_block(rd, t0); i < rd->nblocks && k < cap; ++i) {
+    const nlog_block_hdr_t* b = nlog_block(rd, i);
+    if (b->tMin > t1) break;
+    if (b->tMin >= t0 && b->tMax <= t1 && cap - k >= b->count) {
+      if (decode_block(&rd->hdr, b, out + k) < 0) break;   // whole block in range
+      k += b->count;
+      continue;
+    }
+    if (!tmp && !(tmp = (rlog_rec_t*)malloc((size_t)rd->hdr.blockRecords * sizeof(rlog_rec_t)))) break;
+    if (decode_block(&rd->hdr, b, tmp) < 0) break;
+    for (size_t j = 0; j < b->count && k < cap; ++j)
+      if (tmp[j].t >= t0 && tmp[j].t <= t1) out[k++] = tmp[j];
+  }
+  free(tmp);
+  return k;
+}
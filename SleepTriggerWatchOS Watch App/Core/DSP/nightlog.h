@@ -0,0 +1,119 @@
+//
+//  nightlog.h
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Compressed, time-indexed archive of ring-log records (one file per night).
+//  Records are grouped into blocks; every column of a block is coded on its own:
+//
+//    t           ms ticks, delta-of-delta; zero runs and outliers as varints
+//    hr/still/prop   quantised (file header steps), first value + bit-packed
+//                    zigzag deltas at the block's widest delta
+//    state       run-length (varint run, byte value)
+//
+//  Layout:
+//
+//    [nlog_file_hdr_t, 32 bytes]
+//    [nlog_block_hdr_t, 48 bytes][payload, padded to 8 bytes] ...
+//
+//  Block headers carry the time span and hr/prop ranges, so a reader can
+//  binary-search a time range and decode only the blocks that overlap it.
+//  Quantisation makes the format lossy by design: t to 1 ms, hr to 0.01 bpm,
+//  still/prop to 1e-4. Non-finite values round-trip as NaN.
+//
+//  Blocks are appended whole with one write(2). A crash can leave a torn last
+//  block; readers stop at the first block that does not validate, and a
+//  writer reopening the file truncates it there before appending.
+//
+
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "ringlog.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NLOG_MAGIC          0x474F4C4Eu   // "NLOG" little-endian
+#define NLOG_BLOCK_MAGIC    0x4B4C424Eu   // "NBLK"
+#define NLOG_VERSION        1u
+#define NLOG_BLOCK_DEFAULT  1024u
+#define NLOG_BLOCK_MAX      65536u
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t blockRecords;   // records per full block
+  float    qHR;            // quantisation steps
+  float    qStill;
+  float    qProp;
+  uint32_t tickHz;         // timestamp ticks per second (1000)
+  uint32_t reserved;
+} nlog_file_hdr_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t count;          // records in this block
+  uint32_t bytes;          // payload bytes after the header (multiple of 8)
+  uint8_t  stateMask;      // bit s set if state s occurs
+  uint8_t  reserved[3];
+  double   tMin;           // decoded first / last timestamps
+  double   tMax;
+  float    hrMin;          // over finite values; NaN if none
+  float    hrMax;
+  float    propMin;
+  float    propMax;
+} nlog_block_hdr_t;
+
+typedef struct {
+  int              fd;
+  nlog_file_hdr_t  hdr;
+  rlog_rec_t*      pending;     // current block, hdr.blockRecords slots
+  size_t           npending;
+  int32_t*         quant;       // 3 x hdr.blockRecords quantised columns
+  uint8_t*         scratch;     // encoded block
+  size_t           scratchCap;
+  uint64_t         records;     // appended this session
+  uint64_t         blocks;
+  uint64_t         bytes;       // file size
+} nlog_writer_t;
+
+// Open for appending (a file with a matching header keeps its blocks) or
+// create it. blockRecords 0 selects NLOG_BLOCK_DEFAULT; an existing file
+// keeps its own. Returns 0, or -1 on I/O error / bad blockRecords.
+int  nlog_writer_open(nlog_writer_t* w, const char* path, uint32_t blockRecords);
+// Records must arrive in time order. Full blocks are written as they fill.
+int  nlog_append(nlog_writer_t* w, const rlog_rec_t* recs, size_t n);
+// Archive what a ring-log reader still has to give (consumes the reader).
+int  nlog_append_ring(nlog_writer_t* w, rlog_reader_t* rd);
+// Write the partial block now (e.g. before the app is suspended).
+int  nlog_writer_flush(nlog_writer_t* w);
+int  nlog_writer_close(nlog_writer_t* w);  // flush + fsync + close
+
+typedef struct {
+  const uint8_t*   map;
+  size_t           mapLen;
+  nlog_file_hdr_t  hdr;
+  size_t*          offsets;     // block header offsets into map
+  size_t           nblocks;
+  uint64_t         records;
+} nlog_reader_t;
+
+// Map `path` and index its blocks (headers only). Returns 0 or -1.
+int  nlog_reader_open(nlog_reader_t* rd, const char* path);
+void nlog_reader_close(nlog_reader_t* rd);
+const nlog_block_hdr_t* nlog_block(const nlog_reader_t* rd, size_t i);
+// First block whose tMax >= t (nblocks if none).
+size_t nlog_find_block(const nlog_reader_t* rd, double t);
+// Decode block i into out[0..count). Returns count, or -1 if corrupt.
+int  nlog_decode_block(const nlog_reader_t* rd, size_t i, rlog_rec_t* out);
+// Records with t0 <= t <= t1, oldest first, decoding only overlapping blocks.
+// Returns how many were stored (at most cap).
+size_t nlog_read_range(const nlog_reader_t* rd, double t0, double t1,
+                       rlog_rec_t* out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
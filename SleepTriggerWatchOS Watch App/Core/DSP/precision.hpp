@@ -0,0 +1,198 @@
+//
+//  precision.hpp
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Sample types for the conditioning front end:
+//    - Fixed<Int, Frac>: two's-complement fixed point with saturating
+//      add / sub / mul (round to nearest). Q15 and Q31 cover [-1, 1).
+//    - SampleTraits<T>: real value <-> T. Fixed types divide by a caller
+//      full scale so e.g. HR (0..256 bpm) sits inside [-1, 1); float and
+//      double pass values through unscaled.
+//    - OnePole<T>: signal_filter's iir1 in any sample type; OnePole<float>
+//      is bit-identical to iir1_update.
+//    - Hampel<T>: robust_stats' Hampel (odd window <= RS_HAMPEL_MAX) in any
+//      sample type; Hampel<double> is bit-identical to rs_hampel_update.
+//  Fixed-point variants reformulate constant products that leave [-1, 1)
+//  (1.4826 * nsigma) as a multiply by their reciprocal.
+//
+
+#pragma once
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "robust_stats.h"
+
+namespace st {
+
+template <typename Int, int Frac>
+struct Fixed {
+  static_assert(std::is_signed_v<Int> && std::is_integral_v<Int>, "Fixed: signed integer storage");
+  static_assert(Frac > 0 && Frac < (int)(8 * sizeof(Int)), "Fixed: 0 < Frac < bits");
+  using Wide = std::conditional_t<(sizeof(Int) < 4), int32_t, int64_t>;
+  static constexpr Wide kMax = std::numeric_limits<Int>::max();
+  static constexpr Wide kMin = std::numeric_limits<Int>::min();
+  static constexpr double kScale = (double)((Wide)1 << Frac);
+
+  Int raw{0};
+
+  static constexpr Fixed fromRaw(Wide w) {
+    Fixed f;
+    f.raw = (Int)(w > kMax ? kMax : (w < kMin ? kMin : w));
+    return f;
+  }
+  static constexpr Fixed fromDouble(double x) {
+    const double s = x * kScale;
+    if (!(s == s)) return Fixed{};   // NaN -> 0
+    if (s >= (double)kMax) return fromRaw(kMax);
+    if (s <= (double)kMin) return fromRaw(kMin);
+    return fromRaw((Wide)(s < 0 ? s - 0.5 : s + 0.5));
+  }
+  static constexpr Fixed max() { return fromRaw(kMax); }
+  constexpr double toDouble() const { return (double)raw / kScale; }
+
+  friend constexpr Fixed operator+(Fixed a, Fixed b) { return fromRaw((Wide)a.raw + b.raw); }
+  friend constexpr Fixed operator-(Fixed a, Fixed b) { return fromRaw((Wide)a.raw - b.raw); }
+  friend constexpr Fixed operator-(Fixed a) { return fromRaw(-(Wide)a.raw); }
+  friend constexpr Fixed operator*(Fixed a, Fixed b) {
+    const Wide p = (Wide)a.raw * b.raw;
+    return fromRaw((p + ((Wide)1 << (Frac - 1))) >> Frac);
+  }
+  friend constexpr bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+  friend constexpr bool operator<(Fixed a, Fixed b)  { return a.raw < b.raw; }
+  friend constexpr bool operator>(Fixed a, Fixed b)  { return a.raw > b.raw; }
+  friend constexpr bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+  friend constexpr bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+  friend constexpr Fixed abs(Fixed a) { return a.raw < 0 ? -a : a; }
+};
+
+using Q15 = Fixed<int16_t, 15>;
+using Q31 = Fixed<int32_t, 31>;
+
+template <typename T>
+struct SampleTraits {
+  static_assert(std::is_floating_point_v<T>, "SampleTraits: float, double or Fixed");
+  static constexpr bool kFixed = false;
+  static constexpr T    in(double x, double /*fullScale*/) { return (T)x; }
+  static constexpr double out(T v, double /*fullScale*/) { return (double)v; }
+  static constexpr T    coeff(double c) { return (T)c; }
+};
+
+template <typename Int, int Frac>
+struct SampleTraits<Fixed<Int, Frac>> {
+  using T = Fixed<Int, Frac>;
+  static constexpr bool kFixed = true;
+  static constexpr T    in(double x, double fullScale) { return T::fromDouble(x / fullScale); }
+  static constexpr double out(T v, double fullScale) { return v.toDouble() * fullScale; }
+  static constexpr T    coeff(double c) { return T::fromDouble(c); }
+};
+
+template <typename T>
+class OnePole {
+public:
+  // alpha clamped to [FLT_EPSILON, 1] like iir1_init.
+  explicit OnePole(float alpha = 1.0f) { setAlpha(alpha); }
+
+  void setAlpha(float alpha) {
+    alpha_ = alpha < FLT_EPSILON ? FLT_EPSILON : (alpha > 1.0f ? 1.0f : alpha);
+    a_ = SampleTraits<T>::coeff(alpha_);
+  }
+  void reset() { initialized_ = false; y_ = T{}; }
+
+  T update(T x) {
+    if (!initialized_) { y_ = x; initialized_ = true; return x; }
+    if constexpr (SampleTraits<T>::kFixed) y_ = y_ + a_ * (x - y_);   // 1 - alpha may not be representable
+    else                                   y_ = (T(1) - a_) * y_ + a_ * x;
+    return y_;
+  }
+
+private:
+  float alpha_{1.0f};
+  T     a_{};
+  T     y_{};
+  bool  initialized_{false};
+};
+
+template <typename T>
+class Hampel {
+public:
+  explicit Hampel(int windowOdd = 9, double nsigma = 3.0) { init(windowOdd, nsigma); }
+
+  void init(int windowOdd, double nsigma) {
+    if (windowOdd < 3) windowOdd = 3;
+    if (windowOdd > RS_HAMPEL_MAX) windowOdd = RS_HAMPEL_MAX;
+    if (windowOdd % 2 == 0) windowOdd -= 1;
+    size_ = windowOdd;
+    nsigma_ = SampleTraits<T>::coeff(nsigma);
+    kInv_ = SampleTraits<T>::coeff(1.0 / (1.4826 * nsigma));
+    reset();
+  }
+  void reset() { idx_ = 0; filled_ = 0; }
+
+  T update(T x) {
+    if constexpr (!SampleTraits<T>::kFixed) { if (!std::isfinite(x)) return x; }   // as rs_hampel_update
+    if (filled_ < size_) {
+      int p = filled_++;
+      while (p > 0 && x < sorted_[p - 1]) { sorted_[p] = sorted_[p - 1]; --p; }
+      sorted_[p] = x;
+    } else {
+      // Remove the oldest value, then insert x, shifting only between them.
+      const T old = buf_[idx_];
+      int p = (int)(std::lower_bound(sorted_, sorted_ + size_, old) - sorted_);
+      if (old < x) { while (p + 1 < size_ && sorted_[p + 1] < x) { sorted_[p] = sorted_[p + 1]; ++p; } }
+      else         { while (p > 0 && x < sorted_[p - 1]) { sorted_[p] = sorted_[p - 1]; --p; } }
+      sorted_[p] = x;
+    }
+    buf_[idx_] = x;
+    idx_ = idx_ + 1 == size_ ? 0 : idx_ + 1;
+
+    const int n = filled_;
+    const T median = sorted_[n / 2];
+    const T mad = madOfSorted(n);
+
+    if constexpr (SampleTraits<T>::kFixed) {
+      if (mad.raw == 0) return x;
+      return absDiff(x, median) * kInv_ > mad ? median : x;
+    } else {
+      const T sigma = T(1.4826) * mad;
+      if (sigma <= T(1e-9)) return x;
+      return absDiff(x, median) > nsigma_ * sigma ? median : x;
+    }
+  }
+
+private:
+  // (n/2)-th smallest |sorted[i] - median|, by the same two-run selection
+  // as robust_stats.c: A[t] = m - s[h-1-t], B[t] = s[h+t] - m, ascending.
+  T madOfSorted(int n) const {
+    const int h = n / 2, a = h, b = n - h, take = h + 1;
+    const T m = sorted_[h];
+    int lo = take > b ? take - b : 0;
+    int hi = take < a ? take : a;
+    for (;;) {
+      const int i = (lo + hi) >> 1, j = take - i;
+      if (i > 0 && j < b && m - sorted_[h - i] > sorted_[h + j] - m) { hi = i - 1; continue; }
+      if (j > 0 && i < a && sorted_[h + j - 1] - m > m - sorted_[h - 1 - i]) { lo = i + 1; continue; }
+      if (i == 0) return sorted_[h + j - 1] - m;
+      if (j == 0) return m - sorted_[h - i];
+      const T ap = m - sorted_[h - i], bp = sorted_[h + j - 1] - m;
+      return ap > bp ? ap : bp;
+    }
+  }
+
+  static T absDiff(T a, T b) {
+    if constexpr (SampleTraits<T>::kFixed) return abs(a - b);
+    else                                   return std::fabs(a - b);
+  }
+
+  T   buf_[RS_HAMPEL_MAX]{};
+  T   sorted_[RS_HAMPEL_MAX]{};
+  int size_{9}, idx_{0}, filled_{0};
+  T   nsigma_{}, kInv_{};
+};
+
+} // namespace st
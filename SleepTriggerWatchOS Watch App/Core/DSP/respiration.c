@@ -47,4 +47,31 @@ double resp_update(resp_bpf_t* f, double x, double t){
   return y;
 }
 
+void resp_process_block(resp_bpf_t* f, const double* x, const double* t, double* out, size_t n){
+  if (!f || !x || !t || !out) return;
+  const double b0=f->b0, b1=f->b1, b2=f->b2, a1=f->a1, a2=f->a2;
+  double x1=f->x1, x2=f->x2, y1=f->y1, y2=f->y2;
+  double lastSign=f->lastSign, lastCrossTime=f->lastCrossTime, bpm=f->bpm;
+
+  for (size_t i=0;i<n;++i){
+    double xi = x[i];
+    double y = b0*xi + b1*x1 + b2*x2 - a1*y1 - a2*y2;
+    x2=x1; x1=xi; y2=y1; y1=y;
+
+    double s = (y>=0)?+1.0:-1.0;
+    if (lastSign < 0 && s > 0) {
+      if (lastCrossTime>0) {
+        double period = t[i] - lastCrossTime;
+        if (period>0.5 && period<10.0) bpm = 60.0/period;
+      }
+      lastCrossTime = t[i];
+    }
+    lastSign = s;
+    out[i] = y;
+  }
+
+  f->x1=x1; f->x2=x2; f->y1=y1; f->y2=y2;
+  f->lastSign=lastSign; f->lastCrossTime=lastCrossTime; f->bpm=bpm;
+}
+
 double resp_rate_bpm(const resp_bpf_t* f){ return f->bpm; }
@@ -6,6 +6,8 @@
 //
 
 #pragma once
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -24,6 +26,10 @@ void  resp_init(resp_bpf_t* f, double fsHz, double fLowHz, double fHighHz);
 double resp_update(resp_bpf_t* f, double x, double tSeconds); // returns bandpassed signal
 double resp_rate_bpm(const resp_bpf_t* f); // last estimated rate
 
+// Block form of resp_update over n samples with per-sample timestamps t[i];
+// bit-identical to calling resp_update in a loop. out may alias x.
+void  resp_process_block(resp_bpf_t* f, const double* x, const double* t, double* out, size_t n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,153 @@
+//
+//  ring.hpp
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Fixed-capacity sliding window with O(1) statistics:
+//    - power-of-two storage, indexed by a free-running sequence & mask
+//    - mean / variance from shifted running sums (double accumulators),
+//      recomputed from the buffer every 4N pushes so round-off cannot build
+//      up over a night
+//    - sliding min / max from monotonic deques (amortised O(1) per push)
+//    - spans(): the window as at most two contiguous runs, oldest first,
+//      for handing to vector kernels without a copy
+//  clear() is O(1); stale slots are never read.
+//
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#include "asm_compat.h"
+
+namespace st {
+
+template <typename T, size_t N>
+class Ring {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "Ring capacity must be a power of two");
+  static constexpr size_t kMask = N - 1;
+  static constexpr size_t kResync = 4 * N;
+
+public:
+  struct Spans {
+    const T* a; size_t na;   // older part
+    const T* b; size_t nb;   // newer part (nb == 0 unless the window wraps)
+  };
+
+  static constexpr size_t capacity() { return N; }
+  size_t size() const  { return count_; }
+  bool   empty() const { return count_ == 0; }
+  bool   full() const  { return count_ == N; }
+
+  void clear() {
+    count_ = 0;
+    shift_ = 0; sd_ = 0; sdd_ = 0;
+    sinceResync_ = 0;
+    maxQ_.clear(); minQ_.clear();
+  }
+
+  void push(T x) {
+    const size_t s = seq_++;
+    if (count_ == N) {
+      const double d = (double)buf_[s & kMask] - shift_;
+      sd_ -= d; sdd_ -= d * d;
+    } else {
+      if (count_ == 0) shift_ = (double)x;
+      ++count_;
+    }
+    buf_[s & kMask] = x;
+    const double d = (double)x - shift_;
+    sd_ += d; sdd_ += d * d;
+
+    const size_t first = seq_ - count_;
+    maxQ_.dropBefore(first);
+    minQ_.dropBefore(first);
+    while (!maxQ_.empty() && !(buf_[maxQ_.back() & kMask] > x)) maxQ_.popBack();
+    while (!minQ_.empty() && !(buf_[minQ_.back() & kMask] < x)) minQ_.popBack();
+    maxQ_.pushBack(s);
+    minQ_.pushBack(s);
+
+    if (++sinceResync_ >= kResync) resync();
+  }
+
+  // Same as n push() calls. Only the last N values can stay in the window.
+  void push(const T* x, size_t n) {
+    if (n > N) { x += n - N; n = N; }
+    for (size_t i = 0; i < n; ++i) push(x[i]);
+  }
+
+  // i = 0 is the oldest sample.
+  T operator[](size_t i) const { return buf_[(seq_ - count_ + i) & kMask]; }
+  T back() const               { return buf_[(seq_ - 1) & kMask]; }
+
+  double sum() const  { return shift_ * (double)count_ + sd_; }
+  double mean() const { return count_ ? shift_ + sd_ / (double)count_ : 0.0; }
+  // Sample variance (n - 1); 0 with fewer than two samples.
+  double variance() const {
+    if (count_ < 2) return 0.0;
+    const double v = (sdd_ - sd_ * sd_ / (double)count_) / (double)(count_ - 1);
+    return v > 0 ? v : 0.0;
+  }
+  // Undefined when empty.
+  T max() const { return buf_[maxQ_.front() & kMask]; }
+  T min() const { return buf_[minQ_.front() & kMask]; }
+
+  Spans spans() const {
+    const size_t start = (seq_ - count_) & kMask;
+    const size_t na = std::min(count_, N - start);
+    return {buf_ + start, na, buf_, count_ - na};
+  }
+
+  void copyTo(T* out) const {
+    const Spans s = spans();
+    std::copy(s.a, s.a + s.na, out);
+    std::copy(s.b, s.b + s.nb, out + s.na);
+  }
+
+private:
+  // Re-centre on the current mean and sum the window afresh.
+  void resync() {
+    sinceResync_ = 0;
+    if (count_ == 0) return;
+    shift_ = mean();
+    const Spans s = spans();
+    double sd = 0, sdd = 0;
+    for (size_t i = 0; i < s.na; ++i) { const double d = (double)s.a[i] - shift_; sd += d; sdd += d * d; }
+    for (size_t i = 0; i < s.nb; ++i) { const double d = (double)s.b[i] - shift_; sd += d; sdd += d * d; }
+    sd_ = sd; sdd_ = sdd;
+  }
+
+  // Deque of sequence numbers, at most N live entries.
+  struct Deque {
+    size_t idx[N];
+    size_t head{0}, tail{0};
+    bool   empty() const { return head == tail; }
+    void   clear() { head = tail = 0; }
+    size_t front() const { return idx[head & kMask]; }
+    size_t back() const { return idx[(tail - 1) & kMask]; }
+    void   popBack() { --tail; }
+    void   pushBack(size_t s) { idx[tail++ & kMask] = s; }
+    // The window start moves by at most one per push.
+    void   dropBefore(size_t s) { if (head != tail && idx[head & kMask] < s) ++head; }
+  };
+
+  T      buf_[N]{};
+  size_t seq_{0};
+  size_t count_{0};
+  double shift_{0}, sd_{0}, sdd_{0};
+  size_t sinceResync_{0};
+  Deque  maxQ_{}, minQ_{};
+};
+
+// w[0] pairs with the oldest sample; w must hold r.size() weights.
+template <size_t N>
+inline float dot(const Ring<float, N>& r, const float* w) {
+  const typename Ring<float, N>::Spans s = r.spans();
+  float acc = s.na ? dot_f32_accel(s.a, w, s.na) : 0.0f;
+  if (s.nb) acc += dot_f32_accel(s.b, w + s.na, s.nb);
+  return acc;
+}
+
+} // namespace st
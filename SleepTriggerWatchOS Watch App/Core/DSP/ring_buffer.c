@@ -53,6 +53,31 @@ void ringf_push(ringf_t *r, float x) {
     }
 }
 
+void ringf_push_block(ringf_t *r, const float *x, size_t n) {
+    if (!r || !r->buf || !x) return;
+    float *buf = r->buf;
+    const size_t cap = r->cap;
+    size_t head = r->head, count = r->count;
+    float sum = r->sum;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (count < cap) {
+            buf[head] = x[i];
+            sum += x[i];
+            count++;
+        } else {
+            float old = buf[head];
+            buf[head] = x[i];
+            sum += (x[i] - old);
+        }
+        head = (head + 1) % cap;
+    }
+
+    r->head = head;
+    r->count = count;
+    r->sum = sum;
+}
+
 size_t ringf_count(const ringf_t *r)     { return r ? r->count : 0; }
 size_t ringf_capacity(const ringf_t *r)  { return r ? r->cap   : 0; }
 
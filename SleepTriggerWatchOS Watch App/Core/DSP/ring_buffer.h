@@ -27,6 +27,7 @@ int  ringf_init(ringf_t *r, size_t capacity);
 void ringf_free(ringf_t *r);
 void ringf_clear(ringf_t *r);
 void ringf_push(ringf_t *r, float x);  // overwrites oldest when full
+void ringf_push_block(ringf_t *r, const float *x, size_t n); // same as n ringf_push calls
 size_t ringf_count(const ringf_t *r);
 size_t ringf_capacity(const ringf_t *r);
 float ringf_mean(const ringf_t *r);
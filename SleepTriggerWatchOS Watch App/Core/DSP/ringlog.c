@@ -6,35 +6,189 @@
 //
 
 #include "ringlog.h"
+#include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(rlog_hdr_t) == RLOG_HEADER_SIZE, "ring log header must stay 64 bytes");
+_Static_assert(sizeof(rlog_rec_t) == 21, "ring log records are 21 bytes on disk");
+
+static size_t file_size(uint32_t cap) {
+  return (size_t)RLOG_HEADER_SIZE + (size_t)cap * sizeof(rlog_rec_t);
+}
+
+static int header_matches(const rlog_hdr_t* h, uint32_t cap) {
+  return h->magic == RLOG_MAGIC && h->version == RLOG_VERSION &&
+         h->recSize == sizeof(rlog_rec_t) && h->capacity == cap;
+}
 
 int rlog_open(rlog_t* r, const char* path, uint32_t cap) {
-  r->fp = fopen(path, "wb+");
-  if (!r->fp) return -1;
+  memset(r, 0, sizeof(*r));
+  r->fd = -1;
+  if (cap < 2) return -1;
+
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0) { close(fd); return -1; }
+
+  const size_t len = file_size(cap);
+  int fresh = (size_t)st.st_size != len;
+  if (fresh && ftruncate(fd, 0) != 0) { close(fd); return -1; }
+  if (fresh && ftruncate(fd, (off_t)len) != 0) { close(fd); return -1; }
+
+  void* m = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (m == MAP_FAILED) { close(fd); return -1; }
+
+  r->fd = fd;
+  r->map = (uint8_t*)m;
+  r->mapLen = len;
+  r->hdr = (rlog_hdr_t*)m;
+  r->recs = r->map + RLOG_HEADER_SIZE;
   r->capacity = cap;
-  r->recSize  = sizeof(rlog_rec_t);
+  r->recSize = sizeof(rlog_rec_t);
+  r->syncMode = RLOG_SYNC_ASYNC;
+  r->syncEvery = 64;
+
+  if (fresh || !header_matches(r->hdr, cap)) {
+    // Publish the header last so a crash mid-format leaves no valid magic.
+    memset(r->map, 0, len);
+    r->hdr->version = RLOG_VERSION;
+    r->hdr->recSize = r->recSize;
+    r->hdr->capacity = cap;
+    r->hdr->count = 0;
+    r->hdr->generation = 0;
+    __atomic_store_n(&r->hdr->magic, RLOG_MAGIC, __ATOMIC_RELEASE);
+  }
+  __atomic_store_n(&r->hdr->generation, r->hdr->generation + 1, __ATOMIC_RELEASE);
+  msync(r->map, RLOG_HEADER_SIZE, MS_SYNC);
   return 0;
 }
 
+static int maybe_sync(rlog_t* r, uint32_t added) {
+  if (r->syncMode == RLOG_SYNC_NONE) return 0;
+  r->pending += added;
+  if (r->pending < r->syncEvery) return 0;
+  r->pending = 0;
+  return msync(r->map, r->mapLen, r->syncMode == RLOG_SYNC_FULL ? MS_SYNC : MS_ASYNC) == 0 ? 0 : -1;
+}
+
 int rlog_write(rlog_t* r, const rlog_rec_t* rec) {
-  if (!r->fp) return -1;
-
-  // write one record
-  if (fwrite(rec, r->recSize, 1, r->fp) != 1) return -1;
-
-  // wrap to start when file reaches capacity
-  long size = ftell(r->fp);
-  long max  = (long)r->capacity * (long)r->recSize;
-  if (size >= max) {
-    fflush(r->fp);
-    fseek(r->fp, 0L, SEEK_SET);
-  } else {
-    fflush(r->fp);
+  if (!r->map) return -1;
+  uint64_t c = r->hdr->count;
+  memcpy(r->recs + (size_t)(c % r->capacity) * r->recSize, rec, r->recSize);
+  __atomic_store_n(&r->hdr->count, c + 1, __ATOMIC_RELEASE);
+  return maybe_sync(r, 1);
+}
+
+int rlog_write_block(rlog_t* r, const rlog_rec_t* recs, size_t n) {
+  if (!r->map) return -1;
+  // Publish record by record: the slot for record c holds c - capacity,
+  // which is already outside the visible window, so at most one slot is
+  // ever in flight. Only the msync is batched.
+  uint64_t c = r->hdr->count;
+  size_t slot = (size_t)(c % r->capacity);
+  for (size_t i = 0; i < n; ++i) {
+    memcpy(r->recs + slot * r->recSize, &recs[i], r->recSize);
+    __atomic_store_n(&r->hdr->count, ++c, __ATOMIC_RELEASE);
+    if (++slot == r->capacity) slot = 0;
   }
-  return 0;
+  return n ? maybe_sync(r, n > UINT32_MAX ? UINT32_MAX : (uint32_t)n) : 0;
+}
+
+void rlog_set_sync(rlog_t* r, rlog_sync_t mode, uint32_t every) {
+  r->syncMode = mode;
+  r->syncEvery = every ? every : 1;
+  r->pending = 0;
+}
+
+int rlog_sync(rlog_t* r) {
+  if (!r->map) return -1;
+  r->pending = 0;
+  return msync(r->map, r->mapLen, MS_SYNC) == 0 ? 0 : -1;
+}
+
+uint64_t rlog_count(const rlog_t* r) {
+  return r->map ? __atomic_load_n(&r->hdr->count, __ATOMIC_ACQUIRE) : 0;
 }
 
 void rlog_close(rlog_t* r) {
-  if (r->fp) fclose(r->fp);
-  r->fp = NULL;
+  if (r->map) {
+    msync(r->map, r->mapLen, MS_SYNC);
+    munmap(r->map, r->mapLen);
+  }
+  if (r->fd >= 0) close(r->fd);
+  r->map = NULL;
+  r->hdr = NULL;
+  r->recs = NULL;
+  r->fd = -1;
+}
+
+// ---- reader ----
+
+static void reader_view(rlog_reader_t* rd, const uint8_t* map) {
+  const rlog_hdr_t* h = (const rlog_hdr_t*)map;
+  const rlog_rec_t* recs = (const rlog_rec_t*)(map + RLOG_HEADER_SIZE);
+  uint64_t count = __atomic_load_n(&h->count, __ATOMIC_ACQUIRE);
+  rlog_reader_t v = {0};
+  v.map = rd->map;
+  v.mapLen = rd->mapLen;
+  v.generation = h->generation;
+  // The slot at the head may hold a half-written record from a crash, so
+  // a full ring exposes capacity - 1 records.
+  const uint64_t keep = h->capacity - 1;
+  const uint64_t first = count > keep ? count - keep : 0;
+  const size_t n = (size_t)(count - first);
+  const size_t slot = (size_t)(first % h->capacity);
+  v.a = recs + slot;
+  v.na = n < h->capacity - slot ? n : h->capacity - slot;
+  v.b = recs;
+  v.nb = n - v.na;
+  *rd = v;
+}
+
+int rlog_reader_open(rlog_reader_t* rd, const char* path) {
+  memset(rd, 0, sizeof(*rd));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < RLOG_HEADER_SIZE) { close(fd); return -1; }
+  void* m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) return -1;
+
+  const rlog_hdr_t* h = (const rlog_hdr_t*)m;
+  if (!header_matches(h, h->capacity) || h->capacity < 2 ||
+      (size_t)st.st_size != file_size(h->capacity)) {
+    munmap(m, (size_t)st.st_size);
+    return -1;
+  }
+  rd->map = (const uint8_t*)m;
+  rd->mapLen = (size_t)st.st_size;
+  reader_view(rd, rd->map);
+  return 0;
+}
+
+void rlog_reader_attach(rlog_reader_t* rd, const rlog_t* r) {
+  memset(rd, 0, sizeof(*rd));
+  if (r->map) reader_view(rd, r->map);
+  rd->map = NULL;       // borrowed: close must not unmap the writer
+  rd->mapLen = 0;
+}
+
+size_t rlog_reader_size(const rlog_reader_t* rd) { return rd->na + rd->nb; }
+
+const rlog_rec_t* rlog_reader_next(rlog_reader_t* rd) {
+  size_t i = rd->pos;
+  if (i < rd->na) { rd->pos++; return rd->a + i; }
+  i -= rd->na;
+  if (i < rd->nb) { rd->pos++; return rd->b + i; }
+  return NULL;
+}
+
+void rlog_reader_close(rlog_reader_t* rd) {
+  if (rd->map) munmap((void*)rd->map, rd->mapLen);
+  memset(rd, 0, sizeof(*rd));
 }
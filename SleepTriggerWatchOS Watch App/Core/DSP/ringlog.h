@@ -4,20 +4,30 @@
 //
 //  Created by Daniel Hu on 2025-08-14.
 //
+//  Fixed-size on-disk ring of rlog_rec_t, memory-mapped. Layout:
+//
+//    [rlog_hdr_t, 64 bytes][capacity x recSize records]
+//
+//  The header carries a monotonic record count, so the ring position
+//  survives reopen and crashes: a record is copied into its slot first and
+//  only then published by bumping `count`, so a torn write is never visible.
+//  The head slot is the one being overwritten, so readers see at most
+//  capacity - 1 records.
+//  Reopening a file whose header matches (magic, version, recSize,
+//  capacity) resumes where it left off; anything else is reformatted.
+//
 
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
-#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef struct {
-  FILE* fp;
-  uint32_t capacity; // number of records
-  uint32_t recSize;
-} rlog_t;
+#define RLOG_MAGIC       0x474F4C52u   // "RLOG" little-endian
+#define RLOG_VERSION     1u
+#define RLOG_HEADER_SIZE 64u
 
 typedef struct __attribute__((packed)) {
   double t;        // seconds since reference
@@ -27,9 +37,77 @@ typedef struct __attribute__((packed)) {
   uint8_t state;   // 0/1/2
 } rlog_rec_t;
 
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t recSize;
+  uint32_t capacity;     // records
+  uint64_t count;        // records ever written; head = count % capacity
+  uint64_t generation;   // bumped on every open, lets readers spot a new session
+  uint8_t  reserved[RLOG_HEADER_SIZE - 32];
+} rlog_hdr_t;
+
+// When rlog_write pushes dirty pages towards storage. The mapping itself is
+// crash-safe for the process in every mode; these only matter for power loss.
+typedef enum {
+  RLOG_SYNC_NONE = 0,    // leave write-back to the kernel
+  RLOG_SYNC_ASYNC = 1,   // msync(MS_ASYNC) every `every` records (default, 64)
+  RLOG_SYNC_FULL = 2     // msync(MS_SYNC) every `every` records
+} rlog_sync_t;
+
+typedef struct {
+  int          fd;
+  uint8_t*     map;
+  size_t       mapLen;
+  rlog_hdr_t*  hdr;
+  uint8_t*     recs;
+  uint32_t     capacity; // number of records
+  uint32_t     recSize;
+  rlog_sync_t  syncMode;
+  uint32_t     syncEvery;
+  uint32_t     pending;  // records since last msync
+} rlog_t;
+
+// Returns 0 on success, -1 on I/O error or capacity < 2.
 int  rlog_open(rlog_t* r, const char* path, uint32_t capacity);
 int  rlog_write(rlog_t* r, const rlog_rec_t* rec);
-void rlog_close(rlog_t* r);
+// Same as n rlog_write calls, with at most one msync for the whole block.
+int  rlog_write_block(rlog_t* r, const rlog_rec_t* recs, size_t n);
+void rlog_set_sync(rlog_t* r, rlog_sync_t mode, uint32_t every);
+int  rlog_sync(rlog_t* r);               // msync(MS_SYNC) now
+uint64_t rlog_count(const rlog_t* r);    // records ever written
+void rlog_close(rlog_t* r);              // syncs, then unmaps
+
+// Zero-copy view of the valid records, oldest first. The records live in
+// the mapping: at most two contiguous runs (before and after the wrap).
+typedef struct {
+  const uint8_t*    map;     // owned when opened from a path
+  size_t            mapLen;
+  const rlog_rec_t* a;       // older run
+  size_t            na;
+  const rlog_rec_t* b;       // newer run (starts at slot 0)
+  size_t            nb;
+  size_t            pos;     // iteration cursor over a ++ b
+  uint64_t          generation;
+} rlog_reader_t;
+
+// Map `path` read-only and validate its header. Returns 0, or -1 if the file
+// is missing, truncated or not a ring log.
+int  rlog_reader_open(rlog_reader_t* rd, const char* path);
+// Snapshot the view of a live writer (no mapping of its own).
+void rlog_reader_attach(rlog_reader_t* rd, const rlog_t* r);
+size_t rlog_reader_size(const rlog_reader_t* rd);
+// Next record in chronological order, or NULL at the end.
+const rlog_rec_t* rlog_reader_next(rlog_reader_t* rd);
+void rlog_reader_close(rlog_reader_t* rd);
+
+// Stream the reader's remaining records through an export_stream writer
+// (ringlog_export.c). CSV columns: t,hr,still,prop,state. The binary form is
+// an es_bin header followed by the records verbatim (21 bytes each).
+// Both consume the reader and return es_flush's result.
+struct es_writer;
+int rlog_export_csv(rlog_reader_t* rd, struct es_writer* w);
+int rlog_export_bin(rlog_reader_t* rd, struct es_writer* w);
 
 #ifdef __cplusplus
 }
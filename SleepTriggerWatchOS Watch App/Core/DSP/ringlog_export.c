@@ -0,0 +1,32 @@
+//
+//  ringlog_export.c
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#include "ringlog.h"
+#include "export_stream.h"
+
+int rlog_export_csv(rlog_reader_t* rd, es_writer_t* w) {
+  static const uint8_t decimals[5] = {3, 2, 4, 4, 0};
+  es_puts(w, "t,hr,still,prop,state\n");
+  for (const rlog_rec_t* r; (r = rlog_reader_next(rd));) {
+    const double row[5] = {r->t, r->hr, r->still, r->prop, r->state};
+    es_csv_row_f64(w, row, decimals, 5);
+  }
+  return es_flush(w);
+}
+
+int rlog_export_bin(rlog_reader_t* rd, es_writer_t* w) {
+  static const char* const names[5] = {"t", "hr", "still", "prop", "state"};
+  static const uint8_t types[5] = {ES_COL_F64, ES_COL_F32, ES_COL_F32, ES_COL_F32, ES_COL_U8};
+  es_bin_header(w, names, types, 5);
+  // rlog_rec_t is packed in the same column order, so the runs go out as-is.
+  size_t skip = rd->pos;
+  if (skip < rd->na) es_put(w, rd->a + skip, (rd->na - skip) * sizeof(rlog_rec_t));
+  skip = skip > rd->na ? skip - rd->na : 0;
+  if (skip < rd->nb) es_put(w, rd->b + skip, (rd->nb - skip) * sizeof(rlog_rec_t));
+  rd->pos = rd->na + rd->nb;
+  return es_flush(w);
+}
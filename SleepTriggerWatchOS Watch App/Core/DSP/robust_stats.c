@@ -10,44 +10,165 @@
 #include <math.h>
 #include <stdlib.h>
 
-static int cmpd(const void* a, const void* b){
-    double da = *(const double*)a, db = *(const double*)b;
-    return (da<db)?-1:((da>db)?+1:0);
+// ---- sorted-window order statistics (shared by both Hampel variants) ----
+
+// First index in sorted[0..n) whose value is >= x.
+static int lower_bound(const double* s, int n, double x){
+  int lo = 0, hi = n;
+  while (lo < hi) {
+    int mid = (lo + hi) >> 1;
+    if (s[mid] < x) lo = mid + 1; else hi = mid;
+  }
+  return lo;
 }
 
-void rs_hampel_init(rs_hampel_t* h, int windowOdd, double nsigma){
-  if (windowOdd < 3) windowOdd = 3;
-  if (windowOdd > RS_HAMPEL_MAX) windowOdd = RS_HAMPEL_MAX;
-  if ((windowOdd % 2) == 0) windowOdd -= 1;
-  memset(h, 0, sizeof(*h));
-  h->size = windowOdd;
-  h->nsigma = nsigma;
+// Insert x into sorted[0..n) (capacity > n).
+static void sorted_insert(double* s, int n, double x){
+  int pos = lower_bound(s, n, x);
+  memmove(s + pos + 1, s + pos, (size_t)(n - pos) * sizeof(double));
+  s[pos] = x;
 }
 
-double rs_hampel_update(rs_hampel_t* h, double x){
-  h->buf[h->idx] = x;
-  h->idx = (h->idx + 1) % h->size;
-  if (h->filled < h->size) h->filled++;
+// Replace one occurrence of `old` in sorted[0..n) by x, shifting only the
+// span between the two positions.
+static void sorted_replace(double* s, int n, double old, double x){
+  int from = lower_bound(s, n, old);
+  if (x >= old) {
+    int to = lower_bound(s, n, x) - 1;            // last slot < x
+    if (to < from) to = from;
+    memmove(s + from, s + from + 1, (size_t)(to - from) * sizeof(double));
+    s[to] = x;
+  } else {
+    int to = lower_bound(s, n, x);
+    memmove(s + to + 1, s + to, (size_t)(from - to) * sizeof(double));
+    s[to] = x;
+  }
+}
 
-  h->last = x;
+// k-th smallest (0-based) of |s[i] - m| for sorted s with m = s[h], h = n/2.
+// Deviations form two ascending runs: A[t] = m - s[h-1-t] (t < h) and
+// B[t] = s[h+t] - m (t < n-h); select over their merge by binary search.
+static double sorted_abs_dev_kth(const double* s, int n, int k){
+  const int h = n / 2;
+  const double m = s[h];
+  const int a = h, b = n - h, take = k + 1;
+  int lo = (take > b) ? take - b : 0;
+  int hi = (take < a) ? take : a;
+  for (;;) {
+    int i = (lo + hi) >> 1;          // elements taken from A
+    int j = take - i;                // elements taken from B
+    double aPrev = (i > 0) ? m - s[h - i]     : -INFINITY; // A[i-1]
+    double aNext = (i < a) ? m - s[h - 1 - i] :  INFINITY; // A[i]
+    double bPrev = (j > 0) ? s[h + j - 1] - m : -INFINITY; // B[j-1]
+    double bNext = (j < b) ? s[h + j] - m     :  INFINITY; // B[j]
+    if (aPrev > bNext)      hi = i - 1;
+    else if (bPrev > aNext) lo = i + 1;
+    else return (aPrev > bPrev) ? aPrev : bPrev;
+  }
+}
 
-  // compute median & MAD on copy (small windows only)
-  int n = h->filled;
-  double tmp[RS_HAMPEL_MAX];
-  for (int i=0;i<n;++i) tmp[i]=h->buf[i];
-  qsort(tmp, n, sizeof(double), cmpd);
-  double median = tmp[n/2];
+// Push x into the ring/sorted pair and apply the Hampel decision. A NaN or
+// inf would break the ordering the sorted window relies on, so it passes
+// through unchanged and never enters the window.
+static inline double hampel_step(double* buf, double* sorted, int size, int* idx, int* filled,
+                          double nsigma, double x){
+  if (!isfinite(x)) return x;
+  if (*filled < size) {
+    sorted_insert(sorted, *filled, x);
+    (*filled)++;
+  } else {
+    sorted_replace(sorted, size, buf[*idx], x);
+  }
+  buf[*idx] = x;
+  *idx = (*idx + 1 == size) ? 0 : *idx + 1;
 
-  for (int i=0;i<n;++i) tmp[i] = fabs(h->buf[i] - median);
-  qsort(tmp, n, sizeof(double), cmpd);
-  double mad = tmp[n/2];
+  int n = *filled;
+  double median = sorted[n/2];
+  double mad = sorted_abs_dev_kth(sorted, n, n/2);
   double sigma = 1.4826 * mad; // Gauss approx
 
   if (sigma <= 1e-9) return x; // not enough variation
 
-  if (fabs(x - median) > h->nsigma * sigma) {
+  if (fabs(x - median) > nsigma * sigma) {
     // replace outlier by median
     return median;
   }
   return x;
 }
+
+static int hampel_window(int windowOdd, int maxSize){
+  if (windowOdd < 3) windowOdd = 3;
+  if (windowOdd > maxSize) windowOdd = maxSize;
+  if ((windowOdd % 2) == 0) windowOdd -= 1;
+  return windowOdd;
+}
+
+// ---- fixed-capacity Hampel ----
+
+void rs_hampel_init(rs_hampel_t* h, int windowOdd, double nsigma){
+  memset(h, 0, sizeof(*h));
+  h->size = hampel_window(windowOdd, RS_HAMPEL_MAX);
+  h->nsigma = nsigma;
+}
+
+double rs_hampel_update(rs_hampel_t* h, double x){
+  h->last = x;
+  return hampel_step(h->buf, h->sorted, h->size, &h->idx, &h->filled, h->nsigma, x);
+}
+
+void rs_hampel_process_block(rs_hampel_t* h, const double* in, double* out, size_t n){
+  if (!h || !in || !out || n == 0) return;
+  int idx = h->idx, filled = h->filled;
+  const int size = h->size;
+  const double nsigma = h->nsigma;
+  double x = h->last;
+  for (size_t i=0;i<n;++i) {
+    x = in[i];
+    out[i] = hampel_step(h->buf, h->sorted, size, &idx, &filled, nsigma, x);
+  }
+  h->idx = idx; h->filled = filled; h->last = x;
+}
+
+// ---- long-window Hampel ----
+
+int rs_hampelw_init(rs_hampelw_t* h, int windowOdd, double nsigma){
+  if (!h) return -1;
+  memset(h, 0, sizeof(*h));
+  h->size = hampel_window(windowOdd, RS_HAMPELW_MAX);
+  h->nsigma = nsigma;
+  h->buf = (double*)calloc((size_t)h->size * 2, sizeof(double));
+  if (!h->buf) return -2;
+  h->sorted = h->buf + h->size;
+  return 0;
+}
+
+void rs_hampelw_free(rs_hampelw_t* h){
+  if (!h) return;
+  free(h->buf);
+  h->buf = h->sorted = NULL;
+  h->size = h->idx = h->filled = 0;
+}
+
+void rs_hampelw_reset(rs_hampelw_t* h){
+  if (!h) return;
+  h->idx = 0; h->filled = 0; h->last = 0;
+}
+
+double rs_hampelw_update(rs_hampelw_t* h, double x){
+  if (!h || !h->buf) return x;
+  h->last = x;
+  return hampel_step(h->buf, h->sorted, h->size, &h->idx, &h->filled, h->nsigma, x);
+}
+
+void rs_hampelw_process_block(rs_hampelw_t* h, const double* in, double* out, size_t n){
+  if (!h || !h->buf || !in || !out || n == 0) return;
+  int idx = h->idx, filled = h->filled;
+  const int size = h->size;
+  const double nsigma = h->nsigma;
+  double x = h->last;
+  for (size_t i=0;i<n;++i) {
+    x = in[i];
+    out[i] = hampel_step(h->buf, h->sorted, size, &idx, &filled, nsigma, x);
+  }
+  h->idx = idx; h->filled = filled; h->last = x;
+}
@@ -41,6 +41,13 @@ static inline void rs_eq_update(rs_eq_t* s, double x){
 }
 
 // -------- Hampel filter (windowed MAD around median) ----------
+// Both variants keep the window twice: in arrival order (ring) and sorted.
+// Each sample replaces the oldest value in the sorted copy with one binary
+// search + one shift, then reads the median directly and the MAD by a
+// k-th-smallest search over the two sorted deviation runs either side of the
+// median (O(log w) comparisons). Output matches the original copy+qsort
+// formulation exactly: median = sorted[n/2], MAD = sorted|x-median|[n/2].
+// Non-finite samples are returned unchanged and do not enter the window.
 #define RS_HAMPEL_MAX 15
 typedef struct {
   double buf[RS_HAMPEL_MAX];
@@ -49,10 +56,33 @@ typedef struct {
   int    filled;
   double last;
   double nsigma; // typically 3.0
+  double sorted[RS_HAMPEL_MAX];
 } rs_hampel_t;
 
 void   rs_hampel_init(rs_hampel_t* h, int windowOdd, double nsigma);
 double rs_hampel_update(rs_hampel_t* h, double x);
+void   rs_hampel_process_block(rs_hampel_t* h, const double* in, double* out, size_t n);
+
+// Heap-backed variant for long windows (e.g. 61..301 samples of 1 Hz HR).
+// The search is O(log w) but the shift is an O(w) memmove; at w = 4095 that
+// is still only ~2.5x the cost of w = 61 (dsp_bench rs_hampelw_update/w*).
+#define RS_HAMPELW_MAX 4095
+typedef struct {
+  double* buf;    // arrival order
+  double* sorted; // ascending
+  int    size;    // odd, 3..RS_HAMPELW_MAX
+  int    idx;
+  int    filled;
+  double last;
+  double nsigma;
+} rs_hampelw_t;
+
+// Return 0 on success, nonzero on allocation failure/invalid window.
+int    rs_hampelw_init(rs_hampelw_t* h, int windowOdd, double nsigma);
+void   rs_hampelw_free(rs_hampelw_t* h);
+void   rs_hampelw_reset(rs_hampelw_t* h);
+double rs_hampelw_update(rs_hampelw_t* h, double x);
+void   rs_hampelw_process_block(rs_hampelw_t* h, const double* in, double* out, size_t n);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,150 @@
+//
+//  sample_queue.c
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#include "sample_queue.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SQ_LINE 64
+
+struct sq_queue {
+    // Producer line.
+    _Alignas(SQ_LINE) _Atomic uint64_t head;
+    uint64_t          tailCache;
+    _Atomic uint64_t  dropped;
+    // Consumer line.
+    _Alignas(SQ_LINE) _Atomic uint64_t tail;
+    uint64_t          headCache;
+    // Read-only after create.
+    _Alignas(SQ_LINE) size_t mask;
+    sq_sample_t*      buf;
+};
+
+static void* alloc_lines(size_t bytes) {
+    bytes = (bytes + SQ_LINE - 1) & ~(size_t)(SQ_LINE - 1);
+    void* p = NULL;
+    if (posix_memalign(&p, SQ_LINE, bytes) != 0) return NULL;
+    memset(p, 0, bytes);
+    return p;
+}
+
+sq_queue_t* sq_queue_create(size_t capacity) {
+    size_t cap = 16;
+    while (cap < capacity) cap <<= 1;
+    sq_queue_t* q = (sq_queue_t*)alloc_lines(sizeof(sq_queue_t));
+    if (!q) return NULL;
+    q->buf = (sq_sample_t*)alloc_lines(cap * sizeof(sq_sample_t));
+    if (!q->buf) { free(q); return NULL; }
+    q->mask = cap - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->dropped, 0);
+    return q;
+}
+
+void sq_queue_destroy(sq_queue_t* q) {
+    if (!q) return;
+    free(q->buf);
+    free(q);
+}
+
+size_t sq_queue_capacity(const sq_queue_t* q) { return q ? q->mask + 1 : 0; }
+
+int sq_push(sq_queue_t* q, const sq_sample_t* s) {
+    const uint64_t h = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (h - q->tailCache > q->mask) {
+        q->tailCache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (h - q->tailCache > q->mask) {
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            return -1;
+        }
+    }
+    q->buf[h & q->mask] = *s;
+    atomic_store_explicit(&q->head, h + 1, memory_order_release);
+    return 0;
+}
+
+uint64_t sq_dropped(const sq_queue_t* q) {
+    return atomic_load_explicit(&((sq_queue_t*)q)->dropped, memory_order_relaxed);
+}
+
+size_t sq_pop_batch(sq_queue_t* q, sq_sample_t* out, size_t max) {
+    const uint64_t t = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (q->headCache - t < max)
+        q->headCache = atomic_load_explicit(&q->head, memory_order_acquire);
+    uint64_t n = q->headCache - t;
+    if (n > max) n = max;
+    if (n == 0) return 0;
+    const size_t start = (size_t)(t & q->mask), cap = q->mask + 1;
+    const size_t first = (size_t)n < cap - start ? (size_t)n : cap - start;
+    memcpy(out, q->buf + start, first * sizeof(sq_sample_t));
+    memcpy(out + first, q->buf, ((size_t)n - first) * sizeof(sq_sample_t));
+    atomic_store_explicit(&q->tail, t + n, memory_order_release);
+    return (size_t)n;
+}
+
+size_t sq_size(const sq_queue_t* q) {
+    sq_queue_t* m = (sq_queue_t*)q;
+    const uint64_t t = atomic_load_explicit(&m->tail, memory_order_acquire);
+    const uint64_t h = atomic_load_explicit(&m->head, memory_order_acquire);
+    return (size_t)(h - t);
+}
+
+// ---- seqlock ----
+//
+// Boehm, "Can seqlocks get along with programming language memory models?"
+// (MSPC 2012): the payload is stored as relaxed atomic words, so a reader
+// that races a write reads stale words rather than invoking a data race, and
+// the sequence check throws that copy away.
+
+#define SQ_WORDS (SQ_SEQLOCK_MAX_BYTES / 8)
+
+struct sq_seqlock {
+    _Alignas(SQ_LINE) _Atomic uint64_t seq;   // odd while a write is in flight
+    size_t            bytes;
+    _Atomic uint64_t  words[SQ_WORDS];
+};
+
+sq_seqlock_t* sq_seqlock_create(size_t bytes) {
+    if (bytes == 0 || bytes > SQ_SEQLOCK_MAX_BYTES) return NULL;
+    sq_seqlock_t* l = (sq_seqlock_t*)alloc_lines(sizeof(sq_seqlock_t));
+    if (!l) return NULL;
+    atomic_init(&l->seq, 0);
+    for (size_t i = 0; i < SQ_WORDS; ++i) atomic_init(&l->words[i], 0);
+    l->bytes = bytes;
+    return l;
+}
+
+void sq_seqlock_destroy(sq_seqlock_t* l) { free(l); }
+
+void sq_seqlock_write(sq_seqlock_t* l, const void* value) {
+    uint64_t w[SQ_WORDS] = {0};
+    memcpy(w, value, l->bytes);
+    const size_t n = (l->bytes + 7) / 8;
+    const uint64_t s = atomic_load_explicit(&l->seq, memory_order_relaxed);
+    atomic_store_explicit(&l->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < n; ++i) atomic_store_explicit(&l->words[i], w[i], memory_order_relaxed);
+    atomic_store_explicit(&l->seq, s + 2, memory_order_release);
+}
+
+uint64_t sq_seqlock_read(const sq_seqlock_t* cl, void* out) {
+    sq_seqlock_t* l = (sq_seqlock_t*)cl;
+    uint64_t w[SQ_WORDS];
+    const size_t n = (l->bytes + 7) / 8;
+    for (;;) {
+        const uint64_t s1 = atomic_load_explicit(&l->seq, memory_order_acquire);
+        if (s1 & 1) continue;
+        for (size_t i = 0; i < n; ++i) w[i] = atomic_load_explicit(&l->words[i], memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&l->seq, memory_order_relaxed) == s1) {
+            memcpy(out, w, l->bytes);
+            return s1 / 2;
+        }
+    }
+}
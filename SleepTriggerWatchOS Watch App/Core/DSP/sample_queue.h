@@ -0,0 +1,89 @@
+//
+//  sample_queue.h
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Lock-free hand-off between sensor callbacks, the DSP thread and the UI:
+//
+//    sq_queue_t    single-producer / single-consumer ring of timestamped
+//                  samples. Producer and consumer indices sit on their own
+//                  cache lines, each side caches the other's index and only
+//                  reloads it when the ring looks full / empty, so a push or
+//                  pop touches shared lines only when it has to.
+//    sq_seqlock_t  single-writer, many-reader latest-value cell. The writer
+//                  never waits; readers retry while a write is in flight.
+//
+//  Both are opaque (C11 atomics inside) so Swift only sees pointers.
+//  "Single producer" means pushes are serialised, not that they come from one
+//  thread: a serial dispatch/operation queue qualifies.
+//
+
+#ifndef SAMPLE_QUEUE_H
+#define SAMPLE_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SQ_HEART_RATE = 0,   // value = bpm
+    SQ_STILLNESS  = 1,   // value = stillness score 0..1
+    SQ_CONTROL    = 2,   // value = command (owner-defined)
+} sq_kind_t;
+
+typedef struct {
+    double  t;       // seconds since 1970
+    double  value;
+    int32_t kind;    // sq_kind_t
+    int32_t reserved;
+} sq_sample_t;
+
+typedef struct sq_queue sq_queue_t;
+
+// capacity is rounded up to a power of two (min 16). NULL on failure.
+sq_queue_t* sq_queue_create(size_t capacity);
+void        sq_queue_destroy(sq_queue_t* q);
+size_t      sq_queue_capacity(const sq_queue_t* q);
+
+// Producer side. Returns 0, or -1 if the ring is full (the sample is
+// dropped and counted).
+int         sq_push(sq_queue_t* q, const sq_sample_t* s);
+uint64_t    sq_dropped(const sq_queue_t* q);
+
+// Consumer side: move up to `max` samples, oldest first, into out.
+size_t      sq_pop_batch(sq_queue_t* q, sq_sample_t* out, size_t max);
+// Samples waiting (exact from the consumer; a lower bound elsewhere).
+size_t      sq_size(const sq_queue_t* q);
+
+#define SQ_SEQLOCK_MAX_BYTES 128
+
+typedef struct sq_seqlock sq_seqlock_t;
+
+// A cell of `bytes` (<= SQ_SEQLOCK_MAX_BYTES) zero bytes. NULL on failure.
+sq_seqlock_t* sq_seqlock_create(size_t bytes);
+void          sq_seqlock_destroy(sq_seqlock_t* l);
+// Single writer.
+void          sq_seqlock_write(sq_seqlock_t* l, const void* value);
+// Any thread; copies a consistent value. Returns the write count it saw.
+uint64_t      sq_seqlock_read(const sq_seqlock_t* l, void* out);
+
+// What the DSP thread publishes for the UI after each batch.
+typedef struct {
+    double   t;            // last evaluated tick (seconds since 1970), 0 before
+    double   bpm;          // smoothed HR, NaN before the first sample
+    double   still;        // smoothed stillness
+    double   propensity;
+    double   stateSince;   // drowsy since / asleep at
+    double   onset;        // confirmed onset, NaN until then
+    int32_t  state;        // 0 awake, 1 drowsy, 2 asleep
+    uint32_t ticks;        // evaluate() calls since start
+} sq_snapshot_t;
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* SAMPLE_QUEUE_H */
@@ -0,0 +1,627 @@
+//
+//  sleep_pipeline.hpp
+//  SleepTriggerWatchOS Watch App
+//
+//  Headless C++ port of the SleepMonitor decision chain:
+//    HR:    Hampel → Welford → IIR1 → frame aligner → HR trend
+//           (Hampel / IIR1 in the configured Precision)
+//    still: IIR1 → frame aligner → sliding DFT (VLF)
+//    tick:  once per aligned frame: trend features → motion class (tm_classifier) → fuseFeatures/KF1
+//           → SleepStateMachine → HMM3 → propensity assist → confirm ticks
+//  Same thresholds, ordering and float/double conversions as the Swift code,
+//  driven by caller-supplied timestamps (seconds) instead of Date()/Combine,
+//  so recorded nights can be replayed deterministically off-device.
+//
+
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "robust_stats.h"
+#include "signal_filter.h"
+#include "spectral.h"
+#include "frame_align.h"
+#include "duty_control.h"
+#include "time_window.h"
+#include "tinyml_motion.h"
+#include "ekf.hpp"
+#include "ring.hpp"
+#include "hmm.hpp"
+#include "precision.hpp"
+
+namespace st {
+
+enum class SleepPhase : uint8_t { Awake = 0, Drowsy = 1, Asleep = 2 };
+
+// Port of HRTrendAnalyzer: time-windowed baseline mean and regression slope,
+// both O(1) per sample from time_window.c's shared-buffer horizons.
+struct HRTrend {
+  double baselineWindow{5 * 60};   // seconds
+  double trendWindow{90};          // seconds
+  double longWindow{30 * 60};      // seconds, context only
+
+  HRTrend() {
+    const double h[3] = {trendWindow, baselineWindow, longWindow};
+    tw_init(&w_, h, 3, 512);
+  }
+  ~HRTrend() { tw_free(&w_); }
+  HRTrend(const HRTrend&) = delete;
+  HRTrend& operator=(const HRTrend&) = delete;
+
+  void reset() { tw_clear(&w_); }
+
+  void ingest(double bpm, double t) {
+    if (w_.h[kTrend].horizon != trendWindow) tw_set_horizon(&w_, kTrend, trendWindow);
+    if (w_.h[kBase].horizon != baselineWindow) tw_set_horizon(&w_, kBase, baselineWindow);
+    if (w_.h[kLong].horizon != longWindow) tw_set_horizon(&w_, kLong, longWindow);
+    tw_push(&w_, t, bpm);
+  }
+
+  bool baselineMean(double& out) const { return tw_mean(&w_, kBase, &out) == 0; }
+  bool longMean(double& out) const     { return tw_mean(&w_, kLong, &out) == 0; }
+
+  // (latest - baseline) / baseline; false when not ready (Swift: nil).
+  bool dropFraction(double& out) const { return tw_drop_fraction(&w_, kBase, &out) == 0; }
+
+  // Least-squares slope in bpm/s over the trend window; needs >= 5 points.
+  bool slopeBPMPerSec(double& out) const {
+    return tw_count(&w_, kTrend) >= 5 && tw_slope(&w_, kTrend, &out) == 0;
+  }
+
+private:
+  enum { kTrend = 0, kBase = 1, kLong = 2 };
+  tw_tracker_t w_{};
+};
+
+// Port of SleepStateMachine (inputs are always present in SleepMonitor).
+struct SleepFSM {
+  double dropThreshold{-0.12};
+  double minDrowsySeconds{180};
+  double minStillScore{0.80};
+  bool   requireNegativeSlope{true};
+
+  SleepPhase state{SleepPhase::Awake};
+  double     since{0};   // drowsy since / asleep at
+
+  SleepPhase ingest(double dropFraction, double stillness, double slope, double now) {
+    switch (state) {
+      case SleepPhase::Awake:
+        if (dropFraction <= dropThreshold * 0.5 && stillness >= minStillScore * 0.7) {
+          state = SleepPhase::Drowsy; since = now;
+        }
+        break;
+      case SleepPhase::Drowsy: {
+        bool sustained = (now - since) >= minDrowsySeconds;
+        bool hrIsLow = dropFraction <= dropThreshold;
+        bool slopeOK = requireNegativeSlope ? (slope < 0) : true;
+        bool stillOK = stillness >= minStillScore;
+        if (hrIsLow && stillOK && slopeOK && sustained) { state = SleepPhase::Asleep; since = now; }
+        // motion spike or HR rebound → awake (evaluated after the asleep check)
+        if (stillness < minStillScore * 0.5 || dropFraction > dropThreshold * 0.25)
+          state = SleepPhase::Awake;
+        break;
+      }
+      case SleepPhase::Asleep:
+        break;
+    }
+    return state;
+  }
+
+  void reset() { state = SleepPhase::Awake; }
+};
+
+enum class TrendModel : uint8_t {
+  Window = 0,   // HRTrend: window mean + regression (SleepMonitor today)
+  Kalman = 1,   // HRTrendKF: level/slope/baseline Kalman filter
+};
+
+enum class DutyMode : uint8_t {
+  Every    = 0,   // evaluate every frame (or sample)
+  Switch   = 1,   // dc_next_interval: 2 s drowsy, 5 s otherwise
+  Adaptive = 2,   // dc_sched_next (SleepDSP)
+};
+
+// Sample type of the HR / stillness conditioning (Hampel, IIR1). Mixed is
+// SleepMonitor's chain: double Hampel into the float iir1_t. The rest run
+// both stages in one type (precision.hpp); features and decisions stay
+// double in every mode.
+enum class Precision : uint8_t {
+  Mixed  = 0,
+  Double = 1,
+  Float  = 2,
+  Q31    = 3,
+  Q15    = 4,
+};
+
+// Motion class behind respQuiet. Int8 is SleepDSP's tm_classifier over
+// the last TM_WINDOW ticks (threshold rule until the window fills); Float
+// runs the same model from its unquantised weights; Threshold is the old
+// tiny_motion_classify(stillness, 0).
+enum class MotionModel : uint8_t {
+  Threshold = 0,
+  Int8      = 1,
+  Float     = 2,
+};
+
+inline const char* motionModelName(MotionModel m) {
+  switch (m) {
+    case MotionModel::Threshold: return "threshold";
+    case MotionModel::Int8:      return "int8";
+    case MotionModel::Float:     return "float";
+  }
+  return "?";
+}
+
+inline const char* precisionName(Precision p) {
+  switch (p) {
+    case Precision::Mixed:  return "mixed";
+    case Precision::Double: return "double";
+    case Precision::Float:  return "float";
+    case Precision::Q31:    return "q31";
+    case Precision::Q15:    return "q15";
+  }
+  return "?";
+}
+
+// Hampel → IIR1 for HR and IIR1 for stillness in sample type T. Fixed
+// types see HR / kHRFullScale and stillness / kStillFullScale.
+template <typename T>
+class SampleConditioner {
+public:
+  static constexpr double kHRFullScale = 256.0;     // bpm
+  static constexpr double kStillFullScale = 2.0;    // stillness is 0..1
+
+  void init(int hampelWindow, double hampelSigma, float hrAlpha, float stillAlpha) {
+    hampel_.init(hampelWindow, hampelSigma);
+    hr_ = OnePole<T>(hrAlpha);
+    still_ = OnePole<T>(stillAlpha);
+  }
+
+  // Returns the smoothed HR; *cleaned gets the Hampel output.
+  double hr(double raw, double* cleaned) {
+    const T c = hampel_.update(SampleTraits<T>::in(raw, kHRFullScale));
+    *cleaned = SampleTraits<T>::out(c, kHRFullScale);
+    return SampleTraits<T>::out(hr_.update(c), kHRFullScale);
+  }
+  double still(double raw) {
+    return SampleTraits<T>::out(still_.update(SampleTraits<T>::in(raw, kStillFullScale)), kStillFullScale);
+  }
+
+private:
+  Hampel<T>   hampel_{};
+  OnePole<T>  hr_{}, still_{};
+};
+
+inline dc_policy_t defaultDutyPolicy() {
+  dc_policy_t p;
+  dc_policy_default(&p);
+  return p;
+}
+
+struct SleepPipelineConfig {
+  int    hampelWindow{9};
+  double hampelSigma{3.0};
+  float  hrAlpha{0.22f};
+  float  stillAlpha{0.12f};
+  int    minHRSamplesToDecide{8};
+  int    asleepConfirmTicks{2};
+  double kfQ{0.01}, kfR{0.10};
+  double spectralFs{1.0};       // per-sample mode; frames use 1 / framePeriod
+  int    spectralN{32};
+  int    spectralResync{1200};
+  double vlfHz{0.20};
+  int    vlfMinSamples{32};
+  double vlfScale{5.0};
+  double assistAsleep{0.85};
+  double assistAwake{0.25};
+  double negSlopeScale{0.2};    // bpm/s mapped to negSlope = 1
+  double baselineWindow{5 * 60};
+  double trendWindow{90};
+  TrendModel trendModel{TrendModel::Window};
+  // Evaluation cadence. > 0: one tick per aligned frame of this period
+  // (SleepDSP). 0: one tick per HR or stillness sample, as SleepMonitor
+  // did before frames.
+  double framePeriod{2.0};
+  double frameLag{5.0};          // release delay so HR can be interpolated
+  double hrStaleAfter{15.0};     // HR older than this stops feeding the trend
+  double stillStaleAfter{15.0};
+  // Evaluation pacing. Ticks falling before the next scheduled evaluation
+  // are skipped, and outside Every the sensors are modelled as off (their
+  // samples dropped) until dutyPolicy.sensorLead before it.
+  DutyMode    duty{DutyMode::Every};
+  dc_policy_t dutyPolicy{defaultDutyPolicy()};
+  Precision   precision{Precision::Mixed};
+  MotionModel motionModel{MotionModel::Int8};
+  HRTrendKF  trendKF{};         // prototype for TrendModel::Kalman
+  SleepFSM fsm{};
+};
+
+// Per-run state occupancy, kept without a full trace.
+struct SleepStateSummary {
+  size_t ticksIn[3]{0, 0, 0};     // indexed by SleepPhase
+  size_t transitions{0};
+  double firstDrowsy{NAN};        // seconds, NaN if never drowsy
+};
+
+// One evaluate() tick, mirroring a RingLogger row.
+struct SleepTick {
+  double t;
+  float  hr;          // smoothed bpm (NaN before the first HR sample)
+  float  still;
+  float  drop;
+  float  slope;
+  float  propensity;
+  SleepPhase state;
+};
+
+// Upstream features for one evaluate() tick. Everything here is independent
+// of the KF/fusion/FSM/HMM parameters, so a night's feature columns can be
+// computed once and reused across decision configs (see Tools/replay/sweep).
+struct SleepFeatures {
+  double t;
+  double drop;        // HRTrend drop fraction (0 when not ready)
+  double slope;       // bpm/s (0 when not ready)
+  double negSlope;    // clip(-slope / negSlopeScale)
+  double still;       // smoothed stillness
+  double vlf;         // normalised VLF power, 0 until vlfMinSamples
+  double respQuiet;   // from the motion class (MotionModel)
+};
+
+// Sensor half of SleepMonitor: HR and stillness conditioning up to the
+// feature vector. Per-sample mode returns true from push*() when the sample
+// produces a tick; frame mode returns false there and hands out ticks from
+// nextFrame(), which should be drained after every push.
+class SleepFrontEnd {
+public:
+  explicit SleepFrontEnd(const SleepPipelineConfig& cfg = {}) : cfg_(cfg) { start(); }
+
+  void start() {
+    rs_hampel_init(&hampel_, cfg_.hampelWindow, cfg_.hampelSigma);
+    rs_var_init(&hrVar_);
+    iir1_init(&hrLPF_, cfg_.hrAlpha);
+    iir1_init(&stillLPF_, cfg_.stillAlpha);
+    condD_.init(cfg_.hampelWindow, cfg_.hampelSigma, cfg_.hrAlpha, cfg_.stillAlpha);
+    condF_.init(cfg_.hampelWindow, cfg_.hampelSigma, cfg_.hrAlpha, cfg_.stillAlpha);
+    condQ31_.init(cfg_.hampelWindow, cfg_.hampelSigma, cfg_.hrAlpha, cfg_.stillAlpha);
+    condQ15_.init(cfg_.hampelWindow, cfg_.hampelSigma, cfg_.hrAlpha, cfg_.stillAlpha);
+    tm_classifier_init(&motion_, nullptr, 0);
+    // Frames are the spectrum's sample clock when framed. One bin, as in
+    // SleepDSP: the smoothed stillness carries no usable respiration or
+    // motion band, and both have their own paths.
+    sdft_init(&spectrum_, framed() ? 1.0 / cfg_.framePeriod : cfg_.spectralFs, cfg_.spectralN, cfg_.spectralResync);
+    vlfBin_ = sdft_add_bin(&spectrum_, cfg_.vlfHz);
+    trend_.reset();
+    trend_.baselineWindow = cfg_.baselineWindow;
+    trend_.trendWindow = cfg_.trendWindow;
+    trendKF_ = cfg_.trendKF;
+    trendKF_.reset();
+    hrSampleCount_ = 0;
+    stillWindow_.clear();
+    currentBPM_ = NAN;
+    stillness_ = 0;
+    if (framed()) {
+      fa_init(&align_, cfg_.framePeriod, cfg_.frameLag, 2);
+      fa_stream_config(&align_, kHR, FA_LINEAR, cfg_.hrStaleAfter);
+      fa_stream_config(&align_, kStill, FA_HOLD, cfg_.stillStaleAfter);
+    }
+  }
+
+  bool pushHR(double t, double raw, SleepFeatures& f) {
+    double cleaned = 0, smoothed = 0;
+    switch (cfg_.precision) {
+      case Precision::Mixed:
+        cleaned = rs_hampel_update(&hampel_, raw);
+        smoothed = (double)iir1_update(&hrLPF_, (float)cleaned);
+        break;
+      case Precision::Double: smoothed = condD_.hr(raw, &cleaned); break;
+      case Precision::Float:  smoothed = condF_.hr(raw, &cleaned); break;
+      case Precision::Q31:    smoothed = condQ31_.hr(raw, &cleaned); break;
+      case Precision::Q15:    smoothed = condQ15_.hr(raw, &cleaned); break;
+    }
+    rs_var_update(&hrVar_, cleaned);
+    if (framed()) { alignDrops_ += fa_push(&align_, kHR, t, smoothed) != 0; return false; }
+    ingestHR(t, smoothed);
+    hrSampleCount_ += 1;
+    return features(t, f);
+  }
+
+  bool pushStillness(double t, double raw, SleepFeatures& f) {
+    double s = 0;
+    switch (cfg_.precision) {
+      case Precision::Mixed:  s = (double)iir1_update(&stillLPF_, (float)raw); break;
+      case Precision::Double: s = condD_.still(raw); break;
+      case Precision::Float:  s = condF_.still(raw); break;
+      case Precision::Q31:    s = condQ31_.still(raw); break;
+      case Precision::Q15:    s = condQ15_.still(raw); break;
+    }
+    if (framed()) { alignDrops_ += fa_push(&align_, kStill, t, s) != 0; return false; }
+    ingestStillness(s);
+    return features(t, f);
+  }
+
+  // Frame mode: the next released frame as a tick. Frames before the
+  // minimum HR count are consumed without one.
+  bool nextFrame(SleepFeatures& f) {
+    if (!framed()) return false;
+    fa_frame_t fr;
+    while (fa_pop(&align_, &fr)) {
+      if ((fr.flags[kHR] & FA_VALID) && !(fr.flags[kHR] & FA_STALE)) ingestHR(fr.t, fr.value[kHR]);
+      hrSampleCount_ += fr.count[kHR];
+      if ((fr.flags[kStill] & FA_VALID) && !(fr.flags[kStill] & FA_STALE)) ingestStillness(fr.value[kStill]);
+      if (features(fr.t, f)) return true;
+    }
+    return false;
+  }
+
+  // SleepMonitor.stop() clears the stillness window and spectrum.
+  void stop() {
+    stillWindow_.clear();
+    tm_classifier_reset(&motion_);
+    sdft_reset(&spectrum_);
+    if (framed()) fa_reset(&align_);
+  }
+
+  double currentBPM() const { return currentBPM_; }
+  // Samples the aligner refused (stream queue full or out of order).
+  uint64_t alignerDrops() const { return alignDrops_; }
+  bool   framed() const     { return cfg_.framePeriod > 0; }
+
+private:
+  static constexpr int kHR = 0, kStill = 1;
+
+  void ingestHR(double t, double bpm) {
+    currentBPM_ = bpm;
+    if (cfg_.trendModel == TrendModel::Kalman) trendKF_.ingest(bpm, t);
+    else                                       trend_.ingest(bpm, t);
+  }
+
+  void ingestStillness(double s) {
+    stillness_ = s;
+    stillWindow_.push((float)s);
+    sdft_push(&spectrum_, s);
+  }
+
+  bool features(double now, SleepFeatures& f) {
+    if (hrSampleCount_ < cfg_.minHRSamplesToDecide) return false;
+    double drop = 0, slope = 0;
+    if (cfg_.trendModel == TrendModel::Kalman) {
+      trendKF_.dropFraction(drop);
+      trendKF_.slopeBPMPerSec(slope);
+    } else {
+      trend_.dropFraction(drop);
+      trend_.slopeBPMPerSec(slope);
+    }
+
+    const double stillMean = stillness_;
+    const double stillVar = 0.0;
+
+    double vlf = 0;
+    if ((int)stillWindow_.size() >= cfg_.vlfMinSamples) {
+      vlf = sdft_bin_power(&spectrum_, vlfBin_);
+      vlf = std::min(1.0, vlf / cfg_.vlfScale);
+    }
+
+    int motionClass = 0;
+    switch (cfg_.motionModel) {
+      case MotionModel::Threshold: motionClass = tiny_motion_classify(stillMean, stillVar); break;
+      case MotionModel::Int8:      motionClass = tm_classifier_push(&motion_, stillMean, currentBPM_); break;
+      case MotionModel::Float:     motionClass = tm_classifier_push_ref(&motion_, stillMean, currentBPM_); break;
+    }
+    f.t = now;
+    f.drop = drop;
+    f.slope = slope;
+    f.negSlope = std::max(0.0, std::min(1.0, -slope / cfg_.negSlopeScale));
+    f.still = stillMean;
+    f.vlf = vlf;
+    f.respQuiet = (motionClass == 0) ? 1.0 : (motionClass == 1 ? 0.6 : 0.2);
+    return true;
+  }
+
+  SleepPipelineConfig cfg_;
+  rs_hampel_t hampel_{};
+  rs_var_t    hrVar_{};
+  iir1_t      hrLPF_{}, stillLPF_{};
+  SampleConditioner<double> condD_{};
+  SampleConditioner<float>  condF_{};
+  SampleConditioner<Q31>    condQ31_{};
+  SampleConditioner<Q15>    condQ15_{};
+  tm_classifier_t motion_{};
+  sdft_bank_t spectrum_{};
+  int         vlfBin_{-1};
+  HRTrend     trend_{};
+  HRTrendKF   trendKF_{};
+  int    hrSampleCount_{0};
+  Ring<float, 64> stillWindow_{};   // SleepMonitor.stillWindow
+  fa_aligner_t align_{};
+  uint64_t alignDrops_{0};
+  double currentBPM_{NAN};
+  double stillness_{0};
+};
+
+class SleepPipeline {
+public:
+  explicit SleepPipeline(const SleepPipelineConfig& cfg = {}) : cfg_(cfg), front_(cfg) { start(); }
+
+  // Equivalent of SleepMonitor.init + start(): fresh filters and counters.
+  void start() {
+    front_.start();
+    kf_.set(cfg_.kfQ, cfg_.kfR, 0, 1);
+    hmm_.setDefault();
+    fsm_ = cfg_.fsm;
+    fsm_.reset();
+    asleepStableTicks_ = 0;
+    propensity_ = 0;
+    state_ = SleepPhase::Awake;
+    running_ = true;
+    onset_ = NAN;
+    ticks_ = 0;
+    summary_ = SleepStateSummary{};
+    dc_sched_init(&sched_, &cfg_.dutyPolicy);
+    dc_init(&switch_, 2.0, 5.0);
+    account_ = dc_account_t{};
+    nextEval_ = -INFINITY;
+    lastEval_ = NAN;
+  }
+
+  // Heart-rate sink. Returns true if this sample confirmed sleep onset.
+  bool pushHR(double t, double raw) {
+    if (!running_ || !sensorsOn(t)) return false;
+    SleepFeatures f;
+    return (front_.pushHR(t, raw, f) && evaluate(f)) || drainFrames();
+  }
+
+  // Stillness sink (DeviceMotionMonitor score). Returns true on onset.
+  bool pushStillness(double t, double raw) {
+    if (!running_ || !sensorsOn(t)) return false;
+    SleepFeatures f;
+    return (front_.pushStillness(t, raw, f) && evaluate(f)) || drainFrames();
+  }
+
+  // Optional per-tick trace (RingLogger equivalent); pass nullptr to disable.
+  void setTrace(std::vector<SleepTick>* trace) { trace_ = trace; }
+
+  bool       running() const     { return running_; }
+  double     onsetTime() const   { return onset_; }       // NaN until confirmed
+  SleepPhase state() const       { return state_; }
+  double     propensity() const  { return propensity_; }
+  double     currentBPM() const  { return front_.currentBPM(); }
+  size_t     ticks() const       { return ticks_; }
+  const SleepStateSummary& summary() const { return summary_; }
+  const dc_account_t& dutyAccount() const  { return account_; }
+  const SleepPipelineConfig& config() const { return cfg_; }
+
+private:
+  bool drainFrames() {
+    SleepFeatures f;
+    while (front_.nextFrame(f))
+      if (evaluate(f)) return true;
+    return false;
+  }
+
+  bool sensorsOn(double t) const {
+    return cfg_.duty == DutyMode::Every || t >= nextEval_ - cfg_.dutyPolicy.sensorLead;
+  }
+
+  bool evaluate(const SleepFeatures& f) {
+    const double now = f.t;
+    if (now < nextEval_) return false;
+    ++ticks_;
+    double p = kf_.update(fuseFeatures(f.drop, f.still, f.negSlope, f.respQuiet, f.vlf));
+    propensity_ = p;
+
+    SleepPhase fsmState = fsm_.ingest(f.drop, f.still, f.slope, now);
+    int sm = hmm_.step((int)fsmState);
+    SleepPhase s = (SleepPhase)sm;
+    if (p > cfg_.assistAsleep && s == SleepPhase::Drowsy) s = SleepPhase::Asleep;
+    if (p < cfg_.assistAwake  && s == SleepPhase::Drowsy) s = SleepPhase::Awake;
+    if (s != state_) ++summary_.transitions;
+    state_ = s;
+    ++summary_.ticksIn[(int)s];
+    if (s == SleepPhase::Drowsy && std::isnan(summary_.firstDrowsy)) summary_.firstDrowsy = now;
+
+    if (trace_) {
+      trace_->push_back({now, (float)front_.currentBPM(), (float)f.still, (float)f.drop,
+                         (float)f.slope, (float)p, s});
+    }
+
+    schedule(now, p, s);
+
+    if (s == SleepPhase::Asleep) {
+      if (++asleepStableTicks_ >= cfg_.asleepConfirmTicks) {
+        onset_ = now;
+        stop();
+        return true;
+      }
+    } else {
+      asleepStableTicks_ = 0;
+    }
+    return false;
+  }
+
+  void schedule(double now, double p, SleepPhase s) {
+    const double gap = std::isnan(lastEval_) ? 0.0 : now - lastEval_;
+    lastEval_ = now;
+    const dc_state_t ds = (dc_state_t)s;
+    switch (cfg_.duty) {
+      case DutyMode::Every:
+        dc_account_eval(&account_, gap, INFINITY, 1);
+        break;
+      case DutyMode::Switch: {
+        const double dt = dc_next_interval(&switch_, ds);
+        nextEval_ = now + dt;
+        dc_account_eval(&account_, gap, cfg_.dutyPolicy.sensorLead, dt <= switch_.tickFast);
+        break;
+      }
+      case DutyMode::Adaptive:
+        nextEval_ = now + dc_sched_next(&sched_, now, p, kf_.P, ds);
+        dc_account_eval(&account_, gap, cfg_.dutyPolicy.sensorLead, sched_.fast);
+        break;
+    }
+  }
+
+  // SleepMonitor.stop(): sensors off, FSM/windows/spectrum cleared.
+  void stop() {
+    fsm_.reset();
+    running_ = false;
+    asleepStableTicks_ = 0;
+    front_.stop();
+  }
+
+  SleepPipelineConfig cfg_;
+  SleepFrontEnd front_;
+  KF1         kf_{};
+  HMM3        hmm_{};
+  SleepFSM    fsm_{};
+
+  int    asleepStableTicks_{0};
+  double propensity_{0};
+  SleepPhase state_{SleepPhase::Awake};
+  bool   running_{true};
+  double onset_{NAN};
+  size_t ticks_{0};
+  SleepStateSummary summary_{};
+  std::vector<SleepTick>* trace_{nullptr};
+  dc_scheduler_t sched_{};
+  duty_ctrl_t    switch_{};
+  dc_account_t   account_{};
+  double nextEval_{-INFINITY};
+  double lastEval_{NAN};
+};
+
+// Input event for whole-night replay; events must be in time order.
+struct SensorEvent {
+  double  t;
+  double  value;
+  uint8_t kind;   // 0 = heart rate (bpm), 1 = stillness (0..1)
+};
+
+struct NightResult {
+  double onset{NAN};     // seconds, NaN if no onset confirmed
+  size_t events{0};      // events consumed (replay stops at onset)
+  size_t ticks{0};
+  double finalPropensity{0};
+  SleepPhase finalState{SleepPhase::Awake};
+  SleepStateSummary summary{};
+  dc_account_t duty{};
+};
+
+inline NightResult replayNight(SleepPipeline& p, const SensorEvent* ev, size_t n) {
+  NightResult r;
+  size_t i = 0;
+  for (; i < n && p.running(); ++i) {
+    if (ev[i].kind == 0) p.pushHR(ev[i].t, ev[i].value);
+    else                 p.pushStillness(ev[i].t, ev[i].value);
+  }
+  r.onset = p.onsetTime();
+  r.events = i;
+  r.ticks = p.ticks();
+  r.finalPropensity = p.propensity();
+  r.finalState = p.state();
+  r.summary = p.summary();
+  r.duty = p.dutyAccount();
+  return r;
+}
+
+} // namespace st
@@ -0,0 +1,278 @@
+//
+//  sos.hpp
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Cascades of second-order sections:
+//    - SOS<S>: S normalised biquads (a0 = 1), designed in double
+//    - sos::lowPass / highPass / bandPass<Order>: Butterworth or Bessel
+//      (phase-normalised, orders 1..6) by bilinear transform with
+//      pre-warping; constexpr, so fixed-rate designs are compile-time
+//      constants. Odd orders end in a first-order section (b2 = a2 = 0).
+//      bandPass is highPass(fLow) · lowPass(fHigh), fine for bands an
+//      octave or wider (respiration's 0.1-0.5 Hz is over two).
+//    - SOSCascade<S, T>: transposed Direct Form II in float or double.
+//      process() runs the sections as a wavefront, section s on sample
+//      i - s, so the S recurrences are independent within a step; output
+//      is bit-identical to push() per sample.
+//  Denormals: state below kTiny is flushed to zero at the end of every
+//  process() call and every kFlushEvery push() calls, so a filter decaying
+//  through silence never reaches the subnormal range (on cores without FTZ
+//  each subnormal operation costs ~100 cycles).
+//
+
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace st {
+
+struct Biquad {
+  double b0{1}, b1{0}, b2{0}, a1{0}, a2{0};   // a0 = 1
+};
+
+template <int S>
+struct SOS {
+  std::array<Biquad, S> s{};
+};
+
+namespace sos_detail {
+inline constexpr double kPi = 3.14159265358979323846;
+
+// sin / cos / tan usable in constant expressions; std:: at run time.
+constexpr double sinSeries(double x) {
+  // Reduce to [-pi, pi], then to [-pi/2, pi/2] where the series is short.
+  const double twoPi = 2 * kPi;
+  x -= twoPi * (double)(long long)(x / twoPi);
+  if (x > kPi) x -= twoPi;
+  if (x < -kPi) x += twoPi;
+  if (x > kPi / 2) x = kPi - x;
+  if (x < -kPi / 2) x = -kPi - x;
+  const double x2 = x * x;
+  double term = x, sum = 0;
+  for (int n = 1; n < 30; n += 2) { sum += term; term *= -x2 / ((n + 1) * (n + 2)); }
+  return sum;
+}
+
+constexpr double sin(double x) {
+  if (std::is_constant_evaluated()) return sinSeries(x);
+  return std::sin(x);
+}
+constexpr double cos(double x) {
+  if (std::is_constant_evaluated()) return sinSeries(x + kPi / 2);
+  return std::cos(x);
+}
+constexpr double tan(double x) { return sin(x) / cos(x); }
+struct Pole { double re, im; };   // im > 0: the pair re ± j·im; im == 0: real
+
+// Bessel poles normalised for phase (stopband asymptote of the Butterworth
+// of the same order and cutoff), upper half plane, real pole last for odd
+// orders. DC group delay is kBesselDelay[order-1] / wc.
+inline constexpr Pole kBessel[6][3] = {
+  {{-1.0, 0}},
+  {{-0.8660254037844387, 0.5000000000000001}},
+  {{-0.7456403858480767, 0.7113666249728354}, {-0.9416000265332071, 0}},
+  {{-0.9047587967882448, 0.2709187330038730}, {-0.6572111716718828, 0.8301614350048736}},
+  {{-0.8515536193688404, 0.4427174639443331}, {-0.5905759446119194, 0.9072067564574555},
+   {-0.9264420773877619, 0}},
+  {{-0.9093906830472279, 0.1856964396792902}, {-0.7996541858328328, 0.5621717346937335},
+   {-0.5385526816693097, 0.9616876881954274}},
+};
+// ((2n)! / (2^n n!))^(1/n), the scale between the delay- and
+// phase-normalised poles.
+inline constexpr double kBesselDelay[6] = {
+  1.0, 1.7320508075688772, 2.4662120743304700, 3.2010858729436795, 3.9362834270353520, 4.6716548509467570,
+};
+} // namespace sos_detail
+
+enum class Family { Butterworth, Bessel };
+
+namespace sos {
+
+template <int Order>
+inline constexpr int kSections = (Order + 1) / 2;
+
+template <int Order>
+constexpr std::array<sos_detail::Pole, kSections<Order>> prototype(Family f) {
+  static_assert(Order >= 1 && Order <= 6, "sos: orders 1..6");
+  std::array<sos_detail::Pole, kSections<Order>> p{};
+  if (f == Family::Bessel) {
+    for (int k = 0; k < kSections<Order>; ++k) p[k] = sos_detail::kBessel[Order - 1][k];
+    return p;
+  }
+  for (int k = 0; k < Order / 2; ++k) {
+    const double th = sos_detail::kPi * (2 * k + 1) / (2.0 * Order);
+    p[k] = {-sos_detail::sin(th), sos_detail::cos(th)};
+  }
+  if (Order % 2) p[Order / 2] = {-1.0, 0};
+  return p;
+}
+
+// One prototype pole (pair) at cutoff fc through the bilinear transform.
+constexpr Biquad section(sos_detail::Pole p, bool highPass, double fc, double fs) {
+  const double K = 2 * fs;
+  const double wc = K * sos_detail::tan(sos_detail::kPi * fc / fs);   // pre-warped
+  Biquad q;
+  if (p.im == 0) {
+    const double c = highPass ? wc / -p.re : wc * -p.re;   // s + c
+    const double d = K + c;
+    q.b0 = (highPass ? K : c) / d;
+    q.b1 = highPass ? -q.b0 : q.b0;
+    q.b2 = 0;
+    q.a1 = (c - K) / d;
+    q.a2 = 0;
+    return q;
+  }
+  const double m2 = p.re * p.re + p.im * p.im;
+  // s^2 + a s + b: the low-pass pair scaled by wc, or its s -> wc/s image.
+  const double a = highPass ? -2 * p.re * wc / m2 : -2 * p.re * wc;
+  const double b = highPass ? wc * wc / m2 : m2 * wc * wc;
+  const double d = K * K + a * K + b;
+  const double n = highPass ? K * K : b;
+  q.b0 = n / d;
+  q.b1 = (highPass ? -2 : 2) * n / d;
+  q.b2 = n / d;
+  q.a1 = 2 * (b - K * K) / d;
+  q.a2 = (K * K - a * K + b) / d;
+  return q;
+}
+
+// Unity gain at DC (low-pass) or Nyquist (high-pass). Butterworth is -3 dB
+// at fc; Bessel shares its asymptote and has a flat group delay of
+// kBesselDelay[Order-1] / (2·pi·fc) seconds across the passband.
+template <int Order>
+constexpr SOS<kSections<Order>> lowPass(Family f, double fc, double fs) {
+  const auto p = prototype<Order>(f);
+  SOS<kSections<Order>> d{};
+  for (int k = 0; k < kSections<Order>; ++k) d.s[k] = section(p[k], false, fc, fs);
+  return d;
+}
+
+template <int Order>
+constexpr SOS<kSections<Order>> highPass(Family f, double fc, double fs) {
+  const auto p = prototype<Order>(f);
+  SOS<kSections<Order>> d{};
+  for (int k = 0; k < kSections<Order>; ++k) d.s[k] = section(p[k], true, fc, fs);
+  return d;
+}
+
+template <int Order>
+constexpr SOS<2 * kSections<Order>> bandPass(Family f, double fLow, double fHigh, double fs) {
+  const auto hp = highPass<Order>(f, fLow, fs);
+  const auto lp = lowPass<Order>(f, fHigh, fs);
+  SOS<2 * kSections<Order>> d{};
+  for (int k = 0; k < kSections<Order>; ++k) {
+    d.s[k] = hp.s[k];
+    d.s[kSections<Order> + k] = lp.s[k];
+  }
+  return d;
+}
+
+// |H(e^{jw})| at f, for checks and plots.
+template <int S>
+inline double magnitude(const SOS<S>& d, double f, double fs) {
+  const double w = 2 * sos_detail::kPi * f / fs;
+  const double c1 = std::cos(w), s1 = std::sin(w), c2 = std::cos(2 * w), s2 = std::sin(2 * w);
+  double g = 1;
+  for (const Biquad& q : d.s) {
+    const double nr = q.b0 + q.b1 * c1 + q.b2 * c2, ni = -(q.b1 * s1 + q.b2 * s2);
+    const double dr = 1 + q.a1 * c1 + q.a2 * c2, di = -(q.a1 * s1 + q.a2 * s2);
+    g *= std::sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+  }
+  return g;
+}
+
+} // namespace sos
+
+// Respiration band at MotionFrontEnd's 2 Hz: 4th order, twice the roll-off
+// of resp_bpf_t's single band-pass biquad.
+inline constexpr SOS<2> kRespBand2Hz = sos::bandPass<2>(Family::Butterworth, 0.1, 0.5, 2.0);
+
+template <int S, typename T = float>
+class SOSCascade {
+  static_assert(S >= 1, "SOSCascade needs at least one section");
+  static_assert(std::is_floating_point_v<T>, "SOSCascade<S, T>: T is float or double");
+
+public:
+  static constexpr T kTiny = std::is_same_v<T, float> ? T(1e-15) : T(1e-150);
+  static constexpr int kFlushEvery = 16;
+
+  static constexpr int sections() { return S; }
+
+  constexpr SOSCascade() = default;   // pass-through
+  constexpr explicit SOSCascade(const SOS<S>& d) { setDesign(d); }
+
+  // Keeps the state; call reset() too when the response changes a lot.
+  constexpr void setDesign(const SOS<S>& d) {
+    for (int k = 0; k < S; ++k) {
+      b0_[k] = (T)d.s[k].b0; b1_[k] = (T)d.s[k].b1; b2_[k] = (T)d.s[k].b2;
+      a1_[k] = (T)d.s[k].a1; a2_[k] = (T)d.s[k].a2;
+    }
+  }
+
+  constexpr void reset() { z1_.fill(0); z2_.fill(0); sinceFlush_ = 0; }
+
+  T push(T x) {
+    for (int k = 0; k < S; ++k) x = step(k, x);
+    if (++sinceFlush_ == kFlushEvery) flushDenormals();
+    return x;
+  }
+
+  // y may alias x.
+  void process(const T* x, T* y, size_t n) {
+    if (n == 0) return;
+    std::array<T, S> carry{};   // carry[k]: section k-1's output awaiting section k
+    const size_t steps = n + S - 1;
+    const size_t full = n >= (size_t)S ? n : 0;   // steps [S-1, n) run every section
+    size_t i = 0;
+    for (; i < steps && (i < (size_t)S - 1 || full == 0); ++i) wave(x, y, n, carry, i);
+    for (; i < full; ++i) {
+      for (int k = S - 1; k > 0; --k) {
+        const T out = step(k, carry[k]);
+        if (k == S - 1) y[i - k] = out; else carry[k + 1] = out;
+      }
+      const T out = step(0, x[i]);
+      if (S == 1) y[i] = out; else carry[1] = out;
+    }
+    for (; i < steps; ++i) wave(x, y, n, carry, i);
+    flushDenormals();
+  }
+
+  void flushDenormals() {
+    for (int k = 0; k < S; ++k) {
+      if (std::fabs(z1_[k]) < kTiny) z1_[k] = 0;
+      if (std::fabs(z2_[k]) < kTiny) z2_[k] = 0;
+    }
+    sinceFlush_ = 0;
+  }
+
+  T z1(int k) const { return z1_[k]; }
+  T z2(int k) const { return z2_[k]; }
+
+private:
+  T step(int k, T x) {
+    const T y = b0_[k] * x + z1_[k];
+    z1_[k] = b1_[k] * x - a1_[k] * y + z2_[k];
+    z2_[k] = b2_[k] * x - a2_[k] * y;
+    return y;
+  }
+
+  // Step i of the wavefront with bounds checks, for the ramp in and out.
+  void wave(const T* x, T* y, size_t n, std::array<T, S>& carry, size_t i) {
+    for (int k = S - 1; k >= 0; --k) {
+      if (i < (size_t)k || i - k >= n) continue;
+      const T out = step(k, k == 0 ? x[i] : carry[k]);
+      if (k == S - 1) y[i - k] = out; else carry[k + 1] = out;
+    }
+  }
+
+  std::array<T, S> b0_{[] { std::array<T, S> a{}; a.fill(1); return a; }()};
+  std::array<T, S> b1_{}, b2_{}, a1_{}, a2_{};
+  std::array<T, S> z1_{}, z2_{};
+  int sinceFlush_{0};
+};
+
+} // namespace st
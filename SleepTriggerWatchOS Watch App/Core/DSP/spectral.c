@@ -7,6 +7,7 @@
 
 #include "spectral.h"
 #include <math.h>
+#include <string.h>
 
 void goertzel_init(goertzel_t* g, double fs, double f, int N){
   double k = 0.5 + (N * f / fs);
@@ -23,8 +24,122 @@ void goertzel_push(goertzel_t* g, double x){
   g->s2 = g->s1; g->s1 = s0;
 }
 
+void goertzel_push_block(goertzel_t* g, const double* x, size_t n){
+  if (!g || !x) return;
+  const double c = g->coeff;
+  double s1 = g->s1, s2 = g->s2;
+  for (size_t i=0;i<n;++i){
+    double s0 = x[i] + c*s1 - s2;
+    s2 = s1; s1 = s0;
+  }
+  g->s1 = s1; g->s2 = s2;
+}
+
 double goertzel_power(goertzel_t* g){
   double p = g->s1*g->s1 + g->s2*g->s2 - g->coeff*g->s1*g->s2;
   goertzel_reset(g);
   return p / g->norm;
 }
+
+// -------- Sliding DFT bank ----------
+
+void sdft_init(sdft_bank_t* s, double fs, int N, int resyncEvery){
+  if (N < 4) N = 4;
+  if (N > SDFT_MAX_N) N = SDFT_MAX_N;
+  memset(s, 0, sizeof(*s));
+  s->fs = fs;
+  s->N = N;
+  s->resyncEvery = resyncEvery > 0 ? resyncEvery : 0;
+  for (int m=0;m<N;++m){
+    double w = 2.0*M_PI*(double)m/(double)N;
+    s->cosT[m] = cos(w);
+    s->sinT[m] = sin(w);
+  }
+}
+
+int sdft_add_bin(sdft_bank_t* s, double f){
+  if (s->bins >= SDFT_MAX_BINS) return -1;
+  int k = (int)lround((double)s->N * f / s->fs);
+  if (k < 0) k = 0;
+  if (k > s->N/2) k = s->N/2;
+  int b = s->bins++;
+  s->k[b] = k;
+  s->wr[b] = s->cosT[k];
+  s->wi[b] = s->sinT[k];
+  sdft_resync(s);
+  return b;
+}
+
+void sdft_reset(sdft_bank_t* s){
+  memset(s->ring, 0, sizeof(s->ring));
+  memset(s->re, 0, sizeof(s->re));
+  memset(s->im, 0, sizeof(s->im));
+  s->idx = 0;
+  s->sinceResync = 0;
+}
+
+static inline void sdft_step(sdft_bank_t* restrict s, double x){
+  double d = x - s->ring[s->idx];
+  s->ring[s->idx] = x;
+  s->idx = (s->idx + 1 == s->N) ? 0 : s->idx + 1;
+  const int K = s->bins;
+  double* restrict re = s->re;
+  double* restrict im = s->im;
+  const double* restrict wr = s->wr;
+  const double* restrict wi = s->wi;
+  for (int b=0;b<K;++b){            // independent per bin: vectorises across bins
+    double a = re[b] + d, c = im[b];
+    re[b] = a*wr[b] - c*wi[b];
+    im[b] = a*wi[b] + c*wr[b];
+  }
+}
+
+void sdft_push(sdft_bank_t* s, double x){
+  sdft_step(s, x);
+  if (s->resyncEvery && ++s->sinceResync >= s->resyncEvery) sdft_resync(s);
+}
+
+void sdft_push_block(sdft_bank_t* s, const double* x, size_t n){
+  if (!s || !x) return;
+  for (size_t i=0;i<n;++i) sdft_push(s, x[i]);
+}
+
+// Exact window DFT: S_k = sum_m x[oldest+m] e^{-j2πkm/N}, which is the
+// quantity the recurrence tracks.
+void sdft_resync(sdft_bank_t* s){
+  const int N = s->N;
+  for (int b=0;b<s->bins;++b){
+    const int k = s->k[b];
+    double re = 0, im = 0;
+    int pos = s->idx, ph = 0;         // idx is the oldest sample
+    for (int m=0;m<N;++m){
+      double v = s->ring[pos];
+      re += v * s->cosT[ph];
+      im -= v * s->sinT[ph];
+      pos = (pos + 1 == N) ? 0 : pos + 1;
+      ph += k; if (ph >= N) ph -= N;
+    }
+    s->re[b] = re;
+    s->im[b] = im;
+  }
+  s->sinceResync = 0;
+}
+
+double sdft_bin_freq(const sdft_bank_t* s, int b){
+  if (b < 0 || b >= s->bins) return 0.0;
+  return (double)s->k[b] * s->fs / (double)s->N;
+}
+
+double sdft_bin_power(const sdft_bank_t* s, int b){
+  if (b < 0 || b >= s->bins) return 0.0;
+  return (s->re[b]*s->re[b] + s->im[b]*s->im[b]) / (double)s->N;
+}
+
+double sdft_band_power(const sdft_bank_t* s, double fLo, double fHi){
+  double p = 0.0;
+  for (int b=0;b<s->bins;++b){
+    double f = sdft_bin_freq(s, b);
+    if (f >= fLo && f <= fHi) p += sdft_bin_power(s, b);
+  }
+  return p;
+}
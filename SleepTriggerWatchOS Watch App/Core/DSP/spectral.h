@@ -6,6 +6,8 @@
 //
 
 #pragma once
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,8 +20,44 @@ typedef struct {
 void   goertzel_init(goertzel_t* g, double fs, double fTarget, int N);
 void   goertzel_reset(goertzel_t* g);
 void   goertzel_push(goertzel_t* g, double x);
+void   goertzel_push_block(goertzel_t* g, const double* x, size_t n); // n pushes, no reset
 double goertzel_power(goertzel_t* g); // call after N pushes; then reset
 
+// -------- Sliding DFT bank ----------
+// K bins over the most recent N samples, all updated on every push in O(K):
+//   S_k <- e^{j2πk/N} (S_k + x[n] - x[n-N])
+// Power is readable at any time without disturbing state. The plain
+// recurrence random-walks with rounding over hours, so the bank recomputes
+// every bin exactly from its sample ring every `resyncEvery` pushes
+// (O(N·K), amortised); 0 disables resync. Before N samples have arrived the
+// window is zero-padded.
+#define SDFT_MAX_N    256
+#define SDFT_MAX_BINS 8
+typedef struct {
+  double re[SDFT_MAX_BINS], im[SDFT_MAX_BINS];
+  double wr[SDFT_MAX_BINS], wi[SDFT_MAX_BINS]; // e^{j2πk/N}
+  int    k[SDFT_MAX_BINS];
+  double ring[SDFT_MAX_N];
+  double cosT[SDFT_MAX_N], sinT[SDFT_MAX_N];   // cos/sin(2πm/N) for resync
+  double fs;
+  int    N, bins, idx;
+  int    resyncEvery, sinceResync;
+} sdft_bank_t;
+
+// N is clamped to [4, SDFT_MAX_N].
+void   sdft_init(sdft_bank_t* s, double fs, int N, int resyncEvery);
+// Adds the bin nearest fHz (k = round(N f / fs)); returns its index or -1 if full.
+int    sdft_add_bin(sdft_bank_t* s, double fHz);
+void   sdft_reset(sdft_bank_t* s);
+void   sdft_push(sdft_bank_t* s, double x);
+void   sdft_push_block(sdft_bank_t* s, const double* x, size_t n);
+void   sdft_resync(sdft_bank_t* s);
+double sdft_bin_freq(const sdft_bank_t* s, int bin);
+// |X_k|^2 / N — the same scale goertzel_power reports for a full block.
+double sdft_bin_power(const sdft_bank_t* s, int bin);
+// Sum of bin powers whose centre lies in [fLo, fHi].
+double sdft_band_power(const sdft_bank_t* s, double fLo, double fHi);
+
 #ifdef __cplusplus
 }
 #endif
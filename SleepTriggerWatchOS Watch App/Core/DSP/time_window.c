@@ -0,0 +1,223 @@
+//
+//  time_window.c
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+#include "time_window.h"
+#include <stdlib.h>
+#include <string.h>
+
+static size_t pow2_at_least(size_t n) {
+    size_t c = 16;
+    while (c < n) c <<= 1;
+    return c;
+}
+
+int tw_init(tw_tracker_t *w, const double *horizons, int n, size_t capacityHint) {
+    if (!w) return -1;
+    memset(w, 0, sizeof(*w));
+    if (!horizons || n < 1 || n > TW_MAX_HORIZONS) return -1;
+    for (int i = 0; i < n; ++i) {
+        if (!(horizons[i] >= 0)) return -1;
+        w->h[i].horizon = horizons[i];
+    }
+    w->nh = n;
+    w->cap = pow2_at_least(capacityHint);
+    w->t = (double*)malloc(w->cap * sizeof(double));
+    w->x = (double*)malloc(w->cap * sizeof(double));
+    if (!w->t || !w->x) { tw_free(w); return -1; }
+    return 0;
+}
+
+void tw_free(tw_tracker_t *w) {
+    if (!w) return;
+    free(w->t);
+    free(w->x);
+    w->t = w->x = NULL;
+    w->cap = 0;
+}
+
+void tw_clear(tw_tracker_t *w) {
+    if (!w) return;
+    w->head = w->oldest = 0;
+    w->origin = 0;
+    w->sinceRecentre = 0;
+    for (int i = 0; i < w->nh; ++i) {
+        tw_horizon_t *h = &w->h[i];
+        h->tail = 0;
+        h->st = h->stt = h->sx = h->stx = 0;
+    }
+}
+
+// Sums of horizon h from its tail, exactly, against the current origin.
+static void resum(tw_tracker_t *w, tw_horizon_t *h) {
+    const size_t m = w->cap - 1;
+    double st = 0, stt = 0, sx = 0, stx = 0;
+    for (uint64_t k = h->tail; k < w->head; ++k) {
+        const double dt = w->t[k & m] - w->origin, x = w->x[k & m];
+        st += dt; stt += dt * dt; sx += x; stx += dt * x;
+    }
+    h->st = st; h->stt = stt; h->sx = sx; h->stx = stx;
+}
+
+static void recentre(tw_tracker_t *w, double origin) {
+    w->origin = origin;
+    for (int i = 0; i < w->nh; ++i) resum(w, &w->h[i]);
+    w->sinceRecentre = 0;
+}
+
+static void update_oldest(tw_tracker_t *w) {
+    uint64_t o = w->head;
+    for (int i = 0; i < w->nh; ++i) if (w->h[i].tail < o) o = w->h[i].tail;
+    w->oldest = o;
+}
+
+int tw_set_horizon(tw_tracker_t *w, int i, double seconds) {
+    if (!w || i < 0 || i >= w->nh || !(seconds >= 0)) return -1;
+    tw_horizon_t *h = &w->h[i];
+    h->horizon = seconds;
+    if (w->head == w->oldest) { h->tail = w->head; return 0; }
+    const size_t m = w->cap - 1;
+    const double cut = w->t[(w->head - 1) & m] - seconds;
+    uint64_t k = w->oldest;
+    while (k < w->head && w->t[k & m] < cut) ++k;
+    h->tail = k;
+    resum(w, h);
+    update_oldest(w);
+    return 0;
+}
+
+static int grow(tw_tracker_t *w) {
+    const size_t ncap = w->cap * 2, om = w->cap - 1, nm = ncap - 1;
+    double *t = (double*)malloc(ncap * sizeof(double));
+    double *x = (double*)malloc(ncap * sizeof(double));
+    if (!t || !x) { free(t); free(x); return -1; }
+    for (uint64_t k = w->oldest; k < w->head; ++k) {
+        t[k & nm] = w->t[k & om];
+        x[k & nm] = w->x[k & om];
+    }
+    free(w->t);
+    free(w->x);
+    w->t = t;
+    w->x = x;
+    w->cap = ncap;
+    return 0;
+}
+
+// A sample older than the newest one (HealthKit does deliver out of
+// order) is slotted in by time, so the buffer stays sorted. The newest time
+// is unchanged and nothing is evicted: a horizon the sample falls inside
+// adds it to its sums, one whose cut it is behind just moves its tail past
+// it. Costs one step per stored sample newer than it.
+static int insert_late(tw_tracker_t *w, double t, double x) {
+    const double latest = w->t[(w->head - 1) & (w->cap - 1)];
+    int inside = 0;
+    for (int i = 0; i < w->nh; ++i) inside |= t >= latest - w->h[i].horizon;
+    if (!inside) return 1;
+    if (w->head - w->oldest == w->cap && grow(w) != 0) return -1;
+
+    const size_t m = w->cap - 1;
+    uint64_t k = w->head;
+    while (k > w->oldest && w->t[(k - 1) & m] > t) {
+        w->t[k & m] = w->t[(k - 1) & m];
+        w->x[k & m] = w->x[(k - 1) & m];
+        k -= 1;
+    }
+    w->t[k & m] = t;
+    w->x[k & m] = x;
+    w->head += 1;
+
+    const double dt = t - w->origin;
+    for (int i = 0; i < w->nh; ++i) {
+        tw_horizon_t *h = &w->h[i];
+        if (t >= latest - h->horizon) {
+            h->st += dt; h->stt += dt * dt; h->sx += x; h->stx += dt * x;
+        } else {
+            h->tail += 1;
+        }
+    }
+    update_oldest(w);
+    w->sinceRecentre += 1;
+    return 0;
+}
+
+int tw_push(tw_tracker_t *w, double t, double x) {
+    if (!w || !w->t || t != t) return -1;
+    if (w->head != w->oldest && t < w->t[(w->head - 1) & (w->cap - 1)]) return insert_late(w, t, x);
+    if (w->head == w->oldest) recentre(w, t);
+    if (w->head - w->oldest == w->cap && grow(w) != 0) return -1;
+
+    const size_t m = w->cap - 1;
+    w->t[w->head & m] = t;
+    w->x[w->head & m] = x;
+    w->head += 1;
+
+    const double dt = t - w->origin;
+    int stale = 0;
+    for (int i = 0; i < w->nh; ++i) {
+        tw_horizon_t *h = &w->h[i];
+        h->st += dt; h->stt += dt * dt; h->sx += x; h->stx += dt * x;
+        const double cut = t - h->horizon;
+        uint64_t evicted = 0;
+        while (h->tail < w->head && w->t[h->tail & m] < cut) {
+            const double ot = w->t[h->tail & m] - w->origin, ox = w->x[h->tail & m];
+            h->st -= ot; h->stt -= ot * ot; h->sx -= ox; h->stx -= ot * ox;
+            h->tail += 1;
+            evicted += 1;
+        }
+        // Most of the window just left (a gap in the stream): what remains
+        // is small next to the rounding left behind by the subtractions.
+        if (evicted > w->head - h->tail) stale = 1;
+    }
+    update_oldest(w);
+
+    // Re-centre on the newest sample once the longest window has turned
+    // over (at least every TW_RECENTRE_MIN samples), or after a gap. Both
+    // cost O(window) and are paid for by the samples pushed or evicted
+    // since, so pushes stay amortised O(1).
+    w->sinceRecentre += 1;
+    const uint64_t live = w->head - w->oldest;
+    if (stale || w->sinceRecentre >= (live > TW_RECENTRE_MIN ? live : TW_RECENTRE_MIN)) recentre(w, t);
+    return 0;
+}
+
+size_t tw_count(const tw_tracker_t *w, int i) {
+    if (!w || i < 0 || i >= w->nh) return 0;
+    return (size_t)(w->head - w->h[i].tail);
+}
+
+int tw_latest(const tw_tracker_t *w, double *out) {
+    if (!w || w->head == w->oldest) return -1;
+    *out = w->x[(w->head - 1) & (w->cap - 1)];
+    return 0;
+}
+
+int tw_mean(const tw_tracker_t *w, int i, double *out) {
+    const size_t n = tw_count(w, i);
+    if (n == 0) return -1;
+    *out = w->h[i].sx / (double)n;
+    return 0;
+}
+
+int tw_slope(const tw_tracker_t *w, int i, double *out) {
+    const size_t n0 = tw_count(w, i);
+    if (n0 < 2) return -1;
+    const tw_horizon_t *h = &w->h[i];
+    const double n = (double)n0;
+    // Centred sums; an all-equal-t window leaves only rounding in sxx.
+    const double sxx = h->stt - h->st * h->st / n;
+    if (!(sxx > 1e-12 * h->stt)) return -1;
+    const double sxy = h->stx - h->st * h->sx / n;
+    *out = sxy / sxx;
+    return 0;
+}
+
+int tw_drop_fraction(const tw_tracker_t *w, int i, double *out) {
+    double base, latest;
+    if (tw_mean(w, i, &base) != 0 || tw_latest(w, &latest) != 0) return -1;
+    if (!(base > 0)) return -1;
+    *out = (latest - base) / base;
+    return 0;
+}
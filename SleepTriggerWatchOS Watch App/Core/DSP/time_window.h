@@ -0,0 +1,77 @@
+//
+//  time_window.h
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Time-based sliding windows over one (t, x) sample stream. Several
+//  horizons (e.g. 90 s trend, 5 min baseline, 30 min context) share one
+//  sample buffer; each keeps a tail index and running sums
+//  Σt, Σt², Σx, Σtx, so mean and least-squares slope are O(1) per query
+//  and eviction is amortised O(1) per sample.
+//
+//  t is stored relative to a moving origin and all sums are recomputed
+//  from the buffer every so often (re-centring), which bounds both the
+//  magnitude of Σt² and the drift of the add/subtract running sums.
+//
+
+#ifndef TIME_WINDOW_H
+#define TIME_WINDOW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TW_MAX_HORIZONS 4
+#define TW_RECENTRE_MIN 1024   // samples between re-centrings (at least)
+
+typedef struct {
+    double   horizon;   // seconds; a sample is in while t >= latest - horizon
+    uint64_t tail;      // absolute index of the oldest sample inside
+    double   st, stt;   // Σ(t - origin), Σ(t - origin)²
+    double   sx, stx;   // Σx, Σ(t - origin)·x
+} tw_horizon_t;
+
+typedef struct {
+    double      *t, *x;    // ring storage, cap entries each
+    size_t       cap;      // power of two
+    uint64_t     head;     // absolute index of the next sample
+    uint64_t     oldest;   // absolute index of the oldest stored sample
+    double       origin;
+    uint64_t     sinceRecentre;
+    int          nh;
+    tw_horizon_t h[TW_MAX_HORIZONS];
+} tw_tracker_t;
+
+// horizons[0..n) in seconds, n <= TW_MAX_HORIZONS. The buffer starts at
+// capacityHint samples (rounded up to a power of two) and doubles when the
+// longest horizon needs more. Return 0 on success, -1 on bad arguments or
+// allocation failure.
+int    tw_init(tw_tracker_t *w, const double *horizons, int n, size_t capacityHint);
+void   tw_free(tw_tracker_t *w);
+void   tw_clear(tw_tracker_t *w);
+// Change horizon i. Samples the longest horizon already evicted stay gone.
+int    tw_set_horizon(tw_tracker_t *w, int i, double seconds);
+
+// Samples may arrive out of order: a late one is inserted by time. Returns
+// 0; 1 if t is behind every horizon (relative to the newest sample), so
+// the sample is not stored; -1 for a NaN t or if the buffer could not grow
+// (the sample is dropped).
+int    tw_push(tw_tracker_t *w, double t, double x);
+
+size_t tw_count(const tw_tracker_t *w, int i);
+// The queries return 0 and write *out, or -1 when the value is undefined
+// (empty window, fewer than two distinct times, non-positive baseline).
+int    tw_latest(const tw_tracker_t *w, double *out);
+int    tw_mean(const tw_tracker_t *w, int i, double *out);
+int    tw_slope(const tw_tracker_t *w, int i, double *out);   // x per second
+// (latest - mean_i) / mean_i
+int    tw_drop_fraction(const tw_tracker_t *w, int i, double *out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* TIME_WINDOW_H */
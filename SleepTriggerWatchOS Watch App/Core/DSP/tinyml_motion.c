@@ -6,3 +6,309 @@
 //
 
 #include "tinyml_motion.h"
+#include "vec_kernels.h"
+#include <math.h>
+#include <string.h>
+
+// ---- feature window ----
+
+void tm_window_reset(tm_window_t* w){
+  memset(w, 0, sizeof(*w));
+  w->lastHR = NAN;
+}
+
+static inline int slot_of(uint32_t q){ return (int)(q % TM_WINDOW); }
+
+// Monotonic deque of tick numbers: front is the window min (sign 1) or
+// max (sign -1). Tick `q` must already be in its ring slot.
+static inline void mono_push(uint32_t* dq, int* head, int* len, const float* v, uint32_t q, float sign){
+  if (*len && q - dq[*head] >= TM_WINDOW) { *head = *head + 1 == TM_WINDOW ? 0 : *head + 1; --*len; }
+  const float x = sign * v[slot_of(q)];
+  while (*len) {
+    const int back = (*head + *len - 1) % TM_WINDOW;
+    if (sign * v[slot_of(dq[back])] < x) break;
+    --*len;
+  }
+  dq[(*head + *len) % TM_WINDOW] = q;
+  ++*len;
+}
+
+// Recompute every running value from the ring (window full).
+static void window_resync(tm_window_t* w){
+  const int half = TM_WINDOW / 2;
+  double sS = 0, sSS = 0, sH = 0, sHH = 0, dS = 0, dH = 0, h1S = 0, h1H = 0;
+  int nStill = 0;
+  float pS = 0, pH = 0;
+  w->minHead = w->minLen = w->maxHead = w->maxLen = 0;
+  for (int i = 0; i < TM_WINDOW; ++i) {
+    const uint32_t q = w->seq - TM_WINDOW + (uint32_t)i;   // oldest first
+    const float s = w->still[slot_of(q)], h = w->hr[slot_of(q)];
+    sS += s; sSS += (double)s * s;
+    sH += h; sHH += (double)h * h;
+    nStill += s >= 0.85f;
+    if (i) { dS += fabsf(s - pS); dH += fabsf(h - pH); }
+    if (i == half - 1) { h1S = sS; h1H = sH; }
+    pS = s; pH = h;
+    mono_push(w->minq, &w->minHead, &w->minLen, w->still, q, 1.0f);
+    mono_push(w->maxq, &w->maxHead, &w->maxLen, w->still, q, -1.0f);
+  }
+  w->sS = sS; w->sSS = sSS; w->sH = sH; w->sHH = sHH;
+  w->dS = dS; w->dH = dH; w->h1S = h1S; w->h1H = h1H;
+  w->nStill = nStill;
+  w->sinceResync = 0;
+}
+
+// Ticks before the first HR sample are not stored: the HR features would
+// have nothing to describe.
+void tm_window_push(tm_window_t* w, double still, double hr){
+  if (hr == hr) w->lastHR = (float)hr;
+  if (w->lastHR != w->lastHR) return;
+  const float s = (float)still, h = w->lastHR;
+  const int slot = w->head;
+  const int prev = slot ? slot - 1 : TM_WINDOW - 1;
+
+  if (w->count < TM_WINDOW) {
+    w->still[slot] = s; w->hr[slot] = h;
+    w->sS += s; w->sSS += (double)s * s;
+    w->sH += h; w->sHH += (double)h * h;
+    if (w->count) { w->dS += fabsf(s - w->still[prev]); w->dH += fabsf(h - w->hr[prev]); }
+    w->count += 1;
+    w->seq += 1;
+    w->head = slot + 1 == TM_WINDOW ? 0 : slot + 1;
+    if (w->count == TM_WINDOW) window_resync(w);
+    return;
+  }
+
+  // Full: slot holds the oldest tick; the tick half a window later moves
+  // from the newer half into the older one.
+  const int next = slot + 1 == TM_WINDOW ? 0 : slot + 1;
+  const int mid = (slot + TM_WINDOW / 2) % TM_WINDOW;
+  const float oS = w->still[slot], oH = w->hr[slot];
+  w->sS += (double)s - oS;              w->sH += (double)h - oH;
+  w->sSS += (double)s * s - (double)oS * oS;
+  w->sHH += (double)h * h - (double)oH * oH;
+  w->h1S += (double)w->still[mid] - oS; w->h1H += (double)w->hr[mid] - oH;
+  w->dS += (double)fabsf(s - w->still[prev]) - fabsf(w->still[next] - oS);
+  w->dH += (double)fabsf(h - w->hr[prev]) - fabsf(w->hr[next] - oH);
+  w->nStill += (s >= 0.85f) - (oS >= 0.85f);
+  w->still[slot] = s; w->hr[slot] = h;
+  mono_push(w->minq, &w->minHead, &w->minLen, w->still, w->seq, 1.0f);
+  mono_push(w->maxq, &w->maxHead, &w->maxLen, w->still, w->seq, -1.0f);
+  w->seq += 1;
+  w->head = next;
+  if (++w->sinceResync >= TM_RESYNC) window_resync(w);
+}
+
+int tm_window_features(const tm_window_t* w, float out[TM_FEATURES]){
+  if (w->count < TM_WINDOW) return -1;
+  const int half = TM_WINDOW / 2;
+  const double n = TM_WINDOW;
+  const double mS = w->sS / n, mH = w->sH / n;
+  const double vS = w->sSS / n - mS * mS, vH = w->sHH / n - mH * mH;
+  const int last = w->head ? w->head - 1 : TM_WINDOW - 1;
+  out[0]  = (float)mS;
+  out[1]  = (float)sqrt(vS > 0 ? vS : 0);
+  out[2]  = w->still[slot_of(w->minq[w->minHead])];
+  out[3]  = w->still[slot_of(w->maxq[w->maxHead])];
+  out[4]  = w->still[last];
+  out[5]  = (float)((w->sS - w->h1S) / (n - half) - w->h1S / half);
+  out[6]  = (float)(w->dS / (n - 1));
+  out[7]  = (float)(w->nStill / n);
+  out[8]  = (float)sqrt(vH > 0 ? vH : 0);
+  out[9]  = (float)(w->dH / (n - 1));
+  out[10] = (float)((w->sH - w->h1H) / (n - half) - w->h1H / half);
+  out[11] = (float)(w->hr[last] - mH);
+  return 0;
+}
+
+void tm_window_still_stats(const tm_window_t* w, double* mean, double* var){
+  const double m = w->count ? w->sS / w->count : 0;
+  const double v = w->count ? w->sSS / w->count - m * m : 0;
+  *mean = m;
+  *var = v > 0 ? v : 0;
+}
+
+// ---- model ----
+
+static int in_blob(uint32_t off, size_t bytes, size_t size, uint32_t align){
+  return off % align == 0 && off <= size && bytes <= size - off;
+}
+
+// mult = qmul * 2^-qshift with qmul in [2^30, 2^31); a multiplier too
+// small to reach one int8 step is 0. -1 for a negative / non-finite one
+// or one past 2^30, which no sane model has.
+static int quant_multiplier(float mult, int32_t* qmul, uint8_t* qshift){
+  *qmul = 0; *qshift = 62;
+  if (!(mult >= 0) || isinf(mult)) return -1;
+  if (mult == 0) return 0;
+  int e;
+  const double f = frexp((double)mult, &e);           // mult = f * 2^e, f in [0.5, 1)
+  int64_t q = (int64_t)llround(f * 2147483648.0);
+  if (q == (int64_t)1 << 31) { q >>= 1; ++e; }
+  if (e > 30) return -1;
+  if (31 - e > 62) return 0;
+  *qmul = (int32_t)q;
+  *qshift = (uint8_t)(31 - e);
+  return 0;
+}
+
+int tm_model_load(tm_model_t* m, const void* blob, size_t len){
+  if (!m) return -1;
+  memset(m, 0, sizeof(*m));
+  const tm_blob_header_t* h = (const tm_blob_header_t*)blob;
+  if (!blob || ((uintptr_t)blob & 3) || len < sizeof(*h)) return -1;
+  if (h->magic != TM_MAGIC || h->version != TM_VERSION) return -1;
+  if (h->size < sizeof(*h) || h->size > len) return -1;
+  if (h->nLayers < 1 || h->nLayers > TM_MAX_LAYERS) return -1;
+  if (h->nIn != TM_FEATURES || h->window != TM_WINDOW) return -1;
+
+  const uint8_t* base = (const uint8_t*)blob;
+  const size_t size = h->size;
+  int hasRef = 1;
+  uint32_t nIn = h->nIn;
+  for (uint32_t l = 0; l < h->nLayers; ++l) {
+    const tm_layer_desc_t* d = &h->layer[l];
+    if (d->nIn != nIn || d->nOut < 1 || d->nOut > TM_MAX_WIDTH) return -1;
+    if (d->stride % 16 || d->stride < d->nIn || d->stride > TM_MAX_WIDTH) return -1;
+    if (!(d->inScale > 0)) return -1;
+    if (!in_blob(d->wOff, (size_t)d->nOut * d->stride, size, 16) ||
+        !in_blob(d->bOff, (size_t)d->nOut * sizeof(int32_t), size, 4) ||
+        !in_blob(d->sOff, (size_t)d->nOut * sizeof(float), size, 4)) return -1;
+    if (d->fwOff && d->fbOff &&
+        in_blob(d->fwOff, (size_t)d->nOut * d->nIn * sizeof(float), size, 4) &&
+        in_blob(d->fbOff, (size_t)d->nOut * sizeof(float), size, 4)) {
+      m->fw[l] = (const float*)(base + d->fwOff);
+      m->fb[l] = (const float*)(base + d->fbOff);
+    } else {
+      hasRef = 0;
+    }
+    m->w[l] = (const int8_t*)(base + d->wOff);
+    m->b[l] = (const int32_t*)(base + d->bOff);
+    const float* s = (const float*)(base + d->sOff);
+    const float next = l + 1 < h->nLayers ? h->layer[l + 1].inScale : 1.0f;
+    for (uint32_t r = 0; r < d->nOut; ++r) {
+      m->mult[l][r] = s[r] * d->inScale / next;
+      if (quant_multiplier(m->mult[l][r], &m->qmul[l][r], &m->qshift[l][r]) != 0) {
+        memset(m, 0, sizeof(*m));
+        return -1;
+      }
+    }
+    nIn = d->nOut;
+  }
+  if (nIn != TM_CLASSES) { memset(m, 0, sizeof(*m)); return -1; }
+  if (!hasRef) { memset(m->fw, 0, sizeof(m->fw)); memset(m->fb, 0, sizeof(m->fb)); }
+  for (int k = 0; k < TM_FEATURES; ++k) m->inMul[k] = h->featInvStd[k] / h->layer[0].inScale;
+  m->hdr = h;
+  return 0;
+}
+
+int tm_model_loaded(const tm_model_t* m){ return m->hdr != NULL; }
+int tm_model_has_reference(const tm_model_t* m){ return m->hdr && m->fw[0] != NULL; }
+
+// Round half away from zero, saturate to the symmetric int8 range. Written
+// as selects rather than branches: the signs are data and do not predict.
+static inline int8_t sat8(float v){
+  v = v > 127.0f ? 127.0f : v;
+  v = v < -127.0f ? -127.0f : v;
+  v += copysignf(0.5f, v);
+  return v == v ? (int8_t)v : 0;
+}
+
+// (v * qmul) >> qshift rounded half away from zero, saturated like sat8.
+static inline int8_t requant8(int32_t v, int32_t qmul, int sh){
+  const int64_t p = (int64_t)v * qmul;
+  int64_t y = (p + ((int64_t)1 << (sh - 1)) - (p < 0)) >> sh;
+  y = y > 127 ? 127 : y;
+  y = y < -127 ? -127 : y;
+  return (int8_t)y;
+}
+
+static int argmax3(const float* z){
+  int k = 0;
+  for (int i = 1; i < TM_CLASSES; ++i) if (z[i] > z[k]) k = i;
+  return k;
+}
+
+int tm_infer(const tm_model_t* m, tm_arena_t* a, const float feat[TM_FEATURES], float logits[TM_CLASSES]){
+  const tm_blob_header_t* h = m->hdr;
+  int8_t* x = a->act[0];
+  memset(x + TM_FEATURES, 0, h->layer[0].stride - TM_FEATURES);
+  for (int k = 0; k < TM_FEATURES; ++k) x[k] = sat8((feat[k] - h->featMean[k]) * m->inMul[k]);
+
+  float z[TM_CLASSES];
+  for (uint32_t l = 0; l < h->nLayers; ++l) {
+    const tm_layer_desc_t* d = &h->layer[l];
+    // Padding columns up to the stride are zero in x, so whole strides
+    // keep the kernel on its vector path.
+    vk_gemv_s8(m->w[l], d->stride, x, d->stride, d->nOut, a->acc);
+    const int32_t* b = m->b[l];
+    if (l + 1 == h->nLayers) {
+      const float* mult = m->mult[l];
+      for (uint32_t r = 0; r < TM_CLASSES; ++r) z[r] = (float)(a->acc[r] + b[r]) * mult[r];
+      break;
+    }
+    int8_t* y = x == a->act[0] ? a->act[1] : a->act[0];
+    const int32_t* qmul = m->qmul[l];
+    const uint8_t* qshift = m->qshift[l];
+    const int32_t lo = d->relu ? 0 : INT32_MIN;
+    for (uint32_t r = 0; r < d->nOut; ++r) {
+      int32_t v = a->acc[r] + b[r];
+      v = v < lo ? lo : v;
+      y[r] = requant8(v, qmul[r], qshift[r]);
+    }
+    memset(y + d->nOut, 0, h->layer[l + 1].stride - d->nOut);
+    x = y;
+  }
+  if (logits) memcpy(logits, z, sizeof(z));
+  return argmax3(z);
+}
+
+int tm_infer_ref(const tm_model_t* m, const float feat[TM_FEATURES], float logits[TM_CLASSES]){
+  if (!tm_model_has_reference(m)) return -1;
+  const tm_blob_header_t* h = m->hdr;
+  float buf[2][TM_MAX_WIDTH];
+  float* x = buf[0];
+  for (int k = 0; k < TM_FEATURES; ++k) x[k] = (feat[k] - h->featMean[k]) * h->featInvStd[k];
+  for (uint32_t l = 0; l < h->nLayers; ++l) {
+    const tm_layer_desc_t* d = &h->layer[l];
+    float* y = x == buf[0] ? buf[1] : buf[0];
+    for (uint32_t r = 0; r < d->nOut; ++r) {
+      const float* w = m->fw[l] + (size_t)r * d->nIn;
+      float s = m->fb[l][r];
+      for (uint32_t k = 0; k < d->nIn; ++k) s += w[k] * x[k];
+      y[r] = d->relu && s < 0 ? 0 : s;
+    }
+    x = y;
+  }
+  if (logits) memcpy(logits, x, TM_CLASSES * sizeof(float));
+  return argmax3(x);
+}
+
+// ---- per-tick classifier ----
+
+int tm_classifier_init(tm_classifier_t* c, const void* blob, size_t len){
+  memset(c, 0, sizeof(*c));
+  tm_window_reset(&c->win);
+  if (!blob) blob = tm_default_blob(&len);
+  return tm_model_load(&c->model, blob, len);
+}
+
+void tm_classifier_reset(tm_classifier_t* c){ tm_window_reset(&c->win); }
+
+static int classify(tm_classifier_t* c, double still, double hr, int ref){
+  tm_window_push(&c->win, still, hr);
+  float f[TM_FEATURES];
+  if (tm_model_loaded(&c->model) && tm_window_features(&c->win, f) == 0) {
+    const int k = ref ? tm_infer_ref(&c->model, f, NULL) : -1;
+    return k >= 0 ? k : tm_infer(&c->model, &c->arena, f, NULL);
+  }
+  // Threshold rule on the window so far; before the first HR sample there
+  // is no window and only the current tick to go on.
+  if (c->win.count == 0) return tiny_motion_classify(still, 0.0);
+  double mean, var;
+  tm_window_still_stats(&c->win, &mean, &var);
+  return tiny_motion_classify(mean, var);
+}
+
+int tm_classifier_push(tm_classifier_t* c, double still, double hr){ return classify(c, still, hr, 0); }
+int tm_classifier_push_ref(tm_classifier_t* c, double still, double hr){ return classify(c, still, hr, 1); }
@@ -4,8 +4,27 @@
 //
 //  Created by Daniel Hu on 2025-08-14.
 //
+//  Motion class (0 still, 1 fidget, 2 active) for the respiration proxy.
+//    tiny_motion_classify   the original two-threshold rule; still the
+//                           fallback until a feature window has filled
+//    tm_window_*            last TM_WINDOW ticks of (stillness, HR) and the
+//                           TM_FEATURES summary features over them
+//    tm_model_load          int8 MLP from a flat blob, read in place (so the
+//                           blob can be a const array or an mmap); no copies
+//    tm_infer               int8 inference through vk_gemv_s8 in a fixed
+//                           arena; tm_infer_ref is the float reference from
+//                           the blob's unquantised weights
+//    tm_classifier_*        window + built-in model + arena, one call per tick
+//  No heap anywhere: every struct is fixed size and caller-owned.
+//
+//  The built-in weights (tinyml_motion_model.c) are written by
+//  Tools/replay/st_motion_train.
+//
 
 #pragma once
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,6 +37,132 @@ static inline int tiny_motion_classify(double stillMean, double stillVar){
   return 2;                                                 // likely active/walking
 }
 
+#define TM_MAGIC      0x384C4D54u   // "TML8"
+#define TM_VERSION    1u
+#define TM_WINDOW     32            // ticks per feature window
+#define TM_FEATURES   12
+#define TM_CLASSES    3
+#define TM_MAX_LAYERS 4
+#define TM_MAX_WIDTH  64            // widest layer, and the arena rows
+
+// ---- feature window ----
+
+// Features, in order:
+//   stillness: mean, std, min, max, last, second-half minus first-half mean,
+//              mean |step|, fraction of ticks >= 0.85
+//   HR (bpm):  std, mean |step|, second-half minus first-half mean,
+//              last minus mean
+// The features are kept as running sums (halves for the trend features,
+// summed |steps|) and monotonic deques for min / max, so a push is O(1);
+// the sums are recomputed from the ring every TM_RESYNC pushes to clear
+// round-off.
+#define TM_RESYNC (4 * TM_WINDOW)
+
+typedef struct {
+  float    still[TM_WINDOW], hr[TM_WINDOW];
+  int      head;        // next slot
+  int      count;       // valid ticks, <= TM_WINDOW
+  float    lastHR;      // carried over NaN HR (before the first sample)
+  uint32_t seq;         // ticks stored since reset; tick q lives in slot q % TM_WINDOW
+  double   sS, sSS, sH, sHH;     // sums over the window
+  double   h1S, h1H;             // sums over its oldest TM_WINDOW / 2 ticks
+  double   dS, dH;               // sums of |step| between neighbours
+  int      nStill;               // ticks with stillness >= 0.85
+  uint32_t minq[TM_WINDOW], maxq[TM_WINDOW];   // tick numbers, values monotonic
+  int      minHead, minLen, maxHead, maxLen;
+  int      sinceResync;
+} tm_window_t;
+
+void tm_window_reset(tm_window_t* w);
+void tm_window_push(tm_window_t* w, double still, double hr);
+// 0 and the features once the window is full; -1 before.
+int  tm_window_features(const tm_window_t* w, float out[TM_FEATURES]);
+// Stillness mean and variance over however many ticks there are (0, 0 if
+// none), the inputs tiny_motion_classify expects.
+void tm_window_still_stats(const tm_window_t* w, double* mean, double* var);
+
+// ---- model blob ----
+// Little-endian, every offset from the blob start. The blob itself must be
+// 4-byte aligned; int8 rows start on 16 bytes so vector loads stay in-line.
+
+typedef struct {
+  uint32_t nIn, nOut;
+  uint32_t stride;     // int8 row pitch, a multiple of 16, >= nIn
+  uint32_t relu;       // 1: ReLU before the next layer
+  float    inScale;    // step of this layer's int8 input
+  uint32_t wOff;       // int8  W[nOut][stride], zero padded
+  uint32_t bOff;       // int32 bias[nOut], at scale wScale[r] * inScale
+  uint32_t sOff;       // float wScale[nOut] (per output row)
+  uint32_t fwOff;      // float W[nOut][nIn] for tm_infer_ref, 0 if absent
+  uint32_t fbOff;      // float bias[nOut], 0 if absent
+} tm_layer_desc_t;
+
+typedef struct {
+  uint32_t magic, version;
+  uint32_t size;       // whole blob, bytes
+  uint32_t nLayers;
+  uint32_t nIn;        // TM_FEATURES
+  uint32_t window;     // TM_WINDOW the model was trained on
+  uint32_t reserved[2];
+  float    featMean[TM_FEATURES];     // standardisation before quantising
+  float    featInvStd[TM_FEATURES];
+  tm_layer_desc_t layer[TM_MAX_LAYERS];
+} tm_blob_header_t;
+
+typedef struct {
+  const tm_blob_header_t* hdr;        // NULL: not loaded
+  const int8_t*  w[TM_MAX_LAYERS];
+  const int32_t* b[TM_MAX_LAYERS];
+  const float*   fw[TM_MAX_LAYERS];
+  const float*   fb[TM_MAX_LAYERS];
+  // Requantisation: wScale[r] * inScale / next inScale (last layer: to
+  // float logits). Hidden layers apply it in integers as
+  // (acc * qmul) >> qshift, qmul in [2^30, 2^31).
+  float   mult[TM_MAX_LAYERS][TM_MAX_WIDTH];
+  int32_t qmul[TM_MAX_LAYERS][TM_MAX_WIDTH];
+  uint8_t qshift[TM_MAX_LAYERS][TM_MAX_WIDTH];
+  float inMul[TM_FEATURES];           // featInvStd / layer 0 inScale
+} tm_model_t;
+
+// Scratch for one inference; TM_MAX_WIDTH wide so rows can be padded.
+typedef struct {
+  int32_t acc[TM_MAX_WIDTH];
+  int8_t  act[2][TM_MAX_WIDTH];
+} tm_arena_t;
+
+// Validates the header, dimensions and offsets against len; 0 on success,
+// -1 (model left unloaded) otherwise. The blob must outlive the model.
+int tm_model_load(tm_model_t* m, const void* blob, size_t len);
+int tm_model_loaded(const tm_model_t* m);
+int tm_model_has_reference(const tm_model_t* m);
+
+// Class index; logits (may be NULL) in float. Model must be loaded.
+int tm_infer(const tm_model_t* m, tm_arena_t* a, const float feat[TM_FEATURES], float logits[TM_CLASSES]);
+// Same network in float from the unquantised weights; -1 if the blob has none.
+int tm_infer_ref(const tm_model_t* m, const float feat[TM_FEATURES], float logits[TM_CLASSES]);
+
+// Built-in model (tinyml_motion_model.c).
+const void* tm_default_blob(size_t* len);
+
+// ---- per-tick classifier ----
+
+typedef struct {
+  tm_model_t  model;
+  tm_window_t win;
+  tm_arena_t  arena;
+} tm_classifier_t;
+
+// blob NULL: the built-in model. -1 if the blob does not load; the
+// classifier then keeps answering with tiny_motion_classify.
+int  tm_classifier_init(tm_classifier_t* c, const void* blob, size_t len);
+void tm_classifier_reset(tm_classifier_t* c);
+// One evaluation tick: stillness score (0..1) and smoothed HR (bpm, NaN
+// if none yet). Returns the motion class.
+int  tm_classifier_push(tm_classifier_t* c, double still, double hr);
+// Same, classified by tm_infer_ref (falls back to int8 without float
+// weights), for measuring what quantisation changes downstream.
+int  tm_classifier_push_ref(tm_classifier_t* c, double still, double hr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,123 @@
+//
+//  tinyml_motion_model.c
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+//  Built-in motion classifier, written by Tools/replay/st_motion_train;
+//  regenerate rather than edit.
+//  --seed 1 --train 40000 --hidden 16 --epochs 40: val int8 0.961, float 0.961.
+//
+
+#include "tinyml_motion.h"
+
+// tm_blob_header_t and payload as little-endian words (4-byte aligned).
+static const uint32_t kBlob[816] = {
+  0x384c4d54, 0x00000001, 0x00000cc0, 0x00000003, 0x0000000c, 0x00000020, 0x00000000, 0x00000000,
+  0x3f4e8437, 0x3d2f977e, 0x3f39cdeb, 0x3f5d6239, 0x3f4e7a7f, 0x38000378, 0x3c3c0dd0, 0x3f3a5773,
+  0x3fe7caa5, 0x3fdb91bd, 0x3c9787db, 0x3c8d6650, 0x4047e9d0, 0x41ae92d7, 0x4034d7aa, 0x406d364c,
+  0x4043e24d, 0x41309865, 0x42c6ccc4, 0x4017d471, 0x3f53a7c7, 0x3f5e2d20, 0x3f02c561, 0x3ecc1491,
+  0x0000000c, 0x00000010, 0x00000010, 0x00000001, 0x3d3b3702, 0x00000120, 0x00000220, 0x00000260,
+  0x000002a0, 0x000005a0, 0x00000010, 0x00000010, 0x00000010, 0x00000001, 0x3dbb5576, 0x000005e0,
+  0x000006e0, 0x00000720, 0x00000760, 0x00000b60, 0x00000010, 0x00000003, 0x00000010, 0x00000000,
+  0x3e0cd3bc, 0x00000ba0, 0x00000bd0, 0x00000bdc, 0x00000be8, 0x00000ca8, 0x00000000, 0x00000000,
+  0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+  0xf6af2ecb, 0x525fea28, 0xe6c181ea, 0x00000000, 0x110d15e4, 0xf40dff09, 0x0533ed81, 0x00000000,
+  0x00161c29, 0x06fd24fc, 0xf8f47ff8, 0x00000000, 0x2110ff20, 0xec001281, 0xb0fc4ab1, 0x00000000,
+  0x4ae1f709, 0x1ec68411, 0x107f4500, 0x00000000, 0x17ff4098, 0x6193eb36, 0xf8cd247f, 0x00000000,
+  0x601fef68, 0x170e81ee, 0xaff90d51, 0x00000000, 0xc7ee3912, 0x06ccf308, 0xf9002981, 0x00000000,
+  0x1fed00f0, 0x00ce16fc, 0xf3f381d9, 0x00000000, 0x26d02424, 0x767f6217, 0xdf1241b7, 0x00000000,
+  0x125def97, 0xc8e1457f, 0x139be1a8, 0x00000000, 0xe4f84d81, 0x132ad014, 0x022f0c47, 0x00000000,
+  0x080fb776, 0x9e652aea, 0x7fe70248, 0x00000000, 0xdd0bc21b, 0x7f4a2734, 0xf2245c8f, 0x00000000,
+  0x21ed2d53, 0xbac9e582, 0x7faaf4e8, 0x00000000, 0x204c1a35, 0xcbec07fd, 0xecad7fb7, 0x00000000,
+  0xfffffe09, 0x0000025a, 0xfffffd9c, 0xfffffe3a, 0x000001e6, 0xfffff9c6, 0x000003f2, 0xfffffeb0,
+  0xfffff994, 0x00000260, 0xffffff7e, 0xfffffc89, 0x0000049c, 0x00000137, 0x00000677, 0x0000002a,
+  0x3c2df1cf, 0x3c89841d, 0x3c7e0619, 0x3c6191a9, 0x3c2bc321, 0x3c3aca62, 0x3c12a4ff, 0x3c8ef931,
+  0x3c88a037, 0x3be29710, 0x3c0fb70f, 0x3c42a442, 0x3c216b4d, 0x3c211a27, 0x3bfe9fc6, 0x3c544127,
+  0xbf10c826, 0x3ef86925, 0xbf5cba59, 0xbde3df13, 0x3eda3699, 0xbe6ff614, 0x3f80f065, 0x3f5e8053,
+  0xbe728816, 0xbfac95eb, 0xbf2a4a81, 0xbe8bc1a0, 0xbef321bc, 0x3eb223ee, 0x3e65894c, 0x3e8f81d6,
+  0x3e1950d1, 0xbcaae87b, 0x3e5a088d, 0xbe567a65, 0xc0087115, 0xbea13b88, 0x3f5c75df, 0x3db2a4a7,
+  0x3f2388f7, 0x3edecd4f, 0x3eababa6, 0xbb857520, 0xbd8c78b7, 0x3f0e8455, 0xbd3dfb3f, 0x3dcb5a69,
+  0xbdeed8bc, 0x3ffc0a0d, 0xbe37914e, 0xbdffc6c9, 0x3ee3adcd, 0xbc1228f6, 0x3e657374, 0x3eeb66aa,
+  0xbfdfce86, 0x3e81b08e, 0xbb555d19, 0xbe8ae5a3, 0xbf8ad529, 0x3f8216bc, 0xbd517f68, 0xbf8d75d0,
+  0x3dc4325b, 0xbdb69b1b, 0xbea4f406, 0x3f456135, 0x3e31f939, 0xbfa6205b, 0xbf1b070a, 0x3ea11269,
+  0x3a4a2e18, 0x3f38c6fa, 0x3faa6b9b, 0x3e29af86, 0xbf97ca9d, 0x3f3be9cc, 0xbc384d7c, 0x3e86b8af,
+  0x3f1e6431, 0xbe73f08f, 0xbf9f81ff, 0x3f8d972f, 0x3fb954cd, 0x3ed35ae3, 0xbf136e5d, 0xbdb844f4,
+  0x3f6f5614, 0xbe19cfcf, 0x3e8e4021, 0x3f5bc69e, 0xbe2893a8, 0xbf917fb5, 0x3df83c42, 0x3e55ec4e,
+  0x3f399527, 0x3df2e1d8, 0xbd7592a4, 0xbf39b76c, 0x3e9d1c19, 0x3f7df445, 0xbe9db2ff, 0xbf7ccd54,
+  0x3e10d331, 0xbe6a6107, 0xbf69f87c, 0x3dd61bbe, 0xc00ddb3f, 0x3f3946bf, 0xbbb143b2, 0xbe059164,
+  0xbe88c5e2, 0xbbc6a329, 0xbea1272a, 0x3f037b58, 0xbd94e4a9, 0x3ebc7e1f, 0xbf53defe, 0x39f4c3af,
+  0xbf280051, 0xc0078ef7, 0xbe633091, 0xbe637230, 0x3e7fdac9, 0x3e80885e, 0xbea9056f, 0x3e858d4b,
+  0x3e204c54, 0x3f2e5567, 0x3f60d1e2, 0x3f516e69, 0xbf00b0eb, 0x3ee4685d, 0x3e01b87b, 0xbe67c2e5,
+  0xbf6b6905, 0xbe1adafa, 0x3f50b08c, 0x3e20133b, 0x3f8e97a1, 0x3f1bddb2, 0xbe8c2200, 0xbef99b4b,
+  0xbf44de2e, 0xbe8930a8, 0xbf62ed3a, 0x3e29c421, 0xbfc11ef9, 0x3f69e862, 0xbdcb3956, 0xbea93c7d,
+  0x3e745573, 0xbf12fd30, 0x3efe37e3, 0x3e6c8f21, 0x3f586a30, 0x3e0f7172, 0x3f0ddcd1, 0x3ce6630f,
+  0x3f94a63a, 0xbf393652, 0x3e1adbb8, 0x3d991db6, 0xbe5bdce9, 0x3ed473b0, 0x3f7e1304, 0xbf7814a6,
+  0x3f355fe2, 0x3c8d2c89, 0xbe7f5b91, 0x3fa02876, 0x3e897ede, 0xbf1bcaea, 0x3dd95a60, 0xbeade5d4,
+  0x3f029c7e, 0x3ec4974c, 0x3f39cb7c, 0x3f9fd7f3, 0xbf8e9afe, 0x3f679d72, 0x3eb3a664, 0xbe0f9089,
+  0x3f249ae0, 0x3eb3f7bc, 0xbe15f344, 0x3e848222, 0xbf79b45d, 0xbe558885, 0xbed9ed0c, 0xbf0a73d6,
+  0xbe3ec00a, 0xbdc4f477, 0xbf2ab3e0, 0x3f7ca286, 0x3f2f5289, 0x3eaef560, 0x3f7d0eaa, 0x3ed774c9,
+  0xbd0666dd, 0x3dc3084f, 0xbe86a59a, 0xbf2f219b, 0xbf714c7e, 0x3fd298a5, 0xbf8a6619, 0xbe867170,
+  0xbe7a2798, 0x3eec9120, 0xbedde6fe, 0xbe9264d2, 0x3e6e70c7, 0xbf54ab26, 0x3ed38b60, 0xbe895bfa,
+  0xbfa068ab, 0x3e44c2f8, 0xbd55a312, 0xbef68446, 0x3f0805c8, 0x3e0f0e23, 0x3f168495, 0x3ccc7645,
+  0xc5de81c7, 0x1808da12, 0x30b7f75f, 0xb7290728, 0x81a14e16, 0x31f2ee35, 0xa243e5db, 0x4c882b00,
+  0xe11deb0b, 0xfeeadbfa, 0x3d7f1b94, 0x72c2e41d, 0xc881eaba, 0xe52a3126, 0xe80f1a96, 0x15f526f2,
+  0xd1f5e41d, 0xe502e305, 0x1e082581, 0x01a137f5, 0xc72281f3, 0xe10e0928, 0xd6e70f00, 0x12dcb80b,
+  0xe4fd0c27, 0xfed6f9e5, 0xec3c1814, 0x1605e081, 0x7f5024b2, 0xa54bb678, 0xfd36fa2d, 0x0e54194e,
+  0xbeaa5ef5, 0xf88177f0, 0xd93dd47f, 0x46cce8f3, 0xfbd11936, 0xfedc00e6, 0x8105f843, 0x011c19cf,
+  0x142cdf01, 0x97930705, 0xb8d72a10, 0x467f3712, 0xe500c6cf, 0xb64d81df, 0xf2053933, 0x3738e52b,
+  0x2df99bd3, 0xf5cdeee5, 0x18812935, 0x4ee10030, 0xf9dde13c, 0x7fe999f9, 0xcfdb21a8, 0x3b08231d,
+  0x2eff8ee2, 0x1d28060e, 0x17e2447b, 0xfa24810c, 0xee8103f6, 0x05fcfe12, 0xdf00fef2, 0x0bec0e06,
+  0x0000030a, 0xffffff40, 0x000001ff, 0x000000cf, 0x0000002d, 0x00000069, 0xffffffa4, 0x000002f5,
+  0xffffff49, 0xffffff0a, 0xfffffef2, 0x000000d5, 0xffffff27, 0x000001f1, 0xffffff92, 0x00000001,
+  0x3c2a4ed3, 0x3c4d522f, 0x3c56dbb5, 0x3c6aadff, 0x3c83e55c, 0x3c9cd032, 0x3c848ea6, 0x3c04f83c,
+  0x3c2038af, 0x3c8599d3, 0x3c23d92a, 0x3c50883a, 0x3c6146ff, 0x3c6c694c, 0x3c586a2f, 0x3d564181,
+  0xbf18a4fc, 0xbfa8fa35, 0xbeb3dee7, 0xbf1d3a58, 0x3e42d782, 0xbeccc101, 0x3dafecd0, 0x3e814103,
+  0x3f7bd966, 0xbdc653c8, 0xbf428f0d, 0x3efdc7ae, 0x3ed6715a, 0x3d8d72ee, 0x3edc62d1, 0xbf421187,
+  0x3e8dc110, 0x3f7bc5d5, 0xbf98dcb0, 0xbfcbb78b, 0x3f2ba1fc, 0xbe6192e3, 0xbe31be82, 0x3f1ca2ba,
+  0xbeec9a9e, 0xbeb05c1f, 0x3f57182a, 0xbf974552, 0x3ad36d96, 0x3f0b0b43, 0xbfc043b2, 0x3f737254,
+  0x3e10deb9, 0xbe8fc059, 0x3ec397e0, 0xbed28ed0, 0xbdae821c, 0xbefbbb1a, 0xbe94caf9, 0xbcfbaf7d,
+  0xbfb53e96, 0x3eb40181, 0x3fd52dfe, 0x3f4cd83c, 0x3ec2ae54, 0xbeb91c4a, 0xbf50bee2, 0x3fbf8f55,
+  0xbf80db55, 0xbea0e771, 0xbfe8d8a3, 0xbf4ed44b, 0x3f0a2f6a, 0x3f344fd8, 0x3f19ad78, 0xbec2b67d,
+  0xbfc25e48, 0x3ebcc911, 0x3e5f1bfa, 0xbeb0aaf1, 0xbe476d78, 0x3f0cbfca, 0xbe1b84a8, 0x3e9b62f6,
+  0x3eeddc62, 0xbee9f889, 0xbe3846e0, 0xbf40f275, 0x3da7e3af, 0xbeecac17, 0x3d11ac3f, 0xbedb6503,
+  0xc002dd91, 0x3f173608, 0x3e042ad9, 0x3efaff26, 0xbe374012, 0x3f639a92, 0xbfc48c72, 0x3ca2b0d4,
+  0xbe76f438, 0xc01b9692, 0x3f270d39, 0xbf8bbc77, 0x3f41e536, 0x3e32033b, 0x3e89d809, 0xbf188bfc,
+  0xbc071bda, 0x3e91a997, 0xbef527b7, 0xbf4bdb33, 0x3e5dca74, 0xbfb0c9bd, 0xbf2fd07b, 0x3eb39eea,
+  0x3f22016a, 0x3e49371a, 0xbd5b3972, 0xbeea76ab, 0xbee0f78f, 0xbde542e9, 0xbf2c2a07, 0xbd1d27e5,
+  0x3ea8bca6, 0x3ec6a7fc, 0x3f76d95c, 0xbea6a61c, 0xc0038589, 0xbf0699bc, 0x3d9c1b1b, 0x3eb71ac1,
+  0xbf21993b, 0x3e96c6bd, 0x3f255a2a, 0x3f83ee4c, 0x3f7a0d42, 0xbf1a8fa1, 0x3f1c92bb, 0xbf3d385c,
+  0x3ebac99b, 0xbd4a735f, 0x3edf09ad, 0xbcd80518, 0x3f21f3d0, 0x3e506322, 0x3f2f1257, 0x3de7ad55,
+  0xbdd760f8, 0x3f6bdf85, 0xbf5666bd, 0xbf243d60, 0xbe24f3af, 0x3f946c69, 0xbf9ea6e4, 0xbda8821c,
+  0x3f9ef83e, 0xbede004c, 0x3f190fcb, 0xbec2bd75, 0xbe054fcd, 0xbe73d706, 0xbf0165dd, 0x3f2fdc5c,
+  0x3f5fbcd9, 0x3ecfd639, 0xbf45c1be, 0xbdadb7a2, 0xbed84c90, 0x3bea361f, 0xbf181270, 0xbd1e872b,
+  0x3f8bc9c8, 0xbe0944df, 0x3d994399, 0xc0048e9f, 0xbf4c69d7, 0x3ece2a42, 0x3ee72646, 0x3c3c201b,
+  0x3bd8a64b, 0xbea9f37e, 0x3ee24a71, 0x3e50c261, 0x3d57e0ff, 0x3d95c492, 0xbf8ae763, 0xbf86750f,
+  0x3e21f75a, 0x3ed7bcb2, 0xbed08a0d, 0xbf387e8e, 0x3e33ddcb, 0x3f0c360b, 0x3fa29178, 0x3f32dc52,
+  0xbf1e2dfd, 0xbf3e2dab, 0x3aa9428c, 0xbeb0a77a, 0xbeda26bc, 0xbfcee72a, 0x3f798357, 0xbf729f68,
+  0x3f25d0b5, 0x3f391b17, 0x3d8152f5, 0xbe38c6a1, 0x3f0d4b69, 0xbeb002b9, 0x3f360b8a, 0x3f34966e,
+  0xbf1f5b22, 0xbfb16175, 0xbdc7ae6b, 0x3f1f56bc, 0xbebbed70, 0xbe76ae7d, 0xbf346f44, 0xbe170d8f,
+  0x3f3ae8e2, 0x3f0f13a4, 0xbfdf8471, 0x3eac2b70, 0x3f2858ff, 0xbb8c83ac, 0xbed92cf7, 0x3f8a0976,
+  0x3f5e3718, 0xbee621f3, 0xbf000aae, 0xbdd4096e, 0xbdd60846, 0xbfbe4dc9, 0xbea7993e, 0x3fea9079,
+  0xbfa1fa91, 0x3ef0fd9b, 0xbf096ac6, 0xbf34bb94, 0x3ed8b8b9, 0x3f02948d, 0x3de784ce, 0x3f5a9c5c,
+  0xbec89b55, 0xbfc14265, 0xbc9eb443, 0x3f1ad0b0, 0x3e3bb773, 0x3d996f10, 0x3f06d630, 0x3ec3fb32,
+  0x3fcf5a6d, 0x3f66f48a, 0xbec94543, 0x3e9d0dc2, 0x3e1ed11e, 0xbfd6b95b, 0x3ef32cd5, 0xbdaf4be7,
+  0xbf03dd84, 0x3e10f198, 0xc0d494fe, 0xbf76d5ae, 0x3f7746dd, 0xbde7679a, 0xbe3ca4d5, 0x3e8dee2f,
+  0xbf366d11, 0xbde701de, 0xbc16472a, 0xbfdf3ae4, 0x3ead5b00, 0x3f3fd007, 0xbf85fa14, 0x3f19053a,
+  0x3f3d6568, 0xbe617e26, 0x3f1cd4a0, 0x3e8adf2e, 0x3d880fd9, 0x3e3c5c15, 0xbe0b74b1, 0x3f0fcfdd,
+  0xbe276029, 0xbebb884a, 0xbe7cff60, 0x3e7e5cae, 0xbe8bc835, 0x3f27f796, 0xbe08196b, 0x3b96c432,
+  0xda201508, 0xe7253923, 0x3c811559, 0x110fca09, 0x391bdc07, 0x30ff81e2, 0xccefbf25, 0xb8eb64d2,
+  0xd6cbaf5a, 0x40817d1c, 0x15113bc4, 0xa12fda51, 0xfffffec8, 0x0000017d, 0xffffff72, 0x3c89d9d0,
+  0x3c6b79bc, 0x3c2510f2, 0x3e04ce2d, 0x3eb4db30, 0x3f0908a8, 0xbf25ccf8, 0x3f1528a4, 0x3f7799bb,
+  0x3f1ddf5d, 0xbed5494a, 0x3fbea56f, 0x3eb83234, 0xc008c61c, 0x3f821ae0, 0x3e1bcdd6, 0xbf680fad,
+  0x3e8225dc, 0x3e91bd55, 0x3dc58552, 0xbf04a0e4, 0x3ec81892, 0x3f520816, 0xbedc6985, 0xbfe9a2c9,
+  0xbc288f40, 0x3f2f4b64, 0x3f0684c1, 0xbf6ef0bf, 0xbe7a91eb, 0xbf3f323c, 0xbf29d65f, 0x3fb763f9,
+  0xbe9914e5, 0xbf84a414, 0x3f67709e, 0xbf519854, 0xbf07e098, 0xbed84178, 0x3e8f48dd, 0x3fa161d4,
+  0xbfa3c6d0, 0x3f23d442, 0xbf1a01e6, 0x3f17c3a9, 0x3e2c99db, 0x3e5b2f14, 0x3f50e4c3, 0xbec45205,
+  0x3ef09f50, 0xbf755838, 0xbf38da1a, 0x3f40c145, 0xbe4a1d7e, 0x00000000, 0x00000000, 0x00000000,
+};
+
+const void* tm_default_blob(size_t* len){
+  *len = sizeof(kBlob);
+  return kBlob;
+}
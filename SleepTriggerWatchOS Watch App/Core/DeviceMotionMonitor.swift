@@ -7,47 +7,53 @@
 
 import Foundation
 import CoreMotion
-import Combine
 
 /// Calculates a robust "stillness score" using Device Motion (gravity-removed userAcceleration).
-/// - Sampling: 10 Hz
+/// - Sampling: 20 Hz into a MotionFrontEndWrapper, which decimates to 2 Hz for
+///   respiration and keeps each window's variance from block sums.
 /// - A short window (~5s) computes variance; each window is "still" if variance < threshold.
 /// - A hysteresis buffer (~15 windows ≈ 75s) yields a stillness score in [0, 1].
-final class DeviceMotionMonitor: ObservableObject {
+/// Window state lives on `queue`, which is serial; results go out through
+/// `onWindow` on that queue.
+final class DeviceMotionMonitor {
     private let manager = CMMotionManager()
-    private let queue = OperationQueue()
+    private let queue: OperationQueue = {
+        let q = OperationQueue()
+        q.maxConcurrentOperationCount = 1
+        q.name = "DeviceMotionMonitor"
+        return q
+    }()
 
-    // Per-sample buffer for current short window
-    private var window: [Double] = []
-    private let samplesPerWindow = 50          // 5s @ 10 Hz
+    // 5 s windows and the 2 Hz respiration path
+    private let frontEnd = MotionFrontEndWrapper()
     private let varianceThreshold = 0.0008     // tuned for userAcceleration magnitude
 
     // Hysteresis over recent windows
     private var recentWindows: [Bool] = []
     private let hysteresisWindows = 15         // ~75s total
 
-    @Published private(set) var stillnessScore: Double = 0.0 // 0...1 (fraction of still windows)
-    @Published private(set) var isStillNow: Bool = false     // instantaneous window label
+    /// (score 0...1 = fraction of still windows, instantaneous window label, time).
+    /// Called on the motion queue once per window. Set before start().
+    var onWindow: ((Double, Bool, Date) -> Void)?
+
+    /// (breathing rate in bpm, breathing-band power, time), once per window
+    /// alongside onWindow. Optional.
+    var onRespiration: ((Double, Double, Date) -> Void)?
 
     func start() {
         guard manager.isDeviceMotionAvailable else { return }
-        manager.deviceMotionUpdateInterval = 1.0 / 10.0
+        manager.deviceMotionUpdateInterval = 1.0 / MotionFrontEndWrapper.inputRate
         manager.startDeviceMotionUpdates(using: .xArbitraryZVertical, to: queue) { [weak self] dm, _ in
             guard let self, let dm else { return }
             let ua = dm.userAcceleration
             // magnitude of user acceleration
             let mag = sqrt(ua.x*ua.x + ua.y*ua.y + ua.z*ua.z)
-            self.window.append(mag)
+            _ = self.frontEnd.push(mag, at: dm.timestamp)
 
-            if self.window.count >= self.samplesPerWindow {
-                // Compute variance of current window
-                let mean = self.window.reduce(0,+) / Double(self.window.count)
-                let varSum = self.window.reduce(0) { $0 + pow($1 - mean, 2) }
-                let variance = varSum / Double(self.window.count)
-                let still = variance < self.varianceThreshold
+            if self.frontEnd.windowReady {
+                let still = self.frontEnd.windowVariance < self.varianceThreshold
 
-                // Slide window + update hysteresis
-                self.window.removeAll(keepingCapacity: true)
+                // Update hysteresis
                 self.recentWindows.append(still)
                 if self.recentWindows.count > self.hysteresisWindows {
                     self.recentWindows.removeFirst()
@@ -55,21 +61,18 @@ final class DeviceMotionMonitor: ObservableObject {
 
                 let score = Double(self.recentWindows.filter { $0 }.count) / Double(max(1, self.recentWindows.count))
 
-                DispatchQueue.main.async {
-                    self.isStillNow = still
-                    self.stillnessScore = score
-                }
+                let now = Date()
+                self.onWindow?(score, still, now)
+                self.onRespiration?(self.frontEnd.respirationBPM, self.frontEnd.breathingPower, now)
             }
         }
     }
 
     func stop() {
         manager.stopDeviceMotionUpdates()
-        window.removeAll()
-        recentWindows.removeAll()
-        DispatchQueue.main.async {
-            self.isStillNow = false
-            self.stillnessScore = 0
+        queue.addOperation { [weak self] in
+            self?.frontEnd.reset()
+            self?.recentWindows.removeAll()
         }
     }
 }
@@ -8,50 +8,59 @@
 import Foundation
 
 /// Tracks HR baseline (long window) and short-term trend (slope).
+/// Backed by `tw_tracker_t` (time_window.c): the trend, baseline and 30 min
+/// context windows share one sample buffer and keep running sums, so every
+/// ingest and every query is O(1).
 final class HRTrendAnalyzer {
-    private var baselineBuf: [(Date, Double)] = []
-    private var trendBuf: [(Date, Double)] = []
+    private var tracker = tw_tracker_t()
 
-    var baselineWindow: TimeInterval = 5 * 60     // 5 minutes
-    var trendWindow: TimeInterval = 90            // 90 seconds
+    private static let trend: Int32 = 0, baseline: Int32 = 1, context: Int32 = 2
 
-    func ingest(_ bpm: Double, at time: Date = .now) {
-        baselineBuf.append((time, bpm))
-        trendBuf.append((time, bpm))
-        let baselineCut = time.addingTimeInterval(-baselineWindow)
-        baselineBuf.removeAll { $0.0 < baselineCut }
-        let trendCut = time.addingTimeInterval(-trendWindow)
-        trendBuf.removeAll { $0.0 < trendCut }
+    var baselineWindow: TimeInterval = 5 * 60 {   // 5 minutes
+        didSet { tw_set_horizon(&tracker, Self.baseline, baselineWindow) }
+    }
+    var trendWindow: TimeInterval = 90 {          // 90 seconds
+        didSet { tw_set_horizon(&tracker, Self.trend, trendWindow) }
+    }
+    var contextWindow: TimeInterval = 30 * 60 {   // 30 minutes
+        didSet { tw_set_horizon(&tracker, Self.context, contextWindow) }
     }
 
-    var baselineMean: Double? {
-        guard !baselineBuf.isEmpty else { return nil }
-        return baselineBuf.map(\.1).reduce(0,+) / Double(baselineBuf.count)
+    init() {
+        let horizons = [trendWindow, baselineWindow, contextWindow]
+        tw_init(&tracker, horizons, Int32(horizons.count), 512)
+    }
+
+    deinit { tw_free(&tracker) }
+
+    /// Samples may arrive out of order (HealthKit batches do); a late one is
+    /// placed by its timestamp, and one older than every window is ignored.
+    func ingest(_ bpm: Double, at time: Date = .now) {
+        tw_push(&tracker, time.timeIntervalSinceReferenceDate, bpm)
     }
 
+    func reset() { tw_clear(&tracker) }
+
+    var baselineMean: Double? { mean(Self.baseline) }
+
+    /// Mean over the 30 min context window.
+    var contextMean: Double? { mean(Self.context) }
+
     /// Returns (latest - baseline) / baseline (negative when below baseline).
     var dropFraction: Double? {
-        guard let baseline = baselineMean, let latest = trendBuf.last?.1 else { return nil }
-        guard baseline > 0 else { return nil }
-        return (latest - baseline) / baseline
+        var out = 0.0
+        return tw_drop_fraction(&tracker, Self.baseline, &out) == 0 ? out : nil
     }
 
-    /// Simple linear regression slope in bpm/second over the trend window.
+    /// Least-squares slope in bpm/second over the trend window.
     var slopeBPMPerSec: Double? {
-        let pts = trendBuf
-        guard pts.count >= 5 else { return nil }
-        // x: seconds from first sample
-        let t0 = pts.first!.0.timeIntervalSinceReferenceDate
-        let xs = pts.map { $0.0.timeIntervalSinceReferenceDate - t0 }
-        let ys = pts.map { $0.1 }
-
-        let n = Double(xs.count)
-        let sumX = xs.reduce(0,+), sumY = ys.reduce(0,+)
-        let sumXX = xs.reduce(0) { $0 + $1*$1 }
-        let sumXY = zip(xs, ys).reduce(0) { $0 + $1.0 * $1.1 }
-        let denom = (n * sumXX - sumX * sumX)
-        guard denom != 0 else { return nil }
-        let slope = (n * sumXY - sumX * sumY) / denom
-        return slope
+        guard tw_count(&tracker, Self.trend) >= 5 else { return nil }
+        var out = 0.0
+        return tw_slope(&tracker, Self.trend, &out) == 0 ? out : nil
+    }
+
+    private func mean(_ horizon: Int32) -> Double? {
+        var out = 0.0
+        return tw_mean(&tracker, horizon, &out) == 0 ? out : nil
     }
 }
@@ -8,12 +8,14 @@
 import Foundation
 import HealthKit
 
-final class HeartRateStream: NSObject, ObservableObject, HKLiveWorkoutBuilderDelegate, HKWorkoutSessionDelegate {
+final class HeartRateStream: NSObject, HKLiveWorkoutBuilderDelegate, HKWorkoutSessionDelegate {
     private let store: HKHealthStore
     private var session: HKWorkoutSession?
     private var builder: HKLiveWorkoutBuilder?
 
-    @Published var latestBPM: Double?
+    /// Called on HealthKit's delegate queue (serial) with each new reading.
+    /// Set before start().
+    var onBPM: ((Double, Date) -> Void)?
 
     init(store: HKHealthStore) {
         self.store = store
@@ -54,7 +56,7 @@ final class HeartRateStream: NSObject, ObservableObject, HKLiveWorkoutBuilderDel
 
         let bpmUnit = HKUnit(from: "count/min")
         if let val = stats.mostRecentQuantity()?.doubleValue(for: bpmUnit) {
-            DispatchQueue.main.async { self.latestBPM = val }
+            onBPM?(val, stats.mostRecentQuantityDateInterval()?.end ?? Date())
         }
     }
 
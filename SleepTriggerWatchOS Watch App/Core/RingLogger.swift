@@ -36,9 +36,10 @@ public struct RingLogger {
                                 drop: Double,
                                 slope: Double,
                                 propensity: Double,
-                                stateRaw: Int)
+                                stateRaw: Int,
+                                at t: TimeInterval = Date().timeIntervalSince1970)
     {
-        let r = Row(t: Date().timeIntervalSince1970,
+        let r = Row(t: t,
                     hr: hr, still: still, drop: drop, slope: slope,
                     propensity: propensity, stateRaw: stateRaw)
         buf[idx] = r
@@ -51,15 +52,29 @@ public struct RingLogger {
         return Array(buf[idx...] + buf[..<idx])
     }
 
-    // Optional: write CSV into the App Group so iOS can read it
+    // Optional: write CSV into the App Group so iOS can read it.
+    // Streams through export_stream.c, so memory stays at one output buffer.
+    // Values keep full round-trip precision, as the old "\(Double)" output did.
     public func writeCSVToAppGroup(filename: String = "sleep_ringlog.csv") throws {
         guard let url = FileManager.default
             .containerURL(forSecurityApplicationGroupIdentifier: AppGroup.suite) else { return }
         let file = url.appendingPathComponent(filename)
-        var s = "t,hr,still,drop,slope,propensity,state\n"
-        for r in all() {
-            s += "\(r.t),\(r.hr ?? -1),\(r.still),\(r.drop),\(r.slope),\(r.propensity),\(r.stateRaw)\n"
+
+        var w = es_writer_t()
+        guard es_open(&w, file.path, 0) == 0 else { throw POSIXError(.init(rawValue: errno) ?? .EIO) }
+        es_puts(&w, "t,hr,still,drop,slope,propensity,state\n")
+
+        let rt = UInt8(ES_DEC_ROUNDTRIP)
+        let decimals: [UInt8] = [rt, rt, rt, rt, rt, rt, 0]
+        var row = [Double](repeating: 0, count: 7)
+        let count = filled ? capacity : idx
+        let start = filled ? idx : 0
+        for k in 0..<count {
+            let r = buf[(start + k) % capacity]
+            row[0] = r.t; row[1] = r.hr ?? -1; row[2] = r.still; row[3] = r.drop
+            row[4] = r.slope; row[5] = r.propensity; row[6] = Double(r.stateRaw)
+            es_csv_row_f64(&w, row, decimals, 7)
         }
-        try s.data(using: .utf8)!.write(to: file, options: .atomic)
+        guard es_close(&w) == 0 else { throw POSIXError(.init(rawValue: errno) ?? .EIO) }
     }
 }
@@ -13,4 +13,18 @@ final class IIR1 {
     init(alpha: Float) { iir1_init(&core, alpha) }
 
     func update(_ x: Float) -> Float { iir1_update(&core, x) }
+
+    /// Forget the state; the next sample passes through unfiltered.
+    func reset() { iir1_reset(&core) }
+
+    /// Filters a whole block in one C call (same output as mapping `update`).
+    func process(_ xs: [Float]) -> [Float] {
+        var out = [Float](repeating: 0, count: xs.count)
+        xs.withUnsafeBufferPointer { src in
+            out.withUnsafeMutableBufferPointer { dst in
+                iir1_process_block(&core, src.baseAddress, dst.baseAddress, xs.count)
+            }
+        }
+        return out
+    }
 }
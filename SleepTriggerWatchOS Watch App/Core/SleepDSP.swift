@@ -0,0 +1,400 @@
+//
+//  SleepDSP.swift
+//  SleepTriggerWatchOS Watch App
+//
+//  Created by Daniel Hu on 2025-08-16.
+//
+
+import Foundation
+
+/// Sensor DSP on its own thread.
+///
+/// Sensor callbacks push timestamped samples into lock-free SPSC rings
+/// (sample_queue.c) on whatever thread they arrive on; the DSP thread wakes
+/// about once a second, drains everything that arrived and replays it in time
+/// order. Samples are conditioned as they come, then merged by the frame
+/// aligner (frame_align.c) so trend / EKF / HMM run exactly once per
+/// `framePeriod` on values taken at the frame time. One `sq_snapshot_t` per
+/// batch goes out through a seqlock; the main thread only reads that.
+///
+/// Evaluations are paced by `dc_sched_next` (duty_control.c): every frame
+/// while propensity is high, rising, uncertain or the state is drowsy, up to
+/// 30 s apart when calm. The thread sleeps until the next one is due.
+///
+/// One producer per ring: HealthKit's delegate queue for heart rate, the
+/// (serial) motion queue for stillness, the main actor for control.
+final class SleepDSP: @unchecked Sendable {
+    private enum Command: Double { case start = 1, stop = 2 }
+
+    private let hrQueue:      OpaquePointer
+    private let motionQueue:  OpaquePointer
+    private let controlQueue: OpaquePointer
+    private let snapshotCell: OpaquePointer
+
+    private let wake = DispatchSemaphore(value: 0)
+    private let drainInterval: TimeInterval = 1.0
+    private var thread: Thread?
+
+    // ---- DSP thread only below ----
+
+    private let hrTrend = HRTrendAnalyzer()
+    private let fsm     = SleepStateMachine()
+
+    private let hrLPF    = IIR1(alpha: 0.22)
+    private let stillLPF = IIR1(alpha: 0.12)
+
+    private static let hampelWindow: Int32 = 9, hampelSigma = 3.0   // 9-sample window, 3σ
+    private var hrHampel = rs_hampel_t()
+    private var hrVar    = rs_var_t()
+
+    private let hrWindow    = RingWindowWrapper()   // last 64 samples, O(1) stats
+    private let stillWindow = RingWindowWrapper()
+    private var spectrum    = sdft_bank_t()
+    private var vlfBin: Int32 = -1
+
+    // int8 MLP over the last TM_WINDOW frames (tinyml_motion.c); fed every
+    // frame once HR is trusted, read by evaluate().
+    private var motionClassifier = tm_classifier_t()
+    private var motionClass: Int32 = 2
+
+    private let ekf = EKFWrapper(q: 0.01, r: 0.10, x0: 0, p0: 1)
+    private let hmm = HMMWrapper()
+
+    // Pacing: frames before nextEval only feed the trend / spectrum.
+    private var sched = dc_scheduler_t()
+    private var account = dc_account_t()            // guarded by logLock
+    private var nextEval = -Double.infinity
+    private var lastEval: TimeInterval?
+
+    // Frame clock: HR interpolated between samples, stillness held.
+    private var aligner = fa_aligner_t()
+    private let framePeriod: TimeInterval = 2
+    private let frameLag: TimeInterval = 5        // wait this long for the next HR sample
+    private let staleAfter: TimeInterval = 15
+    private static let hrStream: Int32 = 0, stillStream: Int32 = 1
+
+    private var hrSampleCount = 0
+    private let minHRSamplesToDecide = 8
+    private var asleepStableTicks = 0
+    private let asleepConfirmTicks = 2
+    private var halted = true                      // until .start, and after onset
+    private var startT = -Double.infinity          // time of the last control command
+
+    // Samples fa_push refused even after releasing frames (full stream
+    // queue or out of order); guarded by logLock.
+    private var alignerDrops: UInt64 = 0
+
+    private var batch: [sq_sample_t] = []
+    private var scratch = [sq_sample_t](repeating: sq_sample_t(), count: 64)
+    private var snap = SleepDSP.emptySnapshot
+
+    // Logger and duty account are read from outside; writes are once per tick.
+    private let logLock = NSLock()
+    private var logger = RingLogger(capacity: 600)
+
+    private static let emptySnapshot = sq_snapshot_t(t: 0, bpm: .nan, still: 0, propensity: 0,
+                                                     stateSince: 0, onset: .nan, state: 0, ticks: 0)
+
+    init() {
+        hrQueue      = sq_queue_create(256)
+        motionQueue  = sq_queue_create(64)
+        controlQueue = sq_queue_create(16)
+        snapshotCell = sq_seqlock_create(MemoryLayout<sq_snapshot_t>.size)
+        batch.reserveCapacity(256 + 64 + 16)
+
+        rs_hampel_init(&hrHampel, Self.hampelWindow, Self.hampelSigma)
+        rs_var_init(&hrVar)
+
+        // sliding spectrum around ~0.2 Hz on the frame-rate stillness;
+        // exact resync every ~20 min keeps long nights from drifting.
+        // Only the VLF bin: this stream is the frame-rate stillness score
+        // after stillLPF, which is ~20 dB down across the 0.2-0.4 Hz
+        // breathing band, and Nyquist (0.5 Hz, less with longer frames)
+        // leaves no room for a motion band. Respiration comes from
+        // DeviceMotionMonitor's 2 Hz path and motion from the classifier.
+        sdft_init(&spectrum, 1.0 / framePeriod, 32, 1200)
+        vlfBin = sdft_add_bin(&spectrum, 0.20)
+
+        dc_sched_init(&sched, nil)
+        tm_classifier_init(&motionClassifier, nil, 0)   // built-in model
+
+        fa_init(&aligner, framePeriod, frameLag, 2)
+        fa_stream_config(&aligner, Self.hrStream, FA_LINEAR, staleAfter)
+        fa_stream_config(&aligner, Self.stillStream, FA_HOLD, staleAfter)
+        sq_seqlock_write(snapshotCell, &snap)
+
+        // Holds self only while draining, never across the wait, so deinit
+        // can run (and signal `wake`) while the thread sleeps.
+        let wake = self.wake
+        let t = Thread { [weak self] in
+            while !Thread.current.isCancelled {
+                guard let sleep = self?.sleepInterval() else { return }
+                _ = wake.wait(timeout: .now() + sleep)
+                guard !Thread.current.isCancelled, let dsp = self else { return }
+                dsp.runOnce()
+            }
+        }
+        t.name = "SleepDSP"
+        t.qualityOfService = .utility
+        thread = t
+        t.start()
+    }
+
+    deinit {
+        thread?.cancel()
+        wake.signal()
+        sq_queue_destroy(hrQueue)
+        sq_queue_destroy(motionQueue)
+        sq_queue_destroy(controlQueue)
+        sq_seqlock_destroy(snapshotCell)
+    }
+
+    // MARK: - Producers
+
+    /// HealthKit delegate queue.
+    func pushHeartRate(_ bpm: Double, at time: Date) { push(hrQueue, SQ_HEART_RATE, bpm, time) }
+
+    /// Motion queue.
+    func pushStillness(_ score: Double, at time: Date) { push(motionQueue, SQ_STILLNESS, score, time) }
+
+    /// Main actor. Both reset the pipeline; samples timestamped before the
+    /// command are ignored, even if they were still queued.
+    func start() { control(.start) }
+    func stop()  { control(.stop) }
+
+    // MARK: - Consumers
+
+    /// Latest published state; any thread, never blocks the DSP thread.
+    func snapshot() -> sq_snapshot_t {
+        var s = Self.emptySnapshot
+        sq_seqlock_read(snapshotCell, &s)
+        return s
+    }
+
+    var ringLogger: RingLogger { logLock.withLock { logger } }
+
+    /// Wakeups, sensor-on and DSP time since the last start.
+    var dutyAccount: dc_account_t { logLock.withLock { account } }
+
+    /// Samples lost to full rings (DSP thread starved for a long time) or
+    /// refused by the frame aligner.
+    var droppedSamples: UInt64 {
+        sq_dropped(hrQueue) + sq_dropped(motionQueue) + logLock.withLock { alignerDrops }
+    }
+
+    // MARK: - DSP thread
+
+    private func push(_ q: OpaquePointer, _ kind: sq_kind_t, _ value: Double, _ time: Date) {
+        var s = sq_sample_t(t: time.timeIntervalSince1970, value: value, kind: Int32(kind.rawValue), reserved: 0)
+        sq_push(q, &s)
+    }
+
+    private func control(_ c: Command) {
+        push(controlQueue, SQ_CONTROL, c.rawValue, .now)
+        wake.signal()
+    }
+
+    /// Until the next evaluation's frame can be released.
+    private func sleepInterval() -> TimeInterval {
+        let due = nextEval + frameLag - Date().timeIntervalSince1970
+        return min(sched.pol.maxInterval + frameLag, max(drainInterval, due))
+    }
+
+    private func runOnce() {
+        let c0 = DispatchTime.now().uptimeNanoseconds
+        defer {
+            let dt = Double(DispatchTime.now().uptimeNanoseconds - c0) * 1e-9
+            logLock.withLock { account.dspSeconds += dt }
+        }
+        batch.removeAll(keepingCapacity: true)
+        drain(controlQueue)
+        drain(hrQueue)
+        drain(motionQueue)
+        guard !batch.isEmpty else { return }
+
+        // Each ring is already in order; merge them. Control sorts first on ties.
+        batch.sort { Self.key($0.t, $0.kind) < Self.key($1.t, $1.kind) }
+        for s in batch { handle(s) }
+        sq_seqlock_write(snapshotCell, &snap)
+    }
+
+    private static func key(_ t: Double, _ kind: Int32) -> (Double, Int) {
+        (t, kind == Int32(SQ_CONTROL.rawValue) ? 0 : 1)
+    }
+
+    private func drain(_ q: OpaquePointer) {
+        while true {
+            let n = scratch.withUnsafeMutableBufferPointer { sq_pop_batch(q, $0.baseAddress, $0.count) }
+            batch.append(contentsOf: scratch[0..<n])
+            if n < scratch.count { return }
+        }
+    }
+
+    private func handle(_ s: sq_sample_t) {
+        switch sq_kind_t(rawValue: UInt32(s.kind)) {
+        case SQ_CONTROL:
+            reset()
+            halted = (s.value != Command.start.rawValue)
+            startT = s.t
+        case SQ_HEART_RATE where !halted && s.t >= startT:
+            let cleaned  = rs_hampel_update(&hrHampel, s.value)
+            rs_var_update(&hrVar, cleaned)
+            let smoothed = Double(hrLPF.update(Float(cleaned)))
+            feed(Self.hrStream, s.t, smoothed)
+        case SQ_STILLNESS where !halted && s.t >= startT:
+            feed(Self.stillStream, s.t, Double(stillLPF.update(Float(s.value))))
+        default:
+            break
+        }
+    }
+
+    /// Hands one conditioned sample to the aligner. A full stream queue
+    /// (FA_QUEUE pending) gets the releasable frames drained first, then one
+    /// retry; what still does not fit is counted in droppedSamples.
+    private func feed(_ stream: Int32, _ t: Double, _ x: Double) {
+        if fa_push(&aligner, stream, t, x) != 0 {
+            drainFrames()
+            if fa_push(&aligner, stream, t, x) != 0 {
+                logLock.withLock { alignerDrops &+= 1 }
+            }
+        }
+        drainFrames()
+    }
+
+    private func drainFrames() {
+        var fr = fa_frame_t()
+        while !halted, fa_pop(&aligner, &fr) == 1 {
+            if Int(fr.flags.0) & FA_VALID != 0, Int(fr.flags.0) & FA_STALE == 0 {
+                snap.bpm = fr.value.0
+                hrTrend.ingest(fr.value.0, at: Date(timeIntervalSince1970: fr.t))
+                hrWindow.push(Float(fr.value.0))
+            }
+            hrSampleCount += Int(fr.count.0)
+            // A stillness value held across a sensor gap is not a reading.
+            let stillFresh = Int(fr.flags.1) & FA_VALID != 0 && Int(fr.flags.1) & FA_STALE == 0
+            if stillFresh {
+                snap.still = fr.value.1
+                stillWindow.push(Float(fr.value.1))
+                sdft_push(&spectrum, fr.value.1)
+            }
+            if stillFresh, hrSampleCount >= minHRSamplesToDecide {
+                motionClass = tm_classifier_push(&motionClassifier, snap.still, snap.bpm)
+            }
+            if fr.t >= nextEval { evaluate(at: fr.t) }
+        }
+    }
+
+    private func reset() {
+        fsm.reset()
+        hrTrend.reset()
+        rs_hampel_init(&hrHampel, Self.hampelWindow, Self.hampelSigma)
+        rs_var_init(&hrVar)
+        hrLPF.reset()
+        stillLPF.reset()
+        hrSampleCount = 0
+        asleepStableTicks = 0
+        hrWindow.clear()
+        stillWindow.clear()
+        tm_classifier_reset(&motionClassifier)
+        motionClass = 2
+        sdft_reset(&spectrum)
+        fa_reset(&aligner)
+        dc_sched_reset(&sched)
+        nextEval = -.infinity
+        lastEval = nil
+        logLock.withLock { account = dc_account_t() }
+        snap = Self.emptySnapshot
+    }
+
+    // Helper that works whether inputs are Double or Double?
+    @inline(__always) private func val(_ x: Double) -> Double { x }
+    @inline(__always) private func val(_ x: Double?) -> Double { x ?? 0 }
+
+    // MARK: - Decision core
+    private func evaluate(at t: TimeInterval) {
+        guard hrSampleCount >= minHRSamplesToDecide else { return }
+        let now = Date(timeIntervalSince1970: t)
+
+        // HR trend (optionals safe)
+        let drop  = val(hrTrend.dropFraction)      // 0…1, 0 if not ready yet
+        let slope = val(hrTrend.slopeBPMPerSec)    // neg when dozing
+        let negSlope = max(0.0, min(1.0, -slope / 0.2))
+
+        // Stillness features (use smoothed score; no API calls on buffer)
+        let stillMean = snap.still
+
+        // VLF power once we have enough samples
+        var vlf: Double = 0
+        if stillWindow.count >= 32 {
+            vlf = sdft_bin_power(&spectrum, vlfBin)
+            vlf = min(1.0, vlf / 5.0)
+        }
+
+        // Motion class (classifier, this frame) & respiration proxy: 0 quiet / 1 small / 2 move
+        let respQuiet = (motionClass == 0) ? 1.0 : (motionClass == 1 ? 0.6 : 0.2)
+
+        // EKF fusion → propensity (0…1)
+        let p = ekf.update(withDrop: drop,
+                           still: stillMean,
+                           negSlope: negSlope,
+                           respQuiet: respQuiet,
+                           vlfPower: vlf)
+
+        // FSM → observation, then HMM smoothing
+        var newState = fsm.ingest(dropFraction: drop, stillness: stillMean, slope: slope, now: now)
+        let obs: Int = {
+            if case .awake  = newState { return 0 }
+            if case .drowsy = newState { return 1 }
+            return 2
+        }()
+        let sm = hmm.step(withObservation: obs)
+        newState = (sm == 0 ? .awake : (sm == 1 ? .drowsy(since: now) : .asleep(at: now)))
+
+        // Assist with propensity
+        if p > 0.85, case .drowsy = newState { newState = .asleep(at: now) }
+        if p < 0.25, case .drowsy = newState { newState = .awake }
+
+        let stateRaw: Int32
+        switch newState {
+        case .awake:            stateRaw = 0; snap.stateSince = 0
+        case .drowsy(let d):    stateRaw = 1; snap.stateSince = d.timeIntervalSince1970
+        case .asleep(let a):    stateRaw = 2; snap.stateSince = a.timeIntervalSince1970
+        }
+        snap.t = t
+        snap.propensity = p
+        snap.state = stateRaw
+        snap.ticks &+= 1
+
+        // Log one row per tick (hr is Optional by design)
+        logLock.withLock {
+            logger.append(
+                hr: snap.bpm.isNaN ? nil : snap.bpm,
+                still: stillMean,
+                drop: drop,
+                slope: slope,
+                propensity: p,
+                stateRaw: Int(stateRaw),
+                at: t
+            )
+        }
+
+        // Confirmed-asleep handling: publish the onset and stop evaluating
+        // until the main actor restarts us.
+        if stateRaw == 2 {
+            asleepStableTicks += 1
+            if asleepStableTicks >= asleepConfirmTicks {
+                snap.onset = t
+                halted = true
+            }
+        } else {
+            asleepStableTicks = 0
+        }
+
+        // Duty pacing: the next evaluation from propensity and its variance
+        let dcState: dc_state_t = stateRaw == 1 ? DC_DROWSY : (stateRaw == 2 ? DC_ASLEEP : DC_AWAKE)
+        nextEval = t + dc_sched_next(&sched, t, p, ekf.variance, dcState)
+        let gap = lastEval.map { t - $0 } ?? 0
+        lastEval = t
+        logLock.withLock { dc_account_eval(&account, gap, sched.pol.sensorLead, sched.fast) }
+    }
+}
@@ -0,0 +1,773 @@
+//
+//  dsp_bench.cpp
+//  SleepTrigger Tools
+//
+//  Per-kernel microbenchmarks for the watch DSP core. Each case streams a
+//  synthetic night through one primitive and reports ns/sample, samples/sec
+//  and (when the kernel allows it) cycles, instructions and cache misses.
+//
+//    dsp_bench [--samples N] [--reps R] [--filter substr] [--json]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "perf_counters.hpp"
+
+extern "C" {
+#include "robust_stats.h"
+#include "signal_filter.h"
+#include "respiration.h"
+#include "spectral.h"
+#include "ring_buffer.h"
+#include "asm_compat.h"
+#include "simple_sleep.h"
+#include "kalman.h"
+#include "filter_bank.h"
+#include "vec_kernels.h"
+#include "ringlog.h"
+#include "export_stream.h"
+#include "nightlog.h"
+#include "sample_queue.h"
+#include "tinyml_motion.h"
+#include "window_features.h"
+}
+#include "ekf.hpp"
+#include "hmm.hpp"
+#include "sleep_pipeline.hpp"
+#include "ring.hpp"
+#include "decimate.hpp"
+#include "sos.hpp"
+
+namespace {
+
+std::string benchTmpPath(const char* tag) {
+  const char* dir = std::getenv("TMPDIR");
+  return std::string(dir && *dir ? dir : "/tmp") + "/st_bench_" + tag + ".bin";
+}
+
+struct Inputs {
+  std::vector<double> hr;      // bpm, 1 Hz, with dropouts/spikes
+  std::vector<double> still;   // 0..1 stillness
+  std::vector<double> t;       // seconds
+  std::vector<float>  hrf;     // float copy for float kernels
+  std::vector<int>    obs;     // 0/1/2 FSM observations
+};
+
+// Encode the bench rows into $TMPDIR/st_bench_nlog.bin; returns the file size.
+double writeBenchNightLog(const Inputs& in, size_t n) {
+  std::string path = benchTmpPath("nlog");
+  std::remove(path.c_str());
+  nlog_writer_t w;
+  if (nlog_writer_open(&w, path.c_str(), 0) != 0) return 0.0;
+  rlog_rec_t recs[256];
+  for (size_t i = 0; i < n;) {
+    size_t k = 0;
+    for (; k < 256 && i < n; ++k, ++i)
+      recs[k] = rlog_rec_t{in.t[i], in.hrf[i], (float)in.still[i], 0.5f, (uint8_t)in.obs[i]};
+    nlog_append(&w, recs, k);
+  }
+  nlog_writer_flush(&w);
+  double bytes = (double)w.bytes;
+  close(w.fd);                         // skip the fsync in nlog_writer_close
+  w.fd = -1;
+  nlog_writer_close(&w);
+  return bytes;
+}
+
+// Deterministic xorshift so runs are comparable across machines.
+struct Rng {
+  uint64_t s{0x9E3779B97F4A7C15ull};
+  double uniform() {
+    s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+    return (double)(s >> 11) * (1.0 / 9007199254740992.0);
+  }
+};
+
+Inputs makeInputs(size_t n) {
+  Inputs in;
+  in.hr.resize(n); in.still.resize(n); in.t.resize(n); in.hrf.resize(n); in.obs.resize(n);
+  Rng rng;
+  for (size_t i = 0; i < n; ++i) {
+    double t = (double)i;
+    double settle = 1.0 - std::exp(-t / 1800.0);              // ~30 min wind-down
+    double hr = 72.0 - 14.0 * settle + 2.0 * std::sin(2.0 * M_PI * 0.25 * t)
+              + (rng.uniform() - 0.5) * 3.0;
+    if (rng.uniform() < 0.01) hr += 40.0;                       // optical spikes
+    double still = std::min(1.0, settle + (rng.uniform() - 0.5) * 0.1);
+    in.t[i] = t;
+    in.hr[i] = hr;
+    in.hrf[i] = (float)hr;
+    in.still[i] = std::max(0.0, still);
+    in.obs[i] = still > 0.85 ? 2 : (still > 0.6 ? 1 : 0);
+  }
+  return in;
+}
+
+// A case runs `n` samples and returns a checksum so nothing is optimised away.
+struct Case {
+  std::string name;
+  std::function<double(const Inputs&, size_t n)> run;
+};
+
+std::vector<Case> makeCases() {
+  std::vector<Case> cs;
+
+  cs.push_back({"rs_hampel_update/w9", [](const Inputs& in, size_t n) {
+    rs_hampel_t h; rs_hampel_init(&h, 9, 3.0);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += rs_hampel_update(&h, in.hr[i]);
+    return acc;
+  }});
+
+  for (int w : {61, 301, 1023, 4095}) {
+    cs.push_back({"rs_hampelw_update/w" + std::to_string(w), [w](const Inputs& in, size_t n) {
+      rs_hampelw_t h; rs_hampelw_init(&h, w, 3.0);
+      double acc = 0;
+      for (size_t i = 0; i < n; ++i) acc += rs_hampelw_update(&h, in.hr[i]);
+      rs_hampelw_free(&h);
+      return acc;
+    }});
+  }
+
+  cs.push_back({"iir1_update", [](const Inputs& in, size_t n) {
+    iir1_t f; iir1_init(&f, 0.22f);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += iir1_update(&f, in.hrf[i]);
+    return acc;
+  }});
+
+  cs.push_back({"resp_update", [](const Inputs& in, size_t n) {
+    resp_bpf_t f; resp_init(&f, 10.0, 0.1, 0.5);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += resp_update(&f, in.still[i], in.t[i] * 0.1);
+    return acc;
+  }});
+
+  cs.push_back({"goertzel_push+power/N32", [](const Inputs& in, size_t n) {
+    goertzel_t g; goertzel_init(&g, 1.0, 0.20, 32);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+      goertzel_push(&g, in.still[i]);
+      if ((i & 31) == 31) acc += goertzel_power(&g);
+    }
+    return acc;
+  }});
+
+  cs.push_back({"sdft_push/N32-K3+read", [](const Inputs& in, size_t n) {
+    sdft_bank_t s; sdft_init(&s, 1.0, 32, 1200);
+    int b = sdft_add_bin(&s, 0.2); sdft_add_bin(&s, 0.03); sdft_add_bin(&s, 0.4);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+      sdft_push(&s, in.still[i]);
+      acc += sdft_bin_power(&s, b);   // read every tick, as SleepMonitor does
+    }
+    return acc;
+  }});
+
+  cs.push_back({"ringf_push/cap64", [](const Inputs& in, size_t n) {
+    ringf_t r; ringf_init(&r, 64);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) ringf_push(&r, in.hrf[i]);
+    acc = ringf_mean(&r);
+    ringf_free(&r);
+    return acc;
+  }});
+
+  cs.push_back({"st::Ring<float,64>::push", [](const Inputs& in, size_t n) {
+    st::Ring<float, 64> r;
+    for (size_t i = 0; i < n; ++i) r.push(in.hrf[i]);
+    return r.mean();
+  }});
+  // Every windowed feature every tick: mean, variance, min, max, dot.
+  cs.push_back({"st::Ring<float,64> push+stats", [](const Inputs& in, size_t n) {
+    st::Ring<float, 64> r;
+    float w[64];
+    for (int k = 0; k < 64; ++k) w[k] = (float)k / 64.0f;
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+      r.push(in.hrf[i]);
+      acc += r.mean() + r.variance() + r.min() + r.max();
+      if (r.full()) acc += st::dot(r, w);
+    }
+    return acc;
+  }});
+
+  // Hand-off cost per sample, single thread: push, drain in batches of 32.
+  cs.push_back({"sq_push+pop_batch/32", [](const Inputs& in, size_t n) {
+    sq_queue_t* q = sq_queue_create(256);
+    sq_sample_t out[32];
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+      sq_sample_t s{in.t[i], (double)in.hrf[i], SQ_HEART_RATE, 0};
+      sq_push(q, &s);
+      if ((i & 31) == 31) {
+        const size_t got = sq_pop_batch(q, out, 32);
+        for (size_t k = 0; k < got; ++k) acc += out[k].value;
+      }
+    }
+    sq_queue_destroy(q);
+    return acc;
+  }});
+
+  // Motion stream per 20 Hz input sample: respiration, Goertzel and 5 s
+  // stillness variance at full rate, then behind CIC x5 + polyphase FIR x2.
+  cs.push_back({"motion chain/full-rate", [](const Inputs& in, size_t n) {
+    resp_bpf_t r; resp_init(&r, 20.0, 0.1, 0.5);
+    goertzel_t g; goertzel_init(&g, 20.0, 0.25, 320);
+    std::vector<double> w; w.reserve(100);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+      goertzel_push(&g, resp_update(&r, in.still[i], in.t[i] * 0.05));
+      if (i % 320 == 319) acc += goertzel_power(&g);
+      w.push_back(in.still[i]);
+      if (w.size() == 100) {
+        double m = 0, v = 0;
+        for (double x : w) m += x;
+        m /= 100;
+        for (double x : w) v += (x - m) * (x - m);
+        acc += v / 100 + resp_rate_bpm(&r);
+        w.clear();
+      }
+    }
+    return acc;
+  }});
+
+  cs.push_back({"st::MotionFrontEnd<5,3,2,31>", [](const Inputs& in, size_t n) {
+    st::MotionFrontEnd<> fe;
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+      fe.push(in.still[i], in.t[i] * 0.05);
+      if (fe.windowReady()) acc += fe.windowVariance() + fe.respirationBPM() + fe.goertzelPower();
+    }
+    return acc;
+  }});
+
+  // Block variants: same work, one call per 256-sample block.
+  const size_t kBlock = 256;
+  cs.push_back({"rs_hampel_process_block/w9", [kBlock](const Inputs& in, size_t n) {
+    rs_hampel_t h; rs_hampel_init(&h, 9, 3.0);
+    std::vector<double> out(kBlock);
+    double acc = 0;
+    for (size_t i = 0; i < n; i += kBlock) {
+      size_t m = std::min(kBlock, n - i);
+      rs_hampel_process_block(&h, in.hr.data() + i, out.data(), m);
+      acc += out[0];
+    }
+    return acc;
+  }});
+  cs.push_back({"iir1_process_block", [kBlock](const Inputs& in, size_t n) {
+    iir1_t f; iir1_init(&f, 0.22f);
+    std::vector<float> out(kBlock);
+    double acc = 0;
+    for (size_t i = 0; i < n; i += kBlock) {
+      size_t m = std::min(kBlock, n - i);
+      iir1_process_block(&f, in.hrf.data() + i, out.data(), m);
+      acc += out[m - 1];
+    }
+    return acc;
+  }});
+  cs.push_back({"resp_process_block", [kBlock](const Inputs& in, size_t n) {
+    resp_bpf_t f; resp_init(&f, 10.0, 0.1, 0.5);
+    std::vector<double> out(kBlock);
+    double acc = 0;
+    for (size_t i = 0; i < n; i += kBlock) {
+      size_t m = std::min(kBlock, n - i);
+      resp_process_block(&f, in.still.data() + i, in.t.data() + i, out.data(), m);
+      acc += out[m - 1];
+    }
+    return acc;
+  }});
+  // Steeper respiration band (4th / 8th order) at the cost of one biquad.
+  cs.push_back({"st::SOSCascade<2,float>::push", [](const Inputs& in, size_t n) {
+    st::SOSCascade<2, float> c(st::kRespBand2Hz);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += c.push((float)in.still[i]);
+    return acc;
+  }});
+  cs.push_back({"st::SOSCascade<2,float>::process", [kBlock](const Inputs& in, size_t n) {
+    st::SOSCascade<2, float> c(st::kRespBand2Hz);
+    std::vector<float> out(kBlock);
+    double acc = 0;
+    for (size_t i = 0; i < n; i += kBlock) {
+      size_t m = std::min(kBlock, n - i);
+      c.process(in.hrf.data() + i, out.data(), m);
+      acc += out[m - 1];
+    }
+    return acc;
+  }});
+  cs.push_back({"st::SOSCascade<4,double>::process", [kBlock](const Inputs& in, size_t n) {
+    constexpr auto kBand = st::sos::bandPass<4>(st::Family::Butterworth, 0.1, 0.5, 2.0);
+    st::SOSCascade<4, double> c(kBand);
+    std::vector<double> out(kBlock);
+    double acc = 0;
+    for (size_t i = 0; i < n; i += kBlock) {
+      size_t m = std::min(kBlock, n - i);
+      c.process(in.still.data() + i, out.data(), m);
+      acc += out[m - 1];
+    }
+    return acc;
+  }});
+  // The window part of a tick on its own.
+  cs.push_back({"tm_window_features", [](const Inputs& in, size_t n) {
+    tm_window_t w; tm_window_reset(&w);
+    float f[TM_FEATURES];
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+      tm_window_push(&w, in.still[i], in.hr[i]);
+      if (tm_window_features(&w, f) == 0) acc += f[1];
+    }
+    return acc;
+  }});
+  // Per sample = one evaluation tick: window update, features, inference.
+  cs.push_back({"tm_classifier_push/int8", [](const Inputs& in, size_t n) {
+    tm_classifier_t c; tm_classifier_init(&c, nullptr, 0);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += tm_classifier_push(&c, in.still[i], in.hr[i]);
+    return acc;
+  }});
+  cs.push_back({"tm_classifier_push_ref/float", [](const Inputs& in, size_t n) {
+    tm_classifier_t c; tm_classifier_init(&c, nullptr, 0);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += tm_classifier_push_ref(&c, in.still[i], in.hr[i]);
+    return acc;
+  }});
+  cs.push_back({"goertzel_push_block", [kBlock](const Inputs& in, size_t n) {
+    goertzel_t g; goertzel_init(&g, 1.0, 0.20, 32);
+    double acc = 0;
+    for (size_t i = 0; i < n; i += kBlock) {
+      goertzel_push_block(&g, in.still.data() + i, std::min(kBlock, n - i));
+      acc += goertzel_power(&g);
+    }
+    return acc;
+  }});
+  cs.push_back({"ringf_push_block/cap64", [kBlock](const Inputs& in, size_t n) {
+    ringf_t r; ringf_init(&r, 64);
+    for (size_t i = 0; i < n; i += kBlock)
+      ringf_push_block(&r, in.hrf.data() + i, std::min(kBlock, n - i));
+    double acc = ringf_mean(&r);
+    ringf_free(&r);
+    return acc;
+  }});
+  cs.push_back({"kalman1d_process_block", [kBlock](const Inputs& in, size_t n) {
+    Kalman1D kf; kalman1d_init(&kf, 0.02, 1.2, 65.0, 1.0);
+    std::vector<double> out(kBlock);
+    double acc = 0;
+    for (size_t i = 0; i < n; i += kBlock) {
+      size_t m = std::min(kBlock, n - i);
+      kalman1d_process_block(&kf, in.hr.data() + i, out.data(), m);
+      acc += out[m - 1];
+    }
+    return acc;
+  }});
+
+  // Filter banks: 10k channels; a "sample" is one channel-sample.
+  const size_t kChannels = 10000;
+  cs.push_back({"iir1_update/10k-channels", [kChannels](const Inputs& in, size_t n) {
+    std::vector<iir1_t> fs(kChannels);
+    for (auto& f : fs) iir1_init(&f, 0.22f);
+    double acc = 0;
+    size_t frames = n / kChannels;
+    for (size_t t = 0; t < frames; ++t)
+      for (size_t c = 0; c < kChannels; ++c) acc += iir1_update(&fs[c], in.hrf[t + (c & 1023)]);
+    return acc;
+  }});
+  cs.push_back({"fb_iir1_process/10k-channels", [kChannels](const Inputs& in, size_t n) {
+    fb_iir1_t b; fb_iir1_init(&b, kChannels, 0.22f);
+    const size_t block = 16;
+    std::vector<float> x(block * kChannels), y(block * kChannels);
+    for (size_t i = 0; i < x.size(); ++i) x[i] = in.hrf[i % in.hrf.size()];
+    double acc = 0;
+    for (size_t done = 0; done + block * kChannels <= n; done += block * kChannels) {
+      fb_iir1_process(&b, x.data(), y.data(), block);
+      acc += y[0];
+    }
+    fb_iir1_free(&b);
+    return acc;
+  }});
+  cs.push_back({"fb_biquad_process/10k-channels", [kChannels](const Inputs& in, size_t n) {
+    fb_biquad_t b; fb_biquad_init(&b, kChannels);
+    resp_bpf_t proto; resp_init(&proto, 10.0, 0.1, 0.5);
+    for (size_t c = 0; c < kChannels; ++c) fb_biquad_set_from_resp(&b, c, &proto);
+    const size_t block = 16;
+    std::vector<float> x(block * kChannels), y(block * kChannels);
+    for (size_t i = 0; i < x.size(); ++i) x[i] = in.hrf[i % in.hrf.size()];
+    double acc = 0;
+    for (size_t done = 0; done + block * kChannels <= n; done += block * kChannels) {
+      fb_biquad_process(&b, x.data(), y.data(), block);
+      acc += y[0];
+    }
+    fb_biquad_free(&b);
+    return acc;
+  }});
+
+  cs.push_back({"kalman1d_update", [](const Inputs& in, size_t n) {
+    Kalman1D kf; kalman1d_init(&kf, 0.02, 1.2, 65.0, 1.0);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += kalman1d_update(&kf, in.hr[i]);
+    return acc;
+  }});
+
+  cs.push_back({"st::KF1::update", [](const Inputs& in, size_t n) {
+    st::KF1 kf; kf.set(0.01, 0.10, 0.0, 1.0);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += kf.update(in.still[i]);
+    return acc;
+  }});
+
+  cs.push_back({"st::fuseFeatures+KF1", [](const Inputs& in, size_t n) {
+    st::KF1 kf; kf.set(0.01, 0.10, 0.0, 1.0);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+      double z = st::fuseFeatures(0.12, in.still[i], 0.3, 0.6, 0.2);
+      acc += kf.update(z);
+    }
+    return acc;
+  }});
+
+  cs.push_back({"st::PropensityKF::update", [](const Inputs& in, size_t n) {
+    st::PropensityKF kf; kf.set(0.01, 0.10, 0.0, 1.0);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += kf.update(0.12, in.still[i], 0.3, 0.6, 0.2);
+    return acc;
+  }});
+
+  // HR level/slope/drop per sample: windowed rescans vs the Kalman trend.
+  cs.push_back({"st::HRTrend ingest+features", [](const Inputs& in, size_t n) {
+    st::HRTrend tr;
+    double acc = 0, d = 0, s = 0;
+    for (size_t i = 0; i < n; ++i) {
+      tr.ingest(in.hr[i], in.t[i]);
+      tr.dropFraction(d); tr.slopeBPMPerSec(s);
+      acc += d + s;
+    }
+    return acc;
+  }});
+  cs.push_back({"st::HRTrendKF ingest+features", [](const Inputs& in, size_t n) {
+    st::HRTrendKF tr;
+    double acc = 0, d = 0, s = 0;
+    for (size_t i = 0; i < n; ++i) {
+      tr.ingest(in.hr[i], in.t[i]);
+      tr.dropFraction(d); tr.slopeBPMPerSec(s);
+      acc += d + s;
+    }
+    return acc;
+  }});
+
+  cs.push_back({"st::HMM3::step", [](const Inputs& in, size_t n) {
+    st::HMM3 hmm; hmm.setDefault();
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += hmm.step(in.obs[i]);
+    return acc;
+  }});
+  cs.push_back({"st::HMM<3,3>::step", [](const Inputs& in, size_t n) {
+    st::HMM<3, 3> hmm(st::kSleepHMM3Tables);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += hmm.step(in.obs[i]);
+    return acc;
+  }});
+  cs.push_back({"st::FixedLagViterbi<3,3,16>", [](const Inputs& in, size_t n) {
+    st::FixedLagViterbi<3, 3, 16> v(st::kSleepHMM3Tables);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += v.step(in.obs[i]);
+    return acc;
+  }});
+  // A wider model (8 states, 3 symbols) to show how the step scales with N.
+  cs.push_back({"st::FixedLagViterbi<8,3,16>", [](const Inputs& in, size_t n) {
+    st::HMMModel<8, 3> m{};
+    for (int i = 0; i < 8; ++i) {
+      m.pi[i] = 1.0 / 8;
+      for (int j = 0; j < 8; ++j) m.A[i * 8 + j] = i == j ? 0.79 : 0.03;
+      for (int o = 0; o < 3; ++o) m.E[o * 8 + i] = o == i * 3 / 8 ? 0.8 : 0.1;
+    }
+    st::FixedLagViterbi<8, 3, 16> v;
+    v.setModel(m);
+    double acc = 0;
+    for (size_t i = 0; i < n; ++i) acc += v.step(in.obs[i]);
+    return acc;
+  }});
+
+  // RingLogger rows into the mmap ring (file in $TMPDIR, default sync policy).
+  cs.push_back({"rlog_write/cap4096", [](const Inputs& in, size_t n) {
+    std::string path = benchTmpPath("rlog");
+    rlog_t r;
+    if (rlog_open(&r, path.c_str(), 4096) != 0) return 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      rlog_rec_t rec{in.t[i], in.hrf[i], (float)in.still[i], 0.5f, (uint8_t)in.obs[i]};
+      rlog_write(&r, &rec);
+    }
+    double acc = (double)rlog_count(&r);
+    rlog_close(&r);
+    std::remove(path.c_str());
+    return acc;
+  }});
+
+  // One rlog-style CSV row per sample (t,hr,still,prop,state, ~40 bytes)
+  // through the streaming exporter into a page-cache file.
+  cs.push_back({"es_csv_row/5col", [](const Inputs& in, size_t n) {
+    static const uint8_t dec[5] = {3, 2, 4, 4, 0};
+    std::string path = benchTmpPath("export");
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    es_writer_t w;
+    if (fd < 0 || es_open_fd(&w, fd, 0) != 0) return 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      const double row[5] = {in.t[i], in.hrf[i], in.still[i], 0.5, (double)in.obs[i]};
+      es_csv_row_f64(&w, row, dec, 5);
+    }
+    es_flush(&w);
+    double acc = (double)w.bytes;
+    es_close(&w);
+    close(fd);
+    std::remove(path.c_str());
+    return acc;
+  }});
+
+  // Night-log archive of the same rows: encode (block writes into the page
+  // cache), then a full decode of that file. Per sample = one record.
+  cs.push_back({"nlog_encode", [](const Inputs& in, size_t n) {
+    return writeBenchNightLog(in, n);
+  }});
+  cs.push_back({"nlog_decode", [](const Inputs& in, size_t n) {
+    std::string path = benchTmpPath("nlog");
+    nlog_reader_t rd;
+    if (nlog_reader_open(&rd, path.c_str()) != 0 || rd.records != n) {
+      nlog_reader_close(&rd);          // run alone: build the file first
+      writeBenchNightLog(in, n);
+      if (nlog_reader_open(&rd, path.c_str()) != 0) return 0.0;
+    }
+    std::vector<rlog_rec_t> out(n);
+    size_t got = nlog_read_range(&rd, -INFINITY, INFINITY, out.data(), n);
+    double acc = got ? out[got - 1].t + out[got / 2].hr : 0.0;
+    nlog_reader_close(&rd);
+    return acc;
+  }});
+
+  // Per "sample" = one element of a 64-wide window dot product.
+  cs.push_back({"dot_f32_accel/len64", [](const Inputs& in, size_t n) {
+    const size_t len = 64;
+    double acc = 0;
+    for (size_t i = 0; i + len <= n; i += len)
+      acc += dot_f32_accel(in.hrf.data() + i, in.hrf.data() + i, len);
+    return acc;
+  }});
+
+  // Each vector-kernel path the CPU supports, on 1024-element vectors.
+  for (vk_isa_t isa : {VK_ISA_SCALAR, VK_ISA_NEON, VK_ISA_SSE42, VK_ISA_AVX2, VK_ISA_AVX512}) {
+    vk_isa_t prev = vk_active_isa();
+    bool ok = vk_select_isa(isa) == 0;
+    vk_select_isa(prev);
+    if (!ok) continue;
+    std::string tag = std::string("/") + vk_isa_name(isa);
+    cs.push_back({"vk_dot_f32/len1024" + tag, [isa](const Inputs& in, size_t n) {
+      vk_isa_t prev = vk_active_isa(); vk_select_isa(isa);
+      double acc = 0;
+      for (size_t i = 0; i + 1024 <= n; i += 1024)
+        acc += vk_dot_f32(in.hrf.data() + i, in.hrf.data() + i, 1024);
+      vk_select_isa(prev);
+      return acc;
+    }});
+    // Per sample = one 16x16 int8 GEMV (a motion MLP hidden layer).
+    cs.push_back({"vk_gemv_s8/16x16" + tag, [isa](const Inputs& in, size_t n) {
+      vk_isa_t prev = vk_active_isa(); vk_select_isa(isa);
+      int8_t W[16 * 16];
+      for (int k = 0; k < 16 * 16; ++k) W[k] = (int8_t)(k * 37 % 255 - 127);
+      std::vector<int8_t> x(n + 16, 0);
+      for (size_t i = 0; i < n; ++i) x[i] = std::isnan(in.hr[i]) ? 0 : (int8_t)std::clamp((int)in.hr[i] - 64, -127, 127);
+      int32_t y[16];
+      double acc = 0;
+      for (size_t i = 0; i < n; ++i) {
+        vk_gemv_s8(W, 16, x.data() + i, 16, 16, y);
+        acc += y[i & 15];
+      }
+      vk_select_isa(prev);
+      return acc;
+    }});
+    cs.push_back({"vk_minmax_f32/len1024" + tag, [isa](const Inputs& in, size_t n) {
+      vk_isa_t prev = vk_active_isa(); vk_select_isa(isa);
+      double acc = 0;
+      for (size_t i = 0; i + 1024 <= n; i += 1024) {
+        float lo, hi; vk_minmax_f32(in.hrf.data() + i, 1024, &lo, &hi); acc += hi - lo;
+      }
+      vk_select_isa(prev);
+      return acc;
+    }});
+  }
+
+  // Per "sample" = one element of a sliding 60-sample window, hop 1.
+  cs.push_back({"ss_stats/win60", [](const Inputs& in, size_t n) {
+    const int w = 60;
+    double acc = 0;
+    for (size_t i = 0; i + w <= n; ++i) acc += ss_stats(in.hr.data() + i, w).rmssd;
+    return acc;
+  }});
+
+  cs.push_back({"ss_sleep_score/win60", [](const Inputs& in, size_t n) {
+    const int w = 60;
+    double acc = 0;
+    for (size_t i = 0; i + w <= n; ++i) acc += ss_sleep_score(in.hr.data() + i, w);
+    return acc;
+  }});
+
+  cs.push_back({"wf_compute/win60+mad", [](const Inputs& in, size_t n) {
+    const int w = 60;
+    double acc = 0;
+    wf_features_t f;
+    for (size_t i = 0; i + w <= n; ++i) { wf_compute(nullptr, in.hr.data() + i, w, WF_MAD, &f); acc += f.mad; }
+    return acc;
+  }});
+
+  cs.push_back({"wf_compute/win64+bands", [](const Inputs& in, size_t n) {
+    const int w = 64;
+    const double lo[2] = {0.1, 0.45}, hi[2] = {0.15, 0.5};
+    wf_plan_t p;
+    wf_plan_init(&p, w, 2.0, lo, hi, 2, 70.0);
+    double acc = 0;
+    wf_features_t f;
+    for (size_t i = 0; i + w <= n; ++i) { wf_compute(&p, in.hr.data() + i, w, 0, &f); acc += f.band[0]; }
+    return acc;
+  }});
+
+  // Per sample: one push and a feature read, same window as above.
+  cs.push_back({"wf_stream_push/N64+bands", [](const Inputs& in, size_t n) {
+    const double lo[2] = {0.1, 0.45}, hi[2] = {0.15, 0.5};
+    wf_plan_t p;
+    wf_plan_init(&p, 64, 2.0, lo, hi, 2, 70.0);
+    static wf_stream_t s;
+    wf_stream_init(&s, &p, 0);
+    double acc = 0;
+    wf_features_t f;
+    for (size_t i = 0; i < n; ++i) {
+      wf_stream_push(&s, in.hr[i]);
+      wf_stream_features(&s, 0, &f);
+      acc += f.band[0] + f.var;
+    }
+    return acc;
+  }});
+
+  return cs;
+}
+
+struct Result {
+  std::string name;
+  size_t samples{0};
+  double bestNs{0}, medianNs{0};
+  double checksum{0};
+  stbench::CounterSample counters;
+};
+
+void printJsonString(const std::string& s) {
+  std::putchar('"');
+  for (char c : s) { if (c == '"' || c == '\\') std::putchar('\\'); std::putchar(c); }
+  std::putchar('"');
+}
+
+void printJson(const std::vector<Result>& rs, size_t reps) {
+  std::printf("{\n  \"version\": 1,\n  \"reps\": %zu,\n  \"results\": [\n", reps);
+  for (size_t i = 0; i < rs.size(); ++i) {
+    const Result& r = rs[i];
+    double ns = r.bestNs / (double)r.samples;
+    std::printf("    {\"name\": ");
+    printJsonString(r.name);
+    std::printf(", \"samples\": %zu, \"ns_per_sample\": %.4f, \"median_ns_per_sample\": %.4f"
+                ", \"samples_per_sec\": %.1f",
+                r.samples, ns, r.medianNs / (double)r.samples, ns > 0 ? 1e9 / ns : 0.0);
+    if (r.counters.valid) {
+      std::printf(", \"cycles\": %llu, \"instructions\": %llu, \"cache_misses\": %llu",
+                  (unsigned long long)r.counters.cycles,
+                  (unsigned long long)r.counters.instructions,
+                  (unsigned long long)r.counters.cacheMisses);
+    } else {
+      std::printf(", \"cycles\": null, \"instructions\": null, \"cache_misses\": null");
+    }
+    std::printf(", \"checksum\": %.6g}%s\n", r.checksum, (i + 1 < rs.size()) ? "," : "");
+  }
+  std::printf("  ]\n}\n");
+}
+
+void printTable(const std::vector<Result>& rs) {
+  std::printf("%-28s %12s %14s %10s %8s %12s\n",
+              "kernel", "ns/sample", "samples/sec", "cyc/smp", "IPC", "miss/ksmp");
+  for (const Result& r : rs) {
+    double ns = r.bestNs / (double)r.samples;
+    std::printf("%-28s %12.3f %14.0f", r.name.c_str(), ns, ns > 0 ? 1e9 / ns : 0.0);
+    if (r.counters.valid && r.counters.cycles > 0) {
+      std::printf(" %10.2f %8.2f %12.3f\n",
+                  (double)r.counters.cycles / (double)r.samples,
+                  (double)r.counters.instructions / (double)r.counters.cycles,
+                  1000.0 * (double)r.counters.cacheMisses / (double)r.samples);
+    } else {
+      std::printf(" %10s %8s %12s\n", "-", "-", "-");
+    }
+  }
+}
+
+void usage() {
+  std::fprintf(stderr,
+    "usage: dsp_bench [--samples N] [--reps R] [--filter substr] [--json]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  size_t samples = 1u << 20;
+  size_t reps = 5;
+  bool json = false;
+  std::string filter;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--json") json = true;
+    else if (a == "--samples" && i + 1 < argc) samples = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--reps" && i + 1 < argc) reps = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--filter" && i + 1 < argc) filter = argv[++i];
+    else { usage(); return 2; }
+  }
+  if (samples < 64 || reps == 0) { usage(); return 2; }
+
+  const Inputs in = makeInputs(samples);
+  stbench::PerfCounters pc;
+  if (!pc.available() && !json)
+    std::fprintf(stderr, "note: perf_event_open unavailable, wall time only\n");
+
+  std::vector<Result> results;
+  for (const Case& c : makeCases()) {
+    if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+
+    c.run(in, std::min<size_t>(samples, 4096));  // warm caches and branch predictors
+
+    Result r;
+    r.name = c.name;
+    r.samples = samples;
+    std::vector<double> times;
+    double best = 1e300;
+    for (size_t k = 0; k < reps; ++k) {
+      pc.start();
+      auto t0 = std::chrono::steady_clock::now();
+      r.checksum = c.run(in, samples);
+      auto t1 = std::chrono::steady_clock::now();
+      stbench::CounterSample cs = pc.stop();
+      double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+      times.push_back(ns);
+      if (ns < best) { best = ns; r.counters = cs; }
+    }
+    std::sort(times.begin(), times.end());
+    r.bestNs = best;
+    r.medianNs = times[times.size() / 2];
+    results.push_back(r);
+  }
+
+  if (json) printJson(results, reps);
+  else      printTable(results);
+  return 0;
+}
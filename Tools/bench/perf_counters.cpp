@@ -0,0 +1,75 @@
+//
+//  perf_counters.cpp
+//  SleepTrigger Tools
+//
+
+#include "perf_counters.hpp"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace stbench {
+
+#if defined(__linux__)
+
+static int openCounter(uint32_t type, uint64_t config, int groupFd) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = (groupFd < 0) ? 1 : 0;   // leader starts disabled
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+PerfCounters::PerfCounters() {
+  fds_[0] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+  if (fds_[0] < 0) return;
+  fds_[1] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, fds_[0]);
+  fds_[2] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, fds_[0]);
+  if (fds_[1] < 0 || fds_[2] < 0) {
+    for (int& fd : fds_) { if (fd >= 0) close(fd); fd = -1; }
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : fds_) if (fd >= 0) close(fd);
+}
+
+void PerfCounters::start() {
+  if (!available()) return;
+  ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+CounterSample PerfCounters::stop() {
+  CounterSample s;
+  if (!available()) return s;
+  ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  uint64_t buf[4] = {0, 0, 0, 0}; // nr, cycles, instructions, misses
+  if (read(fds_[0], buf, sizeof(buf)) != (ssize_t)sizeof(buf) || buf[0] != 3) return s;
+  s.valid = true;
+  s.cycles = buf[1];
+  s.instructions = buf[2];
+  s.cacheMisses = buf[3];
+  return s;
+}
+
+#else
+
+PerfCounters::PerfCounters() {}
+PerfCounters::~PerfCounters() {}
+void PerfCounters::start() {}
+CounterSample PerfCounters::stop() { return {}; }
+
+#endif
+
+} // namespace stbench
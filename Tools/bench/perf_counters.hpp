@@ -0,0 +1,39 @@
+//
+//  perf_counters.hpp
+//  SleepTrigger Tools
+//
+
+#pragma once
+#include <cstdint>
+
+namespace stbench {
+
+// Hardware counters for one measured region. `valid` is false when the
+// kernel refuses perf_event_open (containers, perf_event_paranoid, macOS);
+// callers should then report wall time only.
+struct CounterSample {
+  bool     valid{false};
+  uint64_t cycles{0};
+  uint64_t instructions{0};
+  uint64_t cacheMisses{0};
+};
+
+// Thin RAII wrapper over a perf_event_open group (cycles leader +
+// instructions + cache misses), counting user space of this thread only.
+class PerfCounters {
+public:
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  bool available() const { return fds_[0] >= 0; }
+
+  void start();
+  CounterSample stop();
+
+private:
+  int fds_[3]{-1, -1, -1};
+};
+
+} // namespace stbench
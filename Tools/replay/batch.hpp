@@ -0,0 +1,60 @@
+//
+//  batch.hpp
+//  SleepTrigger Tools
+//
+//  Multi-night replay over a WorkStealingPool. Each night is loaded (or
+//  synthesised) and replayed by whichever worker picks it up; outcomes are
+//  stored by index, so everything except the timing column is identical for
+//  any thread count.
+//
+
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "night_io.hpp"
+#include "work_steal_pool.hpp"
+
+namespace stbench {
+
+// A night to replay: a CSV path, or a synthetic seed when path is empty.
+struct NightSource {
+  std::string path;
+  uint64_t    seed{0};
+  SynthParams synth{};
+};
+
+struct NightOutcome {
+  std::string     name;
+  bool            ok{false};
+  std::string     error;
+  double          labelOnset{NAN};
+  st::NightResult result{};
+  double          replaySec{0};   // pipeline time only, excludes loading
+};
+
+inline void runBatch(WorkStealingPool& pool, const std::vector<NightSource>& src,
+                     std::vector<NightOutcome>& out,
+                     const st::SleepPipelineConfig& cfg = {}) {
+  out.assign(src.size(), NightOutcome{});
+  pool.parallelFor(src.size(), [&](size_t i, unsigned) {
+    NightOutcome& o = out[i];
+    Night n;
+    if (src[i].path.empty()) {
+      n = synthNight(src[i].seed, src[i].synth);
+    } else if (!loadNightCSV(src[i].path, n, o.error)) {
+      o.name = src[i].path;
+      return;
+    }
+    o.name = n.name;
+    o.labelOnset = n.labelOnset;
+    st::SleepPipeline p(cfg);
+    auto t0 = std::chrono::steady_clock::now();
+    o.result = st::replayNight(p, n.events.data(), n.events.size());
+    o.replaySec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    o.ok = true;
+  });
+}
+
+} // namespace stbench
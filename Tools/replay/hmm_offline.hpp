@@ -0,0 +1,259 @@
+//
+//  hmm_offline.hpp
+//  SleepTrigger Tools
+//
+//  Whole-night HMM work that is too heavy for the watch: full-path Viterbi
+//  decoding with checkpointed backpointers, and Baum-Welch fitting of the
+//  st::HMM<N,M> matrices over an archive of nights.
+//
+//  The model convention is the online one (st::HMM::step): pi is the state
+//  distribution *before* the first observation, and every observation,
+//  including the first, is preceded by a transition.
+//
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "hmm.hpp"
+#include "night_io.hpp"
+#include "work_steal_pool.hpp"
+
+namespace stbench {
+
+// A night's HMM input (the SleepFSM state per tick), run-length coded: the
+// FSM holds a state for minutes at a time, so 100k nights fit in memory.
+struct ObsRuns {
+  std::vector<uint8_t>  sym;
+  std::vector<uint32_t> len;
+  size_t ticks{0};
+
+  void push(uint8_t s) {
+    if (!sym.empty() && sym.back() == s && len.back() != UINT32_MAX) ++len.back();
+    else { sym.push_back(s); len.push_back(1); }
+    ++ticks;
+  }
+  void expand(std::vector<uint8_t>& out) const {
+    out.clear();
+    out.reserve(ticks);
+    for (size_t r = 0; r < sym.size(); ++r) out.insert(out.end(), len[r], sym[r]);
+  }
+};
+
+// Front end + SleepFSM over the whole night. Like extractFeatures it does
+// not stop at onset; the FSM keeps reporting Asleep once it gets there.
+inline void extractObservations(const Night& n, const st::SleepPipelineConfig& cfg, ObsRuns& out,
+                                std::vector<double>* tickTimes = nullptr) {
+  out = ObsRuns{};
+  if (tickTimes) tickTimes->clear();
+  st::SleepFrontEnd fe(cfg);
+  st::SleepFSM fsm = cfg.fsm;
+  fsm.reset();
+  st::SleepFeatures f;
+  for (const auto& e : n.events) {
+    bool tick = e.kind == 0 ? fe.pushHR(e.t, e.value, f) : fe.pushStillness(e.t, e.value, f);
+    while (tick || fe.nextFrame(f)) {
+      tick = false;
+      out.push((uint8_t)fsm.ingest(f.drop, f.still, f.slope, f.t));
+      if (tickTimes) tickTimes->push_back(f.t);
+    }
+  }
+}
+
+// ---- Viterbi ----
+
+// Full-night MAP path in O(N·sqrt(T)) memory. A forward pass keeps logDelta
+// only at every K-th step (K = ceil(sqrt(T))); segments are then replayed
+// last to first from their checkpoint with backpointers for that segment
+// alone, and traced back into path[]. Replays are bit-identical to the
+// forward pass, so the result equals a traceback over all T backpointers.
+template <int N>
+struct ViterbiScratch {
+  std::vector<std::array<double, N>> checkpoints;
+  std::vector<uint8_t> psi;   // K x N
+};
+
+template <int N, int M>
+void viterbiCheckpointed(const st::HMMLogTables<N, M>& tables, const uint8_t* obs, size_t T,
+                         uint8_t* path, ViterbiScratch<N>& s) {
+  if (T == 0) return;
+  const size_t K = (size_t)std::ceil(std::sqrt((double)T));
+  const size_t segs = (T + K - 1) / K;
+  s.checkpoints.resize(segs);
+  s.psi.resize(K * N);
+
+  st::HMM<N, M> h(tables);
+  for (size_t g = 0; g < segs; ++g) {
+    s.checkpoints[g] = h.logDelta();
+    for (size_t t = g * K, e = std::min(T, t + K); t < e; ++t) h.step(obs[t]);
+  }
+  int state = h.best();
+  for (size_t g = segs; g-- > 0;) {
+    const size_t b = g * K, e = std::min(T, b + K);
+    h.setLogDelta(s.checkpoints[g]);
+    for (size_t t = b; t < e; ++t) h.step(obs[t], &s.psi[(t - b) * N]);
+    for (size_t t = e; t-- > b;) {
+      path[t] = (uint8_t)state;
+      state = s.psi[(t - b) * N + state];
+    }
+  }
+}
+
+// ---- Baum-Welch ----
+
+template <int N, int M>
+struct BaumWelchCounts {
+  std::array<double, N>     pi{};
+  std::array<double, N * N> A{};
+  std::array<double, M * N> E{};   // [obs*N + j], as HMMModel
+  double logLik{0};
+  size_t sequences{0};
+  size_t ticks{0};
+
+  void add(const BaumWelchCounts& o) {
+    for (int i = 0; i < N; ++i) pi[i] += o.pi[i];
+    for (int i = 0; i < N * N; ++i) A[i] += o.A[i];
+    for (int i = 0; i < M * N; ++i) E[i] += o.E[i];
+    logLik += o.logLik;
+    sequences += o.sequences;
+    ticks += o.ticks;
+  }
+};
+
+template <int N>
+struct ForwardBackwardScratch {
+  std::vector<std::array<double, N>> alpha;
+  std::vector<double> scale;
+};
+
+// Scaled forward-backward over one sequence; adds expected initial,
+// transition and emission counts (and log-likelihood) to `c`.
+template <int N, int M>
+void forwardBackward(const st::HMMModel<N, M>& m, const uint8_t* obs, size_t T,
+                     BaumWelchCounts<N, M>& c, ForwardBackwardScratch<N>& s) {
+  if (T == 0) return;
+  s.alpha.resize(T);
+  s.scale.resize(T);
+
+  const std::array<double, N>* prev = &m.pi;
+  for (size_t t = 0; t < T; ++t) {
+    std::array<double, N> a{};
+    for (int i = 0; i < N; ++i) {
+      const double pi = (*prev)[i];
+      for (int j = 0; j < N; ++j) a[j] += pi * m.A[i * N + j];
+    }
+    const double* e = &m.E[(size_t)obs[t] * N];
+    double sum = 0;
+    for (int j = 0; j < N; ++j) sum += (a[j] *= e[j]);
+    const double inv = sum > 0 ? 1.0 / sum : 0.0;
+    for (int j = 0; j < N; ++j) a[j] *= inv;
+    s.alpha[t] = a;
+    s.scale[t] = sum;
+    c.logLik += std::log(sum > 0 ? sum : 1e-300);
+    prev = &s.alpha[t];
+  }
+
+  std::array<double, N> beta;
+  beta.fill(1.0);
+  for (size_t t = T; t-- > 0;) {
+    const std::array<double, N>& ap = t ? s.alpha[t - 1] : m.pi;
+    const double* e = &m.E[(size_t)obs[t] * N];
+    const double inv = s.scale[t] > 0 ? 1.0 / s.scale[t] : 0.0;
+    std::array<double, N> eb;
+    for (int j = 0; j < N; ++j) {
+      eb[j] = e[j] * beta[j] * inv;
+      c.E[(size_t)obs[t] * N + j] += s.alpha[t][j] * beta[j];   // gamma_t
+    }
+    std::array<double, N> bp{};
+    for (int i = 0; i < N; ++i) {
+      double acc = 0;
+      for (int j = 0; j < N; ++j) {
+        const double x = m.A[i * N + j] * eb[j];
+        acc += x;
+        c.A[i * N + j] += ap[i] * x;                               // xi_t(i, j)
+      }
+      bp[i] = acc;
+    }
+    beta = bp;
+  }
+  for (int i = 0; i < N; ++i) c.pi[i] += m.pi[i] * beta[i];         // gamma_{-1}
+  c.sequences += 1;
+  c.ticks += T;
+}
+
+// Normalise counts into a model. `floor` keeps every probability strictly
+// positive so no transition or emission gets locked out for good.
+template <int N, int M>
+st::HMMModel<N, M> maximise(const BaumWelchCounts<N, M>& c, double floor) {
+  st::HMMModel<N, M> m;
+  auto norm = [floor](double* p, int n, int stride) {
+    double sum = 0;
+    for (int k = 0; k < n; ++k) sum += p[k * stride];
+    for (int k = 0; k < n; ++k) p[k * stride] = sum > 0 ? p[k * stride] / sum : 1.0 / n;
+    sum = 0;
+    for (int k = 0; k < n; ++k) sum += (p[k * stride] = std::max(p[k * stride], floor));
+    for (int k = 0; k < n; ++k) p[k * stride] /= sum;
+  };
+  m.pi = c.pi;
+  norm(m.pi.data(), N, 1);
+  m.A = c.A;
+  for (int i = 0; i < N; ++i) norm(&m.A[i * N], N, 1);
+  m.E = c.E;
+  for (int j = 0; j < N; ++j) norm(&m.E[j], M, N);   // each state's column over symbols
+  return m;
+}
+
+struct BaumWelchOptions {
+  int    maxIters{20};
+  double tol{1e-6};          // stop when mean log-likelihood per tick improves less
+  double floor{1e-4};
+  size_t chunk{64};          // sequences per accumulator
+};
+
+struct BaumWelchIteration {
+  double logLikPerTick;
+  double seconds;
+};
+
+// E-step in parallel over sequences. Counts go into one accumulator per
+// fixed chunk of sequences, filled in order and reduced in chunk order, so
+// the fitted model is identical for any worker count.
+template <int N, int M>
+st::HMMModel<N, M> baumWelch(WorkStealingPool& pool, const std::vector<ObsRuns>& seqs,
+                             st::HMMModel<N, M> model, const BaumWelchOptions& opt,
+                             std::vector<BaumWelchIteration>* history = nullptr) {
+  const size_t chunks = (seqs.size() + opt.chunk - 1) / opt.chunk;
+  std::vector<BaumWelchCounts<N, M>> acc(chunks);
+  struct Worker { ForwardBackwardScratch<N> fb; std::vector<uint8_t> obs; };
+  std::vector<Worker> workers(pool.size());
+
+  double prev = -INFINITY;
+  for (int it = 0; it < opt.maxIters; ++it) {
+    auto t0 = std::chrono::steady_clock::now();
+    pool.parallelFor(chunks, [&](size_t ch, unsigned w) {
+      BaumWelchCounts<N, M>& c = acc[ch];
+      c = BaumWelchCounts<N, M>{};
+      Worker& wk = workers[w];
+      for (size_t i = ch * opt.chunk, e = std::min(seqs.size(), i + opt.chunk); i < e; ++i) {
+        seqs[i].expand(wk.obs);
+        forwardBackward(model, wk.obs.data(), wk.obs.size(), c, wk.fb);
+      }
+    });
+    BaumWelchCounts<N, M> total;
+    for (const auto& c : acc) total.add(c);
+    model = maximise(total, opt.floor);
+
+    const double ll = total.ticks ? total.logLik / (double)total.ticks : 0.0;
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (history) history->push_back({ll, sec});
+    if (ll - prev < opt.tol) break;
+    prev = ll;
+  }
+  return model;
+}
+
+} // namespace stbench
@@ -0,0 +1,178 @@
+//
+//  night_io.hpp
+//  SleepTrigger Tools
+//
+//  Night files for offline replay, and deterministic synthetic-night and
+//  labelled-motion generators for tests, training and throughput runs.
+//
+//  CSV format, one sensor event per line, in time order:
+//    # label_onset=<seconds>        (optional ground-truth onset)
+//    t,kind,value                   (header, optional)
+//    12.0,hr,71.5
+//    15.0,still,0.533
+//
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "sleep_pipeline.hpp"
+
+namespace stbench {
+
+struct Night {
+  std::string name;
+  std::vector<st::SensorEvent> events;
+  double labelOnset{NAN};   // seconds, NaN if unlabelled
+};
+
+inline bool loadNightCSV(const std::string& path, Night& out, std::string& err) {
+  FILE* f = std::fopen(path.c_str(), "r");
+  if (!f) { err = path + ": cannot open"; return false; }
+  out = Night{};
+  out.name = path;
+  char line[256];
+  size_t lineNo = 0;
+  while (std::fgets(line, sizeof(line), f)) {
+    ++lineNo;
+    if (line[0] == '#') {
+      const char* p = std::strstr(line, "label_onset=");
+      if (p) out.labelOnset = std::strtod(p + 12, nullptr);
+      continue;
+    }
+    if (line[0] == '\n' || line[0] == '\r' || line[0] == 't') continue;   // blank / header
+    char* end = nullptr;
+    double t = std::strtod(line, &end);
+    if (end == line || *end != ',') { err = path + ":" + std::to_string(lineNo) + ": bad time"; std::fclose(f); return false; }
+    const char* kind = end + 1;
+    uint8_t k;
+    if (std::strncmp(kind, "hr,", 3) == 0)         { k = 0; kind += 3; }
+    else if (std::strncmp(kind, "still,", 6) == 0) { k = 1; kind += 6; }
+    else { err = path + ":" + std::to_string(lineNo) + ": unknown kind"; std::fclose(f); return false; }
+    double v = std::strtod(kind, nullptr);
+    out.events.push_back({t, v, k});
+  }
+  std::fclose(f);
+  return true;
+}
+
+inline bool saveNightCSV(const std::string& path, const Night& n) {
+  FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) return false;
+  if (!std::isnan(n.labelOnset)) std::fprintf(f, "# label_onset=%.3f\n", n.labelOnset);
+  std::fprintf(f, "t,kind,value\n");
+  for (const auto& e : n.events)
+    std::fprintf(f, "%.3f,%s,%.4f\n", e.t, e.kind == 0 ? "hr" : "still", e.value);
+  return std::fclose(f) == 0;
+}
+
+// splitmix64: cheap, seedable, identical on every platform.
+struct SplitMix {
+  uint64_t s;
+  explicit SplitMix(uint64_t seed) : s(seed) {}
+  uint64_t next() {
+    uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+  double uniform() { return (double)(next() >> 11) * (1.0 / 9007199254740992.0); }
+  double normal() {
+    double u1 = uniform() + 1e-12, u2 = uniform();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+  }
+};
+
+struct SynthParams {
+  double awakeMinutes{-1};    // < 0: random 15..60 min of restless wake
+  double hours{8.0};          // total recording length
+  double hrEverySec{-1};      // < 0: HR every 1..5 s (random per sample)
+};
+
+// Wake (restless, baseline HR) → settling (still, HR falling 24–32 % over
+// 6–10 min) → sleep. The decline has to outpace HRTrend's 5 min baseline
+// for the FSM's -12 % drop test to hold through minDrowsySeconds. Stillness is emitted every 5 s as k/15, like
+// DeviceMotionMonitor's 15-window hysteresis score. labelOnset is the end of
+// the HR decline.
+inline Night synthNight(uint64_t seed, const SynthParams& sp = {}) {
+  SplitMix rng(seed * 0x2545F4914F6CDD1Dull + 1);
+  Night n;
+  n.name = "synth-" + std::to_string(seed);
+  const double awake = (sp.awakeMinutes >= 0 ? sp.awakeMinutes : 15.0 + 45.0 * rng.uniform()) * 60.0;
+  const double settle = (6.0 + 4.0 * rng.uniform()) * 60.0;
+  const double base = 64.0 + 16.0 * rng.uniform();
+  const double dropFrac = 0.24 + 0.08 * rng.uniform();
+  const double end = sp.hours * 3600.0;
+  n.labelOnset = awake + settle;
+
+  auto hrAt = [&](double t) {
+    if (t < awake) return base;
+    double u = std::min(1.0, (t - awake) / settle);
+    return base * (1.0 - dropFrac * u);
+  };
+
+  double nextHR = 0, nextStill = 5.0;
+  int stillWindows = 0;          // of the last 15
+  while (true) {
+    bool hr = nextHR <= nextStill;
+    double t = hr ? nextHR : nextStill;
+    if (t > end) break;
+    if (hr) {
+      double v = hrAt(t) + 1.5 * rng.normal();
+      if (rng.uniform() < 0.01) v += 30.0 + 20.0 * rng.uniform();   // optical spike
+      n.events.push_back({t, v, 0});
+      nextHR += sp.hrEverySec > 0 ? sp.hrEverySec : 1.0 + std::floor(5.0 * rng.uniform());
+    } else {
+      double pStill = t < awake ? 0.45 : 0.97;
+      bool still = rng.uniform() < pStill;
+      stillWindows += still ? 1 : -1;
+      stillWindows = std::max(0, std::min(15, stillWindows));
+      n.events.push_back({t, (double)stillWindows / 15.0, 1});
+      nextStill += 5.0;
+    }
+  }
+  return n;
+}
+
+// Labelled motion ticks for st_motion_train and the classifier checks: one
+// per 2 s frame, in segments of 2-12 min that are each still, fidget or
+// active (tm_classifier classes 0 / 1 / 2). Stillness follows synthNight's
+// 15-window hysteresis score with P(still window) 0.97 / 0.75 / 0.40; HR
+// relaxes over about a minute to baseline + 0 / 4 / 15 bpm and jitters
+// more with activity.
+struct MotionTick { double still, hr; int label; };
+
+inline std::vector<MotionTick> synthMotionTicks(uint64_t seed, size_t ticks) {
+  static const double pStill[3] = {0.97, 0.75, 0.40};
+  static const double lift[3] = {0.0, 4.0, 15.0}, jitter[3] = {0.6, 1.4, 3.0};
+  SplitMix rng(seed * 0x9E3779B97F4A7C15ull + 7);
+  std::vector<MotionTick> out;
+  out.reserve(ticks);
+  const double base = 56.0 + 24.0 * rng.uniform();
+  double hr = base, t = 0, nextWindow = 5.0;
+  int stillWindows = (int)(16 * rng.uniform()), label = 0;
+  size_t segLeft = 0;
+  while (out.size() < ticks) {
+    if (segLeft == 0) {
+      label = (int)(3 * rng.uniform());
+      segLeft = (size_t)(60 + 300 * rng.uniform());
+    }
+    --segLeft;
+    t += 2.0;
+    for (; nextWindow <= t; nextWindow += 5.0) {
+      stillWindows += rng.uniform() < pStill[label] ? 1 : -1;
+      stillWindows = std::max(0, std::min(15, stillWindows));
+    }
+    hr += (base + lift[label] - hr) * (2.0 / 60.0) + 0.3 * jitter[label] * rng.normal();
+    out.push_back({(double)stillWindows / 15.0, hr + jitter[label] * rng.normal(), label});
+  }
+  return out;
+}
+
+} // namespace stbench
@@ -0,0 +1,190 @@
+//
+//  st_hmmfit.cpp
+//  SleepTrigger Tools
+//
+//  Fits the 3-state sleep HMM (HMM3::setDefault) to an archive of nights
+//  with Baum-Welch, and scores both the default and the fitted model by
+//  full-night Viterbi decoding against the labelled onsets.
+//
+//    st_hmmfit <dir|night.csv>... | --synth N [--seed S]
+//              [--iters N] [--tol T] [--floor P] [--jobs N] [--out model.txt]
+//
+//  Observations are the SleepFSM states of the default config, extracted
+//  once per night. The fitted model is printed as an st::HMMModel<3,3>
+//  initialiser (kSleepHMM3Model layout).
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "hmm_offline.hpp"
+#include "work_steal_pool.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Model = st::HMMModel<3, 3>;
+
+void addPath(const std::string& p, std::vector<std::string>& files) {
+  std::error_code ec;
+  if (!fs::is_directory(p, ec)) { files.push_back(p); return; }
+  std::vector<std::string> found;
+  for (const auto& e : fs::directory_iterator(p, ec))
+    if (e.is_regular_file() && e.path().extension() == ".csv") found.push_back(e.path().string());
+  std::sort(found.begin(), found.end());
+  files.insert(files.end(), found.begin(), found.end());
+}
+
+void usage() {
+  std::fprintf(stderr,
+    "usage: st_hmmfit <dir|night.csv>... | --synth N [--seed S]\n"
+    "                 [--iters N] [--tol T] [--floor P] [--jobs N] [--out model.txt]\n");
+}
+
+// Per night: what decoding needs besides the observations.
+struct NightMeta {
+  size_t labelTick{SIZE_MAX};   // first tick at/after the label, SIZE_MAX if none
+  double secPerTick{0};
+  std::string error;
+};
+
+struct DecodeScore {
+  size_t labelled{0}, detected{0};
+  double absErrSec{0};
+  double seconds{0};
+};
+
+// Viterbi-decode every night; onset = first tick whose MAP state is Asleep.
+DecodeScore score(stbench::WorkStealingPool& pool, const Model& m,
+                  const std::vector<stbench::ObsRuns>& seqs, const std::vector<NightMeta>& meta) {
+  const auto tables = st::HMMLogTables<3, 3>::from(m);
+  struct Worker { std::vector<uint8_t> obs, path; stbench::ViterbiScratch<3> vs; };
+  std::vector<Worker> workers(pool.size());
+  std::vector<size_t> onset(seqs.size(), SIZE_MAX);
+
+  auto t0 = std::chrono::steady_clock::now();
+  pool.parallelFor(seqs.size(), [&](size_t i, unsigned w) {
+    Worker& wk = workers[w];
+    seqs[i].expand(wk.obs);
+    wk.path.resize(wk.obs.size());
+    stbench::viterbiCheckpointed(tables, wk.obs.data(), wk.obs.size(), wk.path.data(), wk.vs);
+    auto it = std::find(wk.path.begin(), wk.path.end(), (uint8_t)st::SleepPhase::Asleep);
+    if (it != wk.path.end()) onset[i] = (size_t)(it - wk.path.begin());
+  }, 16);
+
+  DecodeScore s;
+  s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  for (size_t i = 0; i < seqs.size(); ++i) {
+    if (!meta[i].error.empty() || meta[i].labelTick == SIZE_MAX) continue;
+    ++s.labelled;
+    if (onset[i] == SIZE_MAX) continue;
+    ++s.detected;
+    const double d = (double)onset[i] - (double)meta[i].labelTick;
+    s.absErrSec += std::fabs(d) * meta[i].secPerTick;
+  }
+  return s;
+}
+
+void printScore(const char* name, const DecodeScore& s) {
+  std::fprintf(stderr, "%-8s decoded onset on %zu/%zu labelled nights, mean |onset - label| %.0f s (%.3f s)\n",
+               name, s.detected, s.labelled, s.detected ? s.absErrSec / (double)s.detected : NAN,
+               s.seconds);
+}
+
+void printModel(FILE* f, const Model& m) {
+  std::fprintf(f, "// st_hmmfit: st::HMMModel<3, 3>{pi, A (i -> j), E [obs*3 + state]}\n{\n");
+  std::fprintf(f, "  {%.6f, %.6f, %.6f},\n", m.pi[0], m.pi[1], m.pi[2]);
+  for (int r = 0; r < 2; ++r) {
+    const auto& M = r ? m.E : m.A;
+    std::fprintf(f, "  {");
+    for (int i = 0; i < 3; ++i)
+      std::fprintf(f, "%s%.6f, %.6f, %.6f", i ? ",\n   " : "", M[i * 3], M[i * 3 + 1], M[i * 3 + 2]);
+    std::fprintf(f, "}%s\n", r ? "" : ",");
+  }
+  std::fprintf(f, "}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> files;
+  std::string outPath;
+  unsigned jobs = 0;
+  size_t synth = 0;
+  uint64_t seed = 1;
+  stbench::BaumWelchOptions opt;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--jobs" && i + 1 < argc) jobs = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+    else if (a == "--out" && i + 1 < argc) outPath = argv[++i];
+    else if (a == "--synth" && i + 1 < argc) synth = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--seed" && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--iters" && i + 1 < argc) opt.maxIters = std::atoi(argv[++i]);
+    else if (a == "--tol" && i + 1 < argc) opt.tol = std::strtod(argv[++i], nullptr);
+    else if (a == "--floor" && i + 1 < argc) opt.floor = std::strtod(argv[++i], nullptr);
+    else if (!a.empty() && a[0] == '-') { usage(); return 2; }
+    else addPath(a, files);
+  }
+  const size_t N = files.size() + synth;
+  if (N == 0) { usage(); return 2; }
+
+  stbench::WorkStealingPool pool(jobs);
+  std::vector<stbench::ObsRuns> seqs(N);
+  std::vector<NightMeta> meta(N);
+  std::vector<std::vector<double>> times(pool.size());
+  const st::SleepPipelineConfig cfg{};
+
+  auto t0 = std::chrono::steady_clock::now();
+  pool.parallelFor(N, [&](size_t i, unsigned w) {
+    stbench::Night n;
+    if (i < files.size()) {
+      if (!stbench::loadNightCSV(files[i], n, meta[i].error)) return;
+    } else {
+      n = stbench::synthNight(seed + (i - files.size()));
+    }
+    std::vector<double>& tt = times[w];
+    stbench::extractObservations(n, cfg, seqs[i], &tt);
+    if (tt.size() > 1) meta[i].secPerTick = (tt.back() - tt.front()) / (double)(tt.size() - 1);
+    if (!std::isnan(n.labelOnset)) {
+      auto it = std::lower_bound(tt.begin(), tt.end(), n.labelOnset);
+      if (it != tt.end()) meta[i].labelTick = (size_t)(it - tt.begin());
+    }
+  });
+  const double extractSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  size_t failed = 0, ticks = 0, runs = 0;
+  for (size_t i = 0; i < N; ++i) {
+    if (!meta[i].error.empty()) { std::fprintf(stderr, "%s\n", meta[i].error.c_str()); ++failed; }
+    ticks += seqs[i].ticks;
+    runs += seqs[i].sym.size();
+  }
+  std::fprintf(stderr, "%zu nights (%zu failed), %zu ticks in %zu runs, extracted in %.3f s on %u workers\n",
+               N, failed, ticks, runs, extractSec, pool.size());
+
+  Model start = st::kSleepHMM3Model;
+  printScore("default", score(pool, start, seqs, meta));
+
+  std::vector<stbench::BaumWelchIteration> hist;
+  Model fit = stbench::baumWelch(pool, seqs, start, opt, &hist);
+  double fitSec = 0;
+  for (size_t k = 0; k < hist.size(); ++k) {
+    std::fprintf(stderr, "  iter %2zu: log-likelihood/tick %.6f (%.3f s, %.1f M ticks/s)\n", k + 1,
+                 hist[k].logLikPerTick, hist[k].seconds,
+                 hist[k].seconds > 0 ? (double)ticks / hist[k].seconds / 1e6 : 0.0);
+    fitSec += hist[k].seconds;
+  }
+  std::fprintf(stderr, "Baum-Welch: %zu iterations in %.3f s\n", hist.size(), fitSec);
+  printScore("fitted", score(pool, fit, seqs, meta));
+
+  FILE* f = outPath.empty() ? stdout : std::fopen(outPath.c_str(), "w");
+  if (!f) { std::perror(outPath.c_str()); return 1; }
+  printModel(f, fit);
+  if (f != stdout) std::fclose(f);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,365 @@
+//
+//  st_motion_train.cpp
+//  SleepTrigger Tools
+//
+//  Trains the int8 motion classifier (tinyml_motion.h) on labelled
+//  synthetic motion ticks, quantises it and writes the flat model blob.
+//
+//    st_motion_train [--seed S] [--train N] [--val N] [--hidden H]
+//                    [--epochs E] [--out model.bin] [--emit-c model.c]
+//
+//  12-H-H-3 MLP with ReLU, softmax cross-entropy, Adam. Weights are
+//  quantised per output row (max |w| / 127), activations per layer from the
+//  99.999th percentile of the float network's values on the training set.
+//  The report runs the validation windows through the int8 engine and the
+//  float reference: accuracy of each, class agreement, worst logit error,
+//  ns per inference, and the threshold rule for comparison. --emit-c
+//  writes the blob as tm_default_blob (Core/DSP/tinyml_motion_model.c).
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "night_io.hpp"
+
+extern "C" {
+#include "tinyml_motion.h"
+}
+
+namespace {
+
+constexpr int kTicksPerSeq = 4000;
+
+struct Sample { float f[TM_FEATURES]; int label; };
+
+// Feature windows of consecutive sequences, seeds seed, seed + 1, ...
+std::vector<Sample> makeSet(uint64_t seed, size_t n) {
+  std::vector<Sample> out;
+  out.reserve(n);
+  for (uint64_t s = seed; out.size() < n; ++s) {
+    tm_window_t w;
+    tm_window_reset(&w);
+    for (const auto& t : stbench::synthMotionTicks(s, kTicksPerSeq)) {
+      tm_window_push(&w, t.still, t.hr);
+      Sample x;
+      if (tm_window_features(&w, x.f) != 0) continue;
+      x.label = t.label;
+      out.push_back(x);
+      if (out.size() == n) break;
+    }
+  }
+  return out;
+}
+
+struct Dense {
+  int nIn{0}, nOut{0};
+  bool relu{true};
+  std::vector<float> w, b, gw, gb, mw, vw, mb, vb;   // w[r * nIn + k]
+
+  Dense(int in, int out, bool r, stbench::SplitMix& rng) : nIn(in), nOut(out), relu(r) {
+    w.resize((size_t)in * out);
+    const double he = std::sqrt(2.0 / in);
+    for (float& v : w) v = (float)(he * rng.normal());
+    b.assign(out, 0.0f);
+    gw.assign(w.size(), 0); mw = vw = gw;
+    gb.assign(out, 0);      mb = vb = gb;
+  }
+
+  void forward(const float* x, float* y) const {
+    for (int r = 0; r < nOut; ++r) {
+      float s = b[r];
+      for (int k = 0; k < nIn; ++k) s += w[(size_t)r * nIn + k] * x[k];
+      y[r] = relu && s < 0 ? 0 : s;
+    }
+  }
+};
+
+struct Net {
+  std::vector<Dense> layers;
+  float mean[TM_FEATURES]{}, invStd[TM_FEATURES]{};
+
+  // acts[0]: standardised input, acts[l + 1]: layer l's output.
+  void forward(const float* f, std::vector<std::vector<float>>& acts) const {
+    acts.resize(layers.size() + 1);
+    acts[0].resize(TM_FEATURES);
+    for (int k = 0; k < TM_FEATURES; ++k) acts[0][k] = (f[k] - mean[k]) * invStd[k];
+    for (size_t l = 0; l < layers.size(); ++l) {
+      acts[l + 1].resize(layers[l].nOut);
+      layers[l].forward(acts[l].data(), acts[l + 1].data());
+    }
+  }
+};
+
+void standardise(Net& net, const std::vector<Sample>& set) {
+  for (int k = 0; k < TM_FEATURES; ++k) {
+    double s = 0, ss = 0;
+    for (const auto& x : set) { s += x.f[k]; ss += (double)x.f[k] * x.f[k]; }
+    const double m = s / set.size(), v = ss / set.size() - m * m;
+    net.mean[k] = (float)m;
+    net.invStd[k] = v > 1e-12 ? (float)(1.0 / std::sqrt(v)) : 1.0f;
+  }
+}
+
+void train(Net& net, const std::vector<Sample>& set, int epochs, stbench::SplitMix& rng) {
+  const int batch = 64;
+  const float lr = 3e-3f, b1 = 0.9f, b2 = 0.999f, eps = 1e-8f;
+  std::vector<size_t> order(set.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::vector<std::vector<float>> acts, delta(net.layers.size() + 1);
+  int step = 0;
+  for (int e = 0; e < epochs; ++e) {
+    for (size_t i = order.size(); i > 1; --i) std::swap(order[i - 1], order[rng.next() % i]);
+    double loss = 0;
+    for (size_t start = 0; start < order.size(); start += batch) {
+      const size_t end = std::min(order.size(), start + batch);
+      for (auto& L : net.layers) { std::fill(L.gw.begin(), L.gw.end(), 0.0f); std::fill(L.gb.begin(), L.gb.end(), 0.0f); }
+      for (size_t i = start; i < end; ++i) {
+        const Sample& x = set[order[i]];
+        net.forward(x.f, acts);
+        // Softmax cross-entropy: dL/dz = p - onehot.
+        const auto& z = acts.back();
+        const float zmax = *std::max_element(z.begin(), z.end());
+        float p[TM_CLASSES], sum = 0;
+        for (int c = 0; c < TM_CLASSES; ++c) { p[c] = std::exp(z[c] - zmax); sum += p[c]; }
+        loss -= std::log(std::max(1e-12f, p[x.label] / sum));
+        auto& d = delta[net.layers.size()];
+        d.assign(TM_CLASSES, 0);
+        for (int c = 0; c < TM_CLASSES; ++c) d[c] = p[c] / sum - (c == x.label);
+        for (size_t l = net.layers.size(); l-- > 0;) {
+          Dense& L = net.layers[l];
+          const auto& in = acts[l];
+          const auto& dl = delta[l + 1];
+          for (int r = 0; r < L.nOut; ++r) {
+            L.gb[r] += dl[r];
+            for (int k = 0; k < L.nIn; ++k) L.gw[(size_t)r * L.nIn + k] += dl[r] * in[k];
+          }
+          if (l == 0) break;
+          auto& dp = delta[l];
+          dp.assign(L.nIn, 0);
+          for (int r = 0; r < L.nOut; ++r)
+            for (int k = 0; k < L.nIn; ++k) dp[k] += L.w[(size_t)r * L.nIn + k] * dl[r];
+          for (int k = 0; k < L.nIn; ++k) if (in[k] <= 0) dp[k] = 0;   // ReLU'
+        }
+      }
+      ++step;
+      const float scale = 1.0f / (float)(end - start);
+      const float c1 = 1.0f - std::pow(b1, (float)step), c2 = 1.0f - std::pow(b2, (float)step);
+      auto adam = [&](std::vector<float>& w, const std::vector<float>& g, std::vector<float>& m, std::vector<float>& v) {
+        for (size_t i = 0; i < w.size(); ++i) {
+          const float gi = g[i] * scale;
+          m[i] = b1 * m[i] + (1 - b1) * gi;
+          v[i] = b2 * v[i] + (1 - b2) * gi * gi;
+          w[i] -= lr * (m[i] / c1) / (std::sqrt(v[i] / c2) + eps);
+        }
+      };
+      for (auto& L : net.layers) { adam(L.w, L.gw, L.mw, L.vw); adam(L.b, L.gb, L.mb, L.vb); }
+    }
+    if (e == 0 || (e + 1) % 10 == 0 || e + 1 == epochs)
+      std::fprintf(stderr, "  epoch %3d: loss %.4f\n", e + 1, loss / (double)set.size());
+  }
+}
+
+// 99.999th percentile: close to the max, but one freak window does not
+// coarsen the step for all the others.
+float calibrationRange(std::vector<float>& v) {
+  if (v.empty()) return 0;
+  const size_t k = (size_t)(0.99999 * (double)(v.size() - 1));
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+size_t align(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+// Quantises net into the tm_blob_header_t layout (see tinyml_motion.h).
+std::vector<uint32_t> buildBlob(const Net& net, const std::vector<Sample>& calib) {
+  const size_t L = net.layers.size();
+  // Activation steps: |standardised input| for layer 0, post-ReLU outputs
+  // after that.
+  std::vector<std::vector<float>> seen(L), acts;
+  for (const auto& x : calib) {
+    net.forward(x.f, acts);
+    for (size_t l = 0; l < L; ++l)
+      for (float v : acts[l]) seen[l].push_back(std::fabs(v));
+  }
+  tm_blob_header_t h{};
+  h.magic = TM_MAGIC;
+  h.version = TM_VERSION;
+  h.nLayers = (uint32_t)L;
+  h.nIn = TM_FEATURES;
+  h.window = TM_WINDOW;
+  std::memcpy(h.featMean, net.mean, sizeof(h.featMean));
+  std::memcpy(h.featInvStd, net.invStd, sizeof(h.featInvStd));
+
+  size_t off = sizeof(h);
+  for (size_t l = 0; l < L; ++l) {
+    const Dense& d = net.layers[l];
+    tm_layer_desc_t& q = h.layer[l];
+    q.nIn = (uint32_t)d.nIn;
+    q.nOut = (uint32_t)d.nOut;
+    q.stride = (uint32_t)align(d.nIn, 16);
+    q.relu = d.relu;
+    q.inScale = std::max(1e-6f, calibrationRange(seen[l]) / 127.0f);
+    off = align(off, 16); q.wOff = (uint32_t)off; off += (size_t)q.nOut * q.stride;
+    off = align(off, 4);  q.bOff = (uint32_t)off; off += 4 * (size_t)q.nOut;
+    q.sOff = (uint32_t)off;  off += 4 * (size_t)q.nOut;
+    q.fwOff = (uint32_t)off; off += 4 * (size_t)q.nOut * q.nIn;
+    q.fbOff = (uint32_t)off; off += 4 * (size_t)q.nOut;
+  }
+  h.size = (uint32_t)align(off, 16);
+
+  std::vector<uint32_t> words(h.size / 4, 0);
+  uint8_t* p = (uint8_t*)words.data();
+  std::memcpy(p, &h, sizeof(h));
+  for (size_t l = 0; l < L; ++l) {
+    const Dense& d = net.layers[l];
+    const tm_layer_desc_t& q = h.layer[l];
+    int8_t* W = (int8_t*)(p + q.wOff);
+    int32_t* B = (int32_t*)(p + q.bOff);
+    float* S = (float*)(p + q.sOff);
+    for (int r = 0; r < d.nOut; ++r) {
+      float mx = 0;
+      for (int k = 0; k < d.nIn; ++k) mx = std::max(mx, std::fabs(d.w[(size_t)r * d.nIn + k]));
+      const float s = mx > 0 ? mx / 127.0f : 1.0f;
+      S[r] = s;
+      for (int k = 0; k < d.nIn; ++k)
+        W[(size_t)r * q.stride + k] = (int8_t)std::max(-127.0f, std::min(127.0f, std::round(d.w[(size_t)r * d.nIn + k] / s)));
+      B[r] = (int32_t)std::lround(d.b[r] / (s * q.inScale));
+    }
+    std::memcpy(p + q.fwOff, d.w.data(), 4 * d.w.size());
+    std::memcpy(p + q.fbOff, d.b.data(), 4 * d.b.size());
+  }
+  return words;
+}
+
+bool emitC(const std::string& path, const std::vector<uint32_t>& words, const std::string& note) {
+  FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) return false;
+  std::fprintf(f,
+    "//\n"
+    "//  tinyml_motion_model.c\n"
+    "//  SleepTriggerWatchOS Watch App\n"
+    "//\n"
+    "//  Created by Daniel Hu on 2025-08-16.\n"
+    "//\n"
+    "//  Built-in motion classifier, written by Tools/replay/st_motion_train;\n"
+    "//  regenerate rather than edit.\n"
+    "//  %s\n"
+    "//\n"
+    "\n"
+    "#include \"tinyml_motion.h\"\n"
+    "\n"
+    "// tm_blob_header_t and payload as little-endian words (4-byte aligned).\n"
+    "static const uint32_t kBlob[%zu] = {\n", note.c_str(), words.size());
+  for (size_t i = 0; i < words.size(); ++i)
+    std::fprintf(f, "%s0x%08x,%s", i % 8 ? " " : "  ", words[i], i % 8 == 7 || i + 1 == words.size() ? "\n" : "");
+  std::fprintf(f,
+    "};\n"
+    "\n"
+    "const void* tm_default_blob(size_t* len){\n"
+    "  *len = sizeof(kBlob);\n"
+    "  return kBlob;\n"
+    "}\n");
+  return std::fclose(f) == 0;
+}
+
+void usage() {
+  std::fprintf(stderr,
+    "usage: st_motion_train [--seed S] [--train N] [--val N] [--hidden H]\n"
+    "                       [--epochs E] [--out model.bin] [--emit-c model.c]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint64_t seed = 1;
+  size_t nTrain = 40000, nVal = 10000;
+  int hidden = 16, epochs = 40;
+  std::string outPath, cPath;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--seed" && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--train" && i + 1 < argc) nTrain = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--val" && i + 1 < argc) nVal = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--hidden" && i + 1 < argc) hidden = std::atoi(argv[++i]);
+    else if (a == "--epochs" && i + 1 < argc) epochs = std::atoi(argv[++i]);
+    else if (a == "--out" && i + 1 < argc) outPath = argv[++i];
+    else if (a == "--emit-c" && i + 1 < argc) cPath = argv[++i];
+    else { usage(); return 2; }
+  }
+  if (hidden < 1 || hidden > TM_MAX_WIDTH || nTrain == 0 || nVal == 0) { usage(); return 2; }
+
+  // Validation sequences use seeds well clear of the training ones.
+  const std::vector<Sample> trainSet = makeSet(seed, nTrain);
+  const std::vector<Sample> valSet = makeSet(seed + 100000, nVal);
+
+  stbench::SplitMix rng(seed ^ 0x5DEECE66Dull);
+  Net net;
+  net.layers.emplace_back(TM_FEATURES, hidden, true, rng);
+  net.layers.emplace_back(hidden, hidden, true, rng);
+  net.layers.emplace_back(hidden, TM_CLASSES, false, rng);
+  standardise(net, trainSet);
+  auto t0 = std::chrono::steady_clock::now();
+  train(net, trainSet, epochs, rng);
+  const double trainSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  const std::vector<uint32_t> blob = buildBlob(net, trainSet);
+  tm_model_t m;
+  if (tm_model_load(&m, blob.data(), blob.size() * 4) != 0) {
+    std::fprintf(stderr, "quantised blob does not load\n");
+    return 1;
+  }
+
+  tm_arena_t arena;
+  size_t okQ = 0, okF = 0, okRule = 0, okStub = 0, agree = 0;
+  double maxLogitErr = 0;
+  for (const auto& x : valSet) {
+    float zq[TM_CLASSES], zf[TM_CLASSES];
+    const int q = tm_infer(&m, &arena, x.f, zq);
+    const int f = tm_infer_ref(&m, x.f, zf);
+    okQ += q == x.label;
+    okF += f == x.label;
+    agree += q == f;
+    for (int c = 0; c < TM_CLASSES; ++c) maxLogitErr = std::max(maxLogitErr, (double)std::fabs(zq[c] - zf[c]));
+    okRule += tiny_motion_classify(x.f[0], (double)x.f[1] * x.f[1]) == x.label;
+    okStub += tiny_motion_classify(x.f[4], 0.0) == x.label;   // SleepMonitor's call
+  }
+
+  const int reps = 20;
+  volatile int sink = 0;
+  t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r)
+    for (const auto& x : valSet) sink = sink + tm_infer(&m, &arena, x.f, nullptr);
+  const double nsQ = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (reps * (double)valSet.size());
+  t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < reps; ++r)
+    for (const auto& x : valSet) sink = sink + tm_infer_ref(&m, x.f, nullptr);
+  const double nsF = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (reps * (double)valSet.size());
+
+  const double n = (double)valSet.size();
+  std::fprintf(stderr, "trained %d-%d-%d-%d on %zu windows in %.2f s; blob %zu bytes\n",
+               TM_FEATURES, hidden, hidden, TM_CLASSES, trainSet.size(), trainSec, blob.size() * 4);
+  std::fprintf(stderr, "validation (%zu windows):\n", valSet.size());
+  std::fprintf(stderr, "  int8     accuracy %.4f  %.0f ns/window\n", okQ / n, nsQ);
+  std::fprintf(stderr, "  float    accuracy %.4f  %.0f ns/window\n", okF / n, nsF);
+  std::fprintf(stderr, "  int8 vs float: class agreement %.4f, max |logit error| %.3f\n", agree / n, maxLogitErr);
+  std::fprintf(stderr, "  threshold rule (window mean, var) accuracy %.4f; (last, var 0) %.4f\n", okRule / n, okStub / n);
+
+  if (!outPath.empty()) {
+    FILE* f = std::fopen(outPath.c_str(), "wb");
+    if (!f || std::fwrite(blob.data(), 4, blob.size(), f) != blob.size()) { std::perror(outPath.c_str()); return 1; }
+    std::fclose(f);
+  }
+  if (!cPath.empty()) {
+    char note[160];
+    std::snprintf(note, sizeof(note), "--seed %llu --train %zu --hidden %d --epochs %d: val int8 %.3f, float %.3f.",
+                  (unsigned long long)seed, nTrain, hidden, epochs, okQ / n, okF / n);
+    if (!emitC(cPath, blob, note)) { std::perror(cPath.c_str()); return 1; }
+  }
+  return 0;
+}
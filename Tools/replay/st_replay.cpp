@@ -0,0 +1,323 @@
+//
+//  st_replay.cpp
+//  SleepTrigger Tools
+//
+//  Replays recorded (or synthetic) nights through st::SleepPipeline and
+//  reports onset time and throughput.
+//
+//    st_replay night.csv [more.csv ...] [--trace out.csv]
+//    st_replay --synth N [--seed S] [--awake-min M]
+//
+//  --trend kalman swaps the windowed HR trend for st::HRTrendKF.
+//  --frame SEC sets the evaluation frame period; 0 evaluates on every sample.
+//  --duty every|switch|adaptive picks the evaluation pacing; --duty-report
+//  instead replays every night under each pacing and compares modelled
+//  compute / sensor energy and onset latency against a fixed 1 Hz cadence.
+//  --precision mixed|double|float|q31|q15 picks the HR / stillness
+//  conditioning sample type; --precision-report replays every night in each
+//  and compares onsets, smoothed HR and conditioning cost against double.
+//  --motion threshold|int8|float picks the motion classifier behind
+//  respQuiet; --motion-report replays every night with each and compares
+//  onsets against the float reference and the labels.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "night_io.hpp"
+
+static void usage() {
+  std::fprintf(stderr,
+    "usage: st_replay <night.csv>... [--trace out.csv]\n"
+    "       st_replay --synth N [--seed S] [--awake-min M] [--write-dir DIR]\n"
+    "       options: --trend window|kalman  --frame SEC  --duty every|switch|adaptive  --duty-report\n"
+    "                --precision mixed|double|float|q31|q15  --precision-report\n"
+    "                --motion threshold|int8|float  --motion-report\n");
+}
+
+static void writeTrace(const std::string& path, const std::vector<st::SleepTick>& tr) {
+  FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) { std::perror(path.c_str()); return; }
+  std::fprintf(f, "t,hr,still,drop,slope,propensity,state\n");
+  for (const auto& k : tr)
+    std::fprintf(f, "%.3f,%.3f,%.4f,%.5f,%.6f,%.5f,%d\n",
+                 k.t, k.hr, k.still, k.drop, k.slope, k.propensity, (int)k.state);
+  std::fclose(f);
+}
+
+struct DutyRun {
+  const char* name;
+  st::SleepPipelineConfig cfg;
+  size_t detected{0}, missed{0}, compared{0};
+  double energy{0}, wakeups{0}, sensorOn{0}, dsp{0};
+  std::vector<double> delay{}; // onset - reference onset, nights both detect
+};
+
+// Every night under each pacing; the first run is the reference.
+static void dutyReport(const std::vector<stbench::Night>& nights, const st::SleepPipelineConfig& base) {
+  std::vector<DutyRun> runs;
+  auto add = [&](const char* name, double frame, st::DutyMode m) {
+    DutyRun r{name, base};
+    r.cfg.framePeriod = frame;
+    r.cfg.duty = m;
+    runs.push_back(r);
+  };
+  add("fixed-1Hz", 1.0, st::DutyMode::Every);
+  add("frame-2s", 2.0, st::DutyMode::Every);
+  add("switch", 2.0, st::DutyMode::Switch);
+  add("adaptive", 2.0, st::DutyMode::Adaptive);
+
+  dc_cost_t cost;
+  dc_cost_default(&cost);
+  for (const auto& n : nights) {
+    double ref = NAN;
+    for (auto& run : runs) {
+      st::SleepPipeline p(run.cfg);
+      auto t0 = std::chrono::steady_clock::now();
+      st::NightResult r = st::replayNight(p, n.events.data(), n.events.size());
+      r.duty.dspSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      run.wakeups += (double)r.duty.wakeups;
+      run.sensorOn += r.duty.sensorOn;
+      run.dsp += r.duty.dspSeconds;
+      run.energy += dc_energy_j(&r.duty, &cost);
+      if (&run == &runs[0]) ref = r.onset;
+      if (!std::isnan(r.onset)) ++run.detected;
+      if (!std::isnan(ref) && std::isnan(r.onset)) ++run.missed;
+      if (!std::isnan(ref) && !std::isnan(r.onset)) run.delay.push_back(r.onset - ref);
+    }
+  }
+
+  const double nn = (double)std::max<size_t>(1, nights.size());
+  const DutyRun& ref = runs[0];
+  std::printf("%-10s %9s %7s %11s %10s %9s %9s %9s %9s %9s\n", "policy", "detected", "missed",
+              "evals/night", "sensor_h", "dsp_ms", "energy_J", "saved_%", "delay_s", "p95_s");
+  for (auto& run : runs) {
+    std::sort(run.delay.begin(), run.delay.end());
+    double mean = 0;
+    for (double d : run.delay) mean += d;
+    mean = run.delay.empty() ? 0 : mean / (double)run.delay.size();
+    const double p95 = run.delay.empty() ? 0 : run.delay[(size_t)(0.95 * (double)(run.delay.size() - 1))];
+    std::printf("%-10s %9zu %7zu %11.0f %10.2f %9.2f %9.3f %9.1f %9.1f %9.1f\n", run.name, run.detected,
+                run.missed, run.wakeups / nn, run.sensorOn / nn / 3600.0, run.dsp / nn * 1e3,
+                run.energy / nn, 100.0 * (1.0 - run.energy / ref.energy), mean, p95);
+  }
+}
+
+// Timing loops store their running sum here so it cannot be optimised away.
+static volatile double g_sink;
+
+// Conditioning alone (Hampel + IIR1 over every HR and stillness sample),
+// ns per sample, best of 3.
+template <typename T>
+static double conditionNs(const std::vector<stbench::Night>& nights, const st::SleepPipelineConfig& cfg) {
+  double best = 1e300, sink = 0;
+  size_t samples = 0;
+  for (int rep = 0; rep < 3; ++rep) {
+    samples = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& n : nights) {
+      st::SampleConditioner<T> c;
+      c.init(cfg.hampelWindow, cfg.hampelSigma, cfg.hrAlpha, cfg.stillAlpha);
+      double cleaned;
+      for (const auto& e : n.events) {
+        sink += e.kind == 0 ? c.hr(e.value, &cleaned) : c.still(e.value);
+        ++samples;
+      }
+    }
+    best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count());
+  }
+  g_sink = sink;
+  return samples ? best / (double)samples : 0;
+}
+
+static double mixedConditionNs(const std::vector<stbench::Night>& nights, const st::SleepPipelineConfig& cfg) {
+  double best = 1e300, sink = 0;
+  size_t samples = 0;
+  for (int rep = 0; rep < 3; ++rep) {
+    samples = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& n : nights) {
+      rs_hampel_t h; rs_hampel_init(&h, cfg.hampelWindow, cfg.hampelSigma);
+      iir1_t hr, still; iir1_init(&hr, cfg.hrAlpha); iir1_init(&still, cfg.stillAlpha);
+      for (const auto& e : n.events) {
+        sink += e.kind == 0 ? iir1_update(&hr, (float)rs_hampel_update(&h, e.value))
+                                              : iir1_update(&still, (float)e.value);
+        ++samples;
+      }
+    }
+    best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count());
+  }
+  g_sink = sink;
+  return samples ? best / (double)samples : 0;
+}
+
+// Every night in each conditioning precision against the double run.
+static void precisionReport(const std::vector<stbench::Night>& nights, const st::SleepPipelineConfig& base) {
+  const st::Precision modes[] = {st::Precision::Double, st::Precision::Mixed, st::Precision::Float,
+                                 st::Precision::Q31, st::Precision::Q15};
+  std::printf("%-8s %9s %10s %9s %10s %9s %11s\n", "mode", "detected", "identical", "delta_s",
+              "max_dhr", "cond_ns", "replay_Mev/s");
+  std::vector<double> refOnset(nights.size());
+  std::vector<std::vector<st::SleepTick>> refTrace(nights.size());
+  for (st::Precision m : modes) {
+    st::SleepPipelineConfig cfg = base;
+    cfg.precision = m;
+    size_t detected = 0, identical = 0, events = 0;
+    double delta = 0, maxDhr = 0, sec = 0;
+    for (size_t i = 0; i < nights.size(); ++i) {
+      st::SleepPipeline p(cfg);
+      std::vector<st::SleepTick> trace;
+      p.setTrace(&trace);
+      auto t0 = std::chrono::steady_clock::now();
+      st::NightResult r = st::replayNight(p, nights[i].events.data(), nights[i].events.size());
+      sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      events += r.events;
+      if (m == st::Precision::Double) { refOnset[i] = r.onset; refTrace[i] = trace; }
+      const double ref = refOnset[i];
+      if (!std::isnan(r.onset)) ++detected;
+      if ((std::isnan(ref) && std::isnan(r.onset)) || r.onset == ref) ++identical;
+      else if (!std::isnan(ref) && !std::isnan(r.onset)) delta = std::max(delta, std::fabs(r.onset - ref));
+      const size_t k = std::min(trace.size(), refTrace[i].size());
+      for (size_t j = 0; j < k; ++j)
+        if (!std::isnan(trace[j].hr) && !std::isnan(refTrace[i][j].hr))
+          maxDhr = std::max(maxDhr, (double)std::fabs(trace[j].hr - refTrace[i][j].hr));
+    }
+    double ns = 0;
+    switch (m) {
+      case st::Precision::Mixed:  ns = mixedConditionNs(nights, cfg); break;
+      case st::Precision::Double: ns = conditionNs<double>(nights, cfg); break;
+      case st::Precision::Float:  ns = conditionNs<float>(nights, cfg); break;
+      case st::Precision::Q31:    ns = conditionNs<st::Q31>(nights, cfg); break;
+      case st::Precision::Q15:    ns = conditionNs<st::Q15>(nights, cfg); break;
+    }
+    std::printf("%-8s %9zu %6zu/%-3zu %9.1f %10.2g %9.2f %11.2f\n", st::precisionName(m), detected, identical,
+                nights.size(), delta, maxDhr, ns, sec > 0 ? (double)events / sec / 1e6 : 0.0);
+  }
+}
+
+// Every night with each motion classifier against the float reference.
+static void motionReport(const std::vector<stbench::Night>& nights, const st::SleepPipelineConfig& base) {
+  const st::MotionModel modes[] = {st::MotionModel::Float, st::MotionModel::Int8, st::MotionModel::Threshold};
+  std::printf("%-10s %9s %10s %9s %12s %11s\n", "motion", "detected", "identical", "delta_s",
+              "label_err_s", "replay_Mev/s");
+  std::vector<double> refOnset(nights.size());
+  for (st::MotionModel m : modes) {
+    st::SleepPipelineConfig cfg = base;
+    cfg.motionModel = m;
+    size_t detected = 0, identical = 0, labelled = 0, events = 0;
+    double delta = 0, labelErr = 0, sec = 0;
+    for (size_t i = 0; i < nights.size(); ++i) {
+      st::SleepPipeline p(cfg);
+      auto t0 = std::chrono::steady_clock::now();
+      st::NightResult r = st::replayNight(p, nights[i].events.data(), nights[i].events.size());
+      sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      events += r.events;
+      if (m == st::MotionModel::Float) refOnset[i] = r.onset;
+      const double ref = refOnset[i];
+      if (!std::isnan(r.onset)) ++detected;
+      if ((std::isnan(ref) && std::isnan(r.onset)) || r.onset == ref) ++identical;
+      else if (!std::isnan(ref) && !std::isnan(r.onset)) delta = std::max(delta, std::fabs(r.onset - ref));
+      if (!std::isnan(r.onset) && !std::isnan(nights[i].labelOnset)) {
+        labelErr += std::fabs(r.onset - nights[i].labelOnset);
+        ++labelled;
+      }
+    }
+    std::printf("%-10s %9zu %6zu/%-3zu %9.1f %12.1f %11.2f\n", st::motionModelName(m), detected, identical,
+                nights.size(), delta, labelled ? labelErr / (double)labelled : NAN,
+                sec > 0 ? (double)events / sec / 1e6 : 0.0);
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> files;
+  std::string tracePath, writeDir;
+  size_t synth = 0;
+  uint64_t seed = 1;
+  stbench::SynthParams sp;
+  st::SleepPipelineConfig cfg;
+  bool report = false, precReport = false, motionRep = false;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--synth" && i + 1 < argc) synth = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--seed" && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--awake-min" && i + 1 < argc) sp.awakeMinutes = std::strtod(argv[++i], nullptr);
+    else if (a == "--trace" && i + 1 < argc) tracePath = argv[++i];
+    else if (a == "--write-dir" && i + 1 < argc) writeDir = argv[++i];
+    else if (a == "--trend" && i + 1 < argc) {
+      std::string m = argv[++i];
+      if (m == "kalman") cfg.trendModel = st::TrendModel::Kalman;
+      else if (m != "window") { usage(); return 2; }
+    }
+    else if (a == "--frame" && i + 1 < argc) cfg.framePeriod = std::strtod(argv[++i], nullptr);
+    else if (a == "--duty" && i + 1 < argc) {
+      std::string m = argv[++i];
+      if (m == "every") cfg.duty = st::DutyMode::Every;
+      else if (m == "switch") cfg.duty = st::DutyMode::Switch;
+      else if (m == "adaptive") cfg.duty = st::DutyMode::Adaptive;
+      else { usage(); return 2; }
+    }
+    else if (a == "--duty-report") report = true;
+    else if (a == "--precision" && i + 1 < argc) {
+      std::string m = argv[++i];
+      bool ok = false;
+      for (st::Precision p : {st::Precision::Mixed, st::Precision::Double, st::Precision::Float,
+                              st::Precision::Q31, st::Precision::Q15})
+        if (m == st::precisionName(p)) { cfg.precision = p; ok = true; }
+      if (!ok) { usage(); return 2; }
+    }
+    else if (a == "--precision-report") precReport = true;
+    else if (a == "--motion" && i + 1 < argc) {
+      std::string m = argv[++i];
+      bool ok = false;
+      for (st::MotionModel mm : {st::MotionModel::Threshold, st::MotionModel::Int8, st::MotionModel::Float})
+        if (m == st::motionModelName(mm)) { cfg.motionModel = mm; ok = true; }
+      if (!ok) { usage(); return 2; }
+    }
+    else if (a == "--motion-report") motionRep = true;
+    else if (!a.empty() && a[0] == '-') { usage(); return 2; }
+    else files.push_back(a);
+  }
+  if (files.empty() && synth == 0) { usage(); return 2; }
+
+  std::vector<stbench::Night> nights;
+  for (const auto& f : files) {
+    stbench::Night n; std::string err;
+    if (!stbench::loadNightCSV(f, n, err)) { std::fprintf(stderr, "%s\n", err.c_str()); return 1; }
+    nights.push_back(std::move(n));
+  }
+  for (size_t i = 0; i < synth; ++i) {
+    nights.push_back(stbench::synthNight(seed + i, sp));
+    if (!writeDir.empty())
+      stbench::saveNightCSV(writeDir + "/" + nights.back().name + ".csv", nights.back());
+  }
+
+  if (report) { dutyReport(nights, cfg); return 0; }
+  if (precReport) { precisionReport(nights, cfg); return 0; }
+  if (motionRep) { motionReport(nights, cfg); return 0; }
+
+  size_t totalEvents = 0;
+  double totalSec = 0;
+  std::printf("%-28s %10s %10s %10s %9s %8s\n", "night", "onset_s", "label_s", "events", "ticks", "Mev/s");
+  for (const auto& n : nights) {
+    st::SleepPipeline p(cfg);
+    std::vector<st::SleepTick> trace;
+    if (!tracePath.empty() && nights.size() == 1) p.setTrace(&trace);
+    auto t0 = std::chrono::steady_clock::now();
+    st::NightResult r = st::replayNight(p, n.events.data(), n.events.size());
+    double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    totalEvents += r.events;
+    totalSec += dt;
+    std::printf("%-28s %10.1f %10.1f %10zu %9zu %8.2f\n", n.name.c_str(), r.onset, n.labelOnset,
+                r.events, r.ticks, dt > 0 ? (double)r.events / dt / 1e6 : 0.0);
+    if (!trace.empty()) writeTrace(tracePath, trace);
+  }
+  if (nights.size() > 1)
+    std::printf("total: %zu events in %.3f s (%.2f M events/s)\n",
+                totalEvents, totalSec, totalSec > 0 ? (double)totalEvents / totalSec / 1e6 : 0.0);
+  return 0;
+}
@@ -0,0 +1,207 @@
+//
+//  st_sweep.cpp
+//  SleepTrigger Tools
+//
+//  Grid search over the decision parameters. Features are extracted once per
+//  night and every config in the grid is scored against them.
+//
+//    st_sweep <dir|night.csv>... | --synth N  [grid options] [--jobs N] [--out scores.csv]
+//
+//  Grid options take comma-separated values; the grid is their cartesian
+//  product. Unlisted parameters stay at the SleepPipelineConfig defaults.
+//    --q --r                       KF1 process / measurement noise
+//    --w-drop --w-still --w-slope --w-resp --w-vlf   fusion weights
+//    --drop-thr --min-drowsy --min-still             SleepFSM thresholds
+//    --assist-asleep --confirm     propensity assist threshold, confirm ticks
+//    --hmm-switch --hmm-confuse    multiply HMM3 off-diagonal A / E entries
+//    --false-margin S              onset this far before label = false trigger (600)
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "sweep.hpp"
+#include "work_steal_pool.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Axis {
+  const char* flag;
+  std::function<void(stbench::DecisionParams&, double)> apply;
+  std::vector<double> values;
+};
+
+std::vector<double> parseList(const char* s) {
+  std::vector<double> v;
+  while (*s) {
+    char* end;
+    v.push_back(std::strtod(s, &end));
+    if (end == s) break;
+    s = *end == ',' ? end + 1 : end;
+  }
+  return v;
+}
+
+std::vector<Axis> makeAxes() {
+  using D = stbench::DecisionParams;
+  return {
+    {"--q",             [](D& d, double v) { d.kfQ = v; }, {}},
+    {"--r",             [](D& d, double v) { d.kfR = v; }, {}},
+    {"--w-drop",        [](D& d, double v) { d.w[0] = v; }, {}},
+    {"--w-still",       [](D& d, double v) { d.w[1] = v; }, {}},
+    {"--w-slope",       [](D& d, double v) { d.w[2] = v; }, {}},
+    {"--w-resp",        [](D& d, double v) { d.w[3] = v; }, {}},
+    {"--w-vlf",         [](D& d, double v) { d.w[4] = v; }, {}},
+    {"--drop-thr",      [](D& d, double v) { d.dropThreshold = v; }, {}},
+    {"--min-drowsy",    [](D& d, double v) { d.minDrowsySeconds = v; }, {}},
+    {"--min-still",     [](D& d, double v) { d.minStillScore = v; }, {}},
+    {"--assist-asleep", [](D& d, double v) { d.assistAsleep = v; }, {}},
+    {"--confirm",       [](D& d, double v) { d.confirmTicks = (int)v; }, {}},
+    {"--hmm-switch",    [](D& d, double v) { D::scaleOffDiagonal(d.A, v); }, {}},
+    {"--hmm-confuse",   [](D& d, double v) { D::scaleOffDiagonal(d.E, v); }, {}},
+  };
+}
+
+void addPath(const std::string& p, std::vector<std::string>& files) {
+  std::error_code ec;
+  if (!fs::is_directory(p, ec)) { files.push_back(p); return; }
+  std::vector<std::string> found;
+  for (const auto& e : fs::directory_iterator(p, ec))
+    if (e.is_regular_file() && e.path().extension() == ".csv") found.push_back(e.path().string());
+  std::sort(found.begin(), found.end());
+  files.insert(files.end(), found.begin(), found.end());
+}
+
+void usage() {
+  std::fprintf(stderr,
+    "usage: st_sweep <dir|night.csv>... | --synth N [--seed S]\n"
+    "                [--q a,b,..] [--r ..] [--w-drop ..] [--w-still ..] [--w-slope ..]\n"
+    "                [--w-resp ..] [--w-vlf ..] [--drop-thr ..] [--min-drowsy ..]\n"
+    "                [--min-still ..] [--assist-asleep ..] [--confirm ..]\n"
+    "                [--hmm-switch ..] [--hmm-confuse ..]\n"
+    "                [--false-margin S] [--jobs N] [--out scores.csv] [--top K]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<Axis> axes = makeAxes();
+  std::vector<std::string> files;
+  std::string outPath;
+  unsigned jobs = 0;
+  size_t synth = 0, top = 10;
+  uint64_t seed = 1;
+  double falseMargin = 600;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    auto ax = std::find_if(axes.begin(), axes.end(), [&](const Axis& x) { return a == x.flag; });
+    if (ax != axes.end() && i + 1 < argc) ax->values = parseList(argv[++i]);
+    else if (a == "--jobs" && i + 1 < argc) jobs = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+    else if (a == "--out" && i + 1 < argc) outPath = argv[++i];
+    else if (a == "--top" && i + 1 < argc) top = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--synth" && i + 1 < argc) synth = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--seed" && i + 1 < argc) seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (a == "--false-margin" && i + 1 < argc) falseMargin = std::strtod(argv[++i], nullptr);
+    else if (!a.empty() && a[0] == '-') { usage(); return 2; }
+    else addPath(a, files);
+  }
+  const size_t N = files.size() + synth;
+  if (N == 0) { usage(); return 2; }
+
+  // Cartesian product, first axis varying slowest.
+  std::vector<stbench::DecisionParams> grid{stbench::DecisionParams{}};
+  for (const auto& ax : axes) {
+    if (ax.values.empty()) continue;
+    std::vector<stbench::DecisionParams> next;
+    next.reserve(grid.size() * ax.values.size());
+    for (const auto& g : grid)
+      for (double v : ax.values) { next.push_back(g); ax.apply(next.back(), v); }
+    grid.swap(next);
+  }
+  const size_t C = grid.size();
+
+  // Config chunks keep per-config state cache-resident while a night's
+  // feature columns stream past.
+  constexpr size_t kChunk = 512;
+  std::vector<std::vector<stbench::DecisionParams>> chunks;
+  for (size_t b = 0; b < C; b += kChunk)
+    chunks.emplace_back(grid.begin() + (long)b, grid.begin() + (long)std::min(C, b + kChunk));
+
+  stbench::WorkStealingPool pool(jobs);
+  std::vector<std::vector<stbench::DecisionBatch>> batches(pool.size());
+  for (auto& wb : batches)
+    for (const auto& ch : chunks) wb.emplace_back(ch);
+  std::vector<stbench::FeatureColumns> cols(pool.size());
+
+  std::vector<double> onsets(N * C, NAN), labels(N, NAN);
+  std::vector<size_t> ticks(N, 0);
+  std::vector<std::string> errors(N);
+  const st::SleepPipelineConfig upstream{};
+
+  auto t0 = std::chrono::steady_clock::now();
+  pool.parallelFor(N, [&](size_t i, unsigned w) {
+    stbench::Night n;
+    if (i < files.size()) {
+      if (!stbench::loadNightCSV(files[i], n, errors[i])) return;
+    } else {
+      n = stbench::synthNight(seed + (i - files.size()));
+    }
+    labels[i] = n.labelOnset;
+    if (!stbench::extractFeatures(n, upstream, cols[w], errors[i])) return;
+    ticks[i] = cols[w].size();
+    double* o = &onsets[i * C];
+    for (size_t k = 0; k < chunks.size(); ++k) batches[w][k].run(cols[w], o + k * kChunk);
+  });
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  // Reduce in night order so sums do not depend on scheduling.
+  std::vector<stbench::SweepScore> scores(C);
+  size_t failed = 0, totalTicks = 0;
+  for (size_t i = 0; i < N; ++i) {
+    if (!errors[i].empty()) { std::fprintf(stderr, "%s\n", errors[i].c_str()); ++failed; continue; }
+    totalTicks += ticks[i];
+    for (size_t c = 0; c < C; ++c) scores[c].add(onsets[i * C + c], labels[i], falseMargin);
+  }
+
+  FILE* f = outPath.empty() ? stdout : std::fopen(outPath.c_str(), "w");
+  if (!f) { std::perror(outPath.c_str()); return 1; }
+  std::fprintf(f, "config,q,r,w_drop,w_still,w_slope,w_resp,w_vlf,drop_thr,min_drowsy,min_still,"
+                  "assist_asleep,confirm,nights,detected,false_triggers,missed,"
+                  "mean_latency_s,mean_abs_latency_s\n");
+  for (size_t c = 0; c < C; ++c) {
+    const auto& d = grid[c];
+    const auto& s = scores[c];
+    std::fprintf(f, "%zu,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g,%d,%zu,%zu,%zu,%zu,%.1f,%.1f\n",
+                 c, d.kfQ, d.kfR, d.w[0], d.w[1], d.w[2], d.w[3], d.w[4], d.dropThreshold,
+                 d.minDrowsySeconds, d.minStillScore, d.assistAsleep, d.confirmTicks,
+                 s.nights, s.detected, s.falseTriggers, s.missed, s.meanLatency(), s.meanAbsLatency());
+  }
+  if (f != stdout) std::fclose(f);
+
+  // Best configs: fewest false triggers, then fewest misses, then latency.
+  std::vector<size_t> order(C);
+  for (size_t c = 0; c < C; ++c) order[c] = c;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    const auto &x = scores[a], &y = scores[b];
+    if (x.falseTriggers != y.falseTriggers) return x.falseTriggers < y.falseTriggers;
+    if (x.missed != y.missed) return x.missed < y.missed;
+    double lx = x.meanAbsLatency(), ly = y.meanAbsLatency();
+    return (std::isnan(ly) && !std::isnan(lx)) || lx < ly;
+  });
+  std::fprintf(stderr, "%zu nights x %zu configs (%zu failed): %.3f s wall, %.1f M config-ticks/s\n",
+               N, C, failed, wall, wall > 0 ? (double)totalTicks * (double)C / wall / 1e6 : 0.0);
+  for (size_t k = 0; k < std::min(top, C); ++k) {
+    const auto& s = scores[order[k]];
+    std::fprintf(stderr, "  #%zu config %zu: false=%zu missed=%zu mean|lat|=%.0f s\n",
+                 k + 1, order[k], s.falseTriggers, s.missed, s.meanAbsLatency());
+  }
+  return failed ? 1 : 0;
+}
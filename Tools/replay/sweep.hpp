@@ -0,0 +1,300 @@
+//
+//  sweep.hpp
+//  SleepTrigger Tools
+//
+//  Parameter sweeps over the decision half of the pipeline. A night's
+//  SleepFrontEnd output is computed once into FeatureColumns; KF1, fusion
+//  weights, SleepFSM thresholds, HMM3 matrices and the assist/confirm rules
+//  are then evaluated for a whole batch of configs per tick, with configs
+//  laid out structure-of-arrays so the inner loop is branch-free and
+//  vectorisable. Onsets match a full SleepPipeline run bit for bit when the
+//  config is expressible as a SleepPipelineConfig with DutyMode::Every.
+//
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "night_io.hpp"
+
+// The per-config columns never alias; say so, since GCC ignores __restrict
+// on block-scope pointers.
+#if defined(__clang__)
+#define ST_SWEEP_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define ST_SWEEP_IVDEP _Pragma("GCC ivdep")
+#else
+#define ST_SWEEP_IVDEP
+#endif
+
+// The config loop is select-heavy; AVX2 blends halve its instruction count
+// versus SSE2 and/or/andn. AVX2 alone does not enable FMA contraction, so
+// both clones produce the same bits.
+#if defined(__x86_64__) && defined(__ELF__) && (defined(__GNUC__) || defined(__clang__))
+#define ST_SWEEP_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define ST_SWEEP_CLONES
+#endif
+
+namespace stbench {
+
+struct FeatureColumns {
+  std::vector<double> t, drop, slope, negSlope, still, vlf, respQuiet;
+
+  size_t size() const { return t.size(); }
+  void clear() {
+    for (auto* v : {&t, &drop, &slope, &negSlope, &still, &vlf, &respQuiet}) v->clear();
+  }
+  void push(const st::SleepFeatures& f) {
+    t.push_back(f.t); drop.push_back(f.drop); slope.push_back(f.slope);
+    negSlope.push_back(f.negSlope); still.push_back(f.still);
+    vlf.push_back(f.vlf); respQuiet.push_back(f.respQuiet);
+  }
+};
+
+// Runs the front end over a whole night. Unlike SleepPipeline it does not
+// stop at onset: where that happens depends on the decision config.
+// Only DutyMode::Every can be shared this way: under Switch / Adaptive the
+// ticks that run (and the samples the sensors deliver) follow the FSM state
+// and posterior, i.e. the decision config itself. Other modes return false
+// with `err` set and the columns left empty.
+inline bool extractFeatures(const Night& n, const st::SleepPipelineConfig& cfg, FeatureColumns& out,
+                            std::string& err) {
+  out.clear();
+  if (cfg.duty != st::DutyMode::Every) {
+    err = "sweep: only DutyMode::Every can be swept (Switch / Adaptive pacing depends on the decision config)";
+    return false;
+  }
+  st::SleepFrontEnd fe(cfg);
+  st::SleepFeatures f;
+  for (const auto& e : n.events) {
+    bool tick = e.kind == 0 ? fe.pushHR(e.t, e.value, f) : fe.pushStillness(e.t, e.value, f);
+    if (tick) out.push(f);
+    while (fe.nextFrame(f)) out.push(f);
+  }
+  return true;
+}
+
+// One point of the sweep. Defaults reproduce SleepPipelineConfig{} and the
+// constants inside st::fuseFeatures / HMM3::setDefault.
+struct DecisionParams {
+  double kfQ{0.01}, kfR{0.10};
+  std::array<double, 5> w{0.35, 0.30, 0.15, 0.10, 0.10};   // drop, still, negSlope, respQuiet, vlf
+  double dropThreshold{-0.12};
+  double minDrowsySeconds{180};
+  double minStillScore{0.80};
+  bool   requireNegativeSlope{true};
+  double assistAsleep{0.85};
+  int    confirmTicks{2};
+  std::array<double, 3> pi{0.7, 0.2, 0.1};
+  std::array<double, 9> A{0.85, 0.12, 0.03, 0.10, 0.80, 0.10, 0.03, 0.12, 0.85};
+  std::array<double, 9> E{0.92, 0.06, 0.02, 0.08, 0.86, 0.06, 0.02, 0.08, 0.90};
+
+  static DecisionParams from(const st::SleepPipelineConfig& c) {
+    DecisionParams d;
+    d.kfQ = c.kfQ; d.kfR = c.kfR;
+    d.dropThreshold = c.fsm.dropThreshold;
+    d.minDrowsySeconds = c.fsm.minDrowsySeconds;
+    d.minStillScore = c.fsm.minStillScore;
+    d.requireNegativeSlope = c.fsm.requireNegativeSlope;
+    d.assistAsleep = c.assistAsleep;
+    d.confirmTicks = c.asleepConfirmTicks;
+    return d;
+  }
+
+  // Scale every off-diagonal probability by k and renormalise the diagonal.
+  // k == 1 leaves the matrix untouched (bit-exact defaults).
+  static void scaleOffDiagonal(std::array<double, 9>& M, double k) {
+    if (k == 1.0) return;
+    for (int i = 0; i < 3; ++i) {
+      double off = 0;
+      for (int j = 0; j < 3; ++j) if (i != j) off += (M[i * 3 + j] *= k);
+      M[i * 3 + i] = std::max(0.0, 1.0 - off);
+    }
+  }
+};
+
+// Structure-of-arrays view of a config batch plus its running state.
+class DecisionBatch {
+public:
+  explicit DecisionBatch(const std::vector<DecisionParams>& ps) { load(ps); }
+
+  size_t size() const { return n_; }
+
+  // Evaluates every config over the night, overwriting onset[0..size());
+  // onset[c] is NaN when config c never confirms sleep.
+  ST_SWEEP_CLONES void run(const FeatureColumns& fc, double* onset) {
+    reset();
+    const size_t T = fc.size(), C = n_;
+    std::fill(onset, onset + C, (double)NAN);
+    const double LOG0 = st::HMM3::LOG0;
+    auto clip = [](double v) { return v < 0 ? 0 : (v > 1 ? 1 : v); };
+
+    // Every per-config column is double (state codes and flags included) so
+    // the config loop is a single-width select chain the compiler vectorises.
+    double* __restrict x = x_.data();
+    double* __restrict P = P_.data();
+    double* __restrict fsm = fsm_.data();
+    double* __restrict since = since_.data();
+    double* __restrict d0 = ld_[0].data();
+    double* __restrict d1 = ld_[1].data();
+    double* __restrict d2 = ld_[2].data();
+    double* __restrict stable = stable_.data();
+    double* __restrict done = done_.data();
+    double* __restrict out = onset;
+    const double* __restrict q = q_.data();
+    const double* __restrict r = r_.data();
+    const double* __restrict w0 = w_[0].data();
+    const double* __restrict w1 = w_[1].data();
+    const double* __restrict w2 = w_[2].data();
+    const double* __restrict w3 = w_[3].data();
+    const double* __restrict w4 = w_[4].data();
+    const double* __restrict dtv = dt_.data();
+    const double* __restrict mdv = md_.data();
+    const double* __restrict msv = ms_.data();
+    const double* __restrict reqNeg = reqNeg_.data();
+    const double* __restrict aA = aA_.data();
+    const double* __restrict confirm = confirm_.data();
+    const double* __restrict A[9];
+    const double* __restrict E[9];
+    for (int i = 0; i < 9; ++i) { A[i] = lA_[i].data(); E[i] = lE_[i].data(); }
+
+    for (size_t k = 0; k < T; ++k) {
+      // Stop early once every config has confirmed (checked every 64 ticks
+      // so the config loop stays reduction-free).
+      if ((k & 63) == 0 && k && std::find(done, done + C, 0.0) == done + C) break;
+      const double now = fc.t[k], drop = fc.drop[k], slope = fc.slope[k], still = fc.still[k];
+      const double cDrop = clip(drop), cStill = clip(still), cNeg = clip(fc.negSlope[k]);
+      const double cResp = clip(fc.respQuiet[k]), cVlf = clip(fc.vlf[k]);
+      const double slopeNeg = slope < 0 ? 1.0 : 0.0;
+
+      ST_SWEEP_IVDEP
+      for (size_t c = 0; c < C; ++c) {
+        // fuseFeatures + KF1::update
+        const double z = w0[c] * cDrop + w1[c] * cStill + w2[c] * cNeg + w3[c] * cResp + w4[c] * cVlf;
+        const double p = P[c] + q[c];
+        const double K = p / (p + r[c]);
+        double xc = x[c] + K * (z - x[c]);
+        P[c] = (1.0 - K) * p;
+        xc = xc < 0 ? 0 : xc;
+        xc = xc > 1 ? 1 : xc;
+        x[c] = xc;
+
+        // SleepFSM::ingest
+        const double st0 = fsm[c], dt = dtv[c], ms = msv[c];
+        const double sn = since[c];
+        const bool toDrowsy = (st0 == 0) & (drop <= dt * 0.5) & (still >= ms * 0.7);
+        const bool drowsy = st0 == 1;
+        const bool slopeOK = slopeNeg + (1.0 - reqNeg[c]) > 0;
+        const bool toAsleep = drowsy & (drop <= dt) & (still >= ms) & slopeOK & ((now - sn) >= mdv[c]);
+        const bool revert = drowsy & ((still < ms * 0.5) | (drop > dt * 0.25));
+        double obs = toDrowsy ? 1 : st0;
+        obs = toAsleep ? 2 : obs;
+        obs = revert ? 0 : obs;
+        fsm[c] = obs;
+        since[c] = toDrowsy ? now : sn;   // only read while drowsy
+
+        // HMM3::step
+        const double a0 = d0[c], a1 = d1[c], a2 = d2[c];
+        double nx[3];
+        for (int j = 0; j < 3; ++j) {
+          double best = LOG0, v;
+          v = a0 + A[0 * 3 + j][c]; best = v > best ? v : best;
+          v = a1 + A[1 * 3 + j][c]; best = v > best ? v : best;
+          v = a2 + A[2 * 3 + j][c]; best = v > best ? v : best;
+          const double e0 = E[0 * 3 + j][c], e1 = E[1 * 3 + j][c], e2 = E[2 * 3 + j][c];
+          nx[j] = best + (obs == 0 ? e0 : (obs == 1 ? e1 : e2));
+        }
+        d0[c] = nx[0]; d1[c] = nx[1]; d2[c] = nx[2];
+        // argmax with HMM3's tie-breaking, kept as flags rather than a state code
+        const bool awake0 = (nx[0] >= nx[1]) & (nx[0] >= nx[2]);
+        const bool hmmDrowsy = !awake0 & (nx[1] >= nx[2]);
+        const bool hmmAsleep = !awake0 & !(nx[1] >= nx[2]);
+
+        // Propensity assist + confirm ticks. Only "asleep or not" feeds the
+        // confirm counter, so the assist-awake rule (drowsy -> awake) cannot
+        // move an onset and is not evaluated here.
+        const double asleep = (hmmAsleep | (hmmDrowsy & (xc > aA[c]))) ? 1.0 : 0.0;
+        const double stab = (stable[c] + 1) * asleep;
+        stable[c] = stab;
+        const double fire = ((done[c] == 0) & (stab >= confirm[c])) ? asleep : 0.0;
+        const double prev = out[c];
+        out[c] = fire != 0 ? now : prev;
+        done[c] += fire;
+      }
+    }
+  }
+
+private:
+  void load(const std::vector<DecisionParams>& ps) {
+    n_ = ps.size();
+    auto col = [&](std::vector<double>& v, auto get) {
+      v.resize(n_);
+      for (size_t c = 0; c < n_; ++c) v[c] = get(ps[c]);
+    };
+    col(q_, [](const DecisionParams& d) { return d.kfQ; });
+    col(r_, [](const DecisionParams& d) { return d.kfR; });
+    for (int i = 0; i < 5; ++i) col(w_[i], [i](const DecisionParams& d) { return d.w[i]; });
+    col(dt_, [](const DecisionParams& d) { return d.dropThreshold; });
+    col(md_, [](const DecisionParams& d) { return d.minDrowsySeconds; });
+    col(ms_, [](const DecisionParams& d) { return d.minStillScore; });
+    col(aA_, [](const DecisionParams& d) { return d.assistAsleep; });
+    for (int i = 0; i < 3; ++i) col(lPi_[i], [i](const DecisionParams& d) { return st::HMM3::lg(d.pi[i]); });
+    for (int i = 0; i < 9; ++i) {
+      col(lA_[i], [i](const DecisionParams& d) { return st::HMM3::lg(d.A[i]); });
+      col(lE_[i], [i](const DecisionParams& d) { return st::HMM3::lg(d.E[i]); });
+    }
+    col(reqNeg_, [](const DecisionParams& d) { return d.requireNegativeSlope ? 1.0 : 0.0; });
+    col(confirm_, [](const DecisionParams& d) { return (double)d.confirmTicks; });
+    x_.resize(n_); P_.resize(n_); fsm_.resize(n_); since_.resize(n_);
+    for (auto& v : ld_) v.resize(n_);
+    stable_.resize(n_); done_.resize(n_);
+  }
+
+  void reset() {
+    std::fill(x_.begin(), x_.end(), 0.0);
+    std::fill(P_.begin(), P_.end(), 1.0);
+    std::fill(fsm_.begin(), fsm_.end(), 0.0);
+    std::fill(since_.begin(), since_.end(), 0.0);
+    for (int i = 0; i < 3; ++i) ld_[i] = lPi_[i];
+    std::fill(stable_.begin(), stable_.end(), 0.0);
+    std::fill(done_.begin(), done_.end(), 0.0);
+  }
+
+  size_t n_{0};
+  // parameters
+  std::vector<double> q_, r_, w_[5], dt_, md_, ms_, aA_, reqNeg_, confirm_;
+  std::vector<double> lPi_[3], lA_[9], lE_[9];
+  // state
+  std::vector<double> x_, P_, fsm_, since_, ld_[3], stable_, done_;
+};
+
+// Per-config aggregate over a set of nights.
+struct SweepScore {
+  size_t nights{0}, labelled{0}, detected{0}, falseTriggers{0}, missed{0}, onTime{0};
+  double sumLatency{0}, sumAbsLatency{0};   // over on-time detections, seconds
+
+  double meanLatency() const    { return onTime ? sumLatency / (double)onTime : NAN; }
+  double meanAbsLatency() const { return onTime ? sumAbsLatency / (double)onTime : NAN; }
+
+  // An onset more than falseMargin seconds before the label is a false trigger.
+  void add(double onset, double label, double falseMargin) {
+    ++nights;
+    const bool hit = !std::isnan(onset);
+    detected += hit;
+    if (std::isnan(label)) return;
+    ++labelled;
+    if (!hit) { ++missed; return; }
+    const double lat = onset - label;
+    if (lat < -falseMargin) { ++falseTriggers; return; }
+    ++onTime;
+    sumLatency += lat;
+    sumAbsLatency += std::fabs(lat);
+  }
+};
+
+} // namespace stbench
@@ -0,0 +1,145 @@
+//
+//  work_steal_pool.cpp
+//  SleepTrigger Tools
+//
+
+#include "work_steal_pool.hpp"
+
+#include <algorithm>
+
+namespace stbench {
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned i = 0; i < threads; ++i) queues_.push_back(std::make_unique<Queue>());
+  for (unsigned i = 1; i < threads; ++i) threads_.emplace_back([this, i] { workerMain(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& t : threads_) t.join();
+}
+
+void WorkStealingPool::parallelFor(size_t n, const Body& fn, size_t grain) {
+  if (n == 0) return;
+  const unsigned w = size();
+  body_ = &fn;
+  grain_ = grain ? grain : 1;
+  remaining_.store(n, std::memory_order_relaxed);
+  steals_.store(0, std::memory_order_relaxed);
+  failed_.store(false, std::memory_order_relaxed);
+
+  // Contiguous initial shards keep neighbouring nights on one core.
+  for (unsigned i = 0; i < w; ++i) {
+    size_t b = n * i / w, e = n * (i + 1) / w;
+    if (b < e) queues_[i]->q.push_back({b, e});
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    ++generation_;
+    busy_ = (unsigned)threads_.size();
+  }
+  wake_.notify_all();
+
+  runJob(0);
+
+  std::exception_ptr err;
+  {
+    std::unique_lock<std::mutex> lk(m_);
+    done_.wait(lk, [&] { return busy_ == 0; });
+    body_ = nullptr;
+    std::swap(err, error_);
+  }
+  if (err) std::rethrow_exception(err);
+}
+
+void WorkStealingPool::workerMain(unsigned id) {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lk(m_);
+      wake_.wait(lk, [&] { return stop_ || generation_ != seen; });
+      if (stop_) return;
+      seen = generation_;
+    }
+    runJob(id);
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      if (--busy_ == 0) done_.notify_one();
+    }
+  }
+}
+
+void WorkStealingPool::runJob(unsigned id) {
+  Range r;
+  for (;;) {
+    // Read the counter before looking for work, so a finish or split that
+    // happens in between makes the wait below return at once.
+    const uint32_t seen = progress_.load(std::memory_order_acquire);
+    if (remaining_.load(std::memory_order_acquire) == 0) return;
+    if (!popLocal(id, r) && !steal(id, r)) {
+      progress_.wait(seen, std::memory_order_acquire);
+      continue;
+    }
+    try {
+      for (size_t i = r.begin; i < r.end && !failed_.load(std::memory_order_relaxed); ++i) (*body_)(i, id);
+    } catch (...) {
+      std::lock_guard<std::mutex> lk(m_);
+      if (!error_) error_ = std::current_exception();
+      failed_.store(true, std::memory_order_relaxed);
+    }
+    // The whole range counts as done even if it was cut short.
+    remaining_.fetch_sub(r.end - r.begin, std::memory_order_acq_rel);
+    progress_.fetch_add(1, std::memory_order_release);
+    progress_.notify_all();
+  }
+}
+
+// Owner end: take the back range and halve it until it is within grain,
+// leaving the upper halves behind for thieves.
+bool WorkStealingPool::popLocal(unsigned id, Range& r) {
+  Queue& q = *queues_[id];
+  std::lock_guard<std::mutex> lk(q.m);
+  if (q.q.empty()) return false;
+  r = q.q.back();
+  q.q.pop_back();
+  bool split = false;
+  while (r.end - r.begin > grain_) {
+    size_t mid = r.begin + (r.end - r.begin) / 2;
+    q.q.push_back({mid, r.end});
+    r.end = mid;
+    split = true;
+  }
+  if (split) {
+    progress_.fetch_add(1, std::memory_order_release);
+    progress_.notify_all();
+  }
+  return true;
+}
+
+// Thief end: the front range is the oldest and therefore the largest.
+bool WorkStealingPool::steal(unsigned id, Range& r) {
+  const unsigned w = size();
+  for (unsigned k = 1; k < w; ++k) {
+    Queue& q = *queues_[(id + k) % w];
+    std::lock_guard<std::mutex> lk(q.m);
+    if (q.q.empty()) continue;
+    r = q.q.front();
+    q.q.pop_front();
+    if (r.end - r.begin > grain_) {
+      size_t mid = r.begin + (r.end - r.begin) / 2;
+      q.q.push_front({mid, r.end});
+      r.end = mid;
+    }
+    steals_.fetch_add(r.end - r.begin, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+} // namespace stbench
@@ -0,0 +1,86 @@
+//
+//  work_steal_pool.hpp
+//  SleepTrigger Tools
+//
+//  Fixed-size thread pool with per-worker range deques and stealing, for
+//  batch jobs whose items (nights) vary a lot in cost.
+//
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace stbench {
+
+// parallelFor(n, fn) runs fn(i, worker) once for every i in [0, n).
+// Each worker starts with a contiguous shard of the index space and splits
+// it lazily (owner pops the back half-by-half); idle workers steal the
+// largest pending range from the front of a victim's deque. The calling
+// thread takes part as worker 0, so a pool of size 1 spawns no threads.
+//
+// Scheduling is nondeterministic; callers get deterministic output by
+// writing results into slot i rather than appending.
+//
+// Workers with nothing to pop or steal block on a progress counter that
+// moves whenever a range finishes or is split, so idle cores do not spin.
+// If fn throws, the indices not yet started are skipped and the first
+// exception is rethrown from parallelFor once every worker has stopped;
+// the pool stays usable.
+class WorkStealingPool {
+public:
+  using Body = std::function<void(size_t index, unsigned worker)>;
+
+  explicit WorkStealingPool(unsigned threads = 0);   // 0 = hardware_concurrency
+  ~WorkStealingPool();
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  unsigned size() const { return (unsigned)queues_.size(); }
+
+  // Blocks until every index has run. `grain` is the smallest range a
+  // worker executes without splitting further. Not reentrant.
+  void parallelFor(size_t n, const Body& fn, size_t grain = 1);
+
+  // Items taken from another worker's deque during the last parallelFor.
+  size_t lastSteals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+  struct Range { size_t begin, end; };
+  struct alignas(64) Queue {
+    std::mutex m;
+    std::deque<Range> q;
+  };
+
+  void workerMain(unsigned id);
+  void runJob(unsigned id);
+  bool popLocal(unsigned id, Range& r);
+  bool steal(unsigned id, Range& r);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+
+  std::mutex m_;
+  std::condition_variable wake_, done_;
+  uint64_t generation_{0};
+  unsigned busy_{0};          // helper threads still inside the current job
+  bool stop_{false};
+
+  const Body* body_{nullptr};
+  size_t grain_{1};
+  std::atomic<size_t> remaining_{0};
+  std::atomic<size_t> steals_{0};
+  std::atomic<uint32_t> progress_{0};  // bumped on every finish / split
+  std::atomic<bool> failed_{false};    // fn threw: skip what is left
+  std::exception_ptr error_;           // first exception, guarded by m_
+};
+
+} // namespace stbench
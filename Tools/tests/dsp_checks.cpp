@@ -0,0 +1,1928 @@
+//
+//  dsp_checks.cpp
+//  SleepTrigger Tools
+//
+//  Equivalence checks for the DSP core: every optimised path is compared
+//  against a straightforward reference on a deterministic synthetic signal.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C" {
+#include "robust_stats.h"
+#include "signal_filter.h"
+#include "respiration.h"
+#include "spectral.h"
+#include "ring_buffer.h"
+#include "kalman.h"
+#include "filter_bank.h"
+#include "vec_kernels.h"
+#include "ringlog.h"
+#include "export_stream.h"
+#include "nightlog.h"
+#include "time_window.h"
+#include "sample_queue.h"
+#include "frame_align.h"
+#include "duty_control.h"
+#include "tinyml_motion.h"
+#include "simple_sleep.h"
+#include "window_features.h"
+}
+#include "batch.hpp"
+#include "hmm_offline.hpp"
+#include "sweep.hpp"
+#include "ring.hpp"
+#include "decimate.hpp"
+#include "sos.hpp"
+#include "precision.hpp"
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond, ...)                                              \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      ++g_failures;                                                   \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed: ", __FILE__,     \
+                   __LINE__, #cond);                                  \
+      std::fprintf(stderr, __VA_ARGS__);                              \
+      std::fputc('\n', stderr);                                       \
+    }                                                                 \
+  } while (0)
+
+struct Rng {
+  uint64_t s{0x243F6A8885A308D3ull};
+  double uniform() {
+    s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+    return (double)(s >> 11) * (1.0 / 9007199254740992.0);
+  }
+};
+
+std::vector<double> noisyHR(size_t n) {
+  std::vector<double> x(n);
+  Rng rng;
+  for (size_t i = 0; i < n; ++i) {
+    x[i] = 70.0 + 5.0 * std::sin(0.01 * (double)i) + std::floor((rng.uniform() - 0.5) * 8.0);
+    if (rng.uniform() < 0.03) x[i] += 45.0;   // spikes
+    if (rng.uniform() < 0.01) x[i] = 0.0;     // dropouts
+  }
+  return x;
+}
+
+// The original copy + double-qsort Hampel, kept as the reference.
+double hampelReference(std::vector<double>& ring, size_t& idx, size_t& filled,
+                       size_t size, double nsigma, double x) {
+  ring[idx] = x;
+  idx = (idx + 1) % size;
+  if (filled < size) filled++;
+  std::vector<double> tmp(ring.begin(), ring.begin() + (long)filled);
+  std::sort(tmp.begin(), tmp.end());
+  double median = tmp[filled / 2];
+  for (size_t i = 0; i < filled; ++i) tmp[i] = std::fabs(ring[i] - median);
+  std::sort(tmp.begin(), tmp.end());
+  double sigma = 1.4826 * tmp[filled / 2];
+  if (sigma <= 1e-9) return x;
+  return (std::fabs(x - median) > nsigma * sigma) ? median : x;
+}
+
+void checkHampel() {
+  const std::vector<double> x = noisyHR(20000);
+  for (int w : {3, 9, 15}) {
+    rs_hampel_t h; rs_hampel_init(&h, w, 3.0);
+    std::vector<double> ring(w, 0.0); size_t idx = 0, filled = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+      double got = rs_hampel_update(&h, x[i]);
+      double want = hampelReference(ring, idx, filled, (size_t)w, 3.0, x[i]);
+      CHECK(got == want, "rs_hampel w=%d i=%zu got %.17g want %.17g", w, i, got, want);
+      if (got != want) break;
+    }
+  }
+  for (int w : {3, 61, 301}) {
+    rs_hampelw_t h; CHECK(rs_hampelw_init(&h, w, 3.0) == 0, "init w=%d", w);
+    std::vector<double> ring(w, 0.0); size_t idx = 0, filled = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+      double got = rs_hampelw_update(&h, x[i]);
+      double want = hampelReference(ring, idx, filled, (size_t)w, 3.0, x[i]);
+      CHECK(got == want, "rs_hampelw w=%d i=%zu got %.17g want %.17g", w, i, got, want);
+      if (got != want) break;
+    }
+    rs_hampelw_free(&h);
+  }
+
+  // A NaN / inf passes through and leaves no trace: the window that follows
+  // matches a filter that never saw it.
+  {
+    const int w = 61;
+    rs_hampel_t a; rs_hampel_init(&a, 9, 3.0);
+    rs_hampelw_t b; rs_hampelw_init(&b, w, 3.0);
+    st::Hampel<double> c(9, 3.0);
+    std::vector<double> ra(9, 0.0), rb(w, 0.0); size_t ia = 0, fa = 0, ib = 0, fb = 0;
+    for (double v : {(double)NAN, (double)INFINITY, -(double)INFINITY}) {
+      const double ga = rs_hampel_update(&a, v), gb = rs_hampelw_update(&b, v), gc = c.update(v);
+      CHECK(std::memcmp(&ga, &v, sizeof v) == 0 && std::memcmp(&gb, &v, sizeof v) == 0 &&
+                std::memcmp(&gc, &v, sizeof v) == 0,
+            "hampel: non-finite %g not passed through", v);
+    }
+    for (size_t i = 0; i < (size_t)(2 * w); ++i) {
+      const double ga = rs_hampel_update(&a, x[i]), gb = rs_hampelw_update(&b, x[i]), gc = c.update(x[i]);
+      const double wa = hampelReference(ra, ia, fa, 9, 3.0, x[i]);
+      const double wb = hampelReference(rb, ib, fb, (size_t)w, 3.0, x[i]);
+      CHECK(ga == wa && gc == wa && gb == wb, "hampel after NaN i=%zu got %.17g/%.17g/%.17g want %.17g/%.17g",
+            i, ga, gc, gb, wa, wb);
+      if (ga != wa || gc != wa || gb != wb) break;
+    }
+    rs_hampelw_free(&b);
+  }
+}
+
+// Every *_process_block must reproduce the per-sample path bit for bit,
+// including across block boundaries of awkward sizes.
+void checkBlockApis() {
+  const std::vector<double> x = noisyHR(5000);
+  std::vector<double> t(x.size());
+  for (size_t i = 0; i < t.size(); ++i) t[i] = 0.1 * (double)i;
+  std::vector<float> xf(x.begin(), x.end());
+  const size_t chunks[] = {1, 7, 64, 1000};
+
+  {
+    iir1_t a, b; iir1_init(&a, 0.22f); iir1_init(&b, 0.22f);
+    std::vector<float> want(xf.size()), got(xf.size());
+    for (size_t i = 0; i < xf.size(); ++i) want[i] = iir1_update(&a, xf[i]);
+    for (size_t c : chunks) {
+      iir1_reset(&b);
+      for (size_t i = 0; i < xf.size(); i += c)
+        iir1_process_block(&b, xf.data() + i, got.data() + i, std::min(c, xf.size() - i));
+      CHECK(std::memcmp(want.data(), got.data(), want.size() * sizeof(float)) == 0,
+            "iir1 block chunk=%zu", c);
+    }
+  }
+  {
+    std::vector<double> want(x.size()), got(x.size());
+    resp_bpf_t a; resp_init(&a, 10.0, 0.1, 0.5);
+    for (size_t i = 0; i < x.size(); ++i) want[i] = resp_update(&a, x[i], t[i]);
+    for (size_t c : chunks) {
+      resp_bpf_t b; resp_init(&b, 10.0, 0.1, 0.5);
+      for (size_t i = 0; i < x.size(); i += c)
+        resp_process_block(&b, x.data() + i, t.data() + i, got.data() + i,
+                           std::min(c, x.size() - i));
+      CHECK(std::memcmp(want.data(), got.data(), want.size() * sizeof(double)) == 0 &&
+            resp_rate_bpm(&a) == resp_rate_bpm(&b), "resp block chunk=%zu", c);
+    }
+  }
+  {
+    goertzel_t a; goertzel_init(&a, 1.0, 0.2, 32);
+    for (double v : x) goertzel_push(&a, v);
+    double want = goertzel_power(&a);
+    for (size_t c : chunks) {
+      goertzel_t b; goertzel_init(&b, 1.0, 0.2, 32);
+      for (size_t i = 0; i < x.size(); i += c)
+        goertzel_push_block(&b, x.data() + i, std::min(c, x.size() - i));
+      CHECK(goertzel_power(&b) == want, "goertzel block chunk=%zu", c);
+    }
+  }
+  {
+    ringf_t a; ringf_init(&a, 60);
+    for (float v : xf) ringf_push(&a, v);
+    for (size_t c : chunks) {
+      ringf_t b; ringf_init(&b, 60);
+      for (size_t i = 0; i < xf.size(); i += c)
+        ringf_push_block(&b, xf.data() + i, std::min(c, xf.size() - i));
+      CHECK(ringf_mean(&a) == ringf_mean(&b) && a.head == b.head &&
+            std::memcmp(a.buf, b.buf, 60 * sizeof(float)) == 0, "ringf block chunk=%zu", c);
+      ringf_free(&b);
+    }
+    ringf_free(&a);
+  }
+  {
+    std::vector<double> want(x.size()), got(x.size());
+    Kalman1D a; std::memset(&a, 0, sizeof(a)); a.q = 0.02; a.r = 1.2;
+    for (size_t i = 0; i < x.size(); ++i) want[i] = kalman1d_update(&a, x[i]);
+    for (size_t c : chunks) {
+      Kalman1D b; std::memset(&b, 0, sizeof(b)); b.q = 0.02; b.r = 1.2;
+      for (size_t i = 0; i < x.size(); i += c)
+        kalman1d_process_block(&b, x.data() + i, got.data() + i, std::min(c, x.size() - i));
+      CHECK(std::memcmp(want.data(), got.data(), want.size() * sizeof(double)) == 0,
+            "kalman1d block chunk=%zu", c);
+    }
+  }
+  {
+    std::vector<double> want(x.size()), got(x.size());
+    rs_hampel_t a; rs_hampel_init(&a, 9, 3.0);
+    for (size_t i = 0; i < x.size(); ++i) want[i] = rs_hampel_update(&a, x[i]);
+    for (size_t c : chunks) {
+      rs_hampel_t b; rs_hampel_init(&b, 9, 3.0);
+      got = x;  // in place
+      for (size_t i = 0; i < x.size(); i += c)
+        rs_hampel_process_block(&b, got.data() + i, got.data() + i, std::min(c, x.size() - i));
+      CHECK(std::memcmp(want.data(), got.data(), want.size() * sizeof(double)) == 0 &&
+            b.last == x.back(), "hampel block chunk=%zu", c);
+    }
+  }
+}
+
+// The SoA banks must track per-channel scalar filters (SIMD lanes and the
+// scalar tail), each channel with its own coefficients.
+void checkFilterBank() {
+  const size_t C = 37, F = 3000;   // 37: exercises full tiles plus a tail
+  const std::vector<double> base = noisyHR(F + C);
+  std::vector<float> x(F * C), y(F * C);
+  for (size_t f = 0; f < F; ++f)
+    for (size_t c = 0; c < C; ++c) x[f * C + c] = (float)base[f + c] * (1.0f + 0.01f * (float)c);
+
+  fb_iir1_t bank; CHECK(fb_iir1_init(&bank, C, 0.2f) == 0, "fb_iir1_init");
+  std::vector<iir1_t> ref(C);
+  for (size_t c = 0; c < C; ++c) {
+    float a = 0.05f + 0.02f * (float)c;
+    iir1_init(&ref[c], a);
+    fb_iir1_set_alpha(&bank, c, a);
+  }
+  for (size_t f = 0; f < F; f += 250) fb_iir1_process(&bank, x.data() + f * C, y.data() + f * C, 250);
+  double worst = 0;
+  for (size_t f = 0; f < F; ++f)
+    for (size_t c = 0; c < C; ++c) {
+      float want = iir1_update(&ref[c], x[f * C + c]);
+      worst = std::max(worst, (double)std::fabs(want - y[f * C + c]) / std::max(1.0f, std::fabs(want)));
+    }
+  CHECK(worst < 1e-5, "fb_iir1 vs iir1_update rel err %.3g", worst);
+  fb_iir1_free(&bank);
+
+  fb_biquad_t bq; CHECK(fb_biquad_init(&bq, C) == 0, "fb_biquad_init");
+  std::vector<resp_bpf_t> rr(C);
+  for (size_t c = 0; c < C; ++c) {
+    resp_init(&rr[c], 10.0, 0.1 + 0.005 * (double)c, 0.5 + 0.01 * (double)c);
+    fb_biquad_set_from_resp(&bq, c, &rr[c]);
+  }
+  fb_biquad_process(&bq, x.data(), y.data(), F);
+  worst = 0;
+  double peak = 0;
+  for (size_t f = 0; f < F; ++f)
+    for (size_t c = 0; c < C; ++c) {
+      double want = resp_update(&rr[c], x[f * C + c], 0.1 * (double)f);
+      worst = std::max(worst, std::fabs(want - (double)y[f * C + c]));
+      peak = std::max(peak, std::fabs(want));
+    }
+  CHECK(worst < 1e-3 * peak, "fb_biquad vs resp_update err %.3g (peak %.3g)", worst, peak);
+  fb_biquad_free(&bq);
+}
+
+// Sliding DFT bins must equal a brute-force DFT of the current window at
+// any read point, and stay there over a long (≈12 h at 1 Hz) stream.
+void checkSlidingDft() {
+  const int N = 32;
+  sdft_bank_t s; sdft_init(&s, 1.0, N, 1200);
+  int bins[3] = {sdft_add_bin(&s, 0.03), sdft_add_bin(&s, 0.20), sdft_add_bin(&s, 0.40)};
+  const std::vector<double> x = noisyHR(43200);
+  std::vector<double> win;
+  for (size_t i = 0; i < x.size(); ++i) {
+    double v = x[i] / 100.0;
+    sdft_push(&s, v);
+    win.push_back(v);
+    if (win.size() > (size_t)N) win.erase(win.begin());
+    if (i % 997 != 0 && i + 1 != x.size()) continue;
+    for (int b : bins) {
+      int k = s.k[b];
+      double re = 0, im = 0;
+      size_t pad = N - win.size();   // zero-padded until the window fills
+      for (size_t m = 0; m < win.size(); ++m) {
+        double w = 2.0 * M_PI * (double)k * (double)(m + pad) / N;
+        re += win[m] * std::cos(w);
+        im -= win[m] * std::sin(w);
+      }
+      double want = (re * re + im * im) / N;
+      double got = sdft_bin_power(&s, b);
+      CHECK(std::fabs(got - want) <= 1e-9 * std::max(1.0, want),
+            "sdft bin k=%d at i=%zu got %.12g want %.12g", k, i, got, want);
+    }
+  }
+  CHECK(sdft_bin_freq(&s, bins[1]) == 6.0 / 32.0, "bin freq");
+  CHECK(sdft_band_power(&s, 0.0, 0.5) > sdft_bin_power(&s, bins[1]), "band power sums bins");
+}
+
+// Every kernel path the CPU supports must agree with a double-precision
+// reference, for lengths covering each unrolled loop and tail.
+void checkVecKernels() {
+  std::vector<float> a(1031), b(1031), y0(1031);
+  Rng rng;
+  for (size_t i = 0; i < a.size(); ++i) {
+    a[i] = (float)(rng.uniform() * 2.0 - 1.0);
+    b[i] = (float)(rng.uniform() * 2.0 - 1.0);
+    y0[i] = (float)(rng.uniform() * 2.0 - 1.0);
+  }
+  const vk_isa_t isas[] = {VK_ISA_SCALAR, VK_ISA_NEON, VK_ISA_SSE42, VK_ISA_AVX2, VK_ISA_AVX512};
+  const vk_isa_t detected = vk_active_isa();
+  for (vk_isa_t isa : isas) {
+    if (vk_select_isa(isa) != 0) continue;
+    const char* name = vk_isa_name(isa);
+    for (size_t n : {0, 1, 3, 4, 15, 16, 17, 31, 33, 64, 65, 100, 1031}) {
+      double dot = 0, sum = 0, sq = 0, lo = INFINITY, hi = -INFINITY;
+      for (size_t i = 0; i < n; ++i) {
+        dot += (double)a[i] * b[i]; sum += a[i]; sq += (double)a[i] * a[i];
+        lo = std::min(lo, (double)a[i]); hi = std::max(hi, (double)a[i]);
+      }
+      const double tol = 1e-5 * (double)(n + 1);
+      CHECK(std::fabs(vk_dot_f32(a.data(), b.data(), n) - dot) < tol, "%s dot n=%zu", name, n);
+      CHECK(std::fabs(vk_sum_f32(a.data(), n) - sum) < tol, "%s sum n=%zu", name, n);
+      CHECK(std::fabs(vk_sumsq_f32(a.data(), n) - sq) < tol, "%s sumsq n=%zu", name, n);
+      float mn, mx;
+      vk_minmax_f32(a.data(), n, &mn, &mx);
+      CHECK(mn == (float)lo && mx == (float)hi, "%s minmax n=%zu", name, n);
+
+      std::vector<float> y = y0, z = y0;
+      vk_axpy_f32(0.5f, a.data(), y.data(), n);
+      vk_axpby_f32(0.5f, a.data(), -2.0f, z.data(), n);
+      for (size_t i = 0; i < a.size(); ++i) {
+        float wy = i < n ? y0[i] + 0.5f * a[i] : y0[i];
+        float wz = i < n ? 0.5f * a[i] - 2.0f * y0[i] : y0[i];
+        CHECK(std::fabs(y[i] - wy) < 1e-6f && std::fabs(z[i] - wz) < 1e-6f,
+              "%s axpy/axpby n=%zu i=%zu", name, n, i);
+        if (std::fabs(y[i] - wy) >= 1e-6f) break;
+      }
+    }
+  }
+  vk_select_isa(detected);
+}
+
+// Replay must be deterministic, and the synthetic wind-down must trip the
+// detector on at least some nights close to the labelled onset.
+void checkSleepPipeline() {
+  int detected = 0;
+  for (uint64_t seed = 1; seed <= 8; ++seed) {
+    stbench::Night n = stbench::synthNight(seed);
+    st::SleepPipeline a, b;
+    std::vector<st::SleepTick> ta, tb;
+    a.setTrace(&ta);
+    b.setTrace(&tb);
+    st::NightResult ra = st::replayNight(a, n.events.data(), n.events.size());
+    st::NightResult rb = st::replayNight(b, n.events.data(), n.events.size());
+    CHECK(ra.events == rb.events && ra.ticks == rb.ticks && ta.size() == tb.size(),
+          "replay seed=%llu not deterministic", (unsigned long long)seed);
+    bool same = ta.size() == tb.size();
+    for (size_t i = 0; same && i < ta.size(); ++i) {
+      const st::SleepTick &x = ta[i], &y = tb[i];
+      same = x.t == y.t && x.still == y.still && x.drop == y.drop && x.slope == y.slope &&
+             x.propensity == y.propensity && x.state == y.state &&
+             (x.hr == y.hr || (std::isnan(x.hr) && std::isnan(y.hr)));
+    }
+    CHECK(same, "replay seed=%llu trace differs", (unsigned long long)seed);
+    if (!std::isnan(ra.onset)) {
+      ++detected;
+      CHECK(std::fabs(ra.onset - n.labelOnset) < 15 * 60, "seed=%llu onset %.0f vs label %.0f",
+            (unsigned long long)seed, ra.onset, n.labelOnset);
+      CHECK(!a.running() && ra.events < n.events.size(), "seed=%llu pipeline kept running", (unsigned long long)seed);
+    }
+  }
+  CHECK(detected > 0, "no synthetic night reached onset");
+
+  // Restart after onset behaves like a fresh pipeline.
+  stbench::Night n = stbench::synthNight(4);
+  st::SleepPipeline p;
+  st::NightResult r1 = st::replayNight(p, n.events.data(), n.events.size());
+  p.start();
+  st::NightResult r2 = st::replayNight(p, n.events.data(), n.events.size());
+  CHECK((std::isnan(r1.onset) && std::isnan(r2.onset)) || r1.onset == r2.onset, "restart changed onset");
+}
+
+// Every index runs exactly once for any pool size/grain, and batch outcomes
+// do not depend on the worker count.
+void checkWorkStealingPool() {
+  for (unsigned threads : {1u, 2u, 5u}) {
+    stbench::WorkStealingPool pool(threads);
+    for (size_t n : {0, 1, 7, 1000}) {
+      for (size_t grain : {1, 16}) {
+        std::vector<std::atomic<int>> hits(n);
+        pool.parallelFor(n, [&](size_t i, unsigned w) {
+          if (w < threads) hits[i].fetch_add(1, std::memory_order_relaxed);
+        }, grain);
+        size_t bad = 0;
+        for (auto& h : hits) bad += h.load() != 1;
+        CHECK(bad == 0, "pool threads=%u n=%zu grain=%zu: %zu indices not run once", threads, n, grain, bad);
+      }
+    }
+    // A throwing body ends the job (no hang), the exception reaches the
+    // caller, and the pool runs the next job normally.
+    for (size_t at : {0, 500, 999}) {
+      std::atomic<size_t> ran{0};
+      bool caught = false;
+      try {
+        pool.parallelFor(1000, [&](size_t i, unsigned) {
+          if (i == at) throw std::runtime_error("boom");
+          ran.fetch_add(1, std::memory_order_relaxed);
+        });
+      } catch (const std::runtime_error& e) {
+        caught = std::strcmp(e.what(), "boom") == 0;
+      }
+      CHECK(caught && ran.load() < 1000, "pool threads=%u: throw at %zu not rethrown", threads, at);
+      std::atomic<size_t> after{0};
+      pool.parallelFor(100, [&](size_t, unsigned) { after.fetch_add(1, std::memory_order_relaxed); });
+      CHECK(after.load() == 100, "pool threads=%u unusable after a throw (%zu of 100)", threads, after.load());
+    }
+  }
+
+  std::vector<stbench::NightSource> src;
+  for (uint64_t s = 1; s <= 12; ++s) src.push_back({"", s, {}});
+  std::vector<stbench::NightOutcome> a, b;
+  stbench::WorkStealingPool p1(1), p3(3);
+  stbench::runBatch(p1, src, a);
+  stbench::runBatch(p3, src, b);
+  for (size_t i = 0; i < src.size(); ++i) {
+    const st::NightResult &x = a[i].result, &y = b[i].result;
+    CHECK(a[i].ok && b[i].ok && a[i].name == b[i].name && x.events == y.events && x.ticks == y.ticks &&
+          (x.onset == y.onset || (std::isnan(x.onset) && std::isnan(y.onset))) &&
+          x.summary.transitions == y.summary.transitions,
+          "batch night %zu differs between 1 and 3 workers", i);
+  }
+}
+
+// The batched decision stage must reproduce SleepPipeline onsets exactly for
+// every config a SleepPipelineConfig can express.
+void checkSweep() {
+  std::vector<st::SleepPipelineConfig> cfgs;
+  for (double q : {0.005, 0.01, 0.04})
+    for (double thr : {-0.08, -0.12})
+      for (int confirm : {1, 2, 4}) {
+        st::SleepPipelineConfig c;
+        c.kfQ = q; c.kfR = q * 12;
+        c.fsm.dropThreshold = thr;
+        c.fsm.minStillScore = confirm == 4 ? 0.7 : 0.8;
+        c.fsm.requireNegativeSlope = confirm != 2;
+        c.assistAsleep = q > 0.02 ? 0.6 : 0.85;
+        c.asleepConfirmTicks = confirm;
+        cfgs.push_back(c);
+      }
+  std::vector<stbench::DecisionParams> ps;
+  for (const auto& c : cfgs) ps.push_back(stbench::DecisionParams::from(c));
+  stbench::DecisionBatch batch(ps);
+  stbench::FeatureColumns fc;
+  std::vector<double> onset(ps.size());
+  size_t hits = 0;
+  for (uint64_t seed = 1; seed <= 6; ++seed) {
+    stbench::Night n = stbench::synthNight(seed);
+    std::string err;
+    CHECK(stbench::extractFeatures(n, st::SleepPipelineConfig{}, fc, err), "extractFeatures: %s", err.c_str());
+    batch.run(fc, onset.data());
+    for (size_t c = 0; c < cfgs.size(); ++c) {
+      st::SleepPipeline p(cfgs[c]);
+      st::NightResult r = st::replayNight(p, n.events.data(), n.events.size());
+      bool same = r.onset == onset[c] || (std::isnan(r.onset) && std::isnan(onset[c]));
+      hits += !std::isnan(r.onset);
+      CHECK(same, "sweep seed=%llu config=%zu onset %.1f vs pipeline %.1f",
+            (unsigned long long)seed, c, onset[c], r.onset);
+    }
+  }
+  CHECK(hits > 0, "sweep check never reached onset");
+
+  // Duty-paced configs skip ticks depending on the decision state, so the
+  // cached columns cannot stand in for them.
+  for (st::DutyMode m : {st::DutyMode::Switch, st::DutyMode::Adaptive}) {
+    st::SleepPipelineConfig c;
+    c.duty = m;
+    std::string err;
+    CHECK(!stbench::extractFeatures(stbench::synthNight(1), c, fc, err) && !err.empty() && fc.size() == 0,
+          "extractFeatures accepted duty mode %d", (int)m);
+  }
+
+  stbench::SweepScore sc;
+  sc.add(1000, 1200, 600);   // early but within margin
+  sc.add(100, 1200, 600);    // false trigger
+  sc.add(NAN, 1200, 600);    // miss
+  sc.add(1500, NAN, 600);    // unlabelled
+  CHECK(sc.nights == 4 && sc.detected == 3 && sc.falseTriggers == 1 && sc.missed == 1 &&
+        sc.meanLatency() == -200 && sc.meanAbsLatency() == 200, "SweepScore bookkeeping");
+}
+
+void checkRingLog() {
+  const char* dir = std::getenv("TMPDIR");
+  std::string path = std::string(dir && *dir ? dir : "/tmp") + "/st_checks_rlog.bin";
+  std::remove(path.c_str());
+  auto rec = [](int i) { return rlog_rec_t{(double)i, 60.0f + i % 7, 0.5f, 0.25f, (uint8_t)(i % 3)}; };
+
+  rlog_t r;
+  CHECK(rlog_open(&r, path.c_str(), 100) == 0, "rlog_open");
+  for (int i = 0; i < 30; ++i) rlog_write(&r, &(const rlog_rec_t&)rec(i));
+  rlog_close(&r);
+
+  // Reopen resumes instead of truncating; generation counts sessions.
+  CHECK(rlog_open(&r, path.c_str(), 100) == 0, "rlog reopen");
+  CHECK(rlog_count(&r) == 30 && r.hdr->generation == 2, "reopen lost position (count=%llu gen=%llu)",
+        (unsigned long long)rlog_count(&r), (unsigned long long)r.hdr->generation);
+  for (int i = 30; i < 170; ++i) rlog_write(&r, &(const rlog_rec_t&)rec(i));
+  std::vector<rlog_rec_t> blk;
+  for (int i = 170; i < 425; ++i) blk.push_back(rec(i));   // longer than capacity
+  rlog_write_block(&r, blk.data(), 55);
+  rlog_write_block(&r, blk.data() + 55, blk.size() - 55);
+
+  rlog_reader_t live;
+  rlog_reader_attach(&live, &r);
+  CHECK(rlog_reader_size(&live) == 99, "live reader size %zu", rlog_reader_size(&live));
+  rlog_close(&r);
+
+  // Torn write: bytes land in the next slot but count is never bumped.
+  {
+    FILE* f = std::fopen(path.c_str(), "r+b");
+    rlog_rec_t junk = rec(-1);
+    std::fseek(f, (long)(RLOG_HEADER_SIZE + (425 % 100) * sizeof(rlog_rec_t)), SEEK_SET);
+    std::fwrite(&junk, 1, 10, f);
+    std::fclose(f);
+  }
+
+  rlog_reader_t rd;
+  CHECK(rlog_reader_open(&rd, path.c_str()) == 0, "rlog_reader_open");
+  int want = 326, bad = 0;
+  for (const rlog_rec_t* p; (p = rlog_reader_next(&rd)); ++want) bad += p->t != (double)want;
+  CHECK(want == 425 && bad == 0, "reader order: ended at %d with %d mismatches", want, bad);
+  rlog_reader_close(&rd);
+
+  // A capacity change reformats; a foreign file is rejected by the reader.
+  CHECK(rlog_open(&r, path.c_str(), 50) == 0 && rlog_count(&r) == 0, "capacity change must reformat");
+  rlog_close(&r);
+  {
+    FILE* f = std::fopen(path.c_str(), "r+b");
+    std::fputc('X', f);
+    std::fclose(f);
+  }
+  CHECK(rlog_reader_open(&rd, path.c_str()) != 0, "reader accepted a bad magic");
+  std::remove(path.c_str());
+}
+
+std::string slurp(const std::string& path) {
+  std::ifstream f(path, std::ios::binary);
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+void checkExportStream() {
+  auto fmt = [](double v, int d) {
+    char b[ES_F64_MAX];
+    return std::string(b, es_format_f64(b, v, d));
+  };
+  struct { double v; int d; const char* want; } cases[] = {
+      {72.0, 3, "72"},          {0.25, 4, "0.25"},       {-1.5, 2, "-1.5"},
+      {0.9996, 3, "1"},         {-0.0001, 3, "0"},       {123.456789, 6, "123.456789"},
+      {0.1, 9, "0.1"},          {1755216000.125, 3, "1755216000.125"},
+      {1e300, 3, "1.0000000000000001e+300"},
+      {NAN, 3, "nan"},          {-INFINITY, 2, "-inf"},  {7.0, 0, "7"}};
+  for (auto& c : cases)
+    CHECK(fmt(c.v, c.d) == c.want, "es_format_f64(%.17g, %d) = '%s', want '%s'", c.v, c.d,
+          fmt(c.v, c.d).c_str(), c.want);
+
+  // Random values must round-trip to within half an ulp of the last digit.
+  Rng rng;
+  int bad = 0;
+  for (int i = 0; i < 20000; ++i) {
+    double v = (rng.uniform() - 0.5) * std::pow(10.0, (int)(rng.uniform() * 12) - 3);
+    int d = (int)(rng.uniform() * 10);
+    std::string s = fmt(v, d);
+    bad += std::fabs(std::strtod(s.c_str(), nullptr) - v) > 0.5 * std::pow(10.0, -d) * (1 + 1e-9) + std::fabs(v) * 1e-15;
+  }
+  CHECK(bad == 0, "es_format_f64 round-trip: %d mismatches", bad);
+
+  // ES_DEC_ROUNDTRIP: shortest text that reads back exactly.
+  struct { double v; const char* want; } rt[] = {
+      {0.1, "0.1"}, {1e-5, "1e-05"}, {0.1 + 0.2, "0.30000000000000004"},
+      {72.0, "72"}, {-0.0, "0"}, {1755216000.125, "1755216000.125"}};
+  for (auto& c : rt)
+    CHECK(fmt(c.v, ES_DEC_ROUNDTRIP) == c.want, "ES_DEC_ROUNDTRIP(%.17g) = '%s', want '%s'", c.v,
+          fmt(c.v, ES_DEC_ROUNDTRIP).c_str(), c.want);
+  bad = 0;
+  for (int i = 0; i < 20000; ++i) {
+    double v = (rng.uniform() - 0.5) * std::pow(10.0, (int)(rng.uniform() * 24) - 12);
+    std::string s = fmt(v, ES_DEC_ROUNDTRIP);
+    bad += std::strtod(s.c_str(), nullptr) != v || s.size() > ES_F64_MAX;
+  }
+  CHECK(bad == 0, "ES_DEC_ROUNDTRIP: %d values did not round-trip", bad);
+
+  const char* dir = std::getenv("TMPDIR");
+  const std::string base = std::string(dir && *dir ? dir : "/tmp");
+  const std::string csv = base + "/st_checks_export.csv";
+
+  // Tiny buffer so rows straddle flushes; nothing appears before close.
+  es_writer_t w;
+  CHECK(es_open(&w, csv.c_str(), 16) == 0, "es_open");
+  es_puts(&w, "date,count\n");
+  std::string want = "date,count\n";
+  struct { double t; const char* iso; } days[] = {
+      {0.0, "1970-01-01T00:00:00.000Z"},
+      {1755216000.0, "2025-08-15T00:00:00.000Z"},
+      {951782400.5, "2000-02-29T00:00:00.500Z"},
+      {-1.0, "1969-12-31T23:59:59.000Z"}};
+  for (int i = 0; i < 4; ++i) {
+    es_put_iso8601(&w, days[i].t);
+    es_putc(&w, ',');
+    es_put_i64(&w, i - 1);
+    es_putc(&w, '\n');
+    want += std::string(days[i].iso) + "," + std::to_string(i - 1) + "\n";
+  }
+  const double row[3] = {1.5, -2.25, 3};
+  const uint8_t dec[3] = {1, 2, 0};
+  es_csv_row_f64(&w, row, dec, 3);
+  want += "1.5,-2.25,3\n";
+  CHECK(std::ifstream(csv).good() == false, "es_open must write to a temp file until close");
+  CHECK(es_close(&w) == 0, "es_close");
+  CHECK(slurp(csv) == want, "export CSV mismatch:\n%s", slurp(csv).c_str());
+  std::remove(csv.c_str());
+
+  // Ring log -> CSV and binary.
+  const std::string ring = base + "/st_checks_export_rlog.bin";
+  const std::string bin = base + "/st_checks_export.stxb";
+  std::remove(ring.c_str());
+  rlog_t r;
+  CHECK(rlog_open(&r, ring.c_str(), 64) == 0, "rlog_open");
+  std::vector<rlog_rec_t> recs;
+  for (int i = 0; i < 100; ++i)
+    recs.push_back(rlog_rec_t{1000.0 + i * 0.5, 60.25f, 0.5f, 0.125f, (uint8_t)(i % 3)});
+  rlog_write_block(&r, recs.data(), recs.size());
+  rlog_close(&r);
+
+  rlog_reader_t rd;
+  CHECK(rlog_reader_open(&rd, ring.c_str()) == 0, "rlog_reader_open");
+  CHECK(es_open(&w, csv.c_str(), 0) == 0 && rlog_export_csv(&rd, &w) == 0 && es_close(&w) == 0,
+        "rlog_export_csv");
+  rlog_reader_close(&rd);
+  std::string text = slurp(csv);
+  CHECK(std::count(text.begin(), text.end(), '\n') == 64, "CSV should hold header + 63 rows");
+  CHECK(text.rfind("t,hr,still,prop,state\n1018.5,60.25,0.5,0.125,1\n", 0) == 0,
+        "rlog CSV head: %.60s", text.c_str());
+
+  CHECK(rlog_reader_open(&rd, ring.c_str()) == 0, "rlog_reader_open");
+  rlog_reader_next(&rd);                       // exports start at the cursor
+  CHECK(es_open(&w, bin.c_str(), 0) == 0 && rlog_export_bin(&rd, &w) == 0 && es_close(&w) == 0,
+        "rlog_export_bin");
+  rlog_reader_close(&rd);
+  std::string blob = slurp(bin);
+  const size_t hdr = 8 + (2 + 1) + (2 + 2) + (2 + 5) + (2 + 4) + (2 + 5);
+  CHECK(blob.size() == hdr + 62 * sizeof(rlog_rec_t) && blob.compare(0, 4, ES_BIN_MAGIC) == 0,
+        "binary export size %zu", blob.size());
+  if (blob.size() == hdr + 62 * sizeof(rlog_rec_t)) {
+    rlog_rec_t first;
+    std::memcpy(&first, blob.data() + hdr, sizeof first);
+    CHECK(first.t == 1019.0 && first.state == 2, "binary first record t=%g", first.t);
+  }
+  std::remove(csv.c_str());
+  std::remove(bin.c_str());
+  std::remove(ring.c_str());
+}
+
+// Night log round-trips within its quantisation, compresses a real replay
+// trace at least 5x, answers range queries and survives a torn tail.
+void checkNightLog() {
+  std::vector<rlog_rec_t> recs;
+  double t0 = 1755216000.0;
+  for (uint64_t seed = 1; seed <= 6; ++seed) {
+    stbench::Night n = stbench::synthNight(seed);
+    st::SleepPipeline p;
+    std::vector<st::SleepTick> trace;
+    p.setTrace(&trace);
+    st::replayNight(p, n.events.data(), n.events.size());
+    for (const st::SleepTick& k : trace)
+      recs.push_back(rlog_rec_t{t0 + k.t, k.hr, k.still, (float)k.propensity, (uint8_t)k.state});
+    t0 = recs.back().t + 3600.0;
+  }
+  recs[recs.size() / 2].still = NAN;
+
+  const char* dir = std::getenv("TMPDIR");
+  const std::string path = std::string(dir && *dir ? dir : "/tmp") + "/st_checks_nlog.bin";
+  std::remove(path.c_str());
+  nlog_writer_t w;
+  CHECK(nlog_writer_open(&w, path.c_str(), 512) == 0, "nlog_writer_open");
+  const size_t half = recs.size() / 3;
+  nlog_append(&w, recs.data(), half);
+  CHECK(nlog_writer_close(&w) == 0, "nlog_writer_close");
+  // Reopen appends after the existing blocks (the partial one included).
+  CHECK(nlog_writer_open(&w, path.c_str(), 0) == 0 && w.hdr.blockRecords == 512, "nlog reopen");
+  nlog_append(&w, recs.data() + half, recs.size() - half);
+  CHECK(nlog_writer_close(&w) == 0, "nlog_writer_close");
+
+  nlog_reader_t rd;
+  CHECK(nlog_reader_open(&rd, path.c_str()) == 0, "nlog_reader_open");
+  CHECK(rd.records == recs.size(), "nlog holds %llu of %zu records", (unsigned long long)rd.records, recs.size());
+  const double ratio = (double)(recs.size() * sizeof(rlog_rec_t)) / (double)rd.mapLen;
+  CHECK(ratio >= 5.0, "nlog compression %.2fx below 5x (%zu records)", ratio, recs.size());
+
+  std::vector<rlog_rec_t> all(recs.size());
+  size_t got = nlog_read_range(&rd, -INFINITY, INFINITY, all.data(), all.size());
+  CHECK(got == recs.size(), "full range returned %zu", got);
+  auto close = [](float a, float b, float step) {
+    return (std::isnan(a) && std::isnan(b)) || std::fabs(a - b) <= 0.5f * step + 1e-5f * std::fabs(b);
+  };
+  int bad = 0;
+  for (size_t i = 0; i < got; ++i) {
+    const rlog_rec_t &a = all[i], &b = recs[i];
+    bad += !(std::fabs(a.t - b.t) <= 0.0005 && close(a.hr, b.hr, 0.01f) &&
+             close(a.still, b.still, 1e-4f) && close(a.prop, b.prop, 1e-4f) && a.state == b.state);
+  }
+  CHECK(bad == 0, "nlog round-trip: %d records outside quantisation", bad);
+
+  // Range query matches a filter over the decoded log and skips blocks.
+  const double q0 = all[got / 4].t + 0.25, q1 = all[got / 4 + 700].t;
+  std::vector<rlog_rec_t> part(2000);
+  size_t np = nlog_read_range(&rd, q0, q1, part.data(), part.size());
+  size_t want = 0;
+  for (const rlog_rec_t& r : all) want += r.t >= q0 && r.t <= q1;
+  CHECK(np == want && np == 700 && part[0].t == all[got / 4 + 1].t, "range query %zu vs %zu", np, want);
+  const size_t b0 = nlog_find_block(&rd, q0);
+  CHECK(nlog_block(&rd, b0)->tMin <= q0 && nlog_block(&rd, b0)->tMax >= q0, "find_block");
+  const size_t lastBlock = rd.nblocks - 1;
+  const size_t fileLen = rd.mapLen;
+  const size_t lastOff = rd.offsets[lastBlock];
+  nlog_reader_close(&rd);
+
+  // Torn tail: the last block is cut short; readers and writers drop it.
+  CHECK(truncate(path.c_str(), (off_t)(fileLen - 5)) == 0, "truncate");
+  CHECK(nlog_reader_open(&rd, path.c_str()) == 0 && rd.nblocks == lastBlock, "torn block still indexed");
+  nlog_reader_close(&rd);
+  CHECK(nlog_writer_open(&w, path.c_str(), 0) == 0 && w.bytes == lastOff, "writer kept a torn tail");
+  nlog_writer_close(&w);
+  std::remove(path.c_str());
+}
+
+// HMM<3,3> reproduces HMM3's filtered path, the constexpr tables agree with
+// std::log, and FixedLagViterbi equals an offline traceback on each prefix.
+void checkGenericHmm() {
+  static_assert(st::kSleepHMM3Tables.logA[0] < 0 && st::kSleepHMM3Tables.logPi[2] < st::kSleepHMM3Tables.logPi[0]);
+  const auto rt = st::HMMLogTables<3, 3>::from(st::kSleepHMM3Model);
+  double worst = 0;
+  for (int i = 0; i < 9; ++i) {
+    worst = std::max(worst, std::fabs(st::kSleepHMM3Tables.logA[i] - rt.logA[i]) / std::fabs(rt.logA[i]));
+    worst = std::max(worst, std::fabs(st::kSleepHMM3Tables.logE[i] - rt.logE[i]) / std::fabs(rt.logE[i]));
+  }
+  CHECK(worst < 1e-15, "constexpr log relative error %g", worst);
+
+  Rng rng;
+  std::vector<int> obs(4000);
+  int truth = 0;
+  for (int& o : obs) {
+    if (rng.uniform() < 0.01) truth = std::min(2, truth + 1);
+    o = rng.uniform() < 0.25 ? (int)(rng.uniform() * 3) : truth;   // noisy labels
+  }
+
+  st::HMM3 ref;
+  ref.setDefault();
+  st::HMM<3, 3> gen(rt);
+  int diff = 0;
+  for (int o : obs) diff += ref.step(o) != gen.step(o);
+  CHECK(diff == 0, "HMM<3,3> filtered path differs from HMM3 at %d steps", diff);
+
+  constexpr int L = 12;
+  st::FixedLagViterbi<3, 3, L> fl(st::kSleepHMM3Tables);
+  st::HMM<3, 3> off(st::kSleepHMM3Tables);
+  std::vector<std::array<uint8_t, 3>> psi(obs.size());
+  int bad = 0, flipsFiltered = 0, flipsSmoothed = 0, lastF = -1, lastS = -1;
+  for (size_t t = 0; t < obs.size(); ++t) {
+    int f = off.step(obs[t], psi[t].data());
+    int s = fl.step(obs[t]);
+    flipsFiltered += lastF >= 0 && f != lastF;
+    lastF = f;
+    if (t < (size_t)L) { bad += s != -1; continue; }
+    int r = f;
+    for (size_t k = t; k > t - L; --k) r = psi[k][r];
+    bad += s != r;
+    flipsSmoothed += lastS >= 0 && s != lastS;
+    lastS = s;
+  }
+  CHECK(bad == 0, "fixed-lag Viterbi disagrees with offline traceback at %d steps", bad);
+  CHECK(flipsSmoothed < flipsFiltered, "smoothing did not reduce flips (%d vs %d)", flipsSmoothed, flipsFiltered);
+
+  // Wider models compile and run through the same step.
+  st::HMMModel<6, 4> m6{};
+  for (int i = 0; i < 6; ++i) {
+    m6.pi[i] = 1.0 / 6;
+    for (int j = 0; j < 6; ++j) m6.A[i * 6 + j] = i == j ? 0.75 : 0.05;
+    for (int o = 0; o < 4; ++o) m6.E[o * 6 + i] = (o == i % 4) ? 0.7 : 0.1;
+  }
+  st::FixedLagViterbi<6, 4, 8> fl6;
+  fl6.setModel(m6);
+  int valid = 0;
+  for (int t = 0; t < 200; ++t) valid += (unsigned)fl6.step(t / 20 % 4) < 6u;
+  CHECK(valid == 200 - 8, "HMM<6,4> fixed-lag emitted %d states", valid);
+}
+
+// Checkpointed Viterbi equals a full-backpointer traceback; Baum-Welch
+// climbs monotonically, recovers a model it sampled from, and gives the
+// same bits for any worker count.
+void checkHmmOffline() {
+  const st::HMMModel<3, 3> truth{
+      {0.6, 0.3, 0.1},
+      {0.95, 0.04, 0.01, 0.03, 0.93, 0.04, 0.01, 0.04, 0.95},
+      {0.80, 0.15, 0.10, 0.15, 0.70, 0.15, 0.05, 0.15, 0.75}};
+  Rng rng;
+  auto draw = [&](const double* p, int n, int stride) {
+    double u = rng.uniform(), c = 0;
+    for (int k = 0; k < n - 1; ++k) if ((c += p[k * stride]) > u) return k;
+    return n - 1;
+  };
+  std::vector<stbench::ObsRuns> seqs(96);
+  std::vector<std::vector<uint8_t>> raw(seqs.size());
+  for (size_t s = 0; s < seqs.size(); ++s) {
+    int x = draw(truth.pi.data(), 3, 1);
+    for (size_t t = 0, T = 500 + 37 * s; t < T; ++t) {
+      x = draw(&truth.A[x * 3], 3, 1);
+      uint8_t o = (uint8_t)draw(&truth.E[x], 3, 3);
+      seqs[s].push(o);
+      raw[s].push_back(o);
+    }
+  }
+
+  const auto tables = st::HMMLogTables<3, 3>::from(truth);
+  stbench::ViterbiScratch<3> vs;
+  int bad = 0;
+  for (size_t s = 0; s < 8; ++s) {
+    const std::vector<uint8_t>& o = raw[s * 11];
+    st::HMM<3, 3> h(tables);
+    std::vector<std::array<uint8_t, 3>> psi(o.size());
+    for (size_t t = 0; t < o.size(); ++t) h.step(o[t], psi[t].data());
+    std::vector<uint8_t> full(o.size()), ck(o.size());
+    int st = h.best();
+    for (size_t t = o.size(); t-- > 0;) { full[t] = (uint8_t)st; st = psi[t][st]; }
+    stbench::viterbiCheckpointed(tables, o.data(), o.size(), ck.data(), vs);
+    bad += full != ck;
+  }
+  CHECK(bad == 0, "checkpointed Viterbi differs from full traceback on %d sequences", bad);
+  CHECK(vs.checkpoints.size() * 3 * sizeof(double) + vs.psi.size() < 4096, "Viterbi scratch not O(sqrt T)");
+
+  st::HMMModel<3, 3> start{
+      {1.0 / 3, 1.0 / 3, 1.0 / 3},
+      {0.8, 0.1, 0.1, 0.1, 0.8, 0.1, 0.1, 0.1, 0.8},
+      {0.6, 0.2, 0.2, 0.2, 0.6, 0.2, 0.2, 0.2, 0.6}};
+  stbench::BaumWelchOptions opt;
+  opt.maxIters = 60;
+  opt.tol = 1e-9;
+  opt.chunk = 7;
+  std::vector<stbench::BaumWelchIteration> hist;
+  stbench::WorkStealingPool one(1), three(3);
+  st::HMMModel<3, 3> a = stbench::baumWelch(one, seqs, start, opt, &hist);
+  st::HMMModel<3, 3> b = stbench::baumWelch(three, seqs, start, opt);
+  CHECK(a.A == b.A && a.E == b.E && a.pi == b.pi, "Baum-Welch depends on the worker count");
+  int drops = 0;
+  for (size_t k = 1; k < hist.size(); ++k) drops += hist[k].logLikPerTick < hist[k - 1].logLikPerTick - 1e-12;
+  CHECK(drops == 0 && hist.size() > 2, "Baum-Welch likelihood decreased %d times", drops);
+  double worst = 0;
+  for (int i = 0; i < 9; ++i) {
+    worst = std::max(worst, std::fabs(a.A[i] - truth.A[i]));
+    worst = std::max(worst, std::fabs(a.E[i] - truth.E[i]));
+  }
+  CHECK(worst < 0.05, "Baum-Welch recovery error %.3f", worst);
+}
+
+// KF<N,M> reduces to the scalar filters, the Cholesky update equals
+// sequential scalar updates for diagonal R, and the ready-made models track
+// what they claim to.
+void checkKalmanN() {
+  Rng rng;
+  {
+    Kalman1D a; kalman1d_init(&a, 0.02, 1.2, 65.0, 1.0);
+    st::KF<1, 1> b;
+    b.reset({65.0}, {1.0});
+    b.Q = {0.02}; b.H = {1.0}; b.R = {1.2};
+    double worst = 0;
+    for (int i = 0; i < 5000; ++i) {
+      const double z = 65.0 + 8.0 * (rng.uniform() - 0.5);
+      b.predict();
+      b.update({z});
+      worst = std::max(worst, std::fabs(kalman1d_update(&a, z) - b.x[0]));
+    }
+    CHECK(worst < 1e-12, "KF<1,1> vs kalman1d: %.3g", worst);
+  }
+  {
+    st::KF<3, 2> a;
+    a.F = {1, 1, 0,  0, 1, 0.1,  0, 0, 0.9};
+    a.Q = {0.01, 0, 0,  0, 0.02, 0,  0, 0, 0.03};
+    a.H = {1, 0, 0,  0.5, 0, 1};
+    a.R = {0.4, 0,  0, 0.7};
+    st::KF<3, 2> b = a;
+    double worst = 0;
+    for (int i = 0; i < 2000; ++i) {
+      const double z0 = rng.uniform() * 4, z1 = rng.uniform() * 2;
+      a.predict(); a.update({z0, z1});
+      b.predict();
+      b.updateScalar(&b.H[0], z0, b.R[0]);
+      b.updateScalar(&b.H[3], z1, b.R[3]);
+      for (int k = 0; k < 3; ++k) worst = std::max(worst, std::fabs(a.x[k] - b.x[k]));
+      for (int k = 0; k < 9; ++k) worst = std::max(worst, std::fabs(a.P[k] - b.P[k]));
+    }
+    CHECK(worst < 1e-9, "KF<3,2> joint vs sequential update: %.3g", worst);
+  }
+  {
+    // 70 bpm, then a -0.02 bpm/s ramp from t = 600 s, sampled at 1 Hz.
+    st::HRTrendKF kf;
+    double slope = 0, drop = 0;
+    for (int t = 0; t < 1200; ++t) {
+      const double hr = 70.0 - (t > 600 ? 0.02 * (t - 600) : 0.0) + 0.5 * (rng.uniform() - 0.5);
+      kf.ingest(hr, t);
+    }
+    CHECK(kf.slopeBPMPerSec(slope) && std::fabs(slope + 0.02) < 0.004, "HRTrendKF slope %.4f", slope);
+    CHECK(kf.dropFraction(drop) && drop < -0.05 && drop > -0.18, "HRTrendKF drop %.4f", drop);
+    CHECK(std::fabs(kf.level() - 58.0) < 1.0, "HRTrendKF level %.2f", kf.level());
+  }
+  {
+    st::KF1 a; a.set(0.01, 0.10, 0.0, 1.0);
+    st::PropensityKF b; b.rateNoise = 0; b.rate0 = 0; b.set(0.01, 0.10, 0.0, 1.0);
+    double worst = 0;
+    for (int i = 0; i < 5000; ++i) {
+      double f[5];
+      for (double& v : f) v = 1.4 * rng.uniform() - 0.2;
+      const double pa = a.update(st::fuseFeatures(f[0], f[1], f[2], f[3], f[4]));
+      worst = std::max(worst, std::fabs(pa - b.update(f[0], f[1], f[2], f[3], f[4])));
+    }
+    CHECK(worst < 1e-9, "PropensityKF without rate vs fuseFeatures+KF1: %.3g", worst);
+  }
+}
+
+// Shared-buffer time windows against a rescan of every sample, over irregular
+// spacing, bursts that force the buffer to grow, long gaps that empty it,
+// and enough samples for many re-centrings.
+void checkTimeWindow() {
+  const double horizons[3] = {90, 300, 1800};
+  tw_tracker_t w;
+  CHECK(tw_init(&w, horizons, 3, 16) == 0, "tw_init");
+  Rng rng;
+  std::vector<std::pair<double, double>> all;
+  double t = 7.0e8;   // large absolute times, as Date.timeIntervalSinceReferenceDate
+  int bad = 0;
+  for (int i = 0; i < 40000; ++i) {
+    const double u = rng.uniform();
+    t += u < 0.002 ? 4000.0 : (u < 0.05 ? 0.0 : 0.2 + 5.0 * rng.uniform());
+    const double x = 60.0 + 0.01 * (double)(i % 3000) + 3.0 * rng.uniform();
+    all.push_back({t, x});
+    tw_push(&w, t, x);
+    if (i % 37) continue;
+    for (int h = 0; h < 3; ++h) {
+      size_t n = 0;
+      double st = 0, sx = 0;
+      for (size_t k = all.size(); k-- > 0 && all[k].first >= t - horizons[h];) {
+        ++n; st += all[k].first - t; sx += all[k].second;
+      }
+      double sxx = 0, sxy = 0;
+      for (size_t k = all.size() - n; k < all.size(); ++k) {
+        const double dt = all[k].first - t - st / (double)n;
+        sxx += dt * dt; sxy += dt * (all[k].second - sx / (double)n);
+      }
+      double mean = 0, slope = 0;
+      bad += tw_count(&w, h) != n;
+      bad += tw_mean(&w, h, &mean) != 0 || std::fabs(mean - sx / (double)n) > 1e-9;
+      const bool slopeOk = tw_slope(&w, h, &slope) == 0;
+      if (sxx > 1e-6) bad += !slopeOk || std::fabs(slope - sxy / sxx) > 1e-7 * (1 + std::fabs(sxy / sxx));
+      else            bad += slopeOk && n > 1 && sxx == 0;
+    }
+  }
+  CHECK(bad == 0, "time window vs rescan: %d mismatches", bad);
+  CHECK(w.cap >= 512, "time window buffer did not grow (cap %zu)", w.cap);
+
+  double before = 0, after = 0;
+  tw_mean(&w, 1, &before);
+  tw_set_horizon(&w, 1, 60);
+  tw_set_horizon(&w, 1, 300);
+  tw_mean(&w, 1, &after);
+  CHECK(std::fabs(before - after) < 1e-9, "tw_set_horizon round trip %.12f vs %.12f", before, after);
+  tw_clear(&w);
+  double d;
+  CHECK(tw_count(&w, 0) == 0 && tw_drop_fraction(&w, 1, &d) != 0, "tw_clear");
+
+  // Out-of-order delivery: late samples (up to ~40 min) land by time, and
+  // windows are measured from the newest time seen.
+  all.clear();
+  double newest = t;
+  int dropped = 0, late = 0;
+  bad = 0;
+  for (int i = 0; i < 20000; ++i) {
+    const double u = rng.uniform();
+    double ts;
+    if (u < 0.1) { ts = newest - 2400.0 * rng.uniform() * rng.uniform(); ++late; }
+    else         { newest += 0.2 + 5.0 * rng.uniform(); ts = newest; }
+    const double x = 60.0 + 3.0 * rng.uniform();
+    const int rc = tw_push(&w, ts, x);
+    const bool behind = ts < newest - horizons[2];
+    bad += rc != (behind ? 1 : 0);
+    dropped += rc == 1;
+    all.push_back({ts, x});
+    if (i % 41) continue;
+    for (int h = 0; h < 3; ++h) {
+      size_t n = 0;
+      double sx = 0, st = 0, last = 0;
+      for (const auto& p : all)
+        if (p.first >= newest - horizons[h]) { ++n; sx += p.second; st += p.first - newest; }
+      for (const auto& p : all) if (p.first == newest) last = p.second;
+      double sxx = 0, sxy = 0;
+      for (const auto& p : all)
+        if (p.first >= newest - horizons[h]) {
+          const double dt = p.first - newest - st / (double)n;
+          sxx += dt * dt; sxy += dt * (p.second - sx / (double)n);
+        }
+      double mean = 0, slope = 0, latest = 0;
+      bad += tw_count(&w, h) != n;
+      bad += tw_mean(&w, h, &mean) != 0 || std::fabs(mean - sx / (double)n) > 1e-9;
+      bad += tw_latest(&w, &latest) != 0 || latest != last;
+      if (sxx > 1e-6) bad += tw_slope(&w, h, &slope) != 0 || std::fabs(slope - sxy / sxx) > 1e-7 * (1 + std::fabs(sxy / sxx));
+    }
+  }
+  CHECK(bad == 0 && late > 0 && dropped > 0, "time window out of order: %d mismatches (%d late, %d dropped)",
+        bad, late, dropped);
+  tw_free(&w);
+}
+
+// st::Ring against a plain copy of the window: stats, sliding min/max,
+// spans and the split dot product, across wrap, bulk pushes and clear().
+template <typename T, size_t N>
+void checkRingOne(const char* name) {
+  st::Ring<T, N> r;
+  std::vector<T> all;
+  Rng rng;
+  int bad = 0;
+  std::vector<float> w(N);
+  for (size_t k = 0; k < N; ++k) w[k] = (float)(rng.uniform() - 0.5);
+  for (int step = 0; step < 20000; ++step) {
+    const double u = rng.uniform();
+    if (u < 0.001) {
+      r.clear(); all.clear();
+    } else if (u < 0.02) {
+      std::vector<T> blk((size_t)(rng.uniform() * 3 * N));
+      for (T& v : blk) v = (T)(60 + 10 * rng.uniform());
+      r.push(blk.data(), blk.size());
+      all.insert(all.end(), blk.begin(), blk.end());
+    } else {
+      const T v = (T)(60 + 10 * rng.uniform() + (step % 500 < 50 ? 30 : 0));
+      r.push(v);
+      all.push_back(v);
+    }
+    const size_t n = std::min(all.size(), N);
+    bad += r.size() != n;
+    if (n == 0) continue;
+    const T* win = all.data() + all.size() - n;
+    double sum = 0;
+    for (size_t k = 0; k < n; ++k) sum += (double)win[k];
+    const double mean = sum / (double)n;
+    double ss = 0;
+    for (size_t k = 0; k < n; ++k) ss += ((double)win[k] - mean) * ((double)win[k] - mean);
+    const double var = n > 1 ? ss / (double)(n - 1) : 0.0;
+    bad += std::fabs(r.mean() - mean) > 1e-9 * std::fabs(mean);
+    bad += std::fabs(r.variance() - var) > 1e-7 * (1 + var);
+    bad += r.min() != *std::min_element(win, win + n) || r.max() != *std::max_element(win, win + n);
+    bad += r[0] != win[0] || r.back() != win[n - 1];
+    std::vector<T> flat(n);
+    r.copyTo(flat.data());
+    bad += !std::equal(flat.begin(), flat.end(), win);
+    if constexpr (std::is_same_v<T, float>) {
+      double d = 0;
+      for (size_t k = 0; k < n; ++k) d += (double)win[k] * (double)w[k];
+      bad += std::fabs(st::dot(r, w.data()) - d) > 1e-4 * (1 + std::fabs(d));
+    }
+  }
+  CHECK(bad == 0, "%s: %d mismatches against the reference window", name, bad);
+}
+
+void checkRing() {
+  checkRingOne<float, 64>("Ring<float,64>");
+  checkRingOne<double, 16>("Ring<double,16>");
+
+  // A night at 1 Hz: the resynced sums stay exact where ringf's float sum drifts.
+  st::Ring<float, 64> r;
+  Rng rng;
+  for (int i = 0; i < 200000; ++i) r.push((float)(55 + 20 * rng.uniform()));
+  double sum = 0;
+  for (size_t k = 0; k < r.size(); ++k) sum += r[k];
+  CHECK(std::fabs(r.mean() - sum / 64.0) < 1e-10, "Ring mean drifted: %.12f vs %.12f", r.mean(), sum / 64.0);
+}
+
+// SPSC queue: capacity/drop accounting, then a producer and a consumer
+// thread moving samples through a small ring (so it wraps and fills
+// constantly) in order and without loss. Seqlock: readers never see a torn
+// snapshot while a writer thread keeps rewriting it.
+void checkSampleQueue() {
+  {
+    sq_queue_t* q = sq_queue_create(10);
+    CHECK(q && sq_queue_capacity(q) == 16, "sq capacity");
+    sq_sample_t s{0, 0, SQ_HEART_RATE, 0}, out[32];
+    int pushed = 0;
+    for (int i = 0; i < 20; ++i) { s.t = i; pushed += sq_push(q, &s) == 0; }
+    CHECK(pushed == 16 && sq_dropped(q) == 4 && sq_size(q) == 16, "sq full: pushed %d dropped %llu",
+          pushed, (unsigned long long)sq_dropped(q));
+    size_t n = sq_pop_batch(q, out, 5);
+    n += sq_pop_batch(q, out + n, 32);
+    bool ordered = n == 16;
+    for (size_t i = 0; i < n; ++i) ordered &= out[i].t == (double)i;
+    CHECK(ordered && sq_pop_batch(q, out, 32) == 0, "sq pop order");
+    sq_queue_destroy(q);
+  }
+  {
+    const uint64_t kN = 300000;
+    sq_queue_t* q = sq_queue_create(64);
+    std::thread producer([q, kN] {
+      for (uint64_t i = 0; i < kN; ++i) {
+        sq_sample_t s{(double)i, (double)(i * 3), (int32_t)(i & 1), 0};
+        while (sq_push(q, &s) != 0) std::this_thread::yield();
+      }
+    });
+    uint64_t next = 0, bad = 0;
+    sq_sample_t buf[48];
+    while (next < kN) {
+      const size_t n = sq_pop_batch(q, buf, 1 + next % 48);
+      if (n == 0) { std::this_thread::yield(); continue; }
+      for (size_t i = 0; i < n; ++i, ++next)
+        bad += buf[i].t != (double)next || buf[i].value != (double)(next * 3) || buf[i].kind != (int32_t)(next & 1);
+    }
+    producer.join();
+    CHECK(bad == 0 && sq_size(q) == 0, "sq threaded: %llu bad samples", (unsigned long long)bad);
+    sq_queue_destroy(q);
+  }
+  {
+    struct Snap { uint64_t v[12]; };
+    sq_seqlock_t* l = sq_seqlock_create(sizeof(Snap));
+    CHECK(l && !sq_seqlock_create(SQ_SEQLOCK_MAX_BYTES + 1), "sq_seqlock_create");
+    std::atomic<bool> done{false};
+    std::thread writer([l, &done] {
+      Snap s;
+      for (uint64_t k = 1; k <= 200000; ++k) {
+        for (auto& w : s.v) w = k;
+        sq_seqlock_write(l, &s);
+        if (k % 64 == 0) std::this_thread::yield();
+      }
+      done = true;
+    });
+    uint64_t torn = 0, backwards = 0, last = 0, reads = 0;
+    while (!done.load()) {
+      Snap s;
+      const uint64_t gen = sq_seqlock_read(l, &s);
+      for (auto w : s.v) torn += w != s.v[0];
+      backwards += s.v[0] < last || gen != s.v[0];
+      last = s.v[0];
+      ++reads;
+      if (reads % 64 == 0) std::this_thread::yield();
+    }
+    writer.join();
+    Snap s;
+    CHECK(torn == 0 && backwards == 0 && sq_seqlock_read(l, &s) == 200000 && s.v[11] == 200000,
+          "seqlock: %llu torn, %llu out of order in %llu reads", (unsigned long long)torn,
+          (unsigned long long)backwards, (unsigned long long)reads);
+    sq_seqlock_destroy(l);
+  }
+}
+
+// Frame aligner: hold / linear values, staleness and grid placement on a
+// hand-built case, then the same random streams popped eagerly and lazily
+// must give identical frames, and the pipeline must tick on the grid only.
+void checkFrameAlign() {
+  fa_aligner_t a;
+  CHECK(fa_init(&a, 1.0, 1.0, 2) == 0, "fa_init");
+  fa_stream_config(&a, 0, FA_LINEAR, 3.0);
+  fa_stream_config(&a, 1, FA_HOLD, 3.0);
+  fa_frame_t fr;
+  fa_push(&a, 1, 0.2, 1.0);   // grid starts at 1.0
+  fa_push(&a, 0, 0.5, 10.0);
+  CHECK(fa_pop(&a, &fr) == 0, "frame released before lag");
+  fa_push(&a, 0, 2.5, 30.0);
+  CHECK(fa_pop(&a, &fr) == 1 && fr.t == 1.0 && fr.index == 0, "first frame at %.3f", fr.t);
+  CHECK(std::fabs(fr.value[0] - 15.0) < 1e-12 && (fr.flags[0] & FA_INTERPOLATED) && fr.count[0] == 1,
+        "linear value %.6f flags %d", fr.value[0], fr.flags[0]);
+  CHECK(fr.value[1] == 1.0 && std::fabs(fr.age[1] - 0.8) < 1e-12 && (fr.flags[1] & FA_FRESH) &&
+        !(fr.flags[1] & FA_STALE), "hold value %.3f age %.3f", fr.value[1], fr.age[1]);
+  CHECK(fa_pop(&a, &fr) == 0, "second frame released early");
+  CHECK(fa_push(&a, 0, 2.0, 0.0) == -1, "out-of-order sample accepted");
+  fa_advance(&a, 9.0);
+  int n = 0;
+  while (fa_pop(&a, &fr)) {
+    ++n;
+    CHECK(fr.t == 1.0 + (double)fr.index, "frame %llu off grid at %.3f", (unsigned long long)fr.index, fr.t);
+  }
+  CHECK(n == 7 && fr.t == 8.0, "advance released %d frames, last %.1f", n, fr.t);
+  CHECK((fr.flags[1] & FA_STALE) && !(fr.flags[1] & FA_FRESH) && fr.value[1] == 1.0, "hold stream not stale");
+  CHECK(fr.value[0] == 30.0 && !(fr.flags[0] & FA_INTERPOLATED), "linear past the end should hold");
+  fa_reset(&a);
+  CHECK(fa_pop(&a, &fr) == 0, "fa_reset left frames");
+
+  // Eager vs lazy popping.
+  std::vector<fa_frame_t> eager, lazy;
+  for (int pass = 0; pass < 2; ++pass) {
+    fa_aligner_t b;
+    fa_init(&b, 2.0, 5.0, 2);
+    fa_stream_config(&b, 0, FA_LINEAR, 15.0);
+    fa_stream_config(&b, 1, FA_HOLD, 15.0);
+    std::vector<fa_frame_t>& out = pass ? lazy : eager;
+    Rng rng;
+    double th = 1.0e9, ts = 1.0e9;
+    for (int i = 0; i < 20000; ++i) {
+      if (th <= ts) { fa_push(&b, 0, th, 60 + 10 * rng.uniform()); th += 1 + 4 * rng.uniform() + (rng.uniform() < 0.002 ? 60 : 0); }
+      else          { fa_push(&b, 1, ts, rng.uniform());           ts += 5; }
+      if (pass == 0 || i % 16 == 15)
+        while (fa_pop(&b, &fr)) out.push_back(fr);
+    }
+    while (fa_pop(&b, &fr)) out.push_back(fr);
+  }
+  bool same = eager.size() == lazy.size() && !eager.empty();
+  for (size_t i = 0; same && i < eager.size(); ++i)
+    same = eager[i].t == lazy[i].t && eager[i].index == lazy[i].index &&
+           std::memcmp(eager[i].value, lazy[i].value, sizeof fr.value) == 0 &&
+           std::memcmp(eager[i].age, lazy[i].age, sizeof fr.age) == 0 &&
+           std::memcmp(eager[i].count, lazy[i].count, sizeof fr.count) == 0 &&
+           std::memcmp(eager[i].flags, lazy[i].flags, sizeof fr.flags) == 0;
+  CHECK(same, "frames depend on pop timing (%zu vs %zu)", eager.size(), lazy.size());
+  size_t stale = 0;
+  for (const auto& f : eager) stale += (f.flags[0] & FA_STALE) != 0;
+  CHECK(stale > 0, "HR gaps never flagged stale");
+
+  // Pipeline: one tick per frame, on the grid, none from per-sample sinks.
+  stbench::Night night = stbench::synthNight(3);
+  st::SleepPipeline p;
+  std::vector<st::SleepTick> tr;
+  p.setTrace(&tr);
+  st::NightResult r = st::replayNight(p, night.events.data(), night.events.size());
+  const double period = p.config().framePeriod;
+  bool onGrid = !tr.empty();
+  for (size_t i = 0; onGrid && i < tr.size(); ++i)
+    onGrid = std::fmod(tr[i].t, period) == 0 && (i == 0 || tr[i].t == tr[i - 1].t + period);
+  CHECK(onGrid, "pipeline ticks off the frame grid");
+  const double span = night.events[r.events - 1].t - night.events[0].t;
+  CHECK((double)r.ticks <= span / period + 1, "%zu ticks for %.0f s of input", r.ticks, span);
+}
+
+// Duty scheduler: bounds, fast latch while drowsy, geometric back-off when
+// calm, hysteresis; then adaptive pacing on synthetic nights must find the
+// same onsets as evaluating every frame, within a couple of intervals, for
+// a fraction of the evaluations and sensor time.
+void checkDutySchedule() {
+  dc_scheduler_t s;
+  dc_sched_init(&s, nullptr);
+  const dc_policy_t& pol = s.pol;
+  double t = 0, dt = 0;
+  for (int i = 0; i < 40; ++i) { dt = dc_sched_next(&s, t, 0.05, 0.0, DC_AWAKE); t += dt; }
+  CHECK(dt == pol.maxInterval && !s.fast, "calm interval %.2f (fast %d)", dt, s.fast);
+  dt = dc_sched_next(&s, t, 0.05, 0.02, DC_DROWSY);
+  CHECK(dt == pol.minInterval && s.fast, "drowsy did not latch fast (%.2f)", dt);
+  // Urgency between offLevel and onLevel keeps whichever latch is set.
+  const double pMid = pol.pLow + 0.5 * (pol.onLevel + pol.offLevel) * (pol.pHigh - pol.pLow);
+  for (int i = 0; i < 200; ++i) { t += dt; dt = dc_sched_next(&s, t, pMid, 0.02, DC_AWAKE); }
+  CHECK(s.fast && dt == pol.minInterval, "fast latch released between thresholds");
+  for (int i = 0; i < 40; ++i) { t += dt; dt = dc_sched_next(&s, t, 0.05, 0.02, DC_AWAKE); }
+  // Creep up slowly enough that the rise term stays quiet.
+  for (double p = 0.05; p < pMid; p += 0.2 * pol.riseScale * dt) { t += dt; dt = dc_sched_next(&s, t, p, 0.02, DC_AWAKE); }
+  for (int i = 0; i < 200; ++i) { t += dt; dt = dc_sched_next(&s, t, pMid, 0.02, DC_AWAKE); }
+  CHECK(!s.fast && dt > pol.minInterval && dt < pol.maxInterval, "calm latch flipped between thresholds (%.2f)", dt);
+  dt = dc_sched_next(&s, t, 0.05, 1.0, DC_AWAKE);
+  CHECK(dt == pol.minInterval, "high variance did not force the fast cadence");
+
+  dc_account_t a{};
+  dc_account_eval(&a, 0, 10, 1);
+  dc_account_eval(&a, 4, 10, 1);
+  dc_account_eval(&a, 30, 10, 0);
+  CHECK(a.wakeups == 3 && a.fastTicks == 2 && a.elapsed == 34 && a.sensorOn == 14, "dc_account_eval");
+
+  st::SleepPipelineConfig every, adaptive;
+  adaptive.duty = st::DutyMode::Adaptive;
+  size_t both = 0;
+  double evalsEvery = 0, evalsAdaptive = 0, sensorEvery = 0, sensorAdaptive = 0;
+  for (uint64_t seed = 1; seed <= 24; ++seed) {
+    stbench::Night n = stbench::synthNight(seed);
+    st::SleepPipeline pe(every), pa(adaptive);
+    st::NightResult re = st::replayNight(pe, n.events.data(), n.events.size());
+    st::NightResult ra = st::replayNight(pa, n.events.data(), n.events.size());
+    evalsEvery += (double)re.duty.wakeups; evalsAdaptive += (double)ra.duty.wakeups;
+    sensorEvery += re.duty.sensorOn;        sensorAdaptive += ra.duty.sensorOn;
+    CHECK(re.duty.wakeups == re.ticks && re.duty.sensorOn == re.duty.elapsed, "seed=%llu every accounting",
+          (unsigned long long)seed);
+    if (std::isnan(re.onset) || std::isnan(ra.onset)) continue;
+    ++both;
+    CHECK(std::fabs(ra.onset - re.onset) <= 2 * pol.maxInterval, "seed=%llu adaptive onset %.0f vs %.0f",
+          (unsigned long long)seed, ra.onset, re.onset);
+  }
+  CHECK(both > 0, "no night detected under both pacings");
+  CHECK(evalsAdaptive < 0.5 * evalsEvery && sensorAdaptive < 0.9 * sensorEvery,
+        "adaptive pacing saved too little: evals %.0f vs %.0f, sensor %.0f vs %.0f s",
+        evalsAdaptive, evalsEvery, sensorAdaptive, sensorEvery);
+}
+
+void checkDecimate() {
+  Rng rng;
+  // CIC == N cascaded length-R boxcars at full rate, kept every R-th sample.
+  {
+    constexpr int R = 5, N = 3;
+    const double g = st::CIC<R, N>::gain();
+    std::vector<double> x(400), a(400), b(400);
+    for (double& v : x) v = rng.uniform() * 2.0 - 1.0;
+    a = x;
+    for (int st = 0; st < N; ++st) {
+      for (size_t i = 0; i < a.size(); ++i) {
+        double acc = 0;
+        for (int k = 0; k < R && k <= (int)i; ++k) acc += a[i - k];
+        b[i] = acc;
+      }
+      std::swap(a, b);
+    }
+    st::CIC<R, N> cic;
+    double maxErr = 0, out = 0;
+    int outs = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+      if (!cic.push(x[i], &out)) continue;
+      ++outs;
+      CHECK(i % R == R - 1, "CIC output at input %zu", i);
+      maxErr = std::max(maxErr, std::fabs(out - a[i] / g));
+    }
+    CHECK(outs == (int)x.size() / R && maxErr < 1e-5, "CIC vs boxcars: %d outputs, err %.3g", outs, maxErr);
+    cic.reset();
+    for (int i = 0; i < 10 * R; ++i) cic.push(0.75, &out);
+    CHECK(std::fabs(out - 0.75) < 1e-6, "CIC DC gain %.6f", out / 0.75);
+  }
+  // Polyphase == full-rate FIR, then keep every M-th output.
+  {
+    constexpr int M = 2, T = 31;
+    st::PolyphaseDecimator<M, T> fir;
+    const auto& rev = fir.taps();
+    std::vector<float> x(300);
+    for (float& v : x) v = (float)(rng.uniform() * 2.0 - 1.0);
+    double maxErr = 0, dc = 0;
+    for (int k = 0; k < T; ++k) dc += rev[k];
+    float out;
+    int outs = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+      if (!fir.push(x[i], &out)) continue;
+      ++outs;
+      double ref = 0;
+      for (int k = 0; k < T && k <= (int)i; ++k) ref += (double)rev[T - 1 - k] * x[i - k];
+      maxErr = std::max(maxErr, std::fabs(out - ref));
+    }
+    CHECK(outs == (int)x.size() / M && maxErr < 1e-5 && std::fabs(dc - 1) < 1e-5,
+          "polyphase vs direct FIR: %d outputs, err %.3g, dc %.6f", outs, maxErr, dc);
+  }
+  // Whole front end against the same stages run at 20 Hz: a 16.2 bpm breath
+  // riding on gravity, sensor noise and a 6 Hz tremor, with bouts of motion.
+  {
+    // Close to the Goertzel bin (goertzel_init lands half a bin above
+    // goertzelHz) but not a whole number of cycles per block, so block
+    // phase averages out.
+    const double kBreathHz = 0.27, bpm = 60 * kBreathHz;
+    const double fs = 20.0, fsLow = fs / st::MotionFrontEnd<>::decimation();
+    st::MotionFrontEndConfig cfg;
+    st::MotionFrontEnd<> fe(cfg);
+    resp_bpf_t resp;
+    goertzel_t gz;
+    const int nFull = cfg.goertzelN * st::MotionFrontEnd<>::decimation();
+    resp_init(&resp, fs, cfg.respLowHz, cfg.respHighHz);
+    goertzel_init(&gz, fs, cfg.goertzelHz, nFull);
+    const int win = cfg.windowBlocks * st::MotionFrontEnd<>::decimation();
+    std::vector<double> w;
+    double bpmLow = 0, bpmFull = 0, pLow = 0, pFull = 0;
+    int nBpm = 0, nPLow = 0, nPFull = 0, gN = 0, windows = 0, labelMiss = 0;
+    double maxVarErr = 0, lastPLow = 0;
+    const int n = (int)(1800 * fs);
+    for (int i = 0; i < n; ++i) {
+      const double t = i / fs;
+      const bool moving = (i / (int)(120 * fs)) % 5 == 4;
+      double x = 1.0 + 0.01 * std::sin(2 * M_PI * kBreathHz * t) + 0.003 * std::sin(2 * M_PI * 6.0 * t) +
+                 0.002 * (rng.uniform() - 0.5);
+      if (moving) x += 0.05 * (rng.uniform() - 0.5);
+      const bool low = fe.push(x, t);
+      goertzel_push(&gz, resp_update(&resp, x, t));
+      if (++gN == nFull) {
+        const double p = goertzel_power(&gz);
+        gN = 0;
+        if (t > 300) { pFull += p / nFull; ++nPFull; }
+      }
+      if (low && t > 300) {
+        bpmLow += fe.respirationBPM(); bpmFull += resp_rate_bpm(&resp); ++nBpm;
+        if (fe.goertzelPower() != lastPLow) { lastPLow = fe.goertzelPower(); pLow += lastPLow / cfg.goertzelN; ++nPLow; }
+      }
+      w.push_back(x);
+      if ((int)w.size() == win) {
+        double m = 0, v = 0;
+        for (double s : w) m += s;
+        m /= win;
+        for (double s : w) v += (s - m) * (s - m);
+        v /= win;
+        CHECK(fe.windowReady(), "window not closed at sample %d", i);
+        maxVarErr = std::max(maxVarErr, std::fabs(fe.windowVariance() - v) / std::max(v, 1e-12));
+        labelMiss += (fe.windowVariance() < 1e-4) != (v < 1e-4);
+        ++windows;
+        w.clear();
+      }
+    }
+    bpmLow /= nBpm; bpmFull /= nBpm; pLow /= nPLow; pFull /= nPFull;
+    CHECK(windows == n / win && maxVarErr < 1e-9 && labelMiss == 0,
+          "window variance: %d windows, rel err %.3g, %d labels differ", windows, maxVarErr, labelMiss);
+    // The 20 Hz band-pass lets more of the motion bouts through, so the
+    // full-rate estimate is the noisier of the two; hold both to the truth.
+    CHECK(std::fabs(bpmLow - bpm) < 0.5 && std::fabs(bpmLow - bpm) <= std::fabs(bpmFull - bpm) + 0.1,
+          "respiration %.2f bpm at %.0f Hz vs %.2f at %.0f Hz", bpmLow, fsLow, bpmFull, fs);
+    CHECK(std::fabs(pLow / pFull - 1) < 0.05, "breathing-band power %.4g at %.0f Hz vs %.4g at %.0f Hz",
+          pLow, fsLow, pFull, fs);
+  }
+}
+
+template <int S, typename T>
+void checkSOSBlock(const st::SOS<S>& d, const char* name) {
+  Rng rng;
+  std::vector<T> x(1000), ref(x.size());
+  for (T& v : x) v = (T)(rng.uniform() * 2.0 - 1.0);
+  st::SOSCascade<S, T> a(d), b(d);
+  for (size_t i = 0; i < x.size(); ++i) ref[i] = a.push(x[i]);
+  // Odd chunk sizes so the wavefront ramps in and out, including n < S.
+  std::vector<T> y = x;
+  size_t i = 0, bad = 0;
+  for (size_t m : {(size_t)1, (size_t)S - 1, (size_t)7, (size_t)300, x.size()}) {
+    m = std::min(m, x.size() - i);
+    b.process(y.data() + i, y.data() + i, m);   // in place
+    i += m;
+  }
+  for (size_t k = 0; k < x.size(); ++k) bad += std::memcmp(&y[k], &ref[k], sizeof(T)) != 0;
+  CHECK(i == x.size() && bad == 0, "%s: process vs push differ at %zu samples", name, bad);
+}
+
+void checkSOSCascade() {
+  using st::Family;
+  namespace sos = st::sos;
+  // constexpr designs match the same call evaluated at run time.
+  constexpr auto ce = sos::bandPass<3>(Family::Bessel, 0.1, 0.5, 2.0);
+  volatile double fs = 2.0;
+  const auto rt = sos::bandPass<3>(Family::Bessel, 0.1, 0.5, fs);
+  double maxDiff = 0;
+  for (int k = 0; k < 4; ++k) {
+    const st::Biquad &p = ce.s[k], &q = rt.s[k];
+    for (double dd : {p.b0 - q.b0, p.b1 - q.b1, p.b2 - q.b2, p.a1 - q.a1, p.a2 - q.a2})
+      maxDiff = std::max(maxDiff, std::fabs(dd));
+  }
+  CHECK(maxDiff < 1e-13, "constexpr vs runtime design differ by %.3g", maxDiff);
+  static_assert(st::kRespBand2Hz.s[0].b0 > 0, "respiration band designed at compile time");
+
+  // 2nd-order Butterworth == the cookbook low-pass with Q = 1/sqrt(2).
+  {
+    const double f = 0.3, rate = 2.0, w0 = 2 * M_PI * f / rate, al = std::sin(w0) / std::sqrt(2.0);
+    const double a0 = 1 + al;
+    const st::Biquad want{(1 - std::cos(w0)) / 2 / a0, (1 - std::cos(w0)) / a0, (1 - std::cos(w0)) / 2 / a0,
+                          -2 * std::cos(w0) / a0, (1 - al) / a0};
+    const st::Biquad got = sos::lowPass<2>(Family::Butterworth, f, rate).s[0];
+    CHECK(std::fabs(got.b0 - want.b0) < 1e-12 && std::fabs(got.b1 - want.b1) < 1e-12 &&
+          std::fabs(got.b2 - want.b2) < 1e-12 && std::fabs(got.a1 - want.a1) < 1e-12 &&
+          std::fabs(got.a2 - want.a2) < 1e-12, "butterworth LP2 vs cookbook");
+  }
+  // Butterworth: unity in the passband, -3 dB at fc, order·6 dB/oct beyond.
+  for (double fc : {0.05, 0.2, 0.4}) {
+    const auto lp = sos::lowPass<5>(Family::Butterworth, fc, 1.0);
+    const auto hp = sos::highPass<4>(Family::Butterworth, fc, 1.0);
+    CHECK(std::fabs(sos::magnitude(lp, 0, 1.0) - 1) < 1e-12 && std::fabs(sos::magnitude(hp, 0.5, 1.0) - 1) < 1e-12,
+          "fc=%.2f: passband gain", fc);
+    CHECK(std::fabs(sos::magnitude(lp, fc, 1.0) - M_SQRT1_2) < 1e-9 &&
+          std::fabs(sos::magnitude(hp, fc, 1.0) - M_SQRT1_2) < 1e-9, "fc=%.2f: -3 dB point", fc);
+  }
+  // Bessel: DC group delay kBesselDelay / (2·pi·fc).
+  {
+    const double fc = 0.02;
+    const auto bl = sos::lowPass<4>(Family::Bessel, fc, 1.0);
+    st::SOSCascade<2, double> c(bl);
+    double gd0 = 0, e = 0;
+    for (int n = 0; n < 4000; ++n) {   // centroid of the impulse response
+      const double h = c.push(n == 0 ? 1.0 : 0.0);
+      gd0 += n * h; e += h;
+    }
+    gd0 /= e;
+    const double want = st::sos_detail::kBesselDelay[3] / (2 * M_PI * fc);
+    CHECK(std::fabs(gd0 - want) < 0.02 * want, "bessel DC group delay %.2f, want %.2f", gd0, want);
+    CHECK(std::fabs(sos::magnitude(bl, 0, 1.0) - 1) < 1e-12 && sos::magnitude(bl, 4 * fc, 1.0) < 0.1,
+          "bessel LP4 gain");
+  }
+  // The compile-time respiration band: passes 0.25 Hz, rejects harder than
+  // resp_bpf_t outside 0.1-0.5 Hz.
+  {
+    resp_bpf_t r;
+    resp_init(&r, 2.0, 0.1, 0.5);
+    const st::SOS<1> rbj{{st::Biquad{r.b0, r.b1, r.b2, r.a1, r.a2}}};
+    const double pass = sos::magnitude(st::kRespBand2Hz, 0.25, 2.0);
+    CHECK(pass > 0.9 && pass < 1.05, "resp band passband %.3f", pass);
+    for (double f : {0.02, 0.8, 0.95})
+      CHECK(sos::magnitude(st::kRespBand2Hz, f, 2.0) < 0.75 * sos::magnitude(rbj, f, 2.0),
+            "resp band at %.2f Hz: %.3f vs biquad %.3f", f, sos::magnitude(st::kRespBand2Hz, f, 2.0),
+            sos::magnitude(rbj, f, 2.0));
+  }
+  checkSOSBlock<1, float>(sos::lowPass<2>(Family::Butterworth, 0.1, 1.0), "S1 float");
+  checkSOSBlock<2, float>(st::kRespBand2Hz, "S2 float");
+  checkSOSBlock<3, double>(sos::lowPass<6>(Family::Bessel, 0.1, 1.0), "S3 double");
+  checkSOSBlock<6, double>(sos::bandPass<5>(Family::Butterworth, 0.05, 0.3, 1.0), "S6 double");
+  // float tracks double.
+  {
+    Rng rng;
+    st::SOSCascade<2, float> f(st::kRespBand2Hz);
+    st::SOSCascade<2, double> g(st::kRespBand2Hz);
+    double err = 0, peak = 0;
+    for (int n = 0; n < 20000; ++n) {
+      const double x = std::sin(0.7 * n) + 0.3 * (rng.uniform() - 0.5);
+      const double yd = g.push(x);
+      err = std::max(err, std::fabs((double)f.push((float)x) - yd));
+      peak = std::max(peak, std::fabs(yd));
+    }
+    CHECK(err < 1e-4 * peak, "float vs double cascade: %.3g of %.3g", err, peak);
+  }
+  // An impulse decaying through silence never leaves subnormal state or output.
+  {
+    st::SOSCascade<3, float> c(sos::lowPass<6>(Family::Butterworth, 0.01, 1.0));
+    int sub = 0;
+    for (int n = 0; n < 200000; ++n) {
+      const float y = c.push(n == 0 ? 1.0f : 0.0f);
+      sub += std::fpclassify(y) == FP_SUBNORMAL;
+      for (int k = 0; k < 3; ++k)
+        sub += std::fpclassify(c.z1(k)) == FP_SUBNORMAL || std::fpclassify(c.z2(k)) == FP_SUBNORMAL;
+    }
+    CHECK(sub == 0 && c.z1(0) == 0 && c.z2(2) == 0, "subnormals seen %d times", sub);
+  }
+}
+
+void checkPrecision() {
+  using st::Q15;
+  using st::Q31;
+  // Saturation and rounding.
+  CHECK((Q15::fromDouble(0.9) + Q15::fromDouble(0.9)).raw == INT16_MAX, "Q15 add saturates");
+  CHECK((Q15::fromDouble(-0.9) - Q15::fromDouble(0.9)).raw == INT16_MIN, "Q15 sub saturates");
+  CHECK((Q15::fromDouble(-1.0) * Q15::fromDouble(-1.0)).raw == INT16_MAX, "Q15 (-1)*(-1) saturates");
+  CHECK((-Q31::fromDouble(-1.0)).raw == INT32_MAX && Q31::fromDouble(2.0).raw == INT32_MAX, "Q31 neg / convert saturate");
+  CHECK((Q15::fromRaw(3) * Q15::fromDouble(0.5)).raw == 2 && (Q15::fromRaw(-3) * Q15::fromDouble(0.5)).raw == -1,
+        "Q15 mul rounds to nearest (ties up)");
+  CHECK(std::fabs(Q31::fromDouble(0.123456789).toDouble() - 0.123456789) < 1e-9, "Q31 round trip");
+
+  // OnePole<float> == iir1_update; fixed point tracks double.
+  std::vector<double> hr = noisyHR(4000);
+  {
+    iir1_t ref; iir1_init(&ref, 0.22f);
+    st::OnePole<float> f(0.22f);
+    st::OnePole<double> d(0.22f);
+    st::OnePole<Q31> q31(0.22f);
+    st::OnePole<Q15> q15(0.22f);
+    size_t bad = 0;
+    double e31 = 0, e15 = 0;
+    using T31 = st::SampleTraits<Q31>;
+    using T15 = st::SampleTraits<Q15>;
+    for (double x : hr) {
+      const float r = iir1_update(&ref, (float)x);
+      bad += f.update((float)x) != r;
+      const double yd = d.update(x);
+      e31 = std::max(e31, std::fabs(T31::out(q31.update(T31::in(x, 256)), 256) - yd));
+      e15 = std::max(e15, std::fabs(T15::out(q15.update(T15::in(x, 256)), 256) - yd));
+    }
+    CHECK(bad == 0, "OnePole<float> differs from iir1_update at %zu samples", bad);
+    CHECK(e31 < 1e-5 && e15 < 0.1, "OnePole fixed vs double: q31 %.3g bpm, q15 %.3g bpm", e31, e15);
+  }
+  // Hampel<double> == rs_hampel_update; fixed point replaces the same spikes.
+  {
+    rs_hampel_t ref; rs_hampel_init(&ref, 9, 3.0);
+    st::Hampel<double> d(9, 3.0);
+    st::Hampel<Q31> q(9, 3.0);
+    using T31 = st::SampleTraits<Q31>;
+    size_t bad = 0, decisions = 0;
+    for (double x : hr) {
+      const double r = rs_hampel_update(&ref, x);
+      const double yd = d.update(x);
+      bad += std::memcmp(&r, &yd, sizeof r) != 0;
+      const double yq = T31::out(q.update(T31::in(x, 256)), 256);
+      decisions += (std::fabs(yq - x) > 1e-3) != (r != x);
+    }
+    CHECK(bad == 0, "Hampel<double> differs from rs_hampel_update at %zu samples", bad);
+    CHECK(decisions == 0, "Hampel<Q31> made %zu different replace decisions", decisions);
+  }
+  // Whole pipeline: float and Q31 conditioning detect onset exactly as double.
+  {
+    st::SleepPipelineConfig cd, cf, cq;
+    cd.precision = st::Precision::Double;
+    cf.precision = st::Precision::Float;
+    cq.precision = st::Precision::Q31;
+    size_t detected = 0;
+    for (uint64_t seed = 1; seed <= 16; ++seed) {
+      stbench::Night n = stbench::synthNight(seed);
+      st::SleepPipeline pd(cd), pf(cf), pq(cq);
+      const double od = st::replayNight(pd, n.events.data(), n.events.size()).onset;
+      const double of = st::replayNight(pf, n.events.data(), n.events.size()).onset;
+      const double oq = st::replayNight(pq, n.events.data(), n.events.size()).onset;
+      detected += !std::isnan(od);
+      CHECK((std::isnan(od) && std::isnan(of) && std::isnan(oq)) || (od == of && od == oq),
+            "seed=%llu onset double %.1f float %.1f q31 %.1f", (unsigned long long)seed, od, of, oq);
+    }
+    CHECK(detected > 0, "no onset detected in double");
+  }
+}
+
+// int8 GEMV: every ISA path exact against a plain loop. Motion classifier:
+// the built-in blob loads, int8 and float agree on held-out windows and
+// both beat the threshold rule; corrupt blobs are refused.
+void checkTinyML() {
+  Rng rng;
+  std::vector<int8_t> W(64 * 80), x(80);
+  for (auto& v : W) v = (int8_t)(std::floor(rng.uniform() * 255.0) - 127);
+  for (auto& v : x) v = (int8_t)(std::floor(rng.uniform() * 255.0) - 127);
+  const vk_isa_t detected = vk_active_isa();
+  for (vk_isa_t isa : {VK_ISA_SCALAR, VK_ISA_NEON, VK_ISA_SSE42, VK_ISA_AVX2, VK_ISA_AVX512}) {
+    if (vk_select_isa(isa) != 0) continue;
+    for (size_t n : {0, 1, 15, 16, 17, 31, 32, 33, 48, 64, 80})
+      for (size_t rows : {1, 2, 3, 16, 17}) {
+        const size_t stride = std::max<size_t>(n, 80);
+        int32_t y[64];
+        vk_gemv_s8(W.data(), stride, x.data(), n, rows, y);
+        for (size_t r = 0; r < rows; ++r) {
+          int32_t want = 0;
+          for (size_t k = 0; k < n; ++k) want += W[r * stride + k] * x[k];
+          CHECK(y[r] == want, "%s gemv_s8 n=%zu rows=%zu r=%zu: %d vs %d", vk_isa_name(isa), n, rows, r, y[r], want);
+          if (y[r] != want) break;
+        }
+      }
+  }
+  vk_select_isa(detected);
+
+  size_t len = 0;
+  const void* blob = tm_default_blob(&len);
+  tm_model_t m;
+  CHECK(tm_model_load(&m, blob, len) == 0 && tm_model_has_reference(&m), "built-in blob does not load");
+  if (!tm_model_loaded(&m)) return;
+
+  // Running window features == a fresh pass over the last TM_WINDOW ticks,
+  // across resyncs and with repeated values in the min / max deques.
+  {
+    tm_window_t w;
+    tm_window_reset(&w);
+    std::vector<float> st, hr;
+    Rng wr;
+    size_t bad = 0, full = 0;
+    for (int i = 0; i < 20 * TM_RESYNC; ++i) {
+      const double still = i % 50 < 20 ? 1.0 : std::floor(wr.uniform() * 8) / 8;
+      const double h = i < 5 ? NAN : 55 + 30 * wr.uniform();
+      tm_window_push(&w, still, h);
+      if (i < 5) continue;
+      st.push_back((float)still); hr.push_back((float)h);
+      float f[TM_FEATURES];
+      if (tm_window_features(&w, f) != 0) continue;
+      ++full;
+      const size_t o = st.size() - TM_WINDOW;
+      const int half = TM_WINDOW / 2;
+      double sS = 0, sSS = 0, sH = 0, sHH = 0, h1S = 0, h1H = 0, dS = 0, dH = 0, nS = 0;
+      float lo = st[o], hi = st[o];
+      for (int k = 0; k < TM_WINDOW; ++k) {
+        const double a = st[o + k], b = hr[o + k];
+        sS += a; sSS += a * a; sH += b; sHH += b * b; nS += a >= 0.85;
+        lo = std::min(lo, st[o + k]); hi = std::max(hi, st[o + k]);
+        if (k < half) { h1S += a; h1H += b; }
+        if (k) { dS += std::fabs(a - st[o + k - 1]); dH += std::fabs(b - hr[o + k - 1]); }
+      }
+      const double n = TM_WINDOW, mS = sS / n, mH = sH / n;
+      const double want[TM_FEATURES] = {
+          mS, std::sqrt(std::max(0.0, sSS / n - mS * mS)), lo, hi, st.back(),
+          (sS - h1S) / half - h1S / half, dS / (n - 1), nS / n,
+          std::sqrt(std::max(0.0, sHH / n - mH * mH)), dH / (n - 1),
+          (sH - h1H) / half - h1H / half, hr.back() - mH};
+      for (int k = 0; k < TM_FEATURES; ++k) bad += std::fabs(f[k] - want[k]) > 1e-4 * (1 + std::fabs(want[k]));
+    }
+    CHECK(full > 0 && bad == 0, "tm_window running features: %zu of %zu windows off", bad, full);
+  }
+
+  // Held-out windows (the trainer uses seeds from 1 and 100001).
+  tm_window_t w;
+  tm_arena_t arena;
+  size_t n = 0, okQ = 0, okF = 0, okRule = 0, agree = 0;
+  for (uint64_t seed = 900001; seed < 900004; ++seed) {
+    tm_window_reset(&w);
+    for (const auto& t : stbench::synthMotionTicks(seed, 2000)) {
+      tm_window_push(&w, t.still, t.hr);
+      float f[TM_FEATURES], zq[TM_CLASSES], zf[TM_CLASSES];
+      if (tm_window_features(&w, f) != 0) continue;
+      const int q = tm_infer(&m, &arena, f, zq), r = tm_infer_ref(&m, f, zf);
+      ++n;
+      okQ += q == t.label;
+      okF += r == t.label;
+      agree += q == r;
+      okRule += tiny_motion_classify(f[0], (double)f[1] * f[1]) == t.label;
+      // Integer kernels: identical logits on every ISA.
+      if (n % 97 == 0) {
+        for (vk_isa_t isa : {VK_ISA_SCALAR, VK_ISA_SSE42, VK_ISA_AVX2, VK_ISA_NEON}) {
+          if (vk_select_isa(isa) != 0) continue;
+          float z2[TM_CLASSES];
+          tm_infer(&m, &arena, f, z2);
+          CHECK(std::memcmp(z2, zq, sizeof(zq)) == 0, "tm_infer differs on %s", vk_isa_name(isa));
+        }
+        vk_select_isa(detected);
+      }
+    }
+  }
+  const double dn = (double)n;
+  CHECK(okQ / dn > 0.9 && okF / dn > 0.9, "motion accuracy int8 %.3f float %.3f", okQ / dn, okF / dn);
+  CHECK(agree / dn > 0.98, "int8 / float agreement %.4f", agree / dn);
+  CHECK(okQ / dn > okRule / dn + 0.2, "int8 %.3f vs threshold rule %.3f", okQ / dn, okRule / dn);
+
+  // Until the window fills the classifier answers with the threshold rule.
+  tm_classifier_t c;
+  CHECK(tm_classifier_init(&c, nullptr, 0) == 0, "tm_classifier_init");
+  CHECK(tm_classifier_push(&c, 0.9, NAN) == tiny_motion_classify(0.9, 0.0), "fallback before HR");
+  for (int i = 0; i < TM_WINDOW - 1; ++i) {
+    const double s = i % 2 ? 0.3 : 0.9;
+    double mean, var;
+    const int k = tm_classifier_push(&c, s, 70.0);
+    tm_window_still_stats(&c.win, &mean, &var);
+    CHECK(k == tiny_motion_classify(mean, var), "fallback tick %d", i);
+  }
+  // The rule sees the window mean, not the newest tick.
+  tm_classifier_reset(&c);
+  for (int i = 0; i < 10; ++i) tm_classifier_push(&c, 0.95, 60.0);
+  {
+    double mean, var;
+    const int k = tm_classifier_push(&c, 0.3, 60.0);
+    tm_window_still_stats(&c.win, &mean, &var);
+    CHECK(tiny_motion_classify(mean, var) != tiny_motion_classify(0.3, var), "fallback case does not discriminate");
+    CHECK(k == tiny_motion_classify(mean, var), "fallback used the last tick (%d) instead of the mean %.3f", k, mean);
+  }
+
+  // Corrupt or misplaced blobs are refused; nothing is read past len.
+  std::vector<uint32_t> copy((len + 3) / 4 + 1);
+  std::memcpy(copy.data(), blob, len);
+  auto* h = (tm_blob_header_t*)copy.data();
+  CHECK(tm_model_load(&m, copy.data(), len) == 0, "copied blob");
+  CHECK(tm_model_load(&m, copy.data(), len - 4) != 0 && !tm_model_loaded(&m), "truncated blob accepted");
+  CHECK(tm_model_load(&m, (const uint8_t*)copy.data() + 1, len) != 0, "misaligned blob accepted");
+  h->layer[1].wOff = h->size - 8;
+  CHECK(tm_model_load(&m, copy.data(), len) != 0, "out-of-range offset accepted");
+  std::memcpy(copy.data(), blob, len);
+  h->layer[1].nIn += 1;
+  CHECK(tm_model_load(&m, copy.data(), len) != 0, "layer shape mismatch accepted");
+  std::memcpy(copy.data(), blob, len);
+  h->magic ^= 1;
+  CHECK(tm_model_load(&m, copy.data(), len) != 0, "bad magic accepted");
+}
+
+
+// Multi-pass reference in long double: two-pass moments, direct DFT bins.
+wf_features_t windowReference(const double* x, int n, const wf_plan_t* p) {
+  wf_features_t f{};
+  long double s = 0, q = 0, d2 = 0, v = 0, ad = 0;
+  double lo = x[0], hi = x[0];
+  int cross = 0;
+  const double level = p ? p->level : 0.0;
+  for (int i = 0; i < n; ++i) {
+    s += x[i]; q += (long double)x[i] * x[i];
+    lo = std::min(lo, x[i]); hi = std::max(hi, x[i]);
+    if (i) { d2 += (long double)(x[i] - x[i - 1]) * (x[i] - x[i - 1]); cross += (x[i] >= level) != (x[i - 1] >= level); }
+  }
+  const long double m = s / n;
+  for (int i = 0; i < n; ++i) { v += (x[i] - m) * (x[i] - m); ad += std::fabs((double)(x[i] - m)); }
+  f.n = n;
+  f.mean = (double)m;
+  f.var = (double)(v / n);
+  f.rmssd = n >= 2 ? (double)std::sqrt(d2 / (n - 1)) : NAN;
+  f.min = lo; f.max = hi;
+  f.mad = (double)(ad / n);
+  f.energy = (double)(q / n);
+  f.crossings = cross;
+  for (int b = 0; b < WF_MAX_BANDS; ++b) f.band[b] = 0;
+  if (p && p->n == n) {
+    for (int j = 0; j < p->bins; ++j) {
+      long double re = 0, im = 0;
+      for (int i = 0; i < n; ++i) {
+        const long double w = 2.0L * 3.14159265358979323846L * p->k[j] * i / n;
+        re += x[i] * std::cos(w); im -= x[i] * std::sin(w);
+      }
+      f.band[p->bandOf[j]] += (double)((re * re + im * im) / n);
+    }
+  }
+  return f;
+}
+
+bool near(double a, double b, double tol) {
+  if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+  return std::fabs(a - b) <= tol * std::max(1.0, std::fabs(b));
+}
+
+int compareFeatures(const wf_features_t& g, const wf_features_t& w, int bands, bool mad, double tol) {
+  int bad = 0;
+  bad += g.n != w.n || g.crossings != w.crossings;
+  bad += !near(g.mean, w.mean, tol) + !near(g.var, w.var, tol) + !near(g.rmssd, w.rmssd, tol);
+  bad += g.min != w.min || g.max != w.max;
+  bad += !near(g.energy, w.energy, tol);
+  if (mad) bad += !near(g.mad, w.mad, tol);
+  for (int b = 0; b < bands; ++b) bad += !near(g.band[b], w.band[b], tol * w.energy);
+  return bad;
+}
+
+void checkWindowFeatures() {
+  const std::vector<double> hr = noisyHR(6000);
+
+  // Batch pass against the multi-pass reference, across lane tails.
+  const double lo[2] = {0.1, 0.45}, hi[2] = {0.15, 0.5};
+  for (int n : {1, 2, 3, 5, 7, 8, 9, 17, 60, 61, 64, 255, 256}) {
+    wf_plan_t p;
+    const int ok = wf_plan_init(&p, n, 2.0, lo, hi, 2, 70.0);
+    CHECK((ok == 0) == (n >= 2), "wf_plan_init n=%d returned %d", n, ok);
+    for (int off : {0, 1000, 4321}) {
+      wf_features_t got;
+      CHECK(wf_compute(n >= 2 ? &p : NULL, hr.data() + off, n, WF_MAD, &got) == 0, "wf_compute n=%d", n);
+      const wf_features_t want = windowReference(hr.data() + off, n, n >= 2 ? &p : NULL);
+      const int bad = compareFeatures(got, want, n >= 2 ? 2 : 0, true, 1e-10);
+      CHECK(bad == 0, "wf_compute n=%d off=%d: %d features differ (mean %.17g/%.17g var %.17g/%.17g x %d/%d)",
+            n, off, bad, got.mean, want.mean, got.var, want.var, got.crossings, want.crossings);
+    }
+  }
+  {
+    wf_plan_t p;
+    const double wide[1] = {0.0}, top[1] = {1.0};
+    CHECK(wf_plan_init(&p, 64, 2.0, wide, top, 1, 0.0) != 0, "more than WF_MAX_BINS bins accepted");
+    CHECK(wf_plan_init(&p, 1, 2.0, NULL, NULL, 0, 0.0) != 0, "n < 2 accepted");
+    wf_features_t f;
+    CHECK(wf_compute(NULL, hr.data(), 0, 0, &f) != 0 && std::isnan(f.mean), "empty window");
+    CHECK(wf_compute(NULL, hr.data(), 10, 0, &f) == 0 && std::isnan(f.mad), "mad without WF_MAD");
+  }
+
+  // A large common offset: shifted sums keep the variance, the textbook
+  // single pass does not.
+  {
+    std::vector<double> x(240);
+    Rng rng;
+    for (double& v : x) v = 1e8 + (rng.uniform() - 0.5);
+    wf_features_t got;
+    wf_compute(NULL, x.data(), (int)x.size(), 0, &got);
+    const wf_features_t want = windowReference(x.data(), (int)x.size(), NULL);
+    CHECK(std::fabs(got.var - want.var) < 1e-6 * want.var, "offset 1e8: var %.9g want %.9g", got.var, want.var);
+  }
+
+  // ss_stats is the fused pass.
+  for (int n : {1, 2, 5, 60, 301}) {
+    const ss_stats_t s = ss_stats(hr.data() + 17, n);
+    const wf_features_t w = windowReference(hr.data() + 17, n, NULL);
+    CHECK(near(s.mean, w.mean, 1e-12) && near(s.sd, std::sqrt(w.var), 1e-12) && near(s.rmssd, w.rmssd, 1e-12),
+          "ss_stats n=%d: %.17g %.17g %.17g", n, s.mean, s.sd, s.rmssd);
+  }
+  CHECK(std::isnan(ss_stats(nullptr, 5).mean) && std::isnan(ss_stats(hr.data(), 0).mean), "ss_stats no data");
+
+  // Sliding window against the batch pass over the same samples.
+  for (int resync : {0, 1 << 30}) {
+    const int N = 64;
+    wf_plan_t p;
+    wf_plan_init(&p, N, 2.0, lo, hi, 2, 70.0);
+    wf_stream_t* s = new wf_stream_t;
+    CHECK(wf_stream_init(s, &p, resync) == 0, "wf_stream_init");
+    wf_features_t got;
+    CHECK(wf_stream_features(s, 0, &got) != 0, "empty stream");
+    int bad = 0;
+    std::vector<double> padded(N);
+    for (size_t i = 0; i < hr.size(); ++i) {
+      wf_stream_push(s, hr[i]);
+      if (i % 13 && i + 1 != hr.size()) continue;
+      const int n = (int)std::min<size_t>(i + 1, N);
+      const double* w = hr.data() + i + 1 - n;
+      wf_stream_features(s, WF_MAD, &got);
+      wf_features_t want = windowReference(w, n, &p);
+      if (n < N) {
+        std::fill(padded.begin(), padded.end(), 0.0);
+        std::copy(w, w + n, padded.end() - n);
+        const wf_features_t z = windowReference(padded.data(), N, &p);
+        for (int b = 0; b < 2; ++b) want.band[b] = z.band[b];
+      }
+      // Without resync the running sums random-walk, slowly.
+      const int d = compareFeatures(got, want, 2, true, resync ? 1e-7 : 1e-10);
+      if (d && bad < 3)
+        std::fprintf(stderr, "  stream i=%zu: mean %.17g/%.17g var %.17g/%.17g band0 %.17g/%.17g\n",
+                     i, got.mean, want.mean, got.var, want.var, got.band[0], want.band[0]);
+      bad += d;
+    }
+    CHECK(bad == 0, "wf_stream resync=%d: %d feature mismatches", resync, bad);
+    wf_stream_reset(s);
+    wf_stream_push_block(s, hr.data(), 3);
+    CHECK(wf_stream_features(s, 0, &got) == 0 && got.n == 3 && got.max == std::max({hr[0], hr[1], hr[2]}),
+          "wf_stream_reset");
+    delete s;
+  }
+}
+} // namespace
+
+int main() {
+  checkHampel();
+  checkBlockApis();
+  checkFilterBank();
+  checkSlidingDft();
+  checkVecKernels();
+  checkSleepPipeline();
+  checkWorkStealingPool();
+  checkSweep();
+  checkRingLog();
+  checkExportStream();
+  checkNightLog();
+  checkGenericHmm();
+  checkHmmOffline();
+  checkKalmanN();
+  checkTimeWindow();
+  checkRing();
+  checkSampleQueue();
+  checkFrameAlign();
+  checkDutySchedule();
+  checkDecimate();
+  checkSOSCascade();
+  checkPrecision();
+  checkTinyML();
+  checkWindowFeatures();
+  if (g_failures) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("dsp_checks: all passed\n");
+  return 0;
+}